@@ -1,97 +1,160 @@
 /*** ***/
 
 #include "DLFLLighting.h"
+#include <DLFLParallel.h>
 
-void computeLighting( DLFLFacePtr fp, LightPtr lightptr, bool usegpu ) {
-  if ( fp->front() ) {
-    double Ka = fp->material()->Ka;
-    double Kd = fp->material()->Kd;
-    double Ks = fp->material()->Ks;
+// Exactly the same, RGBColor::operator == allows for some difference
+static bool sameColor( const RGBColor& c1, const RGBColor& c2 ) {
+  return ( c1.r == c2.r && c1.g == c2.g && c1.b == c2.b );
+}
 
-		RGBColor basecolor = fp->material()->color;
-		RGBColor fvcolor;
-		Vector3d normal, pos;
+// Set the color of a corner, true if that changed it
+static bool setCornerColor( DLFLFaceVertexPtr fvp, const RGBColor& color ) {
+  if ( sameColor(fvp->color,color) ) return false;
+  fvp->color = color;
+  return true;
+}
 
-    DLFLFaceVertexPtr current = fp->front();
-    normal = current->getNormal();
-    pos = current->getVertexCoords();
-		
-		#ifdef GPU_OK
-		if (usegpu){
-			fvcolor = RGBColor(0,0,0);
-		}
-		else {
-    	fvcolor = lightptr->illuminate(pos,normal)*Kd;
-	    fvcolor += (1.0-Kd)*basecolor;
-		}
-		#else
-  	fvcolor = lightptr->illuminate(pos,normal)*Kd;
-    fvcolor += (1.0-Kd)*basecolor;		
-		#endif
-    current->color = fvcolor;
+// Light one corner with the material of its face
+static bool lightCorner( DLFLFaceVertexPtr fvp, DLFLMaterialPtr matl, LightPtr lightptr ) {
+  double Kd = matl->Kd;
+  RGBColor fvcolor = lightptr->illuminate(fvp->getVertexCoords(),fvp->getNormal())*Kd;
+  fvcolor += (1.0-Kd)*matl->color;
+  return setCornerColor(fvp,fvcolor);
+}
 
+bool computeLighting( DLFLFacePtr fp, LightPtr lightptr, bool usegpu ) {
+  bool changed = false;
+  if ( usegpu || !fp->front() ) return false;
+  DLFLFaceVertexPtr current = fp->front();
+  do {
+    if ( lightCorner(current,fp->material(),lightptr) ) changed = true;
     current = current->next();
-    while ( current != fp->front() ) {
-      normal = current->getNormal();
-      pos = current->getVertexCoords();
-
-      #ifdef GPU_OK
-			if (usegpu){
-				// cgSetParameter3f(CgData::instance()->Kd, basecolor.r, basecolor.g, basecolor.b);
-				fvcolor = RGBColor(0,0,0);
-			}
-			else {
-	    	fvcolor = lightptr->illuminate(pos,normal)*Kd;
-		    fvcolor += (1.0-Kd)*basecolor;
-			}
-			#else
-    	fvcolor = lightptr->illuminate(pos,normal)*Kd;
-	    fvcolor += (1.0-Kd)*basecolor;
-			#endif
-    	current->color = fvcolor;
+  } while ( current != fp->front() );
+  return changed;
+}
 
-			// current->color = RGBColor(((double)rand() / ((double)(RAND_MAX)+(double)(1)) ),
-			// 													((double)rand() / ((double)(RAND_MAX)+(double)(1)) ),
-			// 													((double)rand() / ((double)(RAND_MAX)+(double)(1)) )
-			// 													);
+// Light the corners of the faces in parallel and journal the faces which
+// look different
+static void lightFaces( DLFLObjectPtr obj, const DLFLFacePtrArray& faces, LightPtr lightptr ) {
+  // All the corners in one array, those of face i from starts[i] on
+  DLFLFaceVertexPtrArray corners;
+  DLFLMaterialPtrArray materials;
+  vector<uint> starts(faces.size()+1);
+  for (uint i=0; i < faces.size(); ++i) {
+    starts[i] = corners.size();
+    DLFLFaceVertexPtr head = faces[i]->front(), current = head;
+    if ( !head ) continue;
+    do {
+      corners.push_back(current);
+      materials.push_back(faces[i]->material());
       current = current->next();
-    }
+    } while ( current != head );
+  }
+  starts[faces.size()] = corners.size();
+
+  vector<char> changed(corners.size(),0);
+  int num = corners.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i)
+    changed[i] = lightCorner(corners[i],materials[i],lightptr);
+
+  // The corner colors are drawn, faces which look different are journaled.
+  // When that is a good part of the object it is simply all changed, as
+  // the journal would be restarted anyway.
+  DLFLFacePtrArray lit;
+  for (uint i=0; i < faces.size(); ++i) {
+    for (uint j=starts[i]; j < starts[i+1]; ++j)
+      if ( changed[j] ) { lit.push_back(faces[i]); break; }
+  }
+  if ( lit.size() > 1024 && lit.size() > obj->num_faces() / 4 ) {
+    obj->changed();
+  } else {
+    for (uint i=0; i < lit.size(); ++i) obj->changedFace(lit[i]);
   }
 }
 
-void computeLighting(DLFLObjectPtr obj, TMPatchObjectPtr po, LightPtr lightptr, bool usegpu) {
-		// std::cout<< "usegpu = " << usegpu << "\n";
-	// int patchsize = (po)?po->list().size():0;
-	// 
-	// QProgressDialog *progress = new QProgressDialog("Computing Lighting...", "Cancel", 0, obj->num_faces() + patchsize);
-	// progress->setMinimumDuration(4000);
-	// progress->setWindowModality(Qt::WindowModal);
-	// int progressvalue = 0;
-	
-  DLFLFacePtrList::iterator first, last;
-  DLFLFacePtr faceptr;
-  first = obj->beginFace(); last = obj->endFace();
-  while ( first != last ) {
-		// progress->setValue(progressvalue++);
-		// QApplication::processEvents();
-		
-    faceptr = (*first);
-    computeLighting(faceptr,lightptr, usegpu);
-    ++first;
+// Is the cache from a pass over this object, with this light and these materials
+static bool cacheCurrent( const LightingCache& cache, DLFLObjectPtr obj, LightPtr lightptr ) {
+  if ( cache.object != obj || obj->getGeneration() < cache.generation ) return false;
+  const Vector3d& position = lightptr->position;
+  if ( cache.type != lightptr->type() || cache.position[0] != position[0] ||
+       cache.position[1] != position[1] || cache.position[2] != position[2] ||
+       !sameColor(cache.warmcolor,lightptr->warmcolor) || !sameColor(cache.coolcolor,lightptr->coolcolor) ||
+       cache.intensity != lightptr->intensity || cache.state != lightptr->state )
+    return false;
+  if ( cache.materials.size() != (uint) obj->num_materials() ) return false;
+  DLFLMaterialPtrList::iterator mfirst = obj->beginMaterial(), mlast = obj->endMaterial();
+  for (uint i=0; mfirst != mlast; ++mfirst, ++i) {
+    if ( cache.materials[i] != (*mfirst) || !sameColor(cache.colors[i],(*mfirst)->color) ||
+         cache.Kd[i] != (*mfirst)->Kd ) return false;
   }
-  if( po ) {
-    TMPatchFacePtrList patch_list = po->list( );
-    TMPatchFacePtrList::iterator pfirst = patch_list.begin(), plast = patch_list.end();
-    TMPatchFacePtr pfp = NULL;
-    while ( pfirst != plast ) {
-			// progress->setValue(progressvalue++);
-			// QApplication::processEvents();
-	
-      pfp = (*pfirst); ++pfirst;
-      pfp->computeLighting(lightptr);
-    }
+  return true;
+}
+
+static void fillCache( LightingCache& cache, DLFLObjectPtr obj, LightPtr lightptr ) {
+  cache.object = obj;
+  cache.generation = obj->getGeneration();
+  cache.type = lightptr->type();
+  cache.position = lightptr->position;
+  cache.warmcolor = lightptr->warmcolor; cache.coolcolor = lightptr->coolcolor;
+  cache.intensity = lightptr->intensity;
+  cache.state = lightptr->state;
+  cache.materials.clear(); cache.colors.clear(); cache.Kd.clear();
+  DLFLMaterialPtrList::iterator mfirst = obj->beginMaterial(), mlast = obj->endMaterial();
+  for (; mfirst != mlast; ++mfirst) {
+    cache.materials.push_back(*mfirst);
+    cache.colors.push_back((*mfirst)->color);
+    cache.Kd.push_back((*mfirst)->Kd);
+  }
+}
+
+// The faces whose lighting may be out of date since the cached pass: the
+// journaled faces and the faces around the journaled vertices. False if the
+// journal doesn't go back that far.
+static bool changedFaces( const LightingCache& cache, DLFLObjectPtr obj, DLFLFacePtrArray& faces ) {
+  DLFLFacePtrArray jfaces, vfaces;
+  DLFLEdgePtrArray jedges;
+  DLFLVertexPtrArray jvertices;
+  if ( !obj->changesSince(cache.generation,jfaces,jedges,jvertices) ) return false;
+  faces.clear();
+  // Elements in the journal may have been removed since
+  for (uint i=0; i < jfaces.size(); ++i)
+    if ( obj->hasFace(jfaces[i]) ) faces.push_back(jfaces[i]);
+  for (uint i=0; i < jvertices.size(); ++i) {
+    if ( !obj->hasVertex(jvertices[i]) ) continue;
+    jvertices[i]->getFaces(vfaces);
+    faces.insert(faces.end(),vfaces.begin(),vfaces.end());
   }
-	// progress->setValue(obj->num_faces() + patchsize);
+  std::sort(faces.begin(),faces.end());
+  faces.erase(std::unique(faces.begin(),faces.end()),faces.end());
+  return true;
 }
 
+void computeLighting(DLFLObjectPtr obj, TMPatchObjectPtr po, LightPtr lightptr, bool usegpu,
+                     LightingCache *cache) {
+  // The shaders light the normals as they are drawn. The corner colors
+  // keep the last pass, what changed since is lit when it is back on.
+  if ( usegpu ) return;
 
+  DLFLFacePtrArray faces;
+  if ( !cache || !cacheCurrent(*cache,obj,lightptr) || !changedFaces(*cache,obj,faces) ) {
+    faces.clear();
+    faces.reserve(obj->num_faces());
+    faces.insert(faces.end(),obj->beginFace(),obj->endFace());
+  }
+  lightFaces(obj,faces,lightptr);
+  // After the faces lit here are journaled, so the next pass skips them
+  if ( cache ) fillCache(*cache,obj,lightptr);
+
+  if( po ) {
+    // The patch object doesn't tell which patches it made again, all are lit.
+    // Only the patches whose colors changed are tessellated again.
+    const TMPatchFacePtrList& patch_list = po->list( );
+    vector<TMPatchFacePtr> patches(patch_list.begin(),patch_list.end());
+    int num = patches.size();
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num; ++i)
+      patches[i]->computeLighting(lightptr);
+  }
+}
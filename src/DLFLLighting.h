@@ -17,8 +17,38 @@
 using namespace Cg;
 #endif // GPU_OK
 
-void computeLighting( DLFLFacePtr fp, LightPtr lightptr, bool usegpu = false);
-void computeLighting( DLFLObjectPtr obj, TMPatchObjectPtr po, LightPtr lightptr, bool usegpu = false );
+// What the last lighting pass of an object was done with. Given to
+// computeLighting, the next pass only relights the faces in the change
+// journal of the object since then (those whose normals computeNormals
+// found different, with new materials, ...) and the faces around the
+// vertices in it, as long as the light and the colors of the materials
+// are still the same. Otherwise all faces are lit again.
+struct LightingCache {
+  DLFLObjectPtr object;                        // Object lit last, NULL for none
+  unsigned long generation;                    // Its generation after that
+
+  LightType type;                              // The light, as used by Light::illuminate
+  Vector3d position;
+  RGBColor warmcolor, coolcolor;
+  double intensity;
+  bool state;
+
+  vector<DLFLMaterialPtr> materials;           // The materials, with their colors
+  vector<RGBColor> colors;
+  vector<double> Kd;
+
+  LightingCache() : object(NULL), generation(0) {}
+
+  // Light everything on the next pass
+  void invalidate() { object = NULL; }
+};
+
+// Returns true if the color of any corner of the face changed. With usegpu
+// the shaders do the lighting and nothing is done.
+bool computeLighting( DLFLFacePtr fp, LightPtr lightptr, bool usegpu = false);
+// The corners are lit in parallel. With usegpu the shaders do the lighting
+// from the normals and the corner colors are left as they are.
+void computeLighting( DLFLObjectPtr obj, TMPatchObjectPtr po, LightPtr lightptr, bool usegpu = false,
+                      LightingCache *cache = NULL );
 
 #endif /* #ifndef _DLFL_LIGHTING_HH_ */
-
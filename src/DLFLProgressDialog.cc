@@ -0,0 +1,41 @@
+/*** ***/
+
+#include "DLFLProgressDialog.h"
+
+#include <QEventLoop>
+
+DLFLProgressDialog::DLFLProgressDialog( const QString& label, QWidget *parent )
+  : QProgressDialog(label,tr("Cancel"),0,1000,parent), permille(0), cancelled(false) {
+  setWindowModality(Qt::WindowModal);
+  setMinimumDuration(1000); // Don't flash the dialog for quick operations
+  setAutoClose(false); setAutoReset(false);
+  timer.setInterval(50);
+  connect(&timer,SIGNAL(timeout()),this,SLOT(refresh()));
+}
+
+bool DLFLProgressDialog::update(double fraction) {
+  permille = int(fraction*1000.0);
+  return !cancelled;
+}
+
+void DLFLProgressDialog::refresh( ) {
+  if ( wasCanceled() ) cancelled = true;
+  else setValue(permille);
+}
+
+bool DLFLProgressDialog::run(QThread *worker) {
+  QEventLoop loop;
+  connect(worker,SIGNAL(finished()),&loop,SLOT(quit()));
+
+  DLFL::setProgress(this);
+  timer.start();
+  worker->start();
+  // The worker may have finished before we get into the event loop
+  if ( !worker->isFinished() ) loop.exec();
+  worker->wait();
+  timer.stop();
+  DLFL::setProgress(NULL);
+
+  refresh();
+  return !cancelled;
+}
@@ -0,0 +1,153 @@
+/*** ***/
+
+#ifndef _DLFL_PROGRESS_DIALOG_HH_
+#define _DLFL_PROGRESS_DIALOG_HH_
+
+#include <QProgressDialog>
+#include <QThread>
+#include <QTimer>
+
+#include <DLFLObject.h>
+#include <DLFLProgress.h>
+#include <DLFLSubdiv.h>
+
+/*
+  Progress dialog for the DLFL operators.
+
+  The operator runs on a worker thread and reports through the DLFLProgress
+  interface. The reported value and the cancel state are only exchanged
+  through two plain flags - the dialog itself is updated from a timer on the
+  GUI thread, since Qt widgets must not be touched from the worker thread.
+*/
+class DLFLProgressDialog : public QProgressDialog, public DLFL::DLFLProgress {
+  Q_OBJECT
+
+public :
+  DLFLProgressDialog( const QString& label, QWidget *parent = 0 );
+
+  // Called by the operator (on the worker thread)
+  bool update(double fraction);
+
+  // Start the worker thread and process GUI events until it is done.
+  // Returns false if the user cancelled the operation.
+  bool run(QThread *worker);
+
+private slots :
+  void refresh( );
+
+private :
+  volatile int permille;
+  volatile bool cancelled;
+  QTimer timer;
+};
+
+// Worker thread for an operator. Derived classes apply the operator in
+// apply(), which returns false if the operator failed.
+class DLFLOperatorThread : public QThread {
+public :
+  DLFLOperatorThread( ) : mResult(false), mCancelled(false) {}
+
+  bool result( ) const { return mResult; }
+  // Whether a false result is because the operation was cancelled, rather
+  // than the operator failing on the object
+  bool cancelled( ) const { return mCancelled; }
+
+protected :
+  virtual bool apply( ) = 0;
+
+  void run( ) {
+    mResult = apply() && !DLFL::progressCancelled();
+    mCancelled = !mResult && DLFL::progressCancelled();
+  }
+
+private :
+  bool mResult;
+  bool mCancelled;
+};
+
+// Worker thread for the subdivision schemes
+class DLFLSubdivideThread : public DLFLOperatorThread {
+public :
+  DLFLSubdivideThread( DLFL::DLFLObjectPtr obj, DLFL::DLFLSubdivScheme scheme, int levels,
+                       double param1 = 0.0, double param2 = 0.0 )
+    : mObject(obj), mScheme(scheme), mLevels(levels), mParam1(param1), mParam2(param2) {}
+
+protected :
+  bool apply( ) {
+    return DLFL::subdivide(mObject,mScheme,mLevels,mParam1,mParam2);
+  }
+
+private :
+  DLFL::DLFLObjectPtr mObject;
+  DLFL::DLFLSubdivScheme mScheme;
+  int mLevels;
+  double mParam1, mParam2;
+};
+
+// Worker thread for the operators which only fail by being cancelled
+// (crust, wireframe, sponge, convex hull). The operator is called with the
+// object and up to three parameters.
+class DLFLFunctionThread : public DLFLOperatorThread {
+public :
+  typedef void (*Function)( DLFL::DLFLObjectPtr obj, double param1, double param2, double param3 );
+
+  DLFLFunctionThread( DLFL::DLFLObjectPtr obj, Function function,
+                      double param1 = 0.0, double param2 = 0.0, double param3 = 0.0 )
+    : mObject(obj), mFunction(function), mParam1(param1), mParam2(param2), mParam3(param3) {}
+
+protected :
+  bool apply( ) {
+    mFunction(mObject,mParam1,mParam2,mParam3);
+    return true;
+  }
+
+private :
+  DLFL::DLFLObjectPtr mObject;
+  Function mFunction;
+  double mParam1, mParam2, mParam3;
+};
+
+// Worker thread for reading a file into an object. OBJ reading can be
+// cancelled, DLFL reading can't.
+class DLFLReadThread : public DLFLOperatorThread {
+public :
+  DLFLReadThread( DLFL::DLFLObjectPtr obj, istream& file, istream& mtlfile, bool dlfl )
+    : mObject(obj), mFile(file), mMtlFile(mtlfile), mDLFL(dlfl) {}
+
+protected :
+  bool apply( ) {
+    if ( !mDLFL ) return mObject->readObject(mFile,mMtlFile);
+    mObject->readDLFL(mFile,mMtlFile);
+    return true;
+  }
+
+private :
+  DLFL::DLFLObjectPtr mObject;
+  istream& mFile;
+  istream& mMtlFile;
+  bool mDLFL;
+};
+
+// Worker thread for writing an object to a file
+class DLFLWriteThread : public DLFLOperatorThread {
+public :
+  DLFLWriteThread( DLFL::DLFLObjectPtr obj, ostream& file, ostream& mtlfile, bool dlfl,
+                   bool with_normals, bool with_tex_coords )
+    : mObject(obj), mFile(file), mMtlFile(mtlfile), mDLFL(dlfl),
+      mWithNormals(with_normals), mWithTexCoords(with_tex_coords) {}
+
+protected :
+  bool apply( ) {
+    if ( mDLFL ) return mObject->writeDLFL(mFile,mMtlFile);
+    return mObject->writeObject(mFile,mMtlFile,mWithNormals,mWithTexCoords);
+  }
+
+private :
+  DLFL::DLFLObjectPtr mObject;
+  ostream& mFile;
+  ostream& mMtlFile;
+  bool mDLFL;
+  bool mWithNormals, mWithTexCoords;
+};
+
+#endif // _DLFL_PROGRESS_DIALOG_HH_
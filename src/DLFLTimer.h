@@ -0,0 +1,39 @@
+/*** ***/
+
+#ifndef _DLFL_TIMER_HH_
+#define _DLFL_TIMER_HH_
+
+#include <QTime>
+#include <QList>
+#include <iostream>
+
+/*
+  Wall clock timing of the steps of an operation, printed to the console as
+  "label:step1:step2:...:stepN" with the times in seconds.
+
+  Wall clock rather than clock(): the operators run their geometry passes on
+  several threads, and clock() adds up the time of all of them.
+*/
+class DLFLTimer {
+public :
+  DLFLTimer( const char *label ) : mLabel(label) { mTime.start(); }
+
+  // End the current step and start the next one
+  void step( ) { mSteps.append(mTime.restart()); }
+
+  // End the last step and print all of them
+  void print( ) {
+    step();
+    std::cout << mLabel;
+    for (int i=0; i < mSteps.size(); ++i)
+      std::cout << ":" << mSteps[i] / 1000.0;
+    std::cout << std::endl;
+  }
+
+private :
+  const char *mLabel;
+  QTime mTime;
+  QList<int> mSteps;                              // Milliseconds
+};
+
+#endif /* _DLFL_TIMER_HH_ */
@@ -5,33 +5,16 @@
 
 //-- Subroutines dealing with undo and redo for DLFLWindow --//
 
+// The undo and redo lists hold deep copies of the object. Going back and
+// forth only swaps the meshes of the object and a snapshot, nothing is copied.
+
 void MainWindow::clearUndoList(void) {
-  StringStreamPtrList::iterator first, firstmtl, last;
-	firstmtl = undoMtlList.begin();
-  first = undoList.begin(); last = undoList.end();
-	while ( first != last ) {
-		StringStreamPtr temp = (*first); ++first;
-		StringStreamPtr tempmtl = (*firstmtl); ++firstmtl;
-		delete temp;	delete tempmtl;
-		temp = NULL; tempmtl = NULL;
-	}
-  undoList.clear();
-  undoMtlList.clear();
+  clear(undoList);
 }
 
 void MainWindow::clearRedoList(void)
 {
-	StringStreamPtrList::iterator first, firstmtl, last;
-	firstmtl = redoMtlList.begin();
-	first = redoList.begin(); last = redoList.end();
-	while ( first != last ) {
-		StringStreamPtr temp = (*first); ++first;
-		StringStreamPtr tempmtl = (*firstmtl); ++firstmtl;
-		delete temp;	delete tempmtl;
-		temp = NULL; tempmtl = NULL;
-	}
-	redoList.clear();
-	redoMtlList.clear();
+	clear(redoList);
 }
 
 void MainWindow::undoPush(void)
@@ -43,20 +26,12 @@ void MainWindow::undoPush(void)
      // Check if we have reached undo limit, in which case remove oldest state
      // and add current state to end of list.
   if ( undoList.size() > undolimit ) {
-		StringStreamPtr temp = undoList.front();
-		StringStreamPtr tempmtl = undoMtlList.front();
-		delete temp; delete tempmtl;
+		DLFLObjectPtr temp = undoList.front();
+		delete temp;
 		undoList.pop_front();
   }
 
-	StringStreamPtr curobj = new StringStream;
-	StringStreamPtr curobjmtl = new StringStream;
-	
-	object.writeDLFL(*curobj, *curobjmtl);
-	// object.writeMTL(*curobjmtl);
-	
-	undoList.push_back(curobj);
-	undoMtlList.push_back(curobjmtl);
+	undoList.push_back(new DLFLObject(object));
 	// Evertime a new operation is done, previous state is put into UndoList
 	// At the same time the redo list should be cleared, because we have
 	// nothing to redo immediately after an operation.
@@ -68,24 +43,11 @@ void MainWindow::undo(void) {
 	if ( !undoList.empty() ) {		
  		// Restore previous object
 		// Put current object to end of redo list
-		// Take last element of undo list and re-create current object
-		StringStreamPtr curobj = new StringStream;
-		StringStreamPtr curobjmtl = new StringStream;
-
-		object.writeDLFL(*curobj, *curobjmtl);
-		// object.writeMTL(*curobjmtl);
-
-		redoList.push_back(curobj);
-		redoMtlList.push_back(curobjmtl);
-
-		StringStreamPtr oldobj = undoList.back();
-		StringStreamPtr oldobjmtl = undoMtlList.back();
-		
-		object.readDLFL(*oldobj,*oldobjmtl,true);
-		// object.readMTL(*oldobj,true);
-
-		undoList.pop_back(); delete oldobj;
-		undoMtlList.pop_back(); delete oldobjmtl;
+		// Take last element of undo list and make it the current object
+		DLFLObjectPtr oldobj = undoList.back();
+		undoList.pop_back();
+		object.swap(*oldobj);
+		redoList.push_back(oldobj);
 		
     cout << "Recompute patches for undo...." << endl;
 		active->recomputePatches();
@@ -105,23 +67,33 @@ void MainWindow::undo(void) {
 	}
 }
 
+void MainWindow::undoRollback(void) {
+	// Throw away the current object and restore the last undo state.
+	// Unlike undo() the current state is not put on the redo list - used
+	// when an operation was cancelled half way through
+	if ( undoList.empty() ) return;
+
+	DLFLObjectPtr oldobj = undoList.back();
+	undoList.pop_back();
+	object.swap(*oldobj);
+	delete oldobj;
+
+	active->recomputePatches();
+	active->recomputeNormals();
+	MainWindow::clearSelected();
+	redraw();
+}
+
 void MainWindow::redo(void) {
 	
   if ( !redoList.empty() ) {
 		// Redo previously undone operation
 		// Put current object to end of undo list
-		// Take last element of redo list and re-create current object
-		StringStreamPtr curobj = new StringStream;
-		StringStreamPtr curobjmtl = new StringStream;
-		object.writeDLFL(*curobj, *curobjmtl);
-		undoList.push_back(curobj);
-		undoMtlList.push_back(curobjmtl);
-
-		StringStreamPtr newobj = redoList.back();
-		StringStreamPtr newobjmtl = redoMtlList.back();
-		object.readDLFL(*newobj, *newobjmtl);
-		redoList.pop_back(); delete newobj;
-		redoMtlList.pop_back(); delete newobjmtl;
+		// Take last element of redo list and make it the current object
+		DLFLObjectPtr newobj = redoList.back();
+		redoList.pop_back();
+		object.swap(*newobj);
+		undoList.push_back(newobj);
 
 		active->recomputePatches();
 		active->recomputeNormals();
@@ -1,7 +1,6 @@
 /*** ***/
 
 #include "GLWidget.h"
-#include "DLFLSelection.h"
 
 /*!
 	\ingroup gui
@@ -176,10 +175,12 @@ void GLWidget::initializeGL( ) {
 	mShowFaceIDs   = false;
 	mShowFaceVertexIDs = false;
 	mShowSelectedIDs = false;
+	mHideOccludedIDs = true;
 	mShowHUD = false;
 	mBrushSize = 2.5;
 	mShowBrush = false;
 	mShowSelectionWindow = false;
+	mSelectVisibleOnly = false;
 	setMouseTracking(true);
 	
 	locatorPtr = new DLFLLocator(); // brianb
@@ -414,10 +415,14 @@ void GLWidget::paintEvent(QPaintEvent *event){
 		}
 		#endif // GPU_OK
 	}
-	// Adjust the depthrange so selected items are shown clearly
-	glDepthRange(0,1-0.0005-0.0005);
-	drawSelected();
-	glDepthRange(0,1);
+	// Adjust the depthrange so selected items are shown clearly. While
+	// rendering is off another thread may be changing the object, so
+	// nothing drawn from it is shown.
+	if (renderObject){
+		glDepthRange(0,1-0.0005-0.0005);
+		drawSelected();
+		glDepthRange(0,1);
+	}
 	
 	GLdouble model[4][4], proj[4][4];
 	GLint view[4];
@@ -443,8 +448,10 @@ void GLWidget::paintEvent(QPaintEvent *event){
 	drawSelectionWindow(&painter);	
 	//drawBrush(&painter);
 	drawHUD(&painter);
-	drawSelectedIDs(&painter, &model[0][0], &proj[0][0], &view[0]);
-	drawIDs(&painter, &model[0][0], &proj[0][0], &view[0]); // draw vertex, edge and face ids
+	if (renderObject){
+		drawSelectedIDs(&painter, &model[0][0], &proj[0][0], &view[0]);
+		drawIDs(&painter, &model[0][0], &proj[0][0], &view[0]); // draw vertex, edge and face ids
+	}
 	
 	
 	//try out some code to put an axis in the bottom left corner of the screen  
@@ -561,43 +568,46 @@ void GLWidget::drawBrush(QPainter *painter){
 //other data that could be shown will be added later
 void GLWidget::drawHUD(QPainter *painter){	
 	if (mShowHUD){
-		
-		if (mSelectionMaskString == "Faces"){
-		//show info about a selected face	
-			if (numSelectedFaces() == 1) {
-				DLFLFacePtr fp = object->sel_fptr_array[0];
+		// The counts are left out while the object is being changed
+		QString s1, s2;
+		if (renderObject){
+			if (mSelectionMaskString == "Faces"){
+			//show info about a selected face	
+				if (numSelectedFaces() == 1) {
+					DLFLFacePtr fp = object->sel_fptr_array[0];
+				}
 			}
-		}
-		if (mSelectionMaskString == "Edges"){
-		//show info about a selected edge	
-			if (numSelectedEdges() == 1) {
-				DLFLEdgePtr ep = object->sel_eptr_array[0];
-			}			
-		}
-		if (mSelectionMaskString == "Vertices"){
-		//show info about a selected vertex	
-			if (numSelectedVertices() == 1) {
-				DLFLVertexPtr vp = object->sel_vptr_array[0];
+			if (mSelectionMaskString == "Edges"){
+			//show info about a selected edge	
+				if (numSelectedEdges() == 1) {
+					DLFLEdgePtr ep = object->sel_eptr_array[0];
+				}			
 			}
-		}
-		if (mSelectionMaskString == "Corners"){
-		//show info about a selected corner	
-			if (numSelectedCorners() == 1) {
-				DLFLFaceVertexPtr fvp = object->sel_fvptr_array[0];
-				// std::cout << fvp << "\n";
+			if (mSelectionMaskString == "Vertices"){
+			//show info about a selected vertex	
+				if (numSelectedVertices() == 1) {
+					DLFLVertexPtr vp = object->sel_vptr_array[0];
+				}
+			}
+			if (mSelectionMaskString == "Corners"){
+			//show info about a selected corner	
+				if (numSelectedCorners() == 1) {
+					DLFLFaceVertexPtr fvp = object->sel_fvptr_array[0];
+					// std::cout << fvp << "\n";
+				}
 			}
-		}
 		
-		QString s1 = "Vertices: " + QString("%1").arg((uint)object->num_vertices()) +
-		 						"\nEdges: " + QString("%1").arg((uint)object->num_edges()) +
-								"\nFaces: " + QString("%1").arg((uint)object->num_faces()) +
-								"\nMaterials: " + QString("%1").arg((uint)object->num_materials()) +
-								"\nGenus: " + QString("%1").arg(object->genus());
-
-		QString s2 = "Sel. Vertices:" + QString("%1").arg(numSelectedVertices()) +
-		 						"\nSel. Edges: " + QString("%1").arg(numSelectedEdges()) +
-								"\nSel. Faces: " + QString("%1").arg(numSelectedFaces()) +
-								"\nSel. Corners: " + QString("%1").arg(numSelectedCorners());
+			s1 = "Vertices: " + QString("%1").arg((uint)object->num_vertices()) +
+			 						"\nEdges: " + QString("%1").arg((uint)object->num_edges()) +
+									"\nFaces: " + QString("%1").arg((uint)object->num_faces()) +
+									"\nMaterials: " + QString("%1").arg((uint)object->num_materials()) +
+									"\nGenus: " + QString("%1").arg(object->genus());
+
+			s2 = "Sel. Vertices:" + QString("%1").arg(numSelectedVertices()) +
+			 						"\nSel. Edges: " + QString("%1").arg(numSelectedEdges()) +
+									"\nSel. Faces: " + QString("%1").arg(numSelectedFaces()) +
+									"\nSel. Corners: " + QString("%1").arg(numSelectedCorners());
+		}
 
 		QString s3 = 	"Mode: " + mModeString + 
                         "\nRemeshing Mode: " + mRemeshingSchemeString + 
@@ -621,7 +631,7 @@ void GLWidget::drawHUD(QPainter *painter){
 		painter->setPen(Qt::NoPen);
 		QBrush brush = QBrush(QColor(0,0,0,127));
 		painter->setBrush(brush);
-		QRectF rectangle(0.0, height()-r1.height()*7, width(), height());
+		QRectF rectangle(0.0, height()-r3.height()*7, width(), height());
 		// painter->drawRoundRect(QRect(3.0,3.0,rectangle.width(),rectangle.height()),25,25);
 		painter->drawRect(rectangle);
 		painter->setPen(Qt::white);
@@ -631,248 +641,111 @@ void GLWidget::drawHUD(QPainter *painter){
 	}
 }
 
+// Where to put the ID labels. The points were drawn moved by the transform
+// of the object, so the modelview matrix of the layout includes it.
+DLFLLabelLayout GLWidget::labelLayout(const GLdouble *model, const GLdouble *proj, const GLint *view) {
+	double mat[16], modelview[16];
+	object->tr.fillArrayColumnMajor(mat);
+	for (int c=0; c < 4; ++c)
+		for (int r=0; r < 4; ++r) {
+			modelview[c*4+r] = 0.0;
+			for (int k=0; k < 4; ++k) modelview[c*4+r] += model[k*4+r]*mat[c*4+k];
+		}
+	DLFLLabelLayout layout(proj,modelview,view);
+	// One label per label sized cell, so they don't pile up on each other
+	layout.setCells(40,20,1);
+	return layout;
+}
+
+// Draw an ID label, fainter the farther it is. The labels from a layout
+// are in window coordinates, y is inverted for the painter.
+void GLWidget::drawIDLabel(QPainter *painter, const DLFLLabelLayout::Label& label, const QColor& color, int w, bool fade) {
+	int min_alpha = 25, max_alpha = 255;
+	int alpha = fade ? (int)(min_alpha + label.nearness*(max_alpha-min_alpha)) : color.alpha();
+	QRectF rectangle(label.x, height() - label.y, w, 20);
+	painter->setPen(Qt::NoPen);
+	painter->setBrush(QBrush(QColor(color.red(),color.green(),color.blue(),alpha)));
+	painter->drawRoundRect(rectangle,6,6);
+	painter->setPen(fade ? QColor(255,255,255,alpha) : QColor(Qt::white));
+	painter->drawText(rectangle, Qt::AlignCenter,QString::number(label.id));
+}
+
 void GLWidget::drawIDs( QPainter *painter, const GLdouble *model, const GLdouble *proj, const GLint	*view) {
+	if ( !mShowVertexIDs && !mShowEdgeIDs && !mShowFaceIDs ) return;
 	glDisable(GL_DEPTH_TEST);
-	GLdouble win_x = 0, win_y = 0, win_z = 0;	
-	double min_dist=100000000.0, max_dist=-100000000.0, x,y,z,d;
-	int count, min_alpha = 25, max_alpha = 255;
-	// Vector3d coord = viewport.camera.getPos(); //use this to find the dist from the camera
-	Vector3d coord = mCamera->getEye(); //use this to find the dist from the camera
-	QBrush brush;
-	
-	Vector3d offset = object->position;
-	
+	DLFLLabelLayout layout = labelLayout(model,proj,view);
+	if ( mHideOccludedIDs ) layout.setOccluder(object);
+	vector<DLFLLabelLayout::Label> labels;
+
 	/* Draw Vertex IDs */
 	if( mShowVertexIDs ) {
 		DLFLVertexPtrArray vparray;
 		object->getVertices(vparray);
-		double vlsqr_array[vparray.size()];
-		count = 0;
-		DLFLVertexPtrArray::iterator it;
-		for( it = vparray.begin(); it != vparray.end(); it++) {
-			Vector3d dist = (*it)->coords - coord;
-			vlsqr_array[count] = dist.lengthsqr();
-			max_dist = (vlsqr_array[count] > max_dist ) ? vlsqr_array[count] : max_dist;
-			min_dist = (vlsqr_array[count] < min_dist ) ? vlsqr_array[count] : min_dist;
-			count++;
-		}
-		count = 0;
-		for( it = vparray.begin(); it != vparray.end(); it++) {
-			Vector3d point = (*it)->coords;
-			point = object->tr.applyTo(point);
-			//point += object->position;
-			point.get(x,y,z);		
-			QString id = QString::number((*it)->getID() );
-			if(max_dist == min_dist)
-				d = min_alpha;
-			else
-				d = (vlsqr_array[count]-min_dist)*(max_alpha-min_alpha)/(max_dist - min_dist) + min_alpha;
-			gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-			win_y = height() - win_y; // y is inverted
-			painter->setPen(Qt::NoPen);
-			brush = QBrush(QColor(mVertexIDBgColor.red(),mVertexIDBgColor.green(),mVertexIDBgColor.blue(),min_alpha+max_alpha-d));
-			painter->setBrush(brush);
-			QRectF rectangle(win_x, win_y, 35, 20);
-			painter->drawRoundRect(rectangle,6,6);
-			painter->setPen(QColor(255,255,255,min_alpha+max_alpha-d));
-			painter->drawText(rectangle, Qt::AlignCenter,id);
-			count++;
-		}
+		layout.layout(vparray,labels);
+		for (uint i=0; i < labels.size(); ++i)
+			drawIDLabel(painter,labels[i],mVertexIDBgColor,35,true);
 	}
 
 	/* Draw Edge IDs */
 	if( mShowEdgeIDs ) {
 		DLFLEdgePtrArray eparray;
 		object->getEdges(eparray);
-		double elsqr_array[eparray.size()];
-		count = 0;
-		DLFLEdgePtrArray::iterator it;
-		for( it = eparray.begin(); it != eparray.end(); it++) {
-			Vector3d dist = (*it)->getMidPoint() - coord;
-			elsqr_array[count] = dist.lengthsqr();
-			max_dist = (elsqr_array[count] > max_dist ) ? elsqr_array[count] : max_dist;
-			min_dist = (elsqr_array[count] < min_dist ) ? elsqr_array[count] : min_dist;
-			count++;
-		}
-		count=0;
-		for( it = eparray.begin(); it != eparray.end(); it++) {
-			QString id = QString::number( (*it)->getID() );
-			Vector3d point = (*it)->getMidPoint();
-			point = object->tr.applyTo(point);
-			point.get(x,y,z);
-			if(max_dist == min_dist)
-				d = min_alpha;
-			else
-				d = (elsqr_array[count]-min_dist)*(max_alpha-min_alpha)/(max_dist - min_dist) + min_alpha;
-			gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-			win_y = height() - win_y; // y is inverted
-			painter->setPen(Qt::NoPen);
-			// std::cout<< min_alpha << " " << max_alpha << " "<< d << std::endl;
-			brush = QBrush(QColor(mEdgeIDBgColor.red(),mEdgeIDBgColor.green(),mEdgeIDBgColor.blue(),min_alpha+max_alpha-d));
-			painter->setBrush(brush);
-			QRectF rectangle(win_x, win_y, 35, 20);
-			painter->drawRoundRect(rectangle,6,6);
-			painter->setPen(QColor(255,255,255,min_alpha+max_alpha-d));
-			painter->drawText(rectangle, Qt::AlignCenter,id);
-			count++;
-		}
+		layout.layout(eparray,labels);
+		for (uint i=0; i < labels.size(); ++i)
+			drawIDLabel(painter,labels[i],mEdgeIDBgColor,35,true);
 	}
-	
+
 	/* Draw Face IDs */
 	if( mShowFaceIDs ) {
 		DLFLFacePtrArray fparray;
 		object->getFaces(fparray);
-		double flsqr_array[fparray.size()];
-		count = 0;
-		DLFLFacePtrArray::iterator it;
-		for( it = fparray.begin(); it != fparray.end(); it++) {
-			Vector3d dist = (*it)->geomCentroid() - coord;
-			flsqr_array[count] = dist.lengthsqr();
-			max_dist = (flsqr_array[count] > max_dist ) ? flsqr_array[count] : max_dist;
-			min_dist = (flsqr_array[count] < min_dist ) ? flsqr_array[count] : min_dist;
-			count++;
-		}
-		count=0;
-		for( it = fparray.begin(); it != fparray.end(); it++) {
-			QString id = QString::number( (*it)->getID() );
-			Vector3d point = (*it)->geomCentroid();// + (*it)->getNormal();
-			point = object->tr.applyTo(point);
-			point.get(x,y,z);
-			if(max_dist == min_dist)
-				d = min_alpha;
-			else
-				d = (flsqr_array[count]-min_dist)*(max_alpha-min_alpha)/(max_dist - min_dist) + min_alpha;
-			gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-			win_y = height() - win_y; // y is inverted
-			painter->setPen(Qt::NoPen);
-			brush = QBrush(QColor(mFaceIDBgColor.red(),mFaceIDBgColor.green(),mFaceIDBgColor.blue(),min_alpha+max_alpha-d));
-			painter->setBrush(brush);
-			QRectF rectangle(win_x, win_y, 35, 20);
-			painter->drawRoundRect(rectangle,6,6);
-			painter->setPen(QColor(255,255,255,min_alpha+max_alpha-d));
-			painter->drawText(rectangle, Qt::AlignCenter,id);
-			count++;
-		}
+		layout.layout(fparray,labels);
+		for (uint i=0; i < labels.size(); ++i)
+			drawIDLabel(painter,labels[i],mFaceIDBgColor,35,true);
 	}
 
-	glPopMatrix( );
 	glEnable(GL_DEPTH_TEST);
 }
 
 void GLWidget::drawSelectedIDs( QPainter *painter, const GLdouble *model, const GLdouble *proj, const GLint	*view) {
 	if (mShowSelectedIDs){
 		glDisable(GL_DEPTH_TEST);
-		
-		glPushMatrix( );
-		double mat[16];
-		object->tr.fillArrayColumnMajor(mat);
-		glMultMatrixd(mat);
-	
-		double x,y,z;
-		QBrush brush;
-		QRectF rectangle;
-		QString id;
-		GLdouble win_x = 0, win_y = 0, win_z = 0;
-	
-		if( !mShowVertexIDs ) {
-			if ( !object->sel_vptr_array.empty() ){
-				DLFLVertexPtrArray::iterator first, last;
-				first = object->sel_vptr_array.begin(); last = object->sel_vptr_array.end();
-				while ( first != last ){
-					QString id = QString::number( (*first)->getID() );
-					double x,y,z;
-					Vector3d point = (*first)->coords;// + (*it)->getNormal();
-					point = object->tr.applyTo(point);
-					point.get(x,y,z);
-					win_x = 0, win_y = 0, win_z = 0;
-					gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-					win_y = height() - win_y; // y is inverted
-					painter->setPen(Qt::NoPen);
-					brush = QBrush(QColor(mVertexIDBgColor));
-					painter->setBrush(brush);
-					rectangle = QRectF(win_x, win_y, 40, 20);
-					painter->drawRoundRect(rectangle,6,6);
-					painter->setPen(Qt::white);
-					painter->drawText(rectangle, Qt::AlignCenter,id);
-					++first;
-				}
-			}
+		// Selected elements are labelled even when hidden, and all of them,
+		// even if they overlap. There are only as many as were picked.
+		DLFLLabelLayout layout = labelLayout(model,proj,view);
+		layout.setCells(40,20,0);
+		vector<DLFLLabelLayout::Label> labels;
+
+		if( !mShowVertexIDs && !object->sel_vptr_array.empty() ) {
+			layout.layout(object->sel_vptr_array.array(),labels);
+			for (uint i=0; i < labels.size(); ++i)
+				drawIDLabel(painter,labels[i],mVertexIDBgColor,40,false);
 		}
-	
-		if( !mShowEdgeIDs ) {
-			if ( !object->sel_eptr_array.empty() ){
-				DLFLEdgePtrArray::iterator first, last;
-				first = object->sel_eptr_array.begin(); last = object->sel_eptr_array.end();
-				while ( first != last ){
-					QString id = QString::number( (*first)->getID() );
-					Vector3d point = (*first)->getMidPoint(true);
-					point = object->tr.applyTo(point);
-					point.get(x,y,z);
-					win_x = 0, win_y = 0, win_z = 0;
-					gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-					win_y = height() - win_y; // y is inverted
-					painter->setPen(Qt::NoPen);
-					QBrush brush = QBrush(QColor(mEdgeIDBgColor));
-					painter->setBrush(brush);
-					rectangle = QRectF(win_x, win_y, 40, 20);
-					painter->drawRoundRect(rectangle,6,6);
-					painter->setPen(Qt::white);
-					painter->drawText(rectangle, Qt::AlignCenter,id);
-					++first;
-				}
-			}
+
+		if( !mShowEdgeIDs && !object->sel_eptr_array.empty() ) {
+			layout.layout(object->sel_eptr_array.array(),labels);
+			for (uint i=0; i < labels.size(); ++i)
+				drawIDLabel(painter,labels[i],mEdgeIDBgColor,40,false);
 		}
 
-		if( !mShowFaceIDs ) {
-			if ( !object->sel_fptr_array.empty() ){
-				DLFLFacePtrArray::iterator first, last;
-				first = object->sel_fptr_array.begin(); last = object->sel_fptr_array.end();
-				while ( first != last )	{
-					QString id = QString::number( (*first)->getID() );
-					double x,y,z; 
-					Vector3d point = (*first)->geomCentroid();// + (*it)->getNormal();
-					point = object->tr.applyTo(point);
-					point.get(x,y,z);
-					win_x = 0, win_y = 0, win_z = 0;
-					gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-					win_y = height() - win_y; // y is inverted
-					painter->setPen(Qt::NoPen);
-					brush = QBrush(QColor(mFaceIDBgColor));
-					painter->setBrush(brush);
-					rectangle = QRectF(win_x, win_y, 40, 20);
-					painter->drawRoundRect(rectangle,6,6);
-					painter->setPen(Qt::white);
-					painter->drawText(rectangle, Qt::AlignCenter,id);
-					++first;
-				}
-			}
+		if( !mShowFaceIDs && !object->sel_fptr_array.empty() ) {
+			layout.layout(object->sel_fptr_array.array(),labels);
+			for (uint i=0; i < labels.size(); ++i)
+				drawIDLabel(painter,labels[i],mFaceIDBgColor,40,false);
 		}
 
-		if( !mShowFaceVertexIDs ) {
-			if ( !object->sel_fvptr_array.empty() ) {
-				DLFLFaceVertexPtrArray::iterator first, last;
-				first = object->sel_fvptr_array.begin(); last = object->sel_fvptr_array.end();
-				while ( first != last ){
-					QString id = QString::number( (*first)->vertex->getID() );
-					double x,y,z; 
-					Vector3d point = (*first)->vertex->coords;
-					point = object->tr.applyTo(point);
-					point.get(x,y,z);
-					win_x = 0, win_y = 0, win_z = 0;
-					gluProject(x, y, z, model, proj, view, &win_x, &win_y, &win_z);
-					win_y = height() - win_y; // y is inverted
-					painter->setPen(Qt::NoPen);
-					brush = QBrush(QColor(mVertexIDBgColor));
-					painter->setBrush(brush);
-					rectangle = QRectF(win_x, win_y, 40, 20);
-					painter->drawRoundRect(rectangle,6,6);
-					painter->setPen(Qt::white);
-					painter->drawText(rectangle, Qt::AlignCenter,id);
-					++first;
-				}
+		// Corners show the IDs of their vertices
+		if( !mShowFaceVertexIDs && !object->sel_fvptr_array.empty() ) {
+			DLFLVertexPtrArray vparray;
+			DLFLFaceVertexPtrArray::const_iterator first = object->sel_fvptr_array.begin(), last = object->sel_fvptr_array.end();
+			while ( first != last ) {
+				vparray.push_back((*first)->vertex);
+				++first;
 			}
-		} 
-		glPopMatrix( );
+			layout.layout(vparray,labels);
+			for (uint i=0; i < labels.size(); ++i)
+				drawIDLabel(painter,labels[i],mVertexIDBgColor,40,false);
+		}
 		glEnable(GL_DEPTH_TEST);
 	}
 }
@@ -896,23 +769,11 @@ void GLWidget::drawSelectedIDs( QPainter *painter, const GLdouble *model, const
 // 	// mIsFullScreen != mIsFullScreen;
 // }
 
-// Subroutine for selecting a Vertex
-DLFLVertexPtr GLWidget::selectVertex(int mx, int my, int w, int h) {
-	GLuint selectBuf[8192];
-	uint closest;
-	GLuint dist;
-	long hits, index;
-	DLFLVertexPtr sel(NULL);
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
+// The part of the view around the mouse, in place of gluPickMatrix
+DLFLPickIndex::Region GLWidget::pickRegion(int mx, int my, int w, int h, bool round) {
 	GLint vp[4];
+	GLdouble projection[16], modelview[16];
 	glGetIntegerv(GL_VIEWPORT, vp);
-	// viewport.camera.enterSelectionMode(mx,my,30,30,vp); // Reduced sensitivity for picking points
-	mCamera->enterSelectionMode(mx,my,w,h,vp); // Reduced sensitivity for picking points
 
 	// Make sure earlier matrices are preserved, since multiple windows
 	// seem to be sharing the same matrix stacks
@@ -922,90 +783,28 @@ DLFLVertexPtr GLWidget::selectVertex(int mx, int my, int w, int h) {
 	glMatrixMode(GL_MODELVIEW);
 	glPushMatrix();
 
-	// viewport.reshape();
-	// viewport.apply_transform();
-	// glViewport(0,0,width(),height());
 	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderVerticesForSelect(object);
-	glFlush();
+	glGetDoublev(GL_PROJECTION_MATRIX, projection);
+	glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
 
 	glPopMatrix();
 
 	glMatrixMode(GL_PROJECTION);
 	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
 
-	mCamera->leaveSelectionMode();
+	return DLFLPickIndex::Region(projection,modelview,vp,mx,my,w,h,round);
+}
 
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		closest = 0; dist = 0xffffffff;
-		while ( hits ){
-			index = (hits-1)*4;
-			if ( selectBuf[index+1] < dist ){
-				dist = selectBuf[index+1];
-				closest = selectBuf[index+3];
-			}
-			hits--;
-		}
-		// closest now has the id of the selected vertex
-		sel = DLFLObject::vparray[closest];
-	}
-	return sel;
+// Subroutine for selecting a Vertex
+DLFLVertexPtr GLWidget::selectVertex(int mx, int my, int w, int h) {
+	return object->pickIndex().pickVertex(pickRegion(mx,my,w,h));
 }
 
 // Subroutine for selecting a Vertex
 DLFLVertexPtrArray GLWidget::selectVertices(int mx, int my, int w, int h) {
-	GLuint selectBuf[8192];
-	long hits, index;
 	DLFLVertexPtrArray vparray;
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp); // Reduced sensitivity for picking points
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	// viewport.reshape();
-	// viewport.apply_transform();
-	// glViewport(0,0,width(),height());
-	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderVerticesForSelect(object);
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	// std::cout <<  "hits = " << hits << "\n";
-	if ( hits > 0 ){
-		while ( hits ){
-			index = (hits-1)*4;
-			// if(DLFLObject::vparray[selectBuf[index+3]])
-				vparray.push_back(DLFLObject::vparray[selectBuf[index+3]]);
-			hits--;
-		}
-		return vparray;
-	}
-	vparray.clear();
+	object->pickIndex().pickVertices(pickRegion(mx,my,w,h),vparray,mSelectVisibleOnly);
 	return vparray;
 }
 
@@ -1077,345 +876,38 @@ DLFLLocatorPtr GLWidget::selectLocator(int mx, int my, int w, int h) // brianb
 
 // Subroutine for selecting an Edge
 DLFLEdgePtr GLWidget::selectEdge(int mx, int my,int w, int h) {
-	GLuint selectBuf[8192];
-	uint closest;
-	GLuint dist;
-	long hits, index;
-	DLFLEdgePtr sel(NULL);
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp);
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	// viewport.reshape();
-	// viewport.apply_transform();
-	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderEdgesForSelect(object);
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		closest = 0; dist = 0xffffffff;
-		while ( hits ){
-			index = (hits-1)*4;
-			if ( selectBuf[index+1] < dist ){
-				dist = selectBuf[index+1];
-				closest = selectBuf[index+3];
-			}
-			hits--;
-		}
-		// closest now has the id of the selected edge
-		sel = DLFLObject::eparray[closest];
-	}
-	return sel;
+	return object->pickIndex().pickEdge(pickRegion(mx,my,w,h));
 }
 
 // Subroutine for selecting an Edge
 DLFLEdgePtrArray GLWidget::selectEdges(int mx, int my,int w, int h) {
-	GLuint selectBuf[8192];
-	long hits, index;
-	DLFLEdgePtr sel(NULL);
 	DLFLEdgePtrArray eparray;
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp);
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	mCamera->SetProjection(width(),height());
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderEdgesForSelect(object);
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		while ( hits ){
-			index = (hits-1)*4;
-			// if(DLFLObject::eparray[selectBuf[index+3]])
-				eparray.push_back(DLFLObject::eparray[selectBuf[index+3]]);
-			hits--;
-		}
-		return eparray;
-	}
-	eparray.clear();
+	object->pickIndex().pickEdges(pickRegion(mx,my,w,h),eparray,mSelectVisibleOnly);
 	return eparray;
 }
 
 // Subroutine for selecting a Face
 DLFLFacePtr GLWidget::selectFace(int mx, int my, int w, int h) {
-	GLuint selectBuf[8192];
-	uint closest;
-	GLuint dist;
-	long hits, index;
-	DLFLFacePtr sel(NULL);
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp);
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	// glLoadIdentity();
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	// viewport.reshape();
-	// viewport.apply_transform();
-	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderFacesForSelect(object, isInPatchMode());
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		closest = 0; dist = 0xffffffff;
-		while ( hits ){
-			index = (hits-1)*4;
-			if ( selectBuf[index+1] < dist ){
-				dist = selectBuf[index+1];
-				closest = selectBuf[index+3];
-			}
-			hits--;
-		}
-		// closest now has the id of the selected face
-		sel = DLFLObject::fparray[closest];
-	}	
-	return sel;
+	return object->pickIndex().pickFace(pickRegion(mx,my,w,h));
 }
 
 // Subroutine for selecting multiple faces at once
 DLFLFacePtrArray GLWidget::selectFaces(int mx, int my, int w, int h) {
-	// glEnable(GL_CULL_FACE);
-	GLuint selectBuf[8192];
-	long hits, index;
-	DLFLFacePtr sel(NULL);
 	DLFLFacePtrArray fparray;
-	fparray.clear();
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp);
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	mCamera->SetProjection(width(),height());
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderFacesForSelect(object, isInPatchMode());
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	// std::cout << hits << " = hits\n";
-	if ( hits > 0 ){
-		while ( hits ){
-			index = (hits-1)*4;			
-			// if(DLFLObject::fparray[selectBuf[index+3]])
-			fparray.push_back(DLFLObject::fparray[selectBuf[index+3]]);
-			hits--;
-		}	
-		// glDisable(GL_CULL_FACE);
-		return fparray;		
-	}	
-	// glDisable(GL_CULL_FACE);
-	fparray.clear();
+	object->pickIndex().pickFaces(pickRegion(mx,my,w,h),fparray,DLFLPickIndex::NoCulling,mSelectVisibleOnly);
 	return fparray;
 }
 
 
-// Subroutine for selecting multiple faces at once
+// Subroutine for deselecting faces with the brush, back faces are culled
 // DLFLFacePtrArray GLWidget::deselectFaces(int mx, int my) {
 DLFLFacePtr GLWidget::deselectFaces(int mx, int my, int w, int h) {
-	glEnable(GL_CULL_FACE);
-	GLuint selectBuf[8192];
-	uint closest;
-	GLuint dist;
-	long hits, index;
-	DLFLFacePtr sel(NULL);
-	DLFLFacePtrArray fparray;
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,mBrushSize,mBrushSize,vp);
-
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	// glLoadIdentity();
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	// viewport.reshape();
-	// viewport.apply_transform();
-	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderFacesForSelect(object, isInPatchMode());
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		closest = 0; dist = 0xffffffff;
-		while ( hits ){
-			index = (hits-1)*4;
-			if ( selectBuf[index+1] < dist ){
-				dist = selectBuf[index+1];
-				closest = selectBuf[index+3];
-			}
-			
-			//if (DLFLObject::fparray[selectBuf[index+3]].normalCentroid()*camera.getPos()){
-			// if(isSelected(DLFLObject::fparray[selectBuf[index+3]]))
-				// fparray.push_back(DLFLObject::fparray[selectBuf[index+3]]);
-			//}
-			hits--;
-		}
-		// closest now has the id of the selected face
-		sel = DLFLObject::fparray[closest];
-	}	
-	glDisable(GL_CULL_FACE);
-	// return fparray;
-	return sel;
+	return object->pickIndex().pickFace(pickRegion(mx,my,mBrushSize,mBrushSize,true),DLFLPickIndex::CullBack);
 }
 
 // Subroutine for selecting a FaceVertex (Corner) within a Face
 DLFLFaceVertexPtr GLWidget::selectFaceVertex(DLFLFacePtr fp, int mx, int my, int w, int h) {
-	GLuint selectBuf[8192];
-	uint closest;
-	GLuint dist;
-	long hits, index;
-	DLFLFaceVertexPtr sel(NULL);
-
-	glSelectBuffer(8192,selectBuf);
-	glRenderMode(GL_SELECT);
-
-	glInitNames(); glPushName(0);
-
-	GLint vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	mCamera->enterSelectionMode(mx,my,w,h,vp);
-	// Make sure earlier matrices are preserved, since multiple windows
-	// seem to be sharing the same matrix stacks
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	// viewport.reshape();
-	// viewport.apply_transform();
-	mCamera->SetProjection(width(),height());
-	// viewport.apply_transform();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderFaceVerticesForSelect(fp);
-	glFlush();
-
-	glPopMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-
-	mCamera->leaveSelectionMode();
-
-	hits = glRenderMode(GL_RENDER);
-	if ( hits > 0 ){
-		closest = 0; dist = 0xffffffff;
-		while ( hits ){
-			index = (hits-1)*4;
-			if ( selectBuf[index+1] < dist ){
-				dist = selectBuf[index+1];
-				closest = selectBuf[index+3];
-			}
-			hits--;
-		}
-		// closest now has the id of the selected face vertex
-		sel = DLFLObject::fvparray[closest];
-	}
-	return sel;
+	return DLFLPickIndex::pickCorner(fp,pickRegion(mx,my,w,h));
 }
 
 // Draw the selected items
@@ -1426,38 +918,36 @@ void GLWidget::drawSelected(void) {
 
   if ( !object->sel_vptr_array.empty() ) {
     glPointSize(mSelectedVertexThickness);
-    //glBegin(GL_POINTS);
     glColor4f(mSelectedVertexColor.redF(),mSelectedVertexColor.greenF(),mSelectedVertexColor.blueF(),mSelectedVertexColor.alphaF());
-    DLFLVertexPtrArray::iterator first, last;
+    DLFLVertexPtrArray::const_iterator first, last;
     first = object->sel_vptr_array.begin(); last = object->sel_vptr_array.end();
+    glBegin(GL_POINTS);
     while ( first != last ){
-      GeometryRenderer::instance()->renderVertex(*first);
-      ///(*first)->render(); 
+      glVertex3dv((*first)->coords.getCArray());
       ++first;
     }
-    //glEnd();
+    glEnd();
     glPointSize(1.0);
   }
 
 	if ( !object->sel_eptr_array.empty() ){
 		glLineWidth(mSelectedEdgeThickness);
 		glColor4f(mSelectedEdgeColor.redF(),mSelectedEdgeColor.greenF(),mSelectedEdgeColor.blueF(),mSelectedEdgeColor.alphaF());
-		DLFLEdgePtrArray::iterator first, last;
+		DLFLEdgePtrArray::const_iterator first, last;
 		first = object->sel_eptr_array.begin(); last = object->sel_eptr_array.end();
+		glBegin(GL_LINES);
 		while ( first != last ){
-		  glBegin(GL_LINES); {
-		    GeometryRenderer::instance()->renderEdge(*first);
-		  } glEnd();
-		  ///(*first)->render(); 
+		  GeometryRenderer::instance()->renderEdge(*first);
 		  ++first;
 		}
+		glEnd();
 		glLineWidth(3.0);
 	}
 
 	if ( !object->sel_fptr_array.empty() ){
 	  glLineWidth(mSelectedEdgeThickness);
 	  glColor4f(mSelectedFaceColor.redF(),mSelectedFaceColor.greenF(),mSelectedFaceColor.blueF(),mSelectedFaceColor.alphaF());
-	  DLFLFacePtrArray::iterator first, last;
+	  DLFLFacePtrArray::const_iterator first, last;
 	  first = object->sel_fptr_array.begin(); last = object->sel_fptr_array.end();
 	  while ( first != last )	{
 	    GeometryRenderer::instance()->renderFace(*first,false);
@@ -1471,7 +961,7 @@ void GLWidget::drawSelected(void) {
 		glPointSize(mSelectedVertexThickness);
 		glColor4f(mSelectedVertexColor.redF(),mSelectedVertexColor.greenF(),mSelectedVertexColor.blueF(),mSelectedVertexColor.alphaF());
 		glBegin(GL_POINTS);
-		DLFLFaceVertexPtrArray::iterator first, last;
+		DLFLFaceVertexPtrArray::const_iterator first, last;
 		first = object->sel_fvptr_array.begin(); last = object->sel_fvptr_array.end();
 		while ( first != last ){
 		  GeometryRenderer::instance()->renderFaceVertex(*first,false);
@@ -1553,14 +1043,14 @@ void erase_dlp(DLFLLocatorPtr lp)  { delete lp; } // brianb
 void GLWidget::recomputeNormals(void)     // Recompute normals and lighting
 {
 	object->computeNormals();
-  if(mInPatchMode) computeLighting( object, patchObject, &plight, mUseGPU);
-  else computeLighting( object, NULL, &plight, mUseGPU);
+  if(mInPatchMode) computeLighting( object, patchObject, &plight, mUseGPU, &mLightingCache);
+  else computeLighting( object, NULL, &plight, mUseGPU, &mLightingCache);
 }
 
 void GLWidget::recomputeLighting(void)                // Recompute lighting
 {
-  if(mInPatchMode) computeLighting( object, patchObject, &plight, mUseGPU);
-  else computeLighting( object, NULL, &plight, mUseGPU);
+  if(mInPatchMode) computeLighting( object, patchObject, &plight, mUseGPU, &mLightingCache);
+  else computeLighting( object, NULL, &plight, mUseGPU, &mLightingCache);
 }
 
 void GLWidget::recomputePatches(void) // Recompute the patches for patch rendering
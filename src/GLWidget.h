@@ -19,6 +19,7 @@
 #include <QPushButton>
 
 #include <DLFLObject.h>
+#include <DLFLLabelLayout.h>
 #include "DLFLRenderer.h"
 #include "TMPatchObject.h"
 
@@ -169,6 +170,11 @@ public :
     this->repaint();
   }
 
+  void toggleHideOccludedIDs( ) {
+    mHideOccludedIDs = !mHideOccludedIDs;
+    this->repaint();
+  }
+
   void toggleBrush( ) {
     mShowBrush = !mShowBrush;
     this->repaint();
@@ -211,6 +217,11 @@ public :
 
   bool isBrushVisible(){ return mShowBrush; }
 
+      // Toggle whether window selections skip what is hidden behind faces
+  void toggleSelectVisibleOnly( ) {
+    mSelectVisibleOnly = !mSelectVisibleOnly;
+  }
+
       // Toggle object orientation
   void toggleObjectOrientation(void) {
     if ( renderer ) renderer->toggleObjectOrientation();
@@ -229,20 +240,23 @@ public :
   }
 
   void selectAllFaces(){
-    clearSelectedFaces();
-    object->getFaces(object->sel_fptr_array);
+    DLFLFacePtrArray all;
+    object->getFaces(all);
+    object->sel_fptr_array.assign(all);
     repaint();
   }
 
   void selectAllEdges(){
-    clearSelectedEdges();
-    object->getEdges(object->sel_eptr_array);
+    DLFLEdgePtrArray all;
+    object->getEdges(all);
+    object->sel_eptr_array.assign(all);
     repaint();
   }
 
   void selectAllVertices(){
-    clearSelectedVertices();
-    object->getVertices(object->sel_vptr_array);
+    DLFLVertexPtrArray all;
+    object->getVertices(all);
+    object->sel_vptr_array.assign(all);
     repaint();
   }
 
@@ -253,41 +267,53 @@ public :
   }
   
   void selectInverseFaces(){
-    DLFLFacePtrArray fparray;
-    vector<DLFLFacePtr>::iterator it;
-    object->getFaces(fparray);
-    for (it = fparray.begin(); it != fparray.end(); it++){
-      if (!isSelected(*it)){
-        addToSelection(*it);
-      }
-      else clearSelectedFace(*it);
-    }
+    DLFLFacePtrArray all;
+    object->getFaces(all);
+    object->sel_fptr_array.invert(all);
+    repaint();
+  }
+
+  void growSelectedFaces(){
+    object->sel_fptr_array.grow();
+    repaint();
+  }
+
+  void shrinkSelectedFaces(){
+    object->sel_fptr_array.shrink();
     repaint();
   }
 
   void selectInverseEdges(){
-    DLFLEdgePtrArray eparray;
-    vector<DLFLEdgePtr>::iterator it;
-    object->getEdges(eparray);
-    for (it = eparray.begin(); it != eparray.end(); it++){
-      if (!isSelected(*it)){
-        addToSelection(*it);
-      }
-      else clearSelectedEdge(*it);
-    }
+    DLFLEdgePtrArray all;
+    object->getEdges(all);
+    object->sel_eptr_array.invert(all);
+    repaint();
+  }
+
+  void growSelectedEdges(){
+    object->sel_eptr_array.grow();
+    repaint();
+  }
+
+  void shrinkSelectedEdges(){
+    object->sel_eptr_array.shrink();
     repaint();
   }
 
   void selectInverseVertices(){
-    DLFLVertexPtrArray vparray;
-    vector<DLFLVertexPtr>::iterator it;
-    object->getVertices(vparray);
-    for (it = vparray.begin(); it != vparray.end(); it++){
-      if (!isSelected(*it)){
-        addToSelection(*it);
-      }
-      else clearSelectedVertex(*it);
-    }
+    DLFLVertexPtrArray all;
+    object->getVertices(all);
+    object->sel_vptr_array.invert(all);
+    repaint();
+  }
+
+  void growSelectedVertices(){
+    object->sel_vptr_array.grow();
+    repaint();
+  }
+
+  void shrinkSelectedVertices(){
+    object->sel_vptr_array.shrink();
     repaint();
   }
     //maybe this isn't necessary? ??
@@ -326,6 +352,8 @@ public :
   void drawText( int width, int height );
   void drawIDs( QPainter *painter, const GLdouble *model, const GLdouble *proj, const GLint  *view);
   void drawSelectedIDs( QPainter *painter, const GLdouble *model, const GLdouble *proj, const GLint  *view);
+  DLFLLabelLayout labelLayout(const GLdouble *model, const GLdouble *proj, const GLint *view);
+  void drawIDLabel(QPainter *painter, const DLFLLabelLayout::Label& label, const QColor& color, int w, bool fade);
   void drawHUD(QPainter *painter);
   void drawBrush(QPainter *painter);
   void drawSelectionWindow(QPainter *painter);
@@ -350,10 +378,12 @@ public :
   bool mShowVertexIDs;
   bool mShowEdgeIDs;
   bool mShowSelectedIDs;
+  bool mHideOccludedIDs;
   bool mShowFaceVertexIDs;
   bool mShowHUD;
   bool mShowBrush;
   bool mShowSelectionWindow;
+  bool mSelectVisibleOnly;
   bool mUseGPU;
   bool mAntialiasing;
   int mBrushStartX;
@@ -382,6 +412,8 @@ public :
   
   //light is now a member of Glwidget instead of MainWindow
   PointLight plight;
+  // What the last lighting pass did, so the next one only relights what changed
+  LightingCache mLightingCache;
 
   // Each viewport will have its own grid
   // Grid grid;                                        // Display grid
@@ -470,19 +502,19 @@ public :
   }
 
   void addToSelection(DLFLVertexPtr vp) {
-    if ( vp ) object->sel_vptr_array.push_back(vp);
+    object->sel_vptr_array.insert(vp);
   }
 
   void addToSelection(DLFLEdgePtr ep) {
-    if ( ep ) object->sel_eptr_array.push_back(ep);
+    object->sel_eptr_array.insert(ep);
   }
 
   void addToSelection(DLFLFacePtr fp) {
-    if ( fp ) object->sel_fptr_array.push_back(fp);
+    object->sel_fptr_array.insert(fp);
   }
 
   void addToSelection(DLFLFaceVertexPtr fvp) {
-    if ( fvp ) object->sel_fvptr_array.push_back(fvp);
+    object->sel_fvptr_array.insert(fvp);
   }
 
     //--- Check if given item is there in the selection list ---//
@@ -502,55 +534,19 @@ public :
   }
 
   bool isSelected(DLFLVertexPtr vp) {
-    bool found = false;
-    if ( vp )
-    {
-      for (uint i=0; i < object->sel_vptr_array.size(); ++i)
-        if ( object->sel_vptr_array[i] == vp )
-      {
-        found = true; break;
-      }
-    }
-    return found;
+    return object->sel_vptr_array.contains(vp);
   }
 
   bool isSelected(DLFLEdgePtr ep) {
-    bool found = false;
-    if ( ep )
-    {
-      for (uint i=0; i < object->sel_eptr_array.size(); ++i)
-        if ( object->sel_eptr_array[i] == ep )
-      {
-        found = true; break;
-      }
-    }
-    return found;
+    return object->sel_eptr_array.contains(ep);
   }
 
   bool isSelected(DLFLFacePtr fp) {
-    bool found = false;
-    if ( fp )
-    {
-      for (uint i=0; i < object->sel_fptr_array.size(); ++i)
-        if ( object->sel_fptr_array[i] == fp )
-      {
-        found = true; break;
-      }
-    }
-    return found;
+    return object->sel_fptr_array.contains(fp);
   }
 
   bool isSelected(DLFLFaceVertexPtr fvp) {
-    bool found = false;
-    if ( fvp )
-    {
-      for (uint i=0; i < object->sel_fvptr_array.size(); ++i)
-        if ( object->sel_fvptr_array[i] == fvp )
-      {
-        found = true; break;
-      }
-    }
-    return found;
+    return object->sel_fvptr_array.contains(fvp);
   }
 
     //--- Set the selected item at given index ---//
@@ -565,75 +561,35 @@ public :
   }
 
   void setSelectedVertex(int index, DLFLVertexPtr vp) {
-    if ( vp && index >= 0 )
-    {
-      if ( (uint) index < object->sel_vptr_array.size() ) object->sel_vptr_array[index] = vp;
-      else object->sel_vptr_array.push_back(vp);
-    }
+    if ( index >= 0 ) object->sel_vptr_array.replace(index,vp);
   }
 
   void setSelectedEdge(int index, DLFLEdgePtr ep) {
-    if ( ep && index >= 0 )
-    {
-      if ( (uint) index < object->sel_eptr_array.size() ) object->sel_eptr_array[index] = ep;
-      else object->sel_eptr_array.push_back(ep);
-    }
+    if ( index >= 0 ) object->sel_eptr_array.replace(index,ep);
   }
 
   void setSelectedFace(int index, DLFLFacePtr fp) {
-    if ( fp && index >= 0 )
-    {
-      if ( (uint) index < object->sel_fptr_array.size() ) object->sel_fptr_array[index] = fp;
-      else object->sel_fptr_array.push_back(fp);
-    }
+    if ( index >= 0 ) object->sel_fptr_array.replace(index,fp);
   }
 
   void setSelectedFaceVertex(int index, DLFLFaceVertexPtr fvp) {
-    if ( fvp && index >= 0 )
-    {
-      if ( (uint) index < object->sel_fvptr_array.size() ) object->sel_fvptr_array[index] = fvp;
-      else object->sel_fvptr_array.push_back(fvp);
-    }
+    if ( index >= 0 ) object->sel_fvptr_array.replace(index,fvp);
   }
 
   void setSelectedVertex(DLFLVertexPtr vp) {
-    if ( vp )
-    {
-      if (!isSelected(vp)){
-        // if ( (uint) index < object->sel_vptr_array.size() ) object->sel_vptr_array[index] = vp;
-        object->sel_vptr_array.push_back(vp);
-      }
-    }
+    object->sel_vptr_array.insert(vp);
   }
 
   void setSelectedEdge(DLFLEdgePtr ep) {
-    if ( ep )
-    {
-      if (!isSelected(ep)){
-        // if ( (uint) index < object->sel_eptr_array.size() ) object->sel_eptr_array[index] = ep;
-         object->sel_eptr_array.push_back(ep);
-      }
-    }
+    object->sel_eptr_array.insert(ep);
   }
 
   void setSelectedFace(DLFLFacePtr fp) {
-    if ( fp )
-    {
-      if (!isSelected(fp)){
-        // if ( (uint) index < object->sel_fptr_array.size() ) object->sel_fptr_array[index] = fp;
-        object->sel_fptr_array.push_back(fp);
-      }
-    }
+    object->sel_fptr_array.insert(fp);
   }
 
   void setSelectedFaceVertex(DLFLFaceVertexPtr fvp) {
-    if ( fvp )
-    {
-      if (!isSelected(fvp)){
-        // if ( (uint) index < object->sel_fvptr_array.size() ) object->sel_fvptr_array[index] = fvp;
-        object->sel_fvptr_array.push_back(fvp);
-      }
-    }
+    object->sel_fvptr_array.insert(fvp);
   }
 
     //--- Return the selected items at given index ---//
@@ -727,44 +683,19 @@ void clearSelectedCorners(void) {
 }
 
 void clearSelectedFace(DLFLFacePtr fp){
-  vector<DLFLFacePtr>::iterator fiterator;
-  for(fiterator = object->sel_fptr_array.begin(); fiterator != object->sel_fptr_array.end(); fiterator++) {
-    if (fp == *fiterator){
-      // delete fp;
-      object->sel_fptr_array.erase(fiterator);
-      return;
-    }
-  }
+  object->sel_fptr_array.remove(fp);
 }
 
 void clearSelectedEdge(DLFLEdgePtr ep){
-  vector<DLFLEdgePtr>::iterator it;
-  for(it = object->sel_eptr_array.begin(); it != object->sel_eptr_array.end(); it++) {
-    if (ep == *it){
-      object->sel_eptr_array.erase(it);
-      return;
-    }
-  }
+  object->sel_eptr_array.remove(ep);
 }
 
 void clearSelectedVertex(DLFLVertexPtr vp){
-  vector<DLFLVertexPtr>::iterator it;
-  for(it = object->sel_vptr_array.begin(); it != object->sel_vptr_array.end(); it++) {
-    if (vp == *it){
-      object->sel_vptr_array.erase(it);
-      return;
-    }
-  }
+  object->sel_vptr_array.remove(vp);
 }
 
 void clearSelectedFaceVertex(DLFLFaceVertexPtr fvp){
-  vector<DLFLFaceVertexPtr>::iterator it;
-  for(it = object->sel_fvptr_array.begin(); it != object->sel_fvptr_array.end(); it++) {
-    if (fvp == *it){
-      object->sel_fvptr_array.erase(it);
-      return;
-    }
-  }
+  object->sel_fvptr_array.remove(fvp);
 }
 
 void clearSelectedFaceVertices(void) {
@@ -855,6 +786,10 @@ void dropEvent(QDropEvent *event);
 
 private :
 
+// The part of the view w by h pixels around the mouse, for picking. If
+// round only the ellipse inside, as the brush is drawn.
+DLFLPickIndex::Region pickRegion(int mx, int my, int w, int h, bool round = false);
+
 bool   mInPatchMode;
 friend class QGLFormat;
 QColor mGlobalAmbient;
@@ -1,5 +1,7 @@
 /*** ***/
 
+#include <cstddef>
+#include <QGLContext>
 #include "GeometryRenderer.h"
 #include "DLFLRenderer.h"
 
@@ -21,34 +23,181 @@ static void transform( DLFLObjectPtr obj ) {
 	glMultMatrixd(mat);
 }
 
+// Vertex buffer objects are OpenGL 1.5, the headers on some platforms stop
+// at 1.1, so the functions are looked up at run time. Without them the
+// render buffers are drawn from client memory.
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+typedef void (APIENTRY *GenBuffersFunc)( GLsizei n, GLuint *buffers );
+typedef void (APIENTRY *BindBufferFunc)( GLenum target, GLuint buffer );
+typedef void (APIENTRY *BufferDataFunc)( GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage );
+typedef void (APIENTRY *BufferSubDataFunc)( GLenum target, ptrdiff_t offset, ptrdiff_t size, const GLvoid *data );
+
+static GenBuffersFunc genBuffers = 0;
+static BindBufferFunc bindBuffer = 0;
+static BufferDataFunc bufferData = 0;
+static BufferSubDataFunc bufferSubData = 0;
+
+// Look up the buffer functions in the current context, true if it has them
+static bool resolveBufferFunctions( const QGLContext *context ) {
+	genBuffers = (GenBuffersFunc) context->getProcAddress("glGenBuffers");
+	bindBuffer = (BindBufferFunc) context->getProcAddress("glBindBuffer");
+	bufferData = (BufferDataFunc) context->getProcAddress("glBufferData");
+	bufferSubData = (BufferSubDataFunc) context->getProcAddress("glBufferSubData");
+	if ( !genBuffers || !bindBuffer || !bufferData || !bufferSubData ) {
+		genBuffers = (GenBuffersFunc) context->getProcAddress("glGenBuffersARB");
+		bindBuffer = (BindBufferFunc) context->getProcAddress("glBindBufferARB");
+		bufferData = (BufferDataFunc) context->getProcAddress("glBufferDataARB");
+		bufferSubData = (BufferSubDataFunc) context->getProcAddress("glBufferSubDataARB");
+	}
+	return ( genBuffers && bindBuffer && bufferData && bufferSubData );
+}
+
+#ifdef GPU_OK
+static void setMaterialParameters( DLFLMaterialPtr mat ) {
+	double Ka = mat->Ka;
+	double Kd = mat->Kd;
+	double Ks = mat->Ks;
+	RGBColor basecolor = mat->color;
+
+	cgSetParameter3f(CgData::instance()->basecolor, basecolor.r, basecolor.g, basecolor.b);
+	cgSetParameter3f(CgData::instance()->Ka, Ka, Ka, Ka);
+	cgSetParameter3f(CgData::instance()->Kd, Kd, Kd, Kd);
+	cgSetParameter3f(CgData::instance()->Ks, Ks, Ks, Ks);
+	cgSetParameter1f(CgData::instance()->shininess, 50);
+}
+#endif
+
 void GeometryRenderer::render( DLFLObjectPtr obj ) const {
 	// std::cout << "usegpu  = " << useGPU << "\n";
 	DLFLMaterialPtrList::iterator mp_it;
 	DLFLFacePtrList::iterator fp_it;
 	glPushMatrix( ); {
 		transform( obj );
-		for( mp_it = obj->beginMaterial(); mp_it != obj->endMaterial(); mp_it++ ) {
-			DLFLMaterialPtr mat = *mp_it;
-			for( fp_it = mat->faces.begin(); fp_it != mat->faces.end(); fp_it++ ) {
-        renderFace( *fp_it );
+		if ( !useOutline ) {
+			renderBuffers( obj );
+		} else {
+			for( mp_it = obj->beginMaterial(); mp_it != obj->endMaterial(); mp_it++ ) {
+				DLFLMaterialPtr mat = *mp_it;
+				for( fp_it = mat->faces.begin(); fp_it != mat->faces.end(); fp_it++ ) {
+					renderFace( *fp_it );
+				}
 			}
 		}
 	} glPopMatrix( );
 }
 
+// The color renderFaceVertex would give the corners
+DLFLRenderBuffers::ColorSource GeometryRenderer::colorSource( ) const {
+	if ( useLighting && useMaterial ) {
+		#ifdef GPU_OK
+		if ( useGPU ) return DLFLRenderBuffers::BaseColor;
+		#endif
+		return DLFLRenderBuffers::ModulatedCornerColor;
+	}
+	if ( useColorable ) return DLFLRenderBuffers::MaterialColor;
+	if ( useMaterial ) return DLFLRenderBuffers::BaseColor;
+	if ( useLighting ) return DLFLRenderBuffers::CornerColor;
+	return DLFLRenderBuffers::NoColor;
+}
+
+// Bring the bound buffer object from revision uploaded to the given
+// revision of an array, sending only the patched ranges when it can
+static void uploadArray( unsigned long& uploaded, unsigned long revision, bool patched,
+												 unsigned long patchedFrom, const std::vector<DLFLRenderBuffers::Range>& ranges,
+												 const char *data, size_t size, size_t stride ) {
+	if ( uploaded == revision ) return;
+	if ( patched && uploaded == patchedFrom ) {
+		// Only send what a local edit rewrote
+		for( size_t i = 0; i < ranges.size(); ++i ) {
+			bufferSubData( GL_ARRAY_BUFFER, ranges[i].first*stride, ranges[i].count*stride,
+										 data + ranges[i].first*stride );
+		}
+	} else {
+		bufferData( GL_ARRAY_BUFFER, size*stride, data, GL_STATIC_DRAW );
+	}
+	uploaded = revision;
+}
+
+bool GeometryRenderer::haveBuffers( ) const {
+	// A new context (the widget was recreated) has none of our buffers
+	const QGLContext *context = QGLContext::currentContext( );
+	if ( context != mBufferContext ) {
+		mHaveBuffers = context && resolveBufferFunctions( context );
+		mBuffer = 0; mBufferRevision = 0;
+		for( int i = 0; i < DLFLOverlayBuffers::NumKinds; ++i ) {
+			mOverlayBuffer[i] = 0; mOverlayRevision[i] = 0;
+		}
+		mBufferContext = context;
+	}
+	return mHaveBuffers;
+}
+
+void GeometryRenderer::renderBuffers( DLFLObjectPtr obj ) const {
+	typedef DLFLRenderBuffers::Vertex Vertex;
+	DLFLRenderBuffers& buffers = obj->renderBuffers( );
+	DLFLRenderBuffers::ColorSource source = colorSource( );
+	buffers.update( source, renderColor );
+	const std::vector<Vertex>& vertices = buffers.vertices( );
+
+	// Attribute pointers are offsets into the buffer object, or addresses
+	const char *base = 0;
+	if ( haveBuffers( ) ) {
+		if ( mBuffer == 0 ) genBuffers( 1, &mBuffer );
+		bindBuffer( GL_ARRAY_BUFFER, mBuffer );
+		uploadArray( mBufferRevision, buffers.revision(), buffers.patched(), buffers.patchedFrom(),
+								 buffers.patchedRanges(), (const char *) (vertices.empty() ? 0 : &vertices[0]),
+								 vertices.size(), sizeof(Vertex) );
+	} else if ( !vertices.empty() ) {
+		base = (const char *) &vertices[0];
+	}
+
+	glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT ); {
+		GLsizei stride = sizeof(Vertex);
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, stride, base + offsetof(Vertex,position) );
+		if( useNormal ) {
+			glEnableClientState( GL_NORMAL_ARRAY );
+			glNormalPointer( GL_FLOAT, stride, base + offsetof(Vertex,normal) );
+		}
+		if( source != DLFLRenderBuffers::NoColor ) {
+			glEnableClientState( GL_COLOR_ARRAY );
+			glColorPointer( 4, GL_FLOAT, stride, base + offsetof(Vertex,color) );
+		}
+		if( useTexture ) {
+			glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+			glTexCoordPointer( 2, GL_FLOAT, stride, base + offsetof(Vertex,texcoord) );
+		}
+		const std::vector<DLFLRenderBuffers::Batch>& batches = buffers.batches( );
+		for( size_t i = 0; i < batches.size(); ++i ) {
+			if ( batches[i].count == 0 ) continue;
+			#ifdef GPU_OK
+			if ( useGPU ) setMaterialParameters( batches[i].material );
+			#endif
+			glDrawArrays( GL_TRIANGLES, batches[i].first, batches[i].count );
+		}
+	} glPopClientAttrib( );
+	if ( mHaveBuffers ) bindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	// Faces too small for triangles are drawn as points and lines
+	const DLFLFacePtrArray& smallFaces = buffers.smallFaces( );
+	for( size_t i = 0; i < smallFaces.size(); ++i ) {
+		renderFace( smallFaces[i] );
+	}
+}
+
 void GeometryRenderer::renderFace( DLFLFacePtr df, bool useAttrs ) const {
 	#ifdef GPU_OK
 	if (useGPU){
-		double Ka = df->material()->Ka;
-		double Kd = df->material()->Kd;
-		double Ks = df->material()->Ks;
-		RGBColor basecolor = df->material()->color;
-
-		cgSetParameter3f(CgData::instance()->basecolor, basecolor.r, basecolor.g, basecolor.b);
-		cgSetParameter3f(CgData::instance()->Ka, Ka, Ka, Ka);
-	  cgSetParameter3f(CgData::instance()->Kd, Kd, Kd, Kd);
-	  cgSetParameter3f(CgData::instance()->Ks, Ks, Ks, Ks);
-	  cgSetParameter1f(CgData::instance()->shininess, 50);
+		setMaterialParameters( df->material() );
 	}
 	#endif
 	if( useAttrs ) {
@@ -120,32 +269,49 @@ void GeometryRenderer::renderVertex( DLFLVertexPtr dvp ) const {
 }
 
 void GeometryRenderer::renderVertices( DLFLObjectPtr obj, double size ) const {
-	DLFLVertexPtrList::iterator it;
 	// Just render all the vertices with specified point size
 	glPushMatrix(); {
 		transform( obj );
 		glPointSize( size );
-		for( it = obj->beginVertex(); it != obj->endVertex(); it++ ) {
-			renderVertex( *it );
-		}
+		renderOverlay( obj, DLFLOverlayBuffers::Vertices, GL_POINTS );
 		glPointSize(1.0);
 	} glPopMatrix();
 }
 
 void GeometryRenderer::renderEdges( DLFLObjectPtr obj, double width ) const {
-	DLFLEdgePtrList::iterator it;
 // Just render all the edges with specified line width
 	glPushMatrix(); {
 		transform( obj );
 		glLineWidth( width );
-		glBegin(GL_LINES);
-		for( it = obj->beginEdge(); it != obj->endEdge(); it++ ) {
-			renderEdge( *it );
-		}
-		glEnd();
+		renderOverlay( obj, DLFLOverlayBuffers::Edges, GL_LINES );
 		glLineWidth(1.0);
-		glPopMatrix();
+	} glPopMatrix();
+}
+
+void GeometryRenderer::renderOverlay( DLFLObjectPtr obj, DLFLOverlayBuffers::Kind kind,
+																			GLenum mode, double length ) const {
+	typedef DLFLOverlayBuffers::Point Point;
+	const DLFLOverlayBuffers::Array& array = obj->overlayBuffers().update( kind, length );
+	const std::vector<Point>& points = array.points( );
+	if ( array.count() == 0 ) return;
+
+	// Same as the faces, see renderBuffers
+	const char *base = 0;
+	if ( haveBuffers( ) ) {
+		if ( mOverlayBuffer[kind] == 0 ) genBuffers( 1, &mOverlayBuffer[kind] );
+		bindBuffer( GL_ARRAY_BUFFER, mOverlayBuffer[kind] );
+		uploadArray( mOverlayRevision[kind], array.revision(), array.patched(), array.patchedFrom(),
+								 array.patchedRanges(), (const char *) &points[0], points.size(), sizeof(Point) );
+	} else {
+		base = (const char *) &points[0];
 	}
+
+	glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT ); {
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, sizeof(Point), base + offsetof(Point,position) );
+		glDrawArrays( mode, 0, array.count() );
+	} glPopClientAttrib( );
+	if ( mHaveBuffers ) bindBuffer( GL_ARRAY_BUFFER, 0 );
 }
 
 // if( drawFaceCentroids || drawFaceNormals )
@@ -166,36 +332,19 @@ void GeometryRenderer::renderEdges( DLFLObjectPtr obj, double width ) const {
 // } 
 // 
 void GeometryRenderer::renderFaceCentroids( DLFLObjectPtr obj, double size ) const {
-	DLFLFacePtrList::iterator it;
 	glPushMatrix(); {
 		transform( obj );
 		glPointSize( size );
-		glBegin(GL_POINTS);
-		for( it = obj->beginFace(); it != obj->endFace(); it++ ) {
-			(*it)->updateCentroid( );
-			// renderVertex( *it );
-			glVertex3dv( (*it)->centroid.getCArray() ); 
-		}
-		glEnd();
+		renderOverlay( obj, DLFLOverlayBuffers::Centroids, GL_POINTS );
 		glPointSize(1.0);
 	}	glPopMatrix();
 }
 
 void GeometryRenderer::renderFaceNormals( DLFLObjectPtr obj, double width, double length ) const {
-	DLFLFacePtrList::iterator it;
 	glPushMatrix(); {
 		transform( obj );
 		glLineWidth( width );
-		glBegin(GL_LINES);
-		for( it = obj->beginFace(); it != obj->endFace(); it++ ) {
-			// renderEdge( *it );
-			(*it)->updateCentroid( );
-			// (*it)->updateNormal();
-			Vector3d norm = (*it)->centroid + ((*it)->getNormal() * length);
-			glVertex3dv( (*it)->centroid.getCArray() );
-			glVertex3dv( norm.getCArray() );			
-		}
-		glEnd();
+		renderOverlay( obj, DLFLOverlayBuffers::Normals, GL_LINES, length );
 		glLineWidth(1.0);
 	}	glPopMatrix();
 	// glPushAttrib( GL_CURRENT_BIT );
@@ -30,12 +30,18 @@ public :
   //void setObject( DLFLObjectPtr obj ) { mObj = obj; };
   static void glBeginFace( int num, bool outline = false );
 
+  // Draws the faces from the render buffers of the object (see
+  // DLFLRenderBuffers), which are kept in a vertex buffer object on the
+  // graphics card. After a local edit only the changed parts are sent
+  // again. With useOutline the faces are drawn one by one.
   void render( DLFLObjectPtr obj ) const;
   void renderFace( DLFLFacePtr dfp, bool useAttrs = true ) const;
   void renderFaceVertex( DLFLFaceVertexPtr dfvp, bool useAttrs = true ) const;
   void renderEdge( DLFLEdgePtr dep ) const;
   void renderVertex( DLFLVertexPtr dvp ) const;
 
+  // The overlays are drawn from the overlay buffers of the object (see
+  // DLFLOverlayBuffers), kept on the graphics card like the faces
   void renderVertices( DLFLObjectPtr obj, double size = 5.0 ) const;
   void renderEdges( DLFLObjectPtr obj, double width = 1.0 ) const;
 	void renderFaceNormals( DLFLObjectPtr obj, double width, double length ) const;
@@ -67,13 +73,33 @@ public :
 private :
   //DLFLObjectPtr mObj;
 
+  void renderBuffers( DLFLObjectPtr obj ) const;
+  void renderOverlay( DLFLObjectPtr obj, DLFLOverlayBuffers::Kind kind, GLenum mode,
+                      double length = 0.0 ) const;
+  DLFLRenderBuffers::ColorSource colorSource( ) const;
+  // Whether the current context has buffer objects. Forgets the buffers of
+  // the previous context.
+  bool haveBuffers( ) const;
+
+  // Vertex buffer objects holding the last render and overlay buffers drawn
+  mutable bool mHaveBuffers;                     // The context has buffer objects
+  mutable GLuint mBuffer;
+  mutable unsigned long mBufferRevision;
+  mutable GLuint mOverlayBuffer[DLFLOverlayBuffers::NumKinds];
+  mutable unsigned long mOverlayRevision[DLFLOverlayBuffers::NumKinds];
+  mutable const void *mBufferContext;            // GL context of the buffers
+
   static GeometryRenderer *mInstance;
   GeometryRenderer( bool gpu = false) : useMaterial(false), useColorable(false), useLighting(false), 
 				       useNormal(false), useTexture(false), antialiasing(false),
 							useOutline(false), drawFaceCentroids(false), drawVertices(false),
 							drawSilhouette(false),drawWireframe(true),
-				       drawFaceNormals(false), isReversed(false), useGPU(gpu) {
+				       drawFaceNormals(false), isReversed(false), useGPU(gpu),
+				       mHaveBuffers(false), mBuffer(0), mBufferRevision(0), mBufferContext(0) {
     renderColor = new GLdouble[4];
+    for( int i = 0; i < DLFLOverlayBuffers::NumKinds; ++i ) {
+      mOverlayBuffer[i] = 0; mOverlayRevision[i] = 0;
+    }
   };
 };
 
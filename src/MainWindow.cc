@@ -4,12 +4,12 @@
  **
  ****************************************************************************/
 
-#include <ctime>
-
 #include <QtGui>
 #include <QtOpenGL>
 
 #include "MainWindow.h"
+#include "DLFLProgressDialog.h"
+#include "DLFLTimer.h"
 #include "hermite_connect_faces.h"
 
 /*!
@@ -116,6 +116,8 @@ int MainWindow::column_segments = 4;
 double MainWindow::twist_factor = 0.0;
 double MainWindow::weight_factor = 0.0;
 bool MainWindow::doo_sabin_check = true;
+int MainWindow::doo_sabin_levels = 1;
+int MainWindow::catmull_clark_levels = 1;
 double MainWindow::vertex_cutting_offset = 0.25;
 double MainWindow::pentagonal_offset = 0.0;
 double MainWindow::pentagonal_scale = 0.75;
@@ -211,7 +213,7 @@ QColor MainWindow::paint_bucket_color = QColor(0.5,0.5,0.5);
  * asdflkjasdf
  * asdfl;jkas;df
  **/
-MainWindow::MainWindow(char *filename) : object(), mode(NormalMode), undoList(), undoMtlList(), redoList(), redoMtlList(),
+MainWindow::MainWindow(char *filename) : object(), mode(NormalMode), undoList(), redoList(),
 																				 undolimit(20), useUndo(true), mIsModified(false), mIsPrimitive(false), mWasPrimitive(false), mSpinBoxMode(None) {
 
 	// i18n stuff
@@ -610,6 +612,13 @@ void MainWindow::createActions() {
 	connect(mShowSelectedIDsAct, SIGNAL(triggered()), this->getActive(), SLOT(toggleSelectedIDs()));
 	mActionListWidget->addAction(mShowSelectedIDsAct);
 
+	mHideOccludedIDsAct = new QAction(tr("Hide &Occluded IDs"), this);
+	mHideOccludedIDsAct->setCheckable(true);
+	mHideOccludedIDsAct->setChecked(true);
+	sm->registerAction(mHideOccludedIDsAct, "Display Menu", "");
+	connect(mHideOccludedIDsAct, SIGNAL(triggered()), this->getActive(), SLOT(toggleHideOccludedIDs()));
+	mActionListWidget->addAction(mHideOccludedIDsAct);
+
 	showSilhouetteAct = new QAction(tr("Show &Silhouette"), this);
 	showSilhouetteAct->setCheckable(true);
 	sm->registerAction(showSilhouetteAct, "Display Menu", "S" );
@@ -887,6 +896,18 @@ void MainWindow::createActions() {
 	connect(makeObjectSmoothAct, SIGNAL(triggered()), this, SLOT(smoothMesh()));
 	mActionListWidget->addAction(makeObjectSmoothAct);
 
+	mCatmullClarkLimitAct = new QAction(tr("Project to Catmull-Clark Limit"), this);
+	mCatmullClarkLimitAct->setStatusTip(tr("Move the vertices to the limit surface of Catmull-Clark subdivision"));
+	sm->registerAction(mCatmullClarkLimitAct, "Tools", "");
+	connect(mCatmullClarkLimitAct, SIGNAL(triggered()), this, SLOT(projectToCatmullClarkLimit()));
+	mActionListWidget->addAction(mCatmullClarkLimitAct);
+
+	mDooSabinLimitAct = new QAction(tr("Project to Doo-Sabin Limit"), this);
+	mDooSabinLimitAct->setStatusTip(tr("Move the vertices to the limit surface of Doo-Sabin subdivision"));
+	sm->registerAction(mDooSabinLimitAct, "Tools", "");
+	connect(mDooSabinLimitAct, SIGNAL(triggered()), this, SLOT(projectToDooSabinLimit()));
+	mActionListWidget->addAction(mDooSabinLimitAct);
+
 	mPerformCuttingAct = new QAction(tr("Perform Cutting"), this);
 	sm->registerAction(mPerformCuttingAct, "Tools", "CTRL+T");
 	mPerformCuttingAct->setStatusTip(tr("Cut selected faces, edges, or vertices based on the current selection mask"));
@@ -947,6 +968,12 @@ void MainWindow::createActions() {
 	connect( mSelectionWindowAct , SIGNAL( triggered() ), this, SLOT( selection_window() ) );
 	mActionListWidget->addAction(mSelectionWindowAct);
 
+	mSelectVisibleOnlyAct = new QAction(tr("Select Visible Only"), this);
+	mSelectVisibleOnlyAct->setCheckable(true);
+	sm->registerAction(mSelectVisibleOnlyAct, "Selection", "");
+	connect( mSelectVisibleOnlyAct , SIGNAL( triggered() ), this->getActive(), SLOT( toggleSelectVisibleOnly() ) );
+	mActionListWidget->addAction(mSelectVisibleOnlyAct);
+
 	selectVertexAct = new QAction(tr("Select &Vertex"), this);
 	sm->registerAction(selectVertexAct, "Selection", "");
 	selectVertexAct->setStatusTip(tr("Select a Vertex"));
@@ -1432,6 +1459,7 @@ void MainWindow::createMenus(){
 	mShowIDsMenu->addAction(mShowEdgeIDsAct);
 	mShowIDsMenu->addAction(mShowVertexIDsAct);
 	mShowIDsMenu->addAction(mShowSelectedIDsAct);
+	mShowIDsMenu->addAction(mHideOccludedIDsAct);
 	//more view options
 	mDisplayMenu->addAction(showSilhouetteAct);
 	mDisplayMenu->addAction(showWireframeAct);
@@ -1467,6 +1495,7 @@ void MainWindow::createMenus(){
 	mSelectionMenu->addAction(mSelectMultipleAct);
 	mSelectionMenu->addAction(mSelectSimilarAct);
 	mSelectionMenu->addAction(mSelectionWindowAct);
+	mSelectionMenu->addAction(mSelectVisibleOnlyAct);
 	mSelectionMenu->addAction(mSelectComponentAct);
 	mSelectionMenu->addAction(mGrowSelectionAct);
 	mSelectionMenu->addAction(mShrinkSelectionAct);
@@ -1536,6 +1565,8 @@ void MainWindow::createMenus(){
 	mObjectMenu->addAction(planarizeAllFacesAct);
 	mObjectMenu->addAction(makeObjectSphericalAct);
 	mObjectMenu->addAction(makeObjectSmoothAct);
+	mObjectMenu->addAction(mCatmullClarkLimitAct);
+	mObjectMenu->addAction(mDooSabinLimitAct);
 	mObjectMenu->addSeparator();
 	mObjectMenu->addAction(mCleanupWingedVerticesAct);
 	mObjectMenu->addAction(mCleanup2gonsAct);
@@ -1949,7 +1980,7 @@ void MainWindow::openFile(QString fileName){
 		setModified(false);
 	}
 
-	readObject(filename);
+	if ( !readObject(filename) ) return;
 #ifdef WITH_PYTHON
 	DLFLObjectPtr obj = &object;
 	if( obj )
@@ -2160,6 +2191,7 @@ void MainWindow::doDrag(int x, int y) { // brianb
 					}
 
 				vptr->setCoords(Vector3d(obj_world[0],obj_world[1],obj_world[2]));
+				object.changedVertex(vptr);
 
 				// Reset drag start points
 				startDrag(drag_endx,drag_endy);
@@ -2296,7 +2328,6 @@ void MainWindow::doSelection(int x, int y) {
 			svptrarr.clear();
 		}
 		else {
-			svptr = active->selectVertex(x,y);
 			if ( !active->isSelected(svptr)){
 				active->setSelectedVertex(svptr);
 				num_sel_verts++;
@@ -2592,7 +2623,6 @@ void MainWindow::doSelection(int x, int y) {
 			sfptrarr.clear();
 		}
 		else {
-			sfptr = active->selectFace(x,y);
 			if ( !active->isSelected(sfptr)){
 				active->setSelectedFace(num_sel_faces,sfptr);
 				num_sel_faces++;
@@ -3044,6 +3074,7 @@ void MainWindow::mouseReleaseEvent(QMouseEvent *event)  {
 						// first search for the material in the existing list
 						// DLFLMaterialPtr m = object.findMaterial(RGBColor(paint_bucket_color.redF(),paint_bucket_color.greenF(),paint_bucket_color.blueF() ));
 						fp->setMaterial(object.addMaterial(RGBColor(paint_bucket_color.redF(),paint_bucket_color.greenF(),paint_bucket_color.blueF())) );
+						object.changedFace(fp);
 						// if ( m ){
 						//
 						// }
@@ -3854,20 +3885,22 @@ void MainWindow::performExtrusion(){
 	if ( active->numSelectedFaces() >= 1 ) {
 		DLFLFacePtrArray sfptrarr = active->getSelectedFaces();
 		if ( sfptrarr[0] ) {
-      // Fenghui's simple profiler for Extrusion operation.
-      std::clock_t start = std::clock();
-      std::clock_t op = std::clock();
-      std::clock_t recompute_patches = std::clock();
-      std::clock_t recompute_normals = std::clock();
-
+			DLFLTimer timer("Extrusion");
 
 			undoPush();
 			setModified(true);
+			// The common extrusions are done for all faces in one batch,
+			// the others one face at a time
+			bool batched = true;
+			if ( extrusionmode == DooSabinExtrude )
+				DLFL::extrudeFacesDS(&object,sfptrarr,extrude_dist,num_extrusions,ds_ex_twist,extrude_scale);
+			else if ( extrusionmode == CubicalExtrude && !scherk_collins )
+				DLFL::extrudeFaces(&object,sfptrarr,extrude_dist,num_extrusions,extrude_rot,extrude_scale,triangulate_new_faces);
+			else
+				batched = false;
 			vector<DLFLFacePtr>::iterator it;
-			for (it = sfptrarr.begin(); it != sfptrarr.end(); it++) {
+			for (it = sfptrarr.begin(); !batched && it != sfptrarr.end(); it++) {
 				switch (extrusionmode){
-					case DooSabinExtrude: DLFL::extrudeFaceDS(&object,*it,extrude_dist,num_extrusions,ds_ex_twist,extrude_scale);
-							break;
 					case CubicalExtrude:
             /*DLFL::extrudeFace(&object, *it, extrude_dist, num_extrusions,
                               extrude_rot, extrude_scale, triangulate_new_faces,
@@ -3904,22 +3937,13 @@ void MainWindow::performExtrusion(){
 							break;
 						};
 					}
-          //Fenghui, record the time after the operation
-          op = std::clock();
+					timer.step();
 
-          active->recomputePatches();
-          // Fenghui, record the time after compute patches.
-          recompute_patches = std::clock();
+					active->recomputePatches();
+					timer.step();
 
 					active->recomputeNormals();
-          recompute_normals = std::clock();
-          // Fenghui, output the time taken to perform each steps.
-          cout << "Extrusion:" << (op - start) / (double)CLOCKS_PER_SEC
-               << ":" << (recompute_patches - op) / (double)CLOCKS_PER_SEC
-               << ":" << (recompute_normals - recompute_patches) / (double)CLOCKS_PER_SEC
-               << ":" << (std::clock() - recompute_normals) / (double)CLOCKS_PER_SEC
-               << endl;
-          // Fenghui's simple profiler for Extrusion, end!
+					timer.print();
 				}
 			active->clearSelectedFaces();
 			redraw();
@@ -4351,17 +4375,28 @@ void MainWindow::setRemeshingScheme(RemeshingScheme scheme) {
 }
 
 // Read the DLFL object from a file
-void MainWindow::readObject(const char * filename, const char *mtlfilename) {
+bool MainWindow::readObject(const char * filename, const char *mtlfilename) {
 	active->clearSelected();
 	ifstream file, mtlfile;
 	file.open(filename);
 	mtlfile.open(mtlfilename);
 
-	if ( strstr(filename,".dlfl") || strstr(filename,".DLFL") )
-		object.readDLFL(file, mtlfile);
-	else if ( strstr(filename,".obj") || strstr(filename,".OBJ") )
-		object.readObject(file, mtlfile);
+	bool dlfl = ( strstr(filename,".dlfl") || strstr(filename,".DLFL") );
+	bool read = false;
+	if ( dlfl || strstr(filename,".obj") || strstr(filename,".OBJ") ) {
+		// The file is read into a new object on a worker thread, which only
+		// replaces ours once all of the file was read
+		DLFLObject newobject;
+		DLFLReadThread worker(&newobject,file,mtlfile,dlfl);
+		read = runWithProgress(tr("Reading %1").arg(filename),worker);
+		if ( read ) object.swap(newobject);
+		else if ( worker.cancelled() )
+			statusBar()->showMessage(tr("Reading %1 cancelled").arg(filename), 2000);
+		else
+			statusBar()->showMessage(tr("Could not read %1").arg(filename), 2000);
+	}
 	file.close();
+	return read;
 }
 
 // Read the DLFL object from a file
@@ -4407,7 +4442,7 @@ void MainWindow::readObjectAlt(const char * filename) {
 }
 
 // Write the DLFL object to a file
-void MainWindow::writeObject(const char * filename, const char* mtlfilename, bool with_normals, bool with_tex_coords) {
+bool MainWindow::writeObject(const char * filename, const char* mtlfilename, bool with_normals, bool with_tex_coords) {
 	ofstream file;
 	ofstream mtlfile;
 	file.open(filename);
@@ -4415,13 +4450,20 @@ void MainWindow::writeObject(const char * filename, const char* mtlfilename, boo
 
 	std::cout << mtlfilename << " = mtlfilename in writeObject function\n";
 
-	if ( strstr(filename,".dlfl") || strstr(filename,".DLFL") )
-		object.writeDLFL(file, mtlfile);
-	else if ( strstr(filename,".obj") || strstr(filename,".OBJ") ){
-		object.writeObject(file, mtlfile, with_normals,with_tex_coords);
+	bool dlfl = ( strstr(filename,".dlfl") || strstr(filename,".DLFL") );
+	bool wrote = true;
+	if ( dlfl || strstr(filename,".obj") || strstr(filename,".OBJ") ) {
+		DLFLWriteThread worker(&object,file,mtlfile,dlfl,with_normals,with_tex_coords);
+		wrote = runWithProgress(tr("Saving %1").arg(filename),worker);
 	}
 	file.close();
 	mtlfile.close();
+	if ( !wrote ) {
+		// Don't leave part of a file behind
+		QFile::remove(filename);
+		statusBar()->showMessage(tr("Saving %1 cancelled").arg(filename), 2000);
+	}
+	return wrote;
 }
 
 // Write the DLFL object to a file
@@ -4490,9 +4532,9 @@ void MainWindow::openFile(void) {
 		QByteArray ba3 = mtlfile.toLatin1();
 		const char *mtlfilename = ba3.data();
 
-		setCurrentFile(fileName);
 		std::cout << "filename for DLFL reading = " << filename << endl;
-		readObject(filename, mtlfilename);
+		if ( !readObject(filename, mtlfilename) ) return;
+		setCurrentFile(fileName);
 
 #ifdef WITH_PYTHON
 		// Emit and send to python script editor
@@ -4544,7 +4586,7 @@ bool MainWindow::saveFile(bool with_normals, bool with_tex_coords) {
 			const char *mtlfilename = ba2.data();
 			// writeMTL(mtlfilename);
 
-			writeObject(filename, mtlfilename, with_normals, with_tex_coords);
+			if ( !writeObject(filename, mtlfilename, with_normals, with_tex_coords) ) return false;
 
 
 			if (mIncrementalSave)
@@ -4588,7 +4630,7 @@ bool MainWindow::saveFile(bool with_normals, bool with_tex_coords) {
 				const char *mtlfilename = ba2.data();
 				// writeMTL(mtlfilename);
 
-				writeObject(filename, mtlfilename, with_normals,with_tex_coords);
+				if ( !writeObject(filename, mtlfilename, with_normals,with_tex_coords) ) return false;
 
 
 				if (mIncrementalSave)
@@ -4639,7 +4681,7 @@ bool MainWindow::saveFileAs(bool with_normals, bool with_tex_coords) {
 		const char *mtlfilename = ba2.data();
 		// writeMTL(mtlfilename);
 
-		writeObject(filename, mtlfilename, with_normals,with_tex_coords);
+		if ( !writeObject(filename, mtlfilename, with_normals,with_tex_coords) ) return false;
 
 		if (mIncrementalSave)
 			incremental_save_count++;
@@ -5332,6 +5374,7 @@ void MainWindow::retranslateUi() {
 	mShowEdgeIDsAct->setText(tr("Show &Edge IDs"));
 	mShowVertexIDsAct->setText(tr("Show &Vertex IDs"));
 	mShowSelectedIDsAct->setText(tr("Show &Selected IDs"));
+	mHideOccludedIDsAct->setText(tr("Hide &Occluded IDs"));
 	showSilhouetteAct->setText(tr("Show &Silhouette"));
 	showWireframeAct->setText(tr("Show &Wireframe"));
 	showCoordinateAxesAct->setText(tr("Show &Coordinate Axes"));
@@ -5394,6 +5437,10 @@ void MainWindow::retranslateUi() {
 	mCleanupWingedVerticesAct->setText(tr("Remove valence-2 vertices"));
 	mSplitValence2VerticesAct->setText(tr("Split valence-2 vertices"));
 	makeObjectSmoothAct->setText(tr("Make Object &Smooth"));
+	mCatmullClarkLimitAct->setText(tr("Project to Catmull-Clark Limit"));
+	mCatmullClarkLimitAct->setStatusTip(tr("Move the vertices to the limit surface of Catmull-Clark subdivision"));
+	mDooSabinLimitAct->setText(tr("Project to Doo-Sabin Limit"));
+	mDooSabinLimitAct->setStatusTip(tr("Move the vertices to the limit surface of Doo-Sabin subdivision"));
 	mPerformCuttingAct->setText(tr("Perform Cutting"));
 	mPerformCuttingAct->setStatusTip(tr("Cut selected faces, edges, or vertices based on the current selection mask"));
 	createCrustScalingAct->setText(tr("&Create Crust (Scaling)"));
@@ -5427,6 +5474,7 @@ void MainWindow::retranslateUi() {
 	selectFacesByAreaAct->setText(tr("Select Faces By Surf. Area"));
 	selectFacesByColorAct->setText(tr("Select Faces By Color"));
 	mSelectionWindowAct->setText(tr("Selection Window"));
+	mSelectVisibleOnlyAct->setText(tr("Select Visible Only"));
 	selectCheckerboardFacesAct->setText(tr("C&heckerboard Select Faces"));
 	selectAllAct->setText(tr("Select &All"));
 	mGrowSelectionAct->setText(tr("Grow Selection"));
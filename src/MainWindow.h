@@ -59,14 +59,12 @@
 #include <DLFLCrust.h>
 #include <DLFLDual.h>
 #include <DLFLExtrude.h>
+#include <DLFLLimitSurface.h>
 #include <DLFLMeshSmooth.h>
 #include <DLFLMultiConnect.h>
 #include <DLFLSculpting.h>
 #include <DLFLSubdiv.h>
 
-typedef StringStream * StringStreamPtr;
-typedef list<StringStreamPtr> StringStreamPtrList;
-
 class TopModPreferences;
 
 class BasicsMode;
@@ -82,6 +80,7 @@ class GLWidget;
 class QBoxLayout;
 class QComboBox;
 class QMenuBar;
+class DLFLOperatorThread;
 
 using namespace DLFL;
 
@@ -333,6 +332,8 @@ class MainWindow : public QMainWindow {
 	static double twist_factor;     //!< Twist factor for root-4 subdiv
 	static double weight_factor;   //!< Weight factor for root-4 subdiv
 	static bool doo_sabin_check; //!< Flag to check for repeating edges
+	static int doo_sabin_levels; //!< Number of Doo-Sabin levels done at once
+	static int catmull_clark_levels; //!< Number of Catmull-Clark levels done at once
 	static double vertex_cutting_offset; //!< Offset value for vertex cutting
 	static double pentagonal_offset; //!< Offset value for pentagonal subdivision (conversion)
 	static double pentagonal_scale; //!< Scale factor for pentagonal subdivision (preserving)
@@ -439,10 +440,8 @@ protected :
 	RemeshingScheme remeshingscheme;							//!< Current selected remeshing scheme
 	PointLight plight;														//!< Light used to compute lighting
 
-	StringStreamPtrList undoList;                 //!< List for Undo
-	StringStreamPtrList redoList;                 //!< List for Redo
-	StringStreamPtrList undoMtlList;                 //!< Mtl List for Undo
-	StringStreamPtrList redoMtlList;                 //!< Mtl List for Redo
+	DLFLObjectPtrList undoList;                   //!< Snapshots of the object for Undo
+	DLFLObjectPtrList redoList;                   //!< Snapshots of the object for Redo
 	int undolimit;                                //!< Limit for undo
 	bool useUndo;            											//!< Flag to indicate if undo will be used
 
@@ -679,6 +678,7 @@ private:
 	QAction *mShowEdgeIDsAct;
 	QAction *mShowVertexIDsAct;
 	QAction *mShowSelectedIDsAct;
+	QAction *mHideOccludedIDsAct;
 	QAction *showSilhouetteAct;
 	QAction *showWireframeAct;
 	QAction *objectOrientationAct;
@@ -725,6 +725,8 @@ private:
 	QAction *mCleanupWingedVerticesAct;
 	QAction *mSplitValence2VerticesAct;
 	QAction *makeObjectSmoothAct;
+	QAction *mCatmullClarkLimitAct;
+	QAction *mDooSabinLimitAct;
 	QAction *makeWireframeAct;
 	QAction *makeColumnsAct;
 	QAction *makeSierpinskiAct;
@@ -751,6 +753,7 @@ private:
 	QAction *selectFacesByAreaAct;
 	QAction *selectFacesByColorAct;
 	QAction *mSelectionWindowAct;
+	QAction *mSelectVisibleOnlyAct;
 	QAction *selectCheckerboardFacesAct;
 	QAction *selectAllAct;
 	QAction *mGrowSelectionAct;
@@ -1103,6 +1106,8 @@ public slots:
 
 	//remeshing slot functions
 	void toggleDooSabinEdgeFlag(int state);
+	void changeDooSabinLevels(double value);
+	void changeCatmullClarkLevels(double value);
 	void changeRoot4Twist(double value);
 	void changeRoot4Weight(double value);
 	void changeVertexCuttingOffset(double value);
@@ -1154,6 +1159,7 @@ public slots:
 	void clearRedoList();      // Erase all elements on Redo list
 	void undoPush();         // Put current object onto undo list
 	void undo();                           // Undo last operation
+	void undoRollback();  // Restore last undo state without pushing onto redo list
 	void redo();              // Redo previously undone operation
 
   // Change mode
@@ -1211,9 +1217,19 @@ public slots:
 
 	void spheralizeObject();
 	void smoothMesh();
+	void projectToCatmullClarkLimit();
+	void projectToDooSabinLimit();
 	void performRemeshing(); //!< Generic method for all remeshing schemes
 	void performExtrusion(); //!< Generic method for all extrusion schemes on multiple faces
 	// void getExtrudeMultiple(); //!< are we in multi select mode or not?
+	// Run a worker thread with a progress dialog. The object isn't drawn
+	// while the worker runs. Returns the result of the worker.
+	bool runWithProgress(const QString& label, DLFLOperatorThread& worker);
+	// Same for a worker which changes the object. Rolls back to the state
+	// before the operation if it fails or is cancelled.
+	bool applyWithProgress(const QString& label, DLFLOperatorThread& worker);
+	bool subdivideWithProgress(const QString& label, DLFL::DLFLSubdivScheme scheme, int levels,
+														 double param1 = 0.0, double param2 = 0.0);
 	void subdivideCatmullClark();
 	void subdivideDooSabin();
 	void subdivideHoneycomb();
@@ -1291,13 +1307,15 @@ public slots:
 	bool saveFileAs(bool with_normals=true, bool with_tex_coords=true);
 	void setCurrentFile(QString fileName);
 
-	// Read the DLFL object from a file
-	void readObject(const char * filename, const char *mtlfilename = NULL);
+	// Read the DLFL object from a file. Returns false if the file couldn't be
+	// read or reading was cancelled, the object is left alone then.
+	bool readObject(const char * filename, const char *mtlfilename = NULL);
 	void readObjectQFile(QString file);
 	// Read the DLFL object from a file - use alternate OBJ reader for OBJ files
 	void readObjectAlt(const char * filename);
-	// Write the DLFL object to a file
-	void writeObject(const char * filename, const char *mtlfilename = NULL, bool with_normals=true, bool with_tex_coords=true);
+	// Write the DLFL object to a file. Returns false if writing was cancelled,
+	// nothing of the file is left then.
+	bool writeObject(const char * filename, const char *mtlfilename = NULL, bool with_normals=true, bool with_tex_coords=true);
 	void writeMTL(const char * filename);
 
 	//exporters
@@ -5,8 +5,47 @@
 // All these are static methods
 #include <queue>
 #include "MainWindow.h"
+#include "DLFLProgressDialog.h"
+#include "DLFLTimer.h"
 #include "hermite_connect_faces.h"
 
+// The operators run on a worker thread through DLFLFunctionThread
+static void crustWithThickness(DLFLObjectPtr obj, double thickness, double, double) {
+	DLFL::createCrust(obj,thickness);
+}
+
+static void crustWithScaling(DLFLObjectPtr obj, double scale_factor, double, double) {
+	DLFL::createCrustWithScaling(obj,scale_factor);
+}
+
+static void punchMarkedHoles(DLFLObjectPtr obj, double, double, double) {
+	DLFL::punchHoles(obj);
+}
+
+static void wireframe(DLFLObjectPtr obj, double thickness, double split, double) {
+	DLFL::makeWireframe(obj,thickness,split != 0.0);
+}
+
+static void wireframe2(DLFLObjectPtr obj, double thickness, double width, double split) {
+	DLFL::makeWireframe2(obj,thickness,width,split != 0.0);
+}
+
+static void wireframeWithColumns(DLFLObjectPtr obj, double thickness, double segments, double) {
+	DLFL::makeWireframeWithColumns(obj,thickness,int(segments));
+}
+
+static void sponge(DLFLObjectPtr obj, double thickness, double collapse_threshold, double) {
+	DLFL::createSponge(obj,thickness,collapse_threshold);
+}
+
+static void convexHull(DLFLObjectPtr obj, double, double, double) {
+	DLFL::createConvexHull(obj);
+}
+
+static void dualConvexHull(DLFLObjectPtr obj, double, double, double) {
+	DLFL::createDualConvexHull(obj);
+}
+
 void MainWindow::load_texture() {
 	QString fileName = QFileDialog::getOpenFileName(this,
 		tr("Open Texture File..."),
@@ -710,7 +749,8 @@ void MainWindow::performCutting() {
 void MainWindow::createConvexHull() {
 	undoPush();
 	setModified(true);
-	DLFL::createConvexHull(&object);
+	DLFLFunctionThread worker(&object,convexHull);
+	if ( !applyWithProgress(tr("Convex hull"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -720,7 +760,8 @@ void MainWindow::createConvexHull() {
 void MainWindow::createDualConvexHull() {
 	undoPush();
 	setModified(true);
-	DLFL::createDualConvexHull(&object);
+	DLFLFunctionThread worker(&object,dualConvexHull);
+	if ( !applyWithProgress(tr("Dual convex hull"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -770,6 +811,7 @@ void MainWindow::paintSelectedFaces(){
 	// fparray.resize(active->numSelectedFaces());
 	for (int i=0; i < active->numSelectedFaces(); ++i)	{
 		active->getSelectedFace(i)->setMaterial(object.addMaterial(RGBColor(paint_bucket_color.redF(),paint_bucket_color.greenF(),paint_bucket_color.blueF())));
+		object.changedFace(active->getSelectedFace(i));
 	}
 	MainWindow::clearSelected();
   active->recomputePatches();
@@ -967,8 +1009,9 @@ void MainWindow::modifiedMultiConnectCrust(void)
 void MainWindow::createSponge(void)
 {
 	undoPush();
-	DLFL::createSponge(&object,MainWindow::sponge_thickness,
+	DLFLFunctionThread worker(&object,sponge,MainWindow::sponge_thickness,
 		MainWindow::sponge_collapse_threshold);
+	if ( !applyWithProgress(tr("Sponge"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -1002,80 +1045,138 @@ void MainWindow::smoothMesh(void)                          // Smooth the mesh
 	redraw();
 }
 
-void MainWindow::subdivideCatmullClark(void)     // Catmull-Clark subdivision
+void MainWindow::projectToCatmullClarkLimit(void)  // Move vertices to the limit surface
 {
+	// The boundary of an open mesh has no limit points
+	if ( !hasClosedVertexRings(&object) ) {
+		statusBar()->showMessage(tr("The limit surface needs a closed mesh"), 2000);
+		return;
+	}
 	undoPush();
-	DLFL::catmullClarkSubdivide(&object);
+	setModified(true);
+	// Sets the limit normals as well, so they aren't recomputed
+	DLFL::projectToCatmullClarkLimit(&object);
   active->recomputePatches();
-	active->recomputeNormals();
-	MainWindow::clearSelected();
-	QString cmd( "subdivide(\"catmull-clark\")");
+	redraw();
+
+	QString cmd = QString("limit(\"catmull-clark\")");
 	emit echoCommand( cmd );
-	// redraw();
 }
 
-void MainWindow::subdivideDooSabin(void)             // Doo-Sabin subdivision
+void MainWindow::projectToDooSabinLimit(void)      // Move vertices to the limit surface
 {
+	// The boundary of an open mesh has no limit points
+	if ( !hasClosedVertexRings(&object) ) {
+		statusBar()->showMessage(tr("The limit surface needs a closed mesh"), 2000);
+		return;
+	}
 	undoPush();
+	setModified(true);
+	// Sets the limit normals as well, so they aren't recomputed
+	DLFL::projectToDooSabinLimit(&object);
+  active->recomputePatches();
+	redraw();
 
-	// QProgressDialog *progress = new QProgressDialog("Performing Doo Sabin Remeshing...", "Cancel", 0, 1);
-	// progress->setMinimumDuration(2000);
-	// progress->setWindowModality(Qt::WindowModal);
+	QString cmd = QString("limit(\"doo-sabin\")");
+	emit echoCommand( cmd );
+}
 
-	// DLFLObjectPtr t = object;
-	// active->setRenderingEnabled(false);
+bool MainWindow::runWithProgress(const QString& label, DLFLOperatorThread& worker)
+{
+	// The object may be changed on the worker thread, so it isn't drawn
+	// until the operation is done
+	active->setRenderingEnabled(false);
 
-	// if (!DLFL::dooSabinSubdivide(&object, doo_sabin_check/* , progress*/) ){
-		// active->recomputePatches();
-		// active->recomputeNormals();
-		// undo();
-		// MainWindow::clearSelected();
-		// active->setRenderingEnabled(true);
-	// }
-	// else {
-		// object = t;
-		// delete t;
-		// active->setRenderingEnabled(true);
+	DLFLProgressDialog progress(label,this);
+	progress.run(&worker);
 
+	active->setRenderingEnabled(true);
+	return worker.result();
+}
 
-  // Fenghui's simple profiler for the remeshing operation.
-  std::clock_t start = std::clock();
-  std::clock_t op = std::clock();
-  std::clock_t recompute_patches = std::clock();
-  std::clock_t recompute_normals = std::clock();
+bool MainWindow::applyWithProgress(const QString& label, DLFLOperatorThread& worker)
+{
+	// The caller has already done the undoPush(). Without undo keep a copy
+	// of our own so a cancelled operation can still be rolled back
+	DLFLObjectPtr backup = NULL;
+	if ( !useUndo ) backup = new DLFLObject(object);
 
+	// Don't keep pointers into the object while it is changed
+	MainWindow::clearSelected();
+	if ( runWithProgress(label,worker) ) {
+		delete backup;
+		return true;
+	}
 
-  DLFL::dooSabinSubdivide(&object, doo_sabin_check/* , progress*/);
+	if ( useUndo ) undoRollback();
+	else {
+		object.swap(*backup); delete backup;
+		active->recomputePatches();
+		active->recomputeNormals();
+		redraw();
+	}
+	if ( worker.cancelled() )
+		statusBar()->showMessage(tr("%1 cancelled").arg(label),2000);
+	else
+		QMessageBox::warning(this, tr("TopMod"),
+												 tr("%1 could not be applied to this object. The object has been left unchanged.").arg(label));
+	return false;
+}
 
-  // Fenghui, record the time after the remeshing.
-  op = std::clock();
+bool MainWindow::subdivideWithProgress(const QString& label, DLFL::DLFLSubdivScheme scheme, int levels,
+																			 double param1, double param2)
+{
+	DLFLSubdivideThread worker(&object,scheme,levels,param1,param2);
+	return applyWithProgress(label,worker);
+}
 
+void MainWindow::subdivideCatmullClark(void)     // Catmull-Clark subdivision
+{
+	undoPush();
+	// All levels are done in one go with a single undo record and a single
+	// patch/normal update at the end
+	if ( !subdivideWithProgress(tr("Catmull-Clark subdivision"), DLFL::STCatmullClark, catmull_clark_levels) )
+		return;
   active->recomputePatches();
+	active->recomputeNormals();
+	MainWindow::clearSelected();
+	QString cmd( "subdivide(\"catmull-clark\"");
+	if( catmull_clark_levels > 1 )
+		cmd += QString(", levels=%1").arg(catmull_clark_levels);
+	cmd += QString(")");
+	emit echoCommand( cmd );
+	// redraw();
+}
 
-  // Fenghui, record the time after compute patches.
-  recompute_patches = std::clock();
+void MainWindow::subdivideDooSabin(void)             // Doo-Sabin subdivision
+{
+	undoPush();
 
-  active->recomputeNormals();
+  DLFLTimer timer("DooSabin");
 
-  // Fenghui, record the time after compute normals.
-  recompute_normals = std::clock();
+  if ( !subdivideWithProgress(tr("Doo-Sabin subdivision"), DLFL::STDooSabin, doo_sabin_levels, doo_sabin_check) )
+    return;
+
+  timer.step();
+
+  active->recomputePatches();
+  timer.step();
+
+  active->recomputeNormals();
+  timer.step();
 
   MainWindow::clearSelected();
   QString cmd( "subdivide(\"doo-sabin\",");
   QString check("False");
   if( doo_sabin_check )
     check = QString("True");
-		cmd += check + QString(")");
+		cmd += check;
+	if( doo_sabin_levels > 1 )
+		cmd += QString(", levels=%1").arg(doo_sabin_levels);
+	cmd += QString(")");
 		emit echoCommand( cmd );
-	// }
 
-  // Fenghui, output the time taken to perform each steps.
-  cout << "DooSabin:" << (op - start) / (double)CLOCKS_PER_SEC
-       << ":" << (recompute_patches - op) / (double)CLOCKS_PER_SEC
-       << ":" << (recompute_normals - recompute_patches) / (double)CLOCKS_PER_SEC
-       << ":" << (std::clock() - recompute_normals) / (double)CLOCKS_PER_SEC
-       << endl;
-  // Fenghui's simple profiler for DooSabin, end!
+  timer.print();
 }
 
 void MainWindow::subdivideHoneycomb(void)            // Honeycomb subdivision
@@ -1271,7 +1372,7 @@ void MainWindow::subdivideRoot3(void)                     // Root-3 remeshing
 void MainWindow::subdivideLoop(void)                      // Loop subdivision
 {
 	undoPush();
-	DLFL::loopSubdivide(&object);
+	if ( !subdivideWithProgress(tr("Loop subdivision"), DLFL::STLoop, 1) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -1377,7 +1478,7 @@ void MainWindow::subdivideSqrt3(void)           // sqrt(3) subdivision - Doug
 {
 	undoPush();
 	setModified(true);
-	DLFL::sqrt3Subdivide(&object);
+	if ( !subdivideWithProgress(tr("Sqrt(3) subdivision"), DLFL::STSqrt3, 1) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -1565,10 +1666,9 @@ void MainWindow::createCrust(bool use_scaling)        // Create a crust
 {
 	undoPush();
 	setModified(true);
-	if ( use_scaling )
-		DLFL::createCrustWithScaling(&object,MainWindow::crust_scale_factor);
-	else
-		DLFL::createCrust(&object,MainWindow::crust_thickness);
+	DLFLFunctionThread worker(&object, use_scaling ? crustWithScaling : crustWithThickness,
+														use_scaling ? MainWindow::crust_scale_factor : MainWindow::crust_thickness);
+	if ( !applyWithProgress(tr("Crust"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -1586,22 +1686,21 @@ void MainWindow::createCrust2(bool use_scaling) {
 
 	undoPush();
 	setModified(true);
-	if ( use_scaling )
-		DLFL::createCrustWithScaling(&object,MainWindow::crust_scale_factor);
-	else
-		DLFL::createCrust(&object,MainWindow::crust_thickness);
-  active->recomputePatches();
-	active->recomputeNormals();
-	if ( active->numSelectedFaces() >= 1 ) {
-		DLFLFacePtrArray sfptrarr = active->getSelectedFaces();
-		if ( sfptrarr[0] ) {
-			for(it = sfptrarr.begin(); it != sfptrarr.end(); it++) {
-				(*it)->setType(FTHole);
-				facelist += QString().setNum((*it)->getID()) + QString(",");
-			}
-			facelist += QString("]");
-			DLFL::punchHoles(&object);
+	// The selection is cleared while the crust is made. The selected faces
+	// are the outer faces of the crust, which stay.
+	DLFLFacePtrArray sfptrarr = active->getSelectedFaces();
+	DLFLFunctionThread crust(&object, use_scaling ? crustWithScaling : crustWithThickness,
+													 use_scaling ? MainWindow::crust_scale_factor : MainWindow::crust_thickness);
+	if ( !applyWithProgress(tr("Crust"),crust) ) return;
+	if ( !sfptrarr.empty() && sfptrarr[0] ) {
+		for(it = sfptrarr.begin(); it != sfptrarr.end(); it++) {
+			(*it)->setType(FTHole);
+			facelist += QString().setNum((*it)->getID()) + QString(",");
 		}
+		facelist += QString("]");
+		// With undo cancelling this rolls back the crust as well
+		DLFLFunctionThread holes(&object,punchMarkedHoles);
+		if ( !applyWithProgress(tr("Punching holes"),holes) ) return;
 	}
   active->recomputePatches();
 	active->recomputeNormals();
@@ -1619,7 +1718,8 @@ void MainWindow::makeWireframe(void)                    // Create a wireframe
 {
 	undoPush();
 	setModified(true);
-	DLFL::makeWireframe(&object,MainWindow::wireframe_thickness,MainWindow::wireframe_split);
+	DLFLFunctionThread worker(&object,wireframe,MainWindow::wireframe_thickness,MainWindow::wireframe_split);
+	if ( !applyWithProgress(tr("Wireframe"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -1630,7 +1730,9 @@ void MainWindow::makeWireframe2() {// Create a wireframe // dave {
 	// vector<DLFLFacePtr>::iterator it;
 	undoPush();
 	setModified(true);
-	DLFL::makeWireframe2(&object,MainWindow::wireframe2_thickness, MainWindow::wireframe2_width,MainWindow::wireframe_split);
+	DLFLFunctionThread worker(&object,wireframe2,MainWindow::wireframe2_thickness,
+														MainWindow::wireframe2_width,MainWindow::wireframe_split);
+	if ( !applyWithProgress(tr("Wireframe"),worker) ) return;
 	// active->recomputePatches();
 	// active->recomputeNormals();
 	// if ( active->numSelectedFaces() >= 1 ) {
@@ -1653,7 +1755,9 @@ void MainWindow::makeWireframeWithColumns(void) // Create a wireframe using colu
 {
 	undoPush();
 	setModified(true);
-	DLFL::makeWireframeWithColumns(&object,MainWindow::column_thickness, MainWindow::column_segments);
+	DLFLFunctionThread worker(&object,wireframeWithColumns,MainWindow::column_thickness,
+														MainWindow::column_segments);
+	if ( !applyWithProgress(tr("Wireframe with columns"),worker) ) return;
   active->recomputePatches();
 	active->recomputeNormals();
 	MainWindow::clearSelected();
@@ -2235,93 +2339,23 @@ void MainWindow::selectComponent(){
 }
 
 void MainWindow::growSelection(){
-	DLFLEdgePtrArray septrarr;
-	DLFLVertexPtrArray svptrarr;
-	DLFLFaceVertexPtrArray sfvptrarr;
-	DLFLFacePtrArray sfptrarr;
-	vector<DLFLVertexPtr>::iterator vit;
-	vector<DLFLEdgePtr>::iterator eit;
-	vector<DLFLFacePtr>::iterator fit;
-	vector<DLFLFaceVertexPtr>::iterator fvit;
-
-	DLFLVertexPtr vptr1,vptr2;
-	DLFLFacePtr fptr1,fptr2;
-	DLFLEdgePtrArray eptrarray;
-	vector<DLFLEdgePtr>::iterator eit2;
-
 	switch (selectionmask){
 		case MaskVertices:
-		//loop through selected vertices, get corresponding edges
-		svptrarr = active->getSelectedVertices();
-		if ( svptrarr.size() > 0 && svptrarr[0] ) {
-			for(vit = svptrarr.begin(); vit != svptrarr.end(); vit++){
-				(*vit)->getEdges(septrarr);
-				//loop through edges, select all vertices connected to these edges
-				for(eit = septrarr.begin(); eit != septrarr.end(); eit++){
-					DLFLVertexPtr vp1, vp2;
-					//get the two vertices for each edge, select them if they aren't already selected
-					(*eit)->getVertexPointers(vp1,vp2);
-					if (!active->isSelected(vp1)){
-						active->setSelectedVertex(num_sel_verts,vp1);
-						num_sel_verts++;
-					}
-					if (!active->isSelected(vp2)){
-						active->setSelectedVertex(num_sel_verts,vp2);
-						num_sel_verts++;
-					}
-				}
-			}
-		}
+		//select the vertices at the other ends of the edges of the selected vertices
+		active->growSelectedVertices();
+		num_sel_verts = active->numSelectedVertices();
 		redraw();
 		break;
 		case MaskEdges:
-		//loop through selected edges, get vertices, then get those edges
-		septrarr = active->getSelectedEdges();
-		if ( septrarr.size() > 0 && septrarr[0]) {
-			for(eit = septrarr.begin(); eit != septrarr.end(); eit++){
-				//get the 2 vertices for the current edge
-				(*eit)->getVertexPointers(vptr1,vptr2);
-				//get the edges for vertex 1
-				vptr1->getEdges(eptrarray);
-				for (eit2 = eptrarray.begin(); eit2 != eptrarray.end(); eit2++){
-					if (!active->isSelected(*eit2)){
-						active->setSelectedEdge(num_sel_edges,*eit2);
-						num_sel_edges++;
-					}
-				}
-				//get edges for vertex 2
-				vptr2->getEdges(eptrarray);
-				for (eit2 = eptrarray.begin(); eit2 != eptrarray.end(); eit2++){
-					if (!active->isSelected(*eit2)){
-						active->setSelectedEdge(num_sel_edges,*eit2);
-						num_sel_edges++;
-					}
-				}
-			}
-		}
+		//select the edges which share a vertex with a selected edge
+		active->growSelectedEdges();
+		num_sel_edges = active->numSelectedEdges();
 		redraw();
 		break;
 		case MaskFaces:
-		//loop through selected faces
-		sfptrarr = active->getSelectedFaces();
-		if ( sfptrarr.size() > 0 && sfptrarr[0] ) {
-			for(fit = sfptrarr.begin(); fit != sfptrarr.end(); fit++){
-				//get the edges for the current face
-				(*fit)->getEdges(eptrarray);
-				for(eit = eptrarray.begin(); eit != eptrarray.end(); eit++){
-					//get the 2 faces for the current edge, select them if they aren't already selected
-					(*eit)->getFacePointers(fptr1,fptr2);
-					if (!active->isSelected(fptr1)){
-						active->setSelectedFace(num_sel_faces,fptr1);
-						num_sel_faces++;
-					}
-					if (!active->isSelected(fptr2)){
-						active->setSelectedFace(num_sel_faces,fptr2);
-						num_sel_faces++;
-					}
-				}
-			}
-		}
+		//select the faces which share an edge with a selected face
+		active->growSelectedFaces();
+		num_sel_faces = active->numSelectedFaces();
 		redraw();
 		break;
 		case MaskCorners:
@@ -2335,105 +2369,23 @@ void MainWindow::growSelection(){
 }
 
 void MainWindow::shrinkSelection(){
-	DLFLEdgePtrArray septrarr;
-	DLFLVertexPtrArray svptrarr;
-	DLFLFaceVertexPtrArray sfvptrarr;
-	DLFLFacePtrArray sfptrarr;
-	vector<DLFLVertexPtr>::iterator vit;
-	vector<DLFLEdgePtr>::iterator eit;
-	vector<DLFLFacePtr>::iterator fit;
-	vector<DLFLFaceVertexPtr>::iterator fvit;
-	int i = 0;
-
-	DLFLVertexPtr vptr1,vptr2;
-	DLFLFacePtr fptr1,fptr2;
-	DLFLEdgePtrArray eptrarray;
-	vector<DLFLEdgePtr>::iterator eit2;
-
 	switch (selectionmask){
 		case MaskVertices:
-		//loop through selected vertices, get corresponding edges
-		svptrarr = active->getSelectedVertices();
-		if ( svptrarr.size() > 0 && svptrarr[0] ) {
-			bool deselectvertices[svptrarr.size()];
-			for(vit = svptrarr.begin(); vit != svptrarr.end(); vit++,i++){
-				deselectvertices[i] = false;
-				(*vit)->getEdges(septrarr);
-				//loop through edges, select all vertices connected to these edges
-				for(eit = septrarr.begin(); eit != septrarr.end(); eit++){
-					DLFLVertexPtr vp1, vp2;
-					//get the two vertices for each edge, select them if they aren't already selected
-					(*eit)->getVertexPointers(vp1,vp2);
-					if (!active->isSelected(vp1) || !active->isSelected(vp2))
-						deselectvertices[i] = true;
-				}
-			}
-			//loop back through verts, now deselect the flagged ones
-			i = 0;
-			for(vit = svptrarr.begin(); vit != svptrarr.end(); vit++, i++){
-				//if it's flagged, deselect it
-				if (deselectvertices[i])
-					active->clearSelectedVertex(*vit);
-			}
-		}
+		//deselect the vertices with an unselected vertex at the other end of an edge
+		active->shrinkSelectedVertices();
+		num_sel_verts = active->numSelectedVertices();
 		redraw();
 		break;
 		case MaskEdges:
-		//loop through selected edges, get vertices, then get those edges
-		septrarr = active->getSelectedEdges();
-		if ( septrarr.size() > 0 && septrarr[0]) {
-			bool deselectedges[septrarr.size()];
-			for(eit = septrarr.begin(); eit != septrarr.end(); eit++,i++){
-				//get the 2 vertices for the current edge
-				(*eit)->getVertexPointers(vptr1,vptr2);
-				//get the edges for vertex 1
-				vptr1->getEdges(eptrarray);
-				deselectedges[i] = false;
-				for (eit2 = eptrarray.begin(); eit2 != eptrarray.end(); eit2++){
-					if (!active->isSelected(*eit2))
-						deselectedges[i] = true;
-				}
-				//get edges for vertex 2
-				vptr2->getEdges(eptrarray);
-				for (eit2 = eptrarray.begin(); eit2 != eptrarray.end(); eit2++){
-					if (!active->isSelected(*eit2))
-						deselectedges[i] = true;
-				}
-			}
-			//loop back through edges, now deselect the flagged ones
-			i = 0;
-			for(eit = septrarr.begin(); eit != septrarr.end(); eit++,i++){
-				//if it's flagged, deselect it
-				if (deselectedges[i])
-					active->clearSelectedEdge(*eit);
-			}
-		}
-		redraw();		break;
+		//deselect the edges which share a vertex with an unselected edge
+		active->shrinkSelectedEdges();
+		num_sel_edges = active->numSelectedEdges();
+		redraw();
+		break;
 		case MaskFaces:
-		//loop through selected faces
-		sfptrarr = active->getSelectedFaces();
-		if ( sfptrarr.size() > 0 && sfptrarr[0] ) {
-			bool deselectfaces[sfptrarr.size()];
-			for(fit = sfptrarr.begin(); fit != sfptrarr.end(); fit++, i++){
-				//get the edges for the current face
-				(*fit)->getEdges(eptrarray);
-				//by default don't deselect this face
-				deselectfaces[i] = false;
-				for(eit = eptrarray.begin(); eit != eptrarray.end(); eit++){
-					//get the 2 faces for the current edge, check if both of them are selected, flag the current face
-					(*eit)->getFacePointers(fptr1,fptr2);
-					if (!active->isSelected(fptr1) || !active->isSelected(fptr2))
-						deselectfaces[i] = true;
-				}
-			}
-			//loop back through faces, now deselect the flagged ones
-			i = 0;
-			for(fit = sfptrarr.begin(); fit != sfptrarr.end(); fit++,i++){
-				//if it's flagged, deselect it
-				if (deselectfaces[i])
-					active->clearSelectedFace(*fit);
-			}
-		}
+		//deselect the faces which share an edge with an unselected face
+		active->shrinkSelectedFaces();
+		num_sel_faces = active->numSelectedFaces();
 		redraw();
 		break;
 		case MaskCorners:
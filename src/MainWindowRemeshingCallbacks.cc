@@ -8,6 +8,16 @@ void MainWindow::toggleDooSabinEdgeFlag(int state)
   MainWindow::doo_sabin_check = bool(state);
 }
 
+void MainWindow::changeDooSabinLevels(double value)
+{
+  MainWindow::doo_sabin_levels = (int)value;
+}
+
+void MainWindow::changeCatmullClarkLevels(double value)
+{
+  MainWindow::catmull_clark_levels = (int)value;
+}
+
 void MainWindow::changeRoot4Twist(double value)
 {
   MainWindow::twist_factor = value;
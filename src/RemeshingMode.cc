@@ -849,10 +849,13 @@ void RemeshingMode::setupFourConversion(){
 	mCatmullClarkLayout->setVerticalSpacing(1);
 	mCatmullClarkLayout->setHorizontalSpacing(1);
 	// mCatmullClarkLayout->setMargin(0);
+	catmullClarkLevelsLabel = new QLabel(this);
+	catmullClarkLevelsSpinBox = createDoubleSpinBox(mCatmullClarkLayout, catmullClarkLevelsLabel, tr("Levels:"), 1, 6, 1, 1, 0, 0,0);
+	connect(catmullClarkLevelsSpinBox, SIGNAL(valueChanged(double)), ((MainWindow*)mParent),SLOT(changeCatmullClarkLevels(double)) );
 	catmullClarkCreateButton = new QPushButton(tr("Perform Remeshing"), this);
 	connect(catmullClarkCreateButton, SIGNAL(clicked()), ((MainWindow*)mParent),SLOT(performRemeshing()) );
-	mCatmullClarkLayout->addWidget(catmullClarkCreateButton,0,0);
-	mCatmullClarkLayout->setRowStretch(1,1);
+	mCatmullClarkLayout->addWidget(catmullClarkCreateButton,1,0,1,2);
+	mCatmullClarkLayout->setRowStretch(2,1);
 	mCatmullClarkLayout->setColumnStretch(2,1);
 	mCatmullClarkWidget->setWindowTitle(tr("Catmull-Clark Remeshing"));
 	mCatmullClarkWidget->setLayout(mCatmullClarkLayout);
@@ -879,10 +882,13 @@ void RemeshingMode::setupFourConversion(){
 	mDooSabinLayout->addWidget(dooSabinCheckBox,0,0);
 	//connect the checkbox
 	connect(dooSabinCheckBox, SIGNAL(stateChanged(int)), ((MainWindow*)mParent),SLOT(toggleDooSabinEdgeFlag(int)) );
+	dooSabinLevelsLabel = new QLabel(this);
+	dooSabinLevelsSpinBox = createDoubleSpinBox(mDooSabinLayout, dooSabinLevelsLabel, tr("Levels:"), 1, 6, 1, 1, 0, 1,0);
+	connect(dooSabinLevelsSpinBox, SIGNAL(valueChanged(double)), ((MainWindow*)mParent),SLOT(changeDooSabinLevels(double)) );
 	dooSabinCreateButton = new QPushButton(tr("Perform Remeshing"), this);
 	connect(dooSabinCreateButton, SIGNAL(clicked()), ((MainWindow*)mParent),SLOT(performRemeshing()) );
-	mDooSabinLayout->addWidget(dooSabinCreateButton,1,0);
-	mDooSabinLayout->setRowStretch(1,1);
+	mDooSabinLayout->addWidget(dooSabinCreateButton,2,0,1,2);
+	mDooSabinLayout->setRowStretch(3,1);
 	mDooSabinLayout->setColumnStretch(2,1);
 	mDooSabinWidget->setWindowTitle(tr("Doo Sabin Remeshing"));
 	mDooSabinWidget->setLayout(mDooSabinLayout);
@@ -1634,11 +1640,13 @@ void RemeshingMode::retranslateUi(){
 	mDualTwelveSixFourWidget->setWindowTitle(tr("Dual 12.6.4 Remeshing"));
 	linearVertexCreateButton->setText(tr("Perform Remeshing"));
 	mLinearVertexWidget->setWindowTitle(tr("Linear Vertex Insertion Remeshing"));
+	catmullClarkLevelsLabel->setText(tr("Levels:"));
 	catmullClarkCreateButton->setText(tr("Perform Remeshing"));
 	mCatmullClarkWidget->setWindowTitle(tr("Catmull-Clark Remeshing"));
 	stellateEdgeRemovalCreateButton->setText(tr("Perform Remeshing"));
 	mStellateEdgeRemovalWidget->setWindowTitle(tr("Stellate with Edge Removal Remeshing"));
 	dooSabinCheckBox->setText(tr("Check for multiple edges"));
+	dooSabinLevelsLabel->setText(tr("Levels:"));
 	dooSabinCreateButton->setText(tr("Perform Remeshing"));
 	mDooSabinWidget->setWindowTitle(tr("Doo Sabin Remeshing"));
 	cornerCuttingCreateButton->setText(tr("Perform Remeshing"));
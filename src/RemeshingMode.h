@@ -279,8 +279,12 @@ private:
 	QDoubleSpinBox *domeHeightSpinBox;
 	QDoubleSpinBox *domeScaleSpinBox;
 	QDoubleSpinBox *cornerCuttingAlphaSpinBox;
+	QDoubleSpinBox *catmullClarkLevelsSpinBox;
+	QDoubleSpinBox *dooSabinLevelsSpinBox;
 
 	QLabel *cornerCuttingAlphaLabel;
+	QLabel *catmullClarkLevelsLabel;
+	QLabel *dooSabinLevelsLabel;
 	QLabel *starLabel;
 	QLabel *twelveSixFourLabel;
 	QLabel *vertexTruncationLabel;
@@ -17,22 +17,19 @@ typedef vector<TMPatch> TMPatchArray;
 typedef TMPatch* TMPatchPtr;
 typedef vector<TMPatchPtr> TMPatchPtrArray;
 
-// This stuff is to map the patches to the face vertices by index
-struct compare { 
-  bool operator()( DLFLFaceVertexPtr a, DLFLFaceVertexPtr b ) const { 
-		return ( a->getID() < b->getID() );
-	}
-};
-  
-typedef	std::map<DLFLFaceVertexPtr, TMPatchPtr, compare> TMPatchMap;
+// This stuff is to map the patches to the face vertices. The face vertices
+// are only compared as pointers, they may have been deleted from the object
+// by the time their patches are taken out of the map.
+typedef	std::map<DLFLFaceVertexPtr, TMPatchPtr> TMPatchMap;
 
 static void setPatchPtr( TMPatchMap &map, TMPatchPtr p, DLFLFaceVertexPtr fvp ) {
   map[fvp] = p;
 };
 
-static TMPatchPtr getPatchPtr( TMPatchMap &map, DLFLFaceVertexPtr fvp )  {
-  std::map<DLFLFaceVertexPtr, TMPatchPtr, compare>::iterator it;
-  it = map.find(fvp);
+// NULL if the face vertex has no patch
+static TMPatchPtr getPatchPtr( const TMPatchMap &map, DLFLFaceVertexPtr fvp )  {
+  TMPatchMap::const_iterator it = map.find(fvp);
+  if ( it == map.end() ) return NULL;
   return (*it).second;
 };
 
@@ -50,6 +47,7 @@ protected :
   Vector4dGrid ctrlptcolors; // Color for each control point (RGBA)
   GLdouble * glctrlpts;		  // Control points for OpenGL
   GLdouble * glctrlptcolors;     // Control point colors for OpenGL
+  bool modified;                 // The OpenGL arrays changed since the patch was last tessellated
 
   void allocateGLArray() {
     // Allocate memory for the GLdouble array to be sent to OpenGL
@@ -61,6 +59,7 @@ protected :
 			glctrlpts = new GLdouble[patchsize*patchsize*3];
 			glctrlptcolors = new GLdouble[patchsize*patchsize*4];
 		}
+    modified = true;
   }
 
   void populateGLArray()
@@ -84,6 +83,7 @@ protected :
 					glctrlptcolors[colorindex+2] = ctrlptcolors[j][i][2];
 					glctrlptcolors[colorindex+3] = ctrlptcolors[j][i][3];
 				}
+			modified = true;
 		}
   }
      
@@ -91,7 +91,8 @@ public :
 
   // Default constructor
   TMPatch()
-    : patchsize(0), ctrlpts(), ctrlptnormals(), ctrlptcolors(), glctrlpts(NULL), glctrlptcolors(NULL)
+    : patchsize(0), ctrlpts(), ctrlptnormals(), ctrlptcolors(), glctrlpts(NULL), glctrlptcolors(NULL),
+      modified(true)
   {
     resizePatch(4);
   }
@@ -100,7 +101,7 @@ public :
   TMPatch(const TMPatch& patch)
     : patchsize(patch.patchsize), ctrlpts(patch.ctrlpts), ctrlptnormals(patch.ctrlptnormals),
       ctrlptcolors(patch.ctrlptcolors),
-      glctrlpts(NULL), glctrlptcolors(NULL)
+      glctrlpts(NULL), glctrlptcolors(NULL), modified(true)
   {
     allocateGLArray();
     populateGLArray();
@@ -139,6 +140,29 @@ public :
 		}
   }
 
+  int getPatchSize(void) const {
+    return patchsize;
+  }
+
+  // The control points and their colors as handed to OpenGL, NULL for an
+  // empty patch. Point (u,v) of the grid is at index v*patchsize+u.
+  const GLdouble * getGLControlPoints(void) const {
+    return glctrlpts;
+  }
+
+  const GLdouble * getGLControlPointColors(void) const {
+    return glctrlptcolors;
+  }
+
+  // Whether the OpenGL arrays changed since clearModified was last called
+  bool isModified(void) const {
+    return modified;
+  }
+
+  void clearModified(void) {
+    modified = false;
+  }
+
   const Vector3d& getControlPoint(int i, int j) const
   {
     // Return the control point at the specified location
@@ -174,8 +198,10 @@ public :
 	  glctrlpts[index+1] = ctrlpts[j][i][1]; 
 	  glctrlpts[index+2] = ctrlpts[j][i][2]; 
 	}
+    modified = true;
   }
 
+  // Only marks the patch modified if a point moved
   void updateGLPointArray(void)
   {
 		if( glctrlpts == NULL )
@@ -184,15 +210,18 @@ public :
     for (int i=0; i < patchsize; ++i)
       for (int j=0; j < patchsize; ++j) {
 				index = (i*patchsize+j)*3;
-				glctrlpts[index+0] = ctrlpts[j][i][0]; 
-				glctrlpts[index+1] = ctrlpts[j][i][1]; 
-				glctrlpts[index+2] = ctrlpts[j][i][2]; 
+				for (int k=0; k < 3; ++k)
+					if ( glctrlpts[index+k] != ctrlpts[j][i][k] ) {
+						glctrlpts[index+k] = ctrlpts[j][i][k];
+						modified = true;
+					}
 			}
   }
      
   void computeLighting(const RGBColor& basecolor, double Ka, double Kd, double Ks, LightPtr lightptr)
   {
     // Calculate lighting at each control point and update the color
+    // Only marks the patch modified if a color changed
     int colorindex;
     RGBColor color;
     for (int i=0; i < patchsize; ++i)
@@ -201,10 +230,14 @@ public :
 	  color = Kd * lightptr->illuminate(ctrlpts[j][i],ctrlptnormals[j][i]);
 	  color += (1.0 - Kd) * basecolor;
 	  colorindex = (i*patchsize+j)*4;
-	  glctrlptcolors[colorindex+0] = color.r;
-	  glctrlptcolors[colorindex+1] = color.g;
-	  glctrlptcolors[colorindex+2] = color.b;
-	  glctrlptcolors[colorindex+3] = 1.0;
+	  if ( glctrlptcolors[colorindex+0] != color.r || glctrlptcolors[colorindex+1] != color.g ||
+	       glctrlptcolors[colorindex+2] != color.b || glctrlptcolors[colorindex+3] != 1.0 ) {
+	    glctrlptcolors[colorindex+0] = color.r;
+	    glctrlptcolors[colorindex+1] = color.g;
+	    glctrlptcolors[colorindex+2] = color.b;
+	    glctrlptcolors[colorindex+3] = 1.0;
+	    modified = true;
+	  }
 	}
   }
 
@@ -25,7 +25,8 @@ void TMPatchFace::resizePatches(int psize) {
 }
      
 // Create the patches using face information
-void TMPatchFace::createPatches(TMPatchMap &patchMap) {
+void TMPatchFace::createPatches(void) {
+  patchcorners.clear();
   if ( dlflface == NULL ) return;
 
   // patcharray will be resized here
@@ -40,7 +41,7 @@ void TMPatchFace::createPatches(TMPatchMap &patchMap) {
 
   // Get the corners of the face as an array
   // A patch will be created for each corner
-  DLFLFaceVertexPtrArray corners;
+  DLFLFaceVertexPtrArray& corners = patchcorners;
   int size;
   dlflface->getCorners(corners);
   size = corners.size();
@@ -155,17 +156,13 @@ void TMPatchFace::createPatches(TMPatchMap &patchMap) {
     cn[2][2] = normalized(6*cn[3][3]+cn[0][3]+cn[3][0]);
               
     patcharray[i].calculatePatchPoints(cp,cn);
-		setPatchPtr(patchMap, &(patcharray[i]), corners[i] );
   }
 
   // Make adjustment to face point for quadrilaterals
   if ( size == 4 ) {
     TMPatchPtr pptr1, pptr2;
-    pptr1 = getPatchPtr(patchMap,corners[0]);
-    pptr2 = getPatchPtr(patchMap,corners[2]);
-
-		if( pptr1 == NULL || pptr2 == NULL )
-			return;
+    pptr1 = &(patcharray[0]);
+    pptr2 = &(patcharray[2]);
 
     Vector3d p00,p01,p10,p11,ip;
     p00 = pptr1->getControlPoint(3,2); p01 = pptr2->getControlPoint(3,2);
@@ -173,13 +170,27 @@ void TMPatchFace::createPatches(TMPatchMap &patchMap) {
     ip = intersectCoplanarLines(p00,p01,p10,p11);
 
     for (int i=0; i < size; ++i) {
-      pptr1 = getPatchPtr(patchMap,corners[i]);
-      pptr1->setControlPoint(3,3,ip);
-      pptr1->updateGLPointArray();
+      patcharray[i].setControlPoint(3,3,ip);
+      patcharray[i].updateGLPointArray();
     }
   }
 }
 
+// Enter the patches into the map by their corners
+void TMPatchFace::registerPatches(TMPatchMap &patchMap) {
+  for (uint i=0; i < patchcorners.size(); ++i)
+    setPatchPtr(patchMap, &(patcharray[i]), patchcorners[i]);
+}
+
+// Take the patches out of the map
+void TMPatchFace::unregisterPatches(TMPatchMap &patchMap) {
+  for (uint i=0; i < patchcorners.size(); ++i) {
+    TMPatchMap::iterator it = patchMap.find(patchcorners[i]);
+    if ( it != patchMap.end() && it->second == &(patcharray[i]) ) patchMap.erase(it);
+  }
+  patchcorners.clear();
+}
+
 // Adjust the edge points for each patch in the face
 void TMPatchFace::adjustEdgePoints(TMPatchMap &patchMap) {
   if ( dlflface == NULL ) return;
@@ -22,6 +22,7 @@ protected :
   int patchsize;		// Grid size of each patch in the face
   TMPatchArray patcharray;	// Array of Bezier patches for this face
   DLFLFacePtr dlflface;	// DLFLFace associated with this Bezier face
+  DLFLFaceVertexPtrArray patchcorners; // Corners the patches were created for
 
   // Resize the patch array depending on number of corners in the DLFLFace
   void resizePatchArray(void);
@@ -30,18 +31,20 @@ public :
 
   // Default & 1-arg constructor
   TMPatchFace(int psize=4)
-    : patchsize(psize), patcharray(), dlflface(NULL) {}
+    : patchsize(psize), patcharray(), dlflface(NULL), patchcorners() {}
 
   // Destructor
   ~TMPatchFace() {}
 
   // Copy constructor
   TMPatchFace(const TMPatchFace& tmpf)
-    : patchsize(tmpf.patchsize), patcharray(tmpf.patcharray), dlflface(tmpf.dlflface) {}
+    : patchsize(tmpf.patchsize), patcharray(tmpf.patcharray), dlflface(tmpf.dlflface),
+      patchcorners(tmpf.patchcorners) {}
 
   // Assignment operator
   TMPatchFace&  operator = (const TMPatchFace& tmpf) {
     patchsize = tmpf.patchsize; patcharray = tmpf.patcharray; dlflface = tmpf.dlflface;
+    patchcorners = tmpf.patchcorners;
     return (*this);
   }
 
@@ -54,8 +57,32 @@ public :
     resizePatchArray();
   }
      
-  // Create the patches using face information
-  void createPatches(TMPatchMap &patchMap);
+  DLFLFacePtr getDLFLFace(void) const {
+    return dlflface;
+  }
+
+  // The patches of the face, one per corner
+  uint numPatches(void) const {
+    return patcharray.size();
+  }
+
+  TMPatchPtr getPatch(uint i) {
+    return &patcharray[i];
+  }
+
+  // Create the patches using face information. Only this face is changed,
+  // so different faces can be done at the same time.
+  void createPatches(void);
+
+  // Enter the patches into the map by their corners, or take them out.
+  // Taking them out doesn't look at the corners, which may be gone.
+  void registerPatches(TMPatchMap &patchMap);
+  void unregisterPatches(TMPatchMap &patchMap);
+
+  // Copy the control points of all patches to their OpenGL arrays
+  void updateGLPointArrays(void) {
+    for (uint i=0; i < patcharray.size(); ++i) patcharray[i].updateGLPointArray();
+  }
 
   // Adjust the edge points for each patch in the face
   void adjustEdgePoints(TMPatchMap &patchMap);
@@ -1,91 +1,291 @@
 /*** ***/
 
 #include "TMPatchObject.h"
+#include <DLFLParallel.h>
+#include <algorithm>
+#include <cstdio>
 
-void TMPatchObject::updateForPatches( DLFLObjectPtr obj ) {
-  DLFLFacePtrList face_list = obj->getFaceList( );
-  DLFLEdgePtrList edge_list = obj->getEdgeList( );
-  DLFLVertexPtrList vertex_list = obj->getVertexList( );
-
-  // Update information stored at each face, vertex, edge and corner for patch rendering
-
-  // Compute doo-sabin coordinates for each face and store them in the auxcoord field of the corner
-  // Update the auxcoord field of the face
+// Doo-Sabin coordinates of the corners of a face, and its patch point and normal
+static void updateFaceForPatches( DLFLFacePtr fp ) {
   Vector3dArray coords;
-  DLFLFacePtrList::iterator ffirst=face_list.begin(), flast=face_list.end();
-  DLFLFacePtr fp;
   DLFLFaceVertexPtrArray corners;
   int valence;
-       
-  while ( ffirst != flast ) {
-    fp = *ffirst; ++ffirst;
-    fp->getCornersAndCoords(corners,coords);
-    valence = coords.size();
-
-    if ( valence > 0 ) {
-      // Compute Doo-Sabin coordinates - Level 1
-      DLFL::computeDooSabinCoords(coords);
-      for (int i=0; i < valence; ++i) 
-				corners[i]->setAuxCoords(coords[i]);
-
-      // Compute Doo-Sabin coordinates - Level 2
-      DLFL::computeDooSabinCoords(coords);
-      for (int i=0; i < valence; ++i) {
-				corners[i]->setDS2Coord2(coords[i]);
-      }
-
-      // Compute the patch point and patch normal
-      Vector3d pp, pn;
-      DLFL::computeCentroidAndNormal(coords,pp,pn);
-      fp->setAuxCoords(pp); fp->setAuxNormal(pn);
+
+  fp->getCornersAndCoords(corners,coords);
+  valence = coords.size();
+
+  if ( valence > 0 ) {
+    // Compute Doo-Sabin coordinates - Level 1
+    DLFL::computeDooSabinCoords(coords);
+    for (int i=0; i < valence; ++i) 
+      corners[i]->setAuxCoords(coords[i]);
+
+    // Compute Doo-Sabin coordinates - Level 2
+    DLFL::computeDooSabinCoords(coords);
+    for (int i=0; i < valence; ++i) {
+      corners[i]->setDS2Coord2(coords[i]);
     }
+
+    // Compute the patch point and patch normal
+    Vector3d pp, pn;
+    DLFL::computeCentroidAndNormal(coords,pp,pn);
+    fp->setAuxCoords(pp); fp->setAuxNormal(pn);
   }
+}
 
-  // Compute patch point and normal for all edges
-  DLFLEdgePtrList::iterator efirst=edge_list.begin(), elast=edge_list.end();
-  DLFLEdgePtr ep;
-  while ( efirst != elast ) {
-    ep = *efirst; ++efirst;
+// Patch point and normal of an edge, from the corners on either side of it
+static void updateEdgeForPatches( DLFLEdgePtr ep ) {
+  Vector3dArray p;
+  ep->getEFCornersAuxCoords(p);
+            
+  // Compute Doo-Sabin coordinates - Level 2
+  DLFL::computeDooSabinCoords(p);
+
+  Vector3d pp,pn;
+  computeCentroidAndNormal(p,pp,pn);
+  ep->setAuxCoords(pp); ep->setAuxNormal(pn);
+
+  DLFLFaceVertexPtrArray fvp;
+  ep->getEFCorners(fvp);
+  fvp[0]->setDS2Coord3(p[0]); fvp[1]->setDS2Coord1(p[1]);
+  fvp[2]->setDS2Coord3(p[2]); fvp[3]->setDS2Coord1(p[3]);
+}
+
+// Patch point and normal of a vertex, from the corners around it
+static void updateVertexForPatches( DLFLVertexPtr vp ) {
+  Vector3dArray p;
+  vp->getOrderedCornerAuxCoords(p);
 
-    Vector3dArray p;
-    ep->getEFCornersAuxCoords(p);
+  // Compute Doo-Sabin coordinates - Level 2
+  DLFL::computeDooSabinCoords(p);
+
+  Vector3d pp,pn;
+  DLFL::computeCentroidAndNormal(p,pp,pn);
+  vp->setAuxCoords(pp); vp->setAuxNormal(-pn); // Reverse the normal since the rotation order around the vertex is clockwise
             
-    // Compute Doo-Sabin coordinates - Level 2
-    DLFL::computeDooSabinCoords(p);
+  DLFLFaceVertexPtrArray fvp;
+  vp->getOrderedCorners(fvp);
+  for (int i=0; i < fvp.size(); ++i) {
+    fvp[i]->setDS2Coord0(p[i]);
+  }
+}
 
-    Vector3d pp,pn;
-    computeCentroidAndNormal(p,pp,pn);
-    ep->setAuxCoords(pp); ep->setAuxNormal(pn);
+// Update the information for patch rendering at the faces, then at the edges
+// and vertices, which use what the faces around them got. Each pass is done
+// in parallel: a face sets its corners, an edge the level 2 coordinates 3 and
+// 1 of the corners after it and at it, a vertex coordinate 0 of its corners.
+static void updateForPatches( const DLFLFacePtrArray& faces, const DLFLEdgePtrArray& edges,
+                              const DLFLVertexPtrArray& vertices ) {
+  int num = faces.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) updateFaceForPatches(faces[i]);
 
-    DLFLFaceVertexPtrArray fvp;
-    ep->getEFCorners(fvp);
-    fvp[0]->setDS2Coord3(p[0]); fvp[1]->setDS2Coord1(p[1]);
-    fvp[2]->setDS2Coord3(p[2]); fvp[3]->setDS2Coord1(p[3]);
+  num = edges.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) updateEdgeForPatches(edges[i]);
+
+  num = vertices.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) updateVertexForPatches(vertices[i]);
+}
+
+void TMPatchObject::updateForPatches( DLFLObjectPtr obj ) {
+  // Update information stored at each face, vertex, edge and corner for patch rendering
+  DLFLFacePtrArray faces;
+  DLFLEdgePtrArray edges;
+  DLFLVertexPtrArray vertices;
+  obj->getFaces(faces); obj->getEdges(edges); obj->getVertices(vertices);
+  ::updateForPatches(faces,edges,vertices);
+}
+
+// Make the patches on either side of an edge meet at its middle
+static void adjustEdgePatches( const TMPatchMap& patchMap, DLFLEdgePtr ep ) {
+  DLFLFaceVertexPtr fvp1,fvp2;
+  TMPatchPtr pp1, pp2, np1, np2;
+  Vector3d p00,p01,p10,p11,ip;
+
+  ep->getCorners(fvp1,fvp2);
+  pp1 = getPatchPtr(patchMap,fvp1); pp2 = getPatchPtr(patchMap,fvp2);
+  np1 = getPatchPtr(patchMap,fvp1->next()); np2 = getPatchPtr(patchMap,fvp2->next());
+  if( pp1 == NULL || pp2 == NULL || np1 == NULL || np2 == NULL )
+    return;
+
+  p00 = pp1->getControlPoint(2,0); 
+  p01 = pp2->getControlPoint(2,0);
+  p10 = pp1->getControlPoint(3,1); 
+  p11 = pp2->getControlPoint(3,1);
+  ip = intersectCoplanarLines(p00,p01,p10,p11);
+
+  pp1->setControlPoint(3,0,ip); pp2->setControlPoint(3,0,ip);
+  np1->setControlPoint(0,3,ip); np2->setControlPoint(0,3,ip);
+}
+
+// Make the patches around a 4-valence vertex meet at one point
+static void adjustVertexPatches( const TMPatchMap& patchMap, DLFLVertexPtr vp ) {
+  if ( vp->valence() != 4 ) return;
+  DLFLFaceVertexPtrArray vcorners;
+  TMPatchPtr pp[4];
+  Vector3d p00,p01,p10,p11,ip;
+
+  vp->getOrderedCorners(vcorners);
+  for( int i = 0; i < 4; ++i ) {
+    pp[i] = getPatchPtr(patchMap,vcorners[i]);
+    if ( pp[i] == NULL ) return;
   }
 
-  // Compute patch point and normal for all vertices
-  DLFLVertexPtrList::iterator vfirst=vertex_list.begin(), vlast=vertex_list.end();
-  DLFLVertexPtr vp;
-  while ( vfirst != vlast ) {
-    vp = *vfirst; ++vfirst;
-    Vector3dArray p;
-    vp->getOrderedCornerAuxCoords(p);
+  p00 = pp[0]->getControlPoint(1,0); p01 = pp[2]->getControlPoint(1,0);
+  p10 = pp[0]->getControlPoint(0,1); p11 = pp[2]->getControlPoint(0,1);
+  ip = intersectCoplanarLines(p00,p01,p10,p11);
+				
+  for( int i = 0; i < 4; ++i ) pp[i]->setControlPoint(0,0,ip);
+}
 
-    // Compute Doo-Sabin coordinates - Level 2
-    DLFL::computeDooSabinCoords(p);
+// Make the patches of the patch faces and enter them in the map, then adjust
+// the patches along the edges and around the vertices given, and copy the
+// control points of the touched patch faces to OpenGL. The adjustments only
+// set control points which nothing else reads or sets - the middle of an
+// edge, the point at a vertex - so each step is done in parallel.
+static void makePatches( TMPatchMap& patchMap, const TMPatchFacePtrArray& patches,
+                         const DLFLEdgePtrArray& edges, const DLFLVertexPtrArray& vertices,
+                         const TMPatchFacePtrArray& touched ) {
+  int num = patches.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) patches[i]->createPatches();
 
-    Vector3d pp,pn;
-    DLFL::computeCentroidAndNormal(p,pp,pn);
-    vp->setAuxCoords(pp); vp->setAuxNormal(-pn); // Reverse the normal since the rotation order around the vertex is clockwise
-            
-    DLFLFaceVertexPtrArray fvp;
-    vp->getOrderedCorners(fvp);
-    for (int i=0; i < fvp.size(); ++i) {
-      // cout << "TMPatchObject::updateForPatches() check corner " << fvp[i]->getID() << endl;
-      // cout << "--->setDS2Coord0()" << endl;
-      fvp[i]->setDS2Coord0(p[i]);
+  for (int i=0; i < num; ++i) patches[i]->registerPatches(patchMap);
+
+  num = edges.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) adjustEdgePatches(patchMap,edges[i]);
+
+  num = vertices.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) adjustVertexPatches(patchMap,vertices[i]);
+
+  num = touched.size();
+#pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) touched[i]->updateGLPointArrays();
+}
+
+template <class T>
+static void sortUnique( vector<T>& array ) {
+  std::sort(array.begin(),array.end());
+  array.erase(std::unique(array.begin(),array.end()),array.end());
+}
+
+// The vertices and edges of the faces, each once
+static void verticesAndEdges( const DLFLFacePtrArray& faces, DLFLVertexPtrArray& vertices,
+                              DLFLEdgePtrArray& edges ) {
+  DLFLFaceVertexPtrArray corners;
+  DLFLEdgePtrArray fedges;
+  vertices.clear(); edges.clear();
+  for (uint i=0; i < faces.size(); ++i) {
+    faces[i]->getCorners(corners);
+    for (uint j=0; j < corners.size(); ++j) vertices.push_back(corners[j]->vertex);
+    faces[i]->getEdges(fedges);
+    edges.insert(edges.end(),fedges.begin(),fedges.end());
+  }
+  sortUnique(vertices); sortUnique(edges);
+}
+
+// The faces around the vertices, each once
+static void facesAround( const DLFLVertexPtrArray& vertices, DLFLFacePtrArray& faces ) {
+  DLFLFacePtrArray vfaces;
+  faces.clear();
+  for (uint i=0; i < vertices.size(); ++i) {
+    vertices[i]->getFaces(vfaces);
+    faces.insert(faces.end(),vfaces.begin(),vfaces.end());
+  }
+  sortUnique(faces);
+}
+
+void TMPatchObject::updatePatches( DLFLObjectPtr obj ) {
+  if( !obj ) {obj = mObj;}
+  if( !obj ) {return;}
+  DLFLFacePtrArray faces, changed;
+  DLFLEdgePtrArray edges;
+  DLFLVertexPtrArray vertices;
+  if ( obj == mObj && obj->getGeneration() >= generation &&
+       obj->changesSince(generation,faces,edges,vertices) ) {
+    if ( obj->getGeneration() == generation ) return;
+    // The faces in the journal, and those at the edges and vertices in it.
+    // Removed faces are passed on so their patches go too.
+    changed = faces;
+    for (uint i=0; i < edges.size(); ++i) {
+      if ( !obj->hasEdge(edges[i]) ) continue;
+      DLFLFacePtr fp1, fp2;
+      edges[i]->getFacePointers(fp1,fp2);
+      changed.push_back(fp1); changed.push_back(fp2);
+    }
+    for (uint i=0; i < vertices.size(); ++i) {
+      if ( !obj->hasVertex(vertices[i]) ) continue;
+      vertices[i]->getFaces(faces);
+      changed.insert(changed.end(),faces.begin(),faces.end());
+    }
+    sortUnique(changed);
+    if ( updatePatches(obj,changed) ) {
+      generation = obj->getGeneration();
+      return;
     }
   }
+  updateForPatches(obj);
+  createPatches(obj);
+}
+
+bool TMPatchObject::updatePatches( DLFLObjectPtr obj, const DLFLFacePtrArray& changed ) {
+  // Past a quarter of the object, the rings around the faces cover most of it
+  if ( changed.size() > obj->num_faces() / 4 ) return false;
+
+  // The patches of the faces which are gone go first, the corners they
+  // were entered in the map by may be in use again by new faces
+  DLFLFacePtrArray faces;
+  for (uint i=0; i < changed.size(); ++i) {
+    if ( obj->hasFace(changed[i]) ) { faces.push_back(changed[i]); continue; }
+    map<DLFLFacePtr, TMPatchFacePtrList::iterator>::iterator it = patch_idx.find(changed[i]);
+    if ( it == patch_idx.end() ) continue;
+    TMPatchFacePtr pfp = *(it->second);
+    pfp->unregisterPatches(patchMap);
+    delete pfp;
+    patch_list.erase(it->second);
+    patch_idx.erase(it);
+  }
+
+  // The faces, edges and vertices which use the changed faces
+  DLFLVertexPtrArray vertices;
+  DLFLEdgePtrArray edges;
+  verticesAndEdges(faces,vertices,edges);
+  ::updateForPatches(faces,edges,vertices);
+
+  // The patches use those of the faces around their vertices
+  DLFLFacePtrArray ring;
+  facesAround(vertices,ring);
+  TMPatchFacePtrArray patches;
+  for (uint i=0; i < ring.size(); ++i) {
+    map<DLFLFacePtr, TMPatchFacePtrList::iterator>::iterator it = patch_idx.find(ring[i]);
+    TMPatchFacePtr pfp;
+    if ( it != patch_idx.end() ) {
+      pfp = *(it->second);
+      pfp->unregisterPatches(patchMap);
+    } else {
+      pfp = new TMPatchFace(patchsize);
+      patch_idx[ring[i]] = patch_list.insert(patch_list.end(),pfp);
+    }
+    pfp->setDLFLFace(ring[i]);
+    patches.push_back(pfp);
+  }
+
+  // They are adjusted along their edges and around their vertices, which
+  // moves points of the patches of the faces around those
+  DLFLFacePtrArray around;
+  verticesAndEdges(ring,vertices,edges);
+  facesAround(vertices,around);
+  TMPatchFacePtrArray touched;
+  for (uint i=0; i < around.size(); ++i) {
+    map<DLFLFacePtr, TMPatchFacePtrList::iterator>::iterator it = patch_idx.find(around[i]);
+    if ( it != patch_idx.end() ) touched.push_back(*(it->second));
+  }
+  makePatches(patchMap,patches,edges,vertices,touched);
+  return true;
 }
 
 void TMPatchObject::for_each(void (TMPatchFace::*func)(void)) {
@@ -104,84 +304,33 @@ void TMPatchObject::destroyPatches() {
 		delete pfp;
 	}
 	patch_list.clear();
+	patch_idx.clear();
 }
 
 // Build the list of patch faces
 void TMPatchObject::createPatches( DLFLObjectPtr obj ) {
   destroyPatches();
 	destroyPatchMap( patchMap );
-  DLFLFacePtrList face_list = obj->getFaceList( );
-	DLFLFacePtrList::iterator ffirst = face_list.begin(), flast = face_list.end();
-	DLFLFacePtr fp = NULL;
-	TMPatchFacePtr pfp = NULL;
+	DLFLFacePtrArray faces;
+	DLFLEdgePtrArray edges;
+	DLFLVertexPtrArray vertices;
+	obj->getFaces(faces); obj->getEdges(edges); obj->getVertices(vertices);
 
-	while ( ffirst != flast ) {
-		fp = (*ffirst); ++ffirst;
-		pfp = new TMPatchFace(patchsize);
-		pfp->setDLFLFace(fp); 
-		pfp->createPatches(patchMap);
-		patch_list.push_back(pfp);
+	TMPatchFacePtrArray patches;
+	patches.reserve(faces.size());
+	for (uint i=0; i < faces.size(); ++i) {
+		TMPatchFacePtr pfp = new TMPatchFace(patchsize);
+		pfp->setDLFLFace(faces[i]);
+		patch_idx[faces[i]] = patch_list.insert(patch_list.end(),pfp);
+		patches.push_back(pfp);
 	}
 
-	// Adjust the edge points for all patches
-	DLFLEdgePtrList edge_list = obj->getEdgeList();
-	DLFLEdgePtrList::iterator efirst = edge_list.begin(), elast = edge_list.end();
-	DLFLEdgePtr ep = NULL;
-	DLFLFaceVertexPtr fvp1,fvp2;
-	TMPatchPtr pp1, pp2;
-	Vector3d p00,p01,p10,p11,ip;
-	while ( efirst != elast ) {
-		ep = (*efirst); ++efirst;
-		ep->getCorners(fvp1,fvp2);
-		pp1 = getPatchPtr(patchMap,fvp1); pp2 = getPatchPtr(patchMap,fvp2);
-
-		if( pp1 == NULL || pp2 == NULL )
-			return;
-
-		p00 = pp1->getControlPoint(2,0); 
-		p01 = pp2->getControlPoint(2,0);
-		p10 = pp1->getControlPoint(3,1); 
-		p11 = pp2->getControlPoint(3,1);
-		ip = intersectCoplanarLines(p00,p01,p10,p11);
-
-		pp1->setControlPoint(3,0,ip); pp2->setControlPoint(3,0,ip);
-		pp1->updateGLPointArray(); pp2->updateGLPointArray();
-
-		pp1 = getPatchPtr(patchMap,fvp1->next()); pp2 = getPatchPtr(patchMap,fvp2->next());
-		pp1->setControlPoint(0,3,ip); pp2->setControlPoint(0,3,ip);
-		pp1->updateGLPointArray(); pp2->updateGLPointArray();
-	}
+	// Adjust the edge points for all patches, and the vertex points for
+	// 4-valence vertices
+	makePatches(patchMap,patches,edges,vertices,patches);
 
-	// Adjust the vertex points for 4-valence vertices
-	DLFLVertexPtrList vertex_list = obj->getVertexList( );
-	DLFLVertexPtrList::iterator vfirst = vertex_list.begin(), vlast = vertex_list.end();
-	DLFLVertexPtr vp = NULL;
-	while ( vfirst != vlast ) {
-		vp = (*vfirst); ++vfirst;
-		if ( vp->valence() == 4 ) {
-			DLFLFaceVertexPtrArray vcorners;
-			vp->getOrderedCorners(vcorners);
-			pp1 = getPatchPtr(patchMap,vcorners[0]); pp2 = getPatchPtr(patchMap,vcorners[2]);
-
-			p00 = pp1->getControlPoint(1,0); p01 = pp2->getControlPoint(1,0);
-			p10 = pp1->getControlPoint(0,1); p11 = pp2->getControlPoint(0,1);
-			ip = intersectCoplanarLines(p00,p01,p10,p11);
-				
-			for( int i = 0; i < 4; ++i ) {
-				pp1 = getPatchPtr(patchMap,vcorners[i]);
-				pp1->setControlPoint(0,0,ip);
-				pp1->updateGLPointArray();
-			}
-		}
-	}
-                 
-	/*
-		TMPatchFacePtrList::iterator pfirst = patch_list.begin(), plast = patch_list.end();
-		while ( pfirst != plast ) {
-		pfp = (*pfirst); ++pfirst;
-		pfp->adjustEdgePoints(patchMap);
-		}
-	*/
+	mObj = obj;
+	generation = obj->getGeneration();
 }
 
 void TMPatchObject::setPatchSize( int size, DLFLObjectPtr obj ){
@@ -195,28 +344,63 @@ void TMPatchObject::setPatchSize( int size, DLFLObjectPtr obj ){
 
 /* stuart - bezier export */
 void TMPatchObject::objPatchWrite( ostream& o ) {
-  o << "g patches" << std::endl
-    << "mg 1 0.5"  << std::endl << std::endl;
-  TMPatchFacePtrList::const_iterator first = patch_list.begin(), last = patch_list.end();
-  int i = 0;
-  int v = 0;
-  while( first != last ) {
-    o << "# Face " << i+1 << std::endl;
-    int npatches = (*first)->print(o);
-    int j = 0;
-    while( j < npatches ) {
-      o << "# Patch" << i+j+1 << std::endl;
-      o << "cstype bezier" << std::endl
-	<< "deg 3 3" << std::endl
-	<< "surf 0.000000 1.000000 0.000000 1.000000 " 
-	<< 1+v << " " << 2+v << " " << 3+v << " " << 4+v << " " << 5+v << " " << 6+v << " " << 7+v << " " << 8+v << " " << 9+v << " " << 10+v << " " << 11+v << " " << 12+v << " " << 13+v << " " << 14+v << " " << 15+v << " " << 16+v << std::endl
-	<< "parm u 0.000000 1.000000" << std::endl
-	<< "parm v 0.000000 1.000000" << std::endl
-	<< "end" << std::endl << std::endl;
-      j++;
-      v += 16;
+  tessellation.update(patch_list);
+  const vector<TMPatchTessellation::Point>& points = tessellation.points();
+  const vector<uint>& firsts = tessellation.faceFirsts();
+  const vector<uint>& cells = tessellation.pattern(TMPatchTessellation::Triangles);
+  uint num = tessellation.numPatches(), per = tessellation.pointsPerPatch();
+  uint percell = tessellation.indicesPerPatch(TMPatchTessellation::Triangles);
+
+  o << "g patches" << std::endl << std::endl;
+  char line[128];
+  uint face = 0;
+  for (uint i=0; i < num; ++i) {
+    while ( face < firsts.size() && firsts[face] <= i ) {
+      if ( face+1 == firsts.size() || firsts[face+1] > i ) o << "# Face " << face+1 << std::endl;
+      ++face;
+    }
+    o << "# Patch " << i+1 << std::endl;
+    // Formatted by hand, there are many more lines than control points
+    for (uint j=0; j < per; ++j) {
+      const float *p = points[i*per+j].position;
+      o.write(line,snprintf(line,sizeof(line),"v %g %g %g\n",p[0],p[1],p[2]));
+    }
+    for (uint j=0; j < per; ++j) {
+      const float *n = points[i*per+j].normal;
+      o.write(line,snprintf(line,sizeof(line),"vn %g %g %g\n",n[0],n[1],n[2]));
+    }
+    // The two triangles of a cell make a quad, which fans back into them
+    uint v = i*per + 1;
+    for (uint j=0; j < percell; j += 6) {
+      uint a = cells[j]+v, b = cells[j+1]+v, c = cells[j+2]+v, d = cells[j+5]+v;
+      o.write(line,snprintf(line,sizeof(line),"f %u//%u %u//%u %u//%u %u//%u\n",a,a,b,b,c,c,d,d));
     }
-    ++first;
-    i++;
+    o << std::endl;
+  }
+}
+
+// Draw with the points of BatchPatches patches at a time, so the indices
+// of the pattern are the same for every batch
+void TMPatchObject::renderTessellation(TMPatchTessellation::Pattern which) {
+  tessellation.update(patch_list);
+  typedef TMPatchTessellation::Point Point;
+  const vector<Point>& points = tessellation.points();
+  const vector<uint>& indices = tessellation.pattern(which);
+  uint num = tessellation.numPatches(), per = tessellation.pointsPerPatch();
+  uint batch = TMPatchTessellation::BatchPatches;
+  uint count = tessellation.indicesPerPatch(which);
+  if ( num == 0 || count == 0 ) return;
+
+  bool surface = ( which == TMPatchTessellation::Triangles );
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  if ( surface ) glEnableClientState(GL_COLOR_ARRAY);
+  for (uint first=0; first < num; first += batch) {
+    const Point *base = &points[first*per];
+    glVertexPointer(3,GL_FLOAT,sizeof(Point),base->position);
+    if ( surface ) glColorPointer(4,GL_UNSIGNED_BYTE,sizeof(Point),base->color);
+    glDrawElements(surface ? GL_TRIANGLES : GL_LINES, std::min(batch,num-first)*count,
+                   GL_UNSIGNED_INT, &indices[0]);
   }
+  glPopClientAttrib();
 }
@@ -1,7 +1,7 @@
 #ifndef _TM_PATCH_OBJECT_HH_
 #define _TM_PATCH_OBJECT_HH_
 
-#include "TMPatchFace.h"
+#include "TMPatchTessellation.h"
 
 class TMPatchObject;
 typedef TMPatchObject* TMPatchObjectPtr;
@@ -17,7 +17,7 @@ protected:
 public:
   //   Default constructor
   TMPatchObject(uint id) :
-    uid(id), patch_list(), patchsize(4) {
+    uid(id), patch_list(), patchsize(4), mObj(NULL), generation(0) {
   }
 
   uint id() {
@@ -35,12 +35,13 @@ public:
   void for_each(void(TMPatchFace::*func)(void));
 
   /* stuart - bezier export */
+  // Writes the patches as the polygons of their tessellation, as drawn
   void objPatchWrite( ostream& o );
 
 private :
 
   TMPatchObject(const TMPatchObject& tmpo)
-  : patch_list(), patchsize(tmpo.patchsize) {}
+  : patch_list(), patchsize(tmpo.patchsize), mObj(NULL), generation(0) {}
 
   void operator=(const TMPatchObject& tmpo) {}
 
@@ -49,13 +50,22 @@ public :
   ~TMPatchObject() {destroyPatches(); destroyPatchMap(patchMap);}
 
 protected :
-  DLFLObjectPtr mObj;
+  DLFLObjectPtr mObj;    // Object the patches were made for, NULL for none
+  unsigned long generation; // Generation of mObj when they were made
 
   TMPatchMap patchMap;
+  map<DLFLFacePtr, TMPatchFacePtrList::iterator> patch_idx; // Patch face of each face
+  TMPatchTessellation tessellation; // What the patches are drawn and exported as
 
   void destroyPatches();
   /*Build the list of patch faces*/
   void createPatches( DLFLObjectPtr obj );
+  /*
+   * Remake the patches around the given faces, which have changed or are
+   * new, and drop the patch faces of the faces which are no longer in obj.
+   * Returns false if that is about as much work as making all of them.
+   */
+  bool updatePatches( DLFLObjectPtr obj, const DLFLFacePtrArray& faces );
 
 public :
 
@@ -67,27 +77,26 @@ public :
   void updateForPatches( DLFLObjectPtr obj );
 
   /*
-   * Update the patches
+   * Update the patches. When they were last made for the same object, and
+   * its change journal goes back to then, only the patches within one ring
+   * of the changed faces and vertices are made again. The Doo-Sabin
+   * coordinates and patch points kept in the elements of the object are
+   * taken as still good elsewhere - the operations which use those as
+   * scratch space (the subdivisions) change the whole object anyway.
    */
-  void updatePatches( DLFLObjectPtr obj = NULL ) {
-    if( !obj ) {obj = mObj;}
-    if( !obj ) {return;}
-    updateForPatches(obj);
-    createPatches(obj);
-  }
+  void updatePatches( DLFLObjectPtr obj = NULL );
 
   void renderPatches(void) {
     glPushMatrix();
     transform();
-    for_each(&TMPatchFace::render);
+    renderTessellation(TMPatchTessellation::Triangles);
     glPopMatrix();
   }
   //Render the object using patches*/
   void renderWireframePatches(void) {
     glPushMatrix();
     transform();
-    //for_each(face_list.begin(), face_list.end(), outline);*/
-    for_each(&TMPatchFace::outline);
+    renderTessellation(TMPatchTessellation::Wireframe);
     glPopMatrix();
   }
 
@@ -103,16 +112,14 @@ public :
   void renderPatchBoundaries(void) {
     glPushMatrix();
     transform();
-    //for_each(patch_list.begin(), patch_list.end(), tmpf_patch_boundary);
-    for_each(&TMPatchFace::patch_boundary);
+    renderTessellation(TMPatchTessellation::PatchBoundaries);
     glPopMatrix();
   }
 
   void renderPatchFaceBoundaries(void) {
     glPushMatrix();
     transform();
-    //for_each(patch_list.begin(), patch_list.end(), tmpf_face_boundary);
-    for_each(&TMPatchFace::face_boundary);
+    renderTessellation(TMPatchTessellation::FaceBoundaries);
     glPopMatrix();
   }
 
@@ -146,6 +153,10 @@ public :
     }
   }
 
+  // Draw the tessellation of the patches, brought up to date first. Only
+  // the surface is drawn in the colors of the patches.
+  void renderTessellation(TMPatchTessellation::Pattern which);
+
   void transform( ) {
     double mat[16];
     mObj->tr.fillArrayColumnMajor(mat);
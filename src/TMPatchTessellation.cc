@@ -0,0 +1,216 @@
+/*** ***/
+
+#include "TMPatchTessellation.h"
+#include <DLFLParallel.h>
+#include <algorithm>
+
+TMPatchTessellation::TMPatchTessellation(int res)
+  : resolution(0), patches(), face_first(), grid(), bases() {
+  setResolution(res);
+}
+
+void TMPatchTessellation::setResolution(int res) {
+  if ( res < 1 ) res = 1;
+  if ( res == resolution ) return;
+  resolution = res;
+  // Every patch has to be evaluated again
+  patches.clear(); face_first.clear(); grid.clear(); bases.clear();
+  makePatterns();
+}
+
+void TMPatchTessellation::makeBasis(uint order) {
+  if ( order >= bases.size() ) bases.resize(order+1);
+  Basis& basis = bases[order];
+  if ( order == 0 || !basis.value.empty() ) return;
+
+  int num = resolution+1, degree = order-1;
+  basis.value.assign(order*num,0.0);
+  basis.slope.assign(order*num,0.0);
+  for (int s=0; s < num; ++s) {
+    double u = double(s) / double(resolution);
+    // Bernstein polynomials of the degree and the one below it
+    std::vector<double> b(order,0.0), lower(order,0.0);
+    b[0] = 1.0;
+    for (int d=1; d <= degree; ++d) {
+      lower = b;
+      b[0] = (1.0-u)*lower[0];
+      for (int j=1; j <= d; ++j) b[j] = (1.0-u)*lower[j] + u*lower[j-1];
+    }
+    for (int j=0; j < (int)order; ++j) {
+      basis.value[j*num+s] = b[j];
+      if ( degree > 0 )
+        basis.slope[j*num+s] = degree * (( j > 0 ? lower[j-1] : 0.0 ) - ( j < degree ? lower[j] : 0.0 ));
+    }
+  }
+}
+
+void TMPatchTessellation::makePatterns(void) {
+  uint num = resolution+1, per = num*num;
+  for (int k=0; k < NumPatterns; ++k) patterns[k].clear();
+
+  // Same cells as the quad strips of glEvalMesh2, each cut along the diagonal
+  // from its first corner like GL_QUAD_STRIP
+  std::vector<uint> triangles, wireframe, patchboundaries, faceboundaries;
+  for (uint t=0; t < num-1; ++t)
+    for (uint s=0; s < num-1; ++s) {
+      uint a = t*num+s, b = (t+1)*num+s, c = (t+1)*num+s+1, d = t*num+s+1;
+      triangles.push_back(a); triangles.push_back(b); triangles.push_back(c);
+      triangles.push_back(a); triangles.push_back(c); triangles.push_back(d);
+    }
+
+  // The lines of a 6x6 grid, each drawn through all samples on it
+  std::vector<uint> lines;
+  for (uint k=0; k <= 6; ++k) lines.push_back((k*resolution+3)/6);
+  lines.erase(std::unique(lines.begin(),lines.end()),lines.end());
+  for (uint k=0; k < lines.size(); ++k)
+    for (uint s=0; s < num-1; ++s) {
+      wireframe.push_back(lines[k]*num+s); wireframe.push_back(lines[k]*num+s+1);
+      wireframe.push_back(s*num+lines[k]); wireframe.push_back((s+1)*num+lines[k]);
+    }
+
+  for (uint s=0; s < num-1; ++s) {
+    faceboundaries.push_back(s); faceboundaries.push_back(s+1);
+    patchboundaries.push_back(s); patchboundaries.push_back(s+1);
+    patchboundaries.push_back(s*num+num-1); patchboundaries.push_back((s+1)*num+num-1);
+  }
+
+  const std::vector<uint> *single[NumPatterns] = { &triangles, &wireframe, &patchboundaries, &faceboundaries };
+  for (int k=0; k < NumPatterns; ++k) {
+    std::vector<uint>& pattern = patterns[k];
+    pattern.reserve(single[k]->size() * BatchPatches);
+    for (uint i=0; i < BatchPatches; ++i)
+      for (uint j=0; j < single[k]->size(); ++j) pattern.push_back(i*per + (*single[k])[j]);
+  }
+}
+
+void TMPatchTessellation::evaluate(const TMPatch& patch, Point *points) const {
+  int num = resolution+1, order = patch.getPatchSize();
+  const GLdouble *ctrlpts = patch.getGLControlPoints();
+  const GLdouble *ctrlcolors = patch.getGLControlPointColors();
+  if ( order < 1 || ctrlpts == NULL ) {
+    Point zero = { {0,0,0,0}, {0,0,0}, {0,0,0} };
+    std::fill(points,points+num*num,zero);
+    return;
+  }
+  const double *value = &(bases[order].value[0]);
+  const double *slope = &(bases[order].slope[0]);
+
+  // Channels of a row: x, y, z, r, g, b, a and d/du of x, y, z
+  enum { Colors = 3, Slopes = 7, Channels = 10 };
+
+  // Every row of control points (fixed v) summed over u at all samples of u
+  std::vector<double> rows(order*Channels*num,0.0);
+  for (int r=0; r < order; ++r) {
+    double *row = &rows[r*Channels*num];
+    for (int j=0; j < order; ++j) {
+      const double *b = value + j*num, *db = slope + j*num;
+      const GLdouble *p = ctrlpts + (r*order+j)*3, *c = ctrlcolors + (r*order+j)*4;
+      for (int ch=0; ch < 3; ++ch) {
+        double *out = row + ch*num, *dout = row + (Slopes+ch)*num, w = p[ch];
+        for (int s=0; s < num; ++s) { out[s] += w*b[s]; dout[s] += w*db[s]; }
+      }
+      for (int ch=0; ch < 4; ++ch) {
+        double *out = row + (Colors+ch)*num, w = c[ch];
+        for (int s=0; s < num; ++s) out[s] += w*b[s];
+      }
+    }
+  }
+
+  // Then the rows summed over v for each row of samples, d/dv of x, y, z
+  // after the others
+  std::vector<double> sums((Channels+3)*num);
+  for (int t=0; t < num; ++t) {
+    std::fill(sums.begin(),sums.end(),0.0);
+    for (int r=0; r < order; ++r) {
+      const double *row = &rows[r*Channels*num];
+      double w = value[r*num+t], dw = slope[r*num+t];
+      for (int ch=0; ch < Channels; ++ch) {
+        double *out = &sums[ch*num];
+        const double *in = row + ch*num;
+        for (int s=0; s < num; ++s) out[s] += w*in[s];
+      }
+      for (int ch=0; ch < 3; ++ch) {
+        double *out = &sums[(Channels+ch)*num];
+        const double *in = row + ch*num;
+        for (int s=0; s < num; ++s) out[s] += dw*in[s];
+      }
+    }
+
+    for (int s=0; s < num; ++s) {
+      Point& point = points[t*num+s];
+      Vector3d du, dv;
+      for (int ch=0; ch < 3; ++ch) {
+        point.position[ch] = sums[ch*num+s];
+        du[ch] = sums[(Slopes+ch)*num+s];
+        dv[ch] = sums[(Channels+ch)*num+s];
+      }
+      for (int ch=0; ch < 4; ++ch) {
+        double c = sums[(Colors+ch)*num+s];
+        c = ( c < 0.0 ) ? 0.0 : ( ( c > 1.0 ) ? 1.0 : c );
+        point.color[ch] = (unsigned char)(c*255.0 + 0.5);
+      }
+
+      // Where a side of the patch is collapsed the derivative across it
+      // vanishes, the diagonals of the control grid are used there
+      Vector3d n = dv % du;
+      if ( normsqr(n) < 1.0e-20 * (normsqr(du) + normsqr(dv) + 1.0e-20) ) {
+        const GLdouble *p00 = ctrlpts, *p10 = ctrlpts + (order-1)*3;
+        const GLdouble *p01 = ctrlpts + (order-1)*order*3, *p11 = ctrlpts + (order*order-1)*3;
+        Vector3d d1(p11[0]-p00[0],p11[1]-p00[1],p11[2]-p00[2]);
+        Vector3d d2(p01[0]-p10[0],p01[1]-p10[1],p01[2]-p10[2]);
+        n = d2 % d1;
+      }
+      // Not normalize, which leaves the normals of small patches alone
+      double len = norm(n);
+      if ( len > 0.0 ) n /= len;
+      for (int ch=0; ch < 3; ++ch) point.normal[ch] = n[ch];
+    }
+  }
+}
+
+bool TMPatchTessellation::update(const TMPatchFacePtrList& faces) {
+  std::vector<TMPatchPtr> order;
+  std::vector<uint> firsts;
+  TMPatchFacePtrList::const_iterator first = faces.begin(), last = faces.end();
+  while ( first != last ) {
+    TMPatchFacePtr pfp = (*first); ++first;
+    firsts.push_back(order.size());
+    for (uint i=0; i < pfp->numPatches(); ++i) order.push_back(pfp->getPatch(i));
+  }
+  face_first.swap(firsts);
+
+  uint per = pointsPerPatch();
+  std::vector<int> todo;
+  bool moved = ( order != patches );
+  if ( !moved ) {
+    for (uint i=0; i < patches.size(); ++i)
+      if ( patches[i]->isModified() ) todo.push_back(i);
+  } else {
+    // Patches which are still there keep their points. One which was
+    // deleted and another made where it was is modified, so it isn't
+    // taken for the old one.
+    std::map<TMPatchPtr,uint> old;
+    for (uint i=0; i < patches.size(); ++i) old[patches[i]] = i;
+    std::vector<Point> points(order.size()*per);
+    for (uint i=0; i < order.size(); ++i) {
+      std::map<TMPatchPtr,uint>::const_iterator it = old.find(order[i]);
+      if ( it != old.end() && !order[i]->isModified() )
+        std::copy(grid.begin() + (*it).second*per, grid.begin() + ((*it).second+1)*per,
+                  points.begin() + i*per);
+      else
+        todo.push_back(i);
+    }
+    grid.swap(points); patches.swap(order);
+  }
+
+  for (uint i=0; i < todo.size(); ++i) makeBasis(patches[todo[i]]->getPatchSize());
+
+  int num = todo.size();
+  #pragma omp parallel for schedule(static)
+  for (int i=0; i < num; ++i) {
+    TMPatchPtr patch = patches[todo[i]];
+    evaluate(*patch,&grid[todo[i]*per]);
+    patch->clearModified();
+  }
+  return moved || num > 0;
+}
@@ -0,0 +1,113 @@
+/*** ***/
+
+#ifndef _TM_PATCH_TESSELLATION_HH_
+#define _TM_PATCH_TESSELLATION_HH_
+
+#include "TMPatchFace.h"
+
+/*
+  The patches of a patch object evaluated on a grid of points, all kept in
+  one interleaved vertex array. The patch object draws the array with a few
+  calls instead of setting up the OpenGL evaluators for every patch, and the
+  OBJ export writes the same grids out as polygons, so what is exported is
+  what was shown.
+
+  Every patch gets (resolution+1)^2 points, a row of u after another from
+  v=0 on, and the patches follow each other in the order of the patch list.
+  The grid is triangulated as glEvalMesh2 does it. The Bernstein basis is
+  tabled once at the grid samples, so a patch is evaluated as two short
+  sums over the tables, each done over a whole row of samples at once
+  which the compiler vectorizes. The patches are evaluated in parallel.
+
+  Only the patches whose control points or colors changed since they were
+  last evaluated (see TMPatch::isModified) are evaluated again, the others
+  keep their points even when the patch list changed around them. That
+  clears the flag of the patches, so a patch object has one tessellation.
+
+  The index patterns cover BatchPatches patches from the first point of a
+  batch, the same for every batch. They don't depend on the patches, only
+  on the resolution. Nothing in here calls OpenGL.
+*/
+class TMPatchTessellation {
+public :
+  // Same layout as GL_C4UB_V3F, with a normal in between
+  struct Point {
+    unsigned char color[4];
+    float normal[3];
+    float position[3];
+  };
+
+  // Ways to draw the points
+  enum Pattern {
+    Triangles,                 // The surface, as GL_TRIANGLES
+    Wireframe,                 // 7x7 grid lines of each patch, as GL_LINES
+    PatchBoundaries,           // The v=0 and u=1 sides of each patch, as GL_LINES
+    FaceBoundaries,            // The v=0 side of each patch, as GL_LINES
+    NumPatterns
+  };
+
+  static const uint BatchPatches = 256;
+
+  TMPatchTessellation(int res = 12);
+
+  // Number of grid intervals along each side of a patch
+  void setResolution(int res);
+  int getResolution(void) const {
+    return resolution;
+  }
+
+  // Bring the points up to date with the patches of the faces. Returns
+  // true if anything changed.
+  bool update(const TMPatchFacePtrList& faces);
+
+  uint numPatches(void) const {
+    return patches.size();
+  }
+
+  uint pointsPerPatch(void) const {
+    return (resolution+1)*(resolution+1);
+  }
+
+  // Points of all patches, patch i starts at i*pointsPerPatch()
+  const std::vector<Point>& points(void) const {
+    return grid;
+  }
+
+  // First patch of each face, in the order of the faces given to update
+  const std::vector<uint>& faceFirsts(void) const {
+    return face_first;
+  }
+
+  // Indices of the points of a pattern for BatchPatches patches
+  const std::vector<uint>& pattern(Pattern which) const {
+    return patterns[which];
+  }
+
+  // The patterns for the cells of a patch at its first point, the other
+  // patches of a batch are offset from it
+  uint indicesPerPatch(Pattern which) const {
+    return patterns[which].size() / BatchPatches;
+  }
+
+private :
+  // Bernstein basis of a patch order and its derivative, at the samples of
+  // the grid, value[j*(resolution+1)+s] for basis function j at sample s
+  struct Basis {
+    std::vector<double> value;
+    std::vector<double> slope;
+  };
+
+  void makeBasis(uint order);
+  void makePatterns(void);
+  // Evaluate a patch on the grid
+  void evaluate(const TMPatch& patch, Point *points) const;
+
+  int resolution;
+  std::vector<TMPatchPtr> patches;             // Patches in the order of their points
+  std::vector<uint> face_first;
+  std::vector<Point> grid;
+  std::vector<Basis> bases;                    // By order, empty for orders not seen yet
+  std::vector<uint> patterns[NumPatterns];
+};
+
+#endif /* #ifndef _TM_PATCH_TESSELLATION_HH_ */
@@ -0,0 +1,533 @@
+/*** ***/
+
+/*
+  Benchmark for the subdivision and remeshing operators.
+
+  Loads every mesh, applies every scheme from DLFLSubdiv.h (plus createDual,
+  createCrust and makeWireframe) for levels 1..N and reports for each level
+  the wall time, the peak resident set size, the number and size of heap
+  allocations and the resulting element counts, as CSV or JSON.
+
+  usage: dlflbench [options] [mesh.obj ...]
+    -objs <dir>       benchmark all .obj files in dir (default ../objs)
+    -levels <n>       number of levels per operator (default 3)
+    -maxfaces <n>     don't start another level above n faces (default 250000)
+    -ops <a,b,...>    only run the named operators (see -list)
+    -threads <n>      number of threads for the parallel passes
+    -timeout <s>      seconds allowed per mesh and operator (default 300)
+    -format csv|json  output format (default csv)
+    -o <file>         write results to file instead of stdout
+    -list             list the operators and exit
+    -limit            check the exact limit surface instead (see below)
+
+  Each mesh/operator pair runs in its own child process, so the peak RSS
+  isn't polluted by earlier runs, and an operator that crashes or hangs on
+  some mesh is reported instead of ending the run. The library output of the
+  operators is discarded. Needs a POSIX system (fork, getrusage).
+
+  With -limit no timings are taken. The limit points of DLFLLimitSurface.h
+  are computed for the vertices of each mesh, then Catmull-Clark and
+  Doo-Sabin are applied for levels 1..N and the largest distance between
+  the limit points and the refined mesh is reported, relative to the
+  diagonal of the bounding box. The distance has to drop by a quarter or
+  more with every level (Catmull-Clark takes off about 5/6 of it, Doo-Sabin
+  half), otherwise the level is reported as failed and the exit status is
+  1. A wrong limit point leaves a distance which doesn't go away. Vertices
+  of valence 2 are left out, meshes with open corner rings around some
+  vertex are skipped.
+*/
+
+#include <DLFLObject.h>
+#include <DLFLCore.h>
+#include <DLFLParallel.h>
+#include <DLFLSubdiv.h>
+#include <DLFLDual.h>
+#include <DLFLCrust.h>
+#include <DLFLLimitSurface.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace DLFL;
+
+//--- Allocation counting ---//
+
+// Every global operator new in the process goes through these, including
+// the ones in the library and the STL containers. Element classes with their
+// own pools only show up when a pool is expanded.
+static long num_allocs = 0;
+static long num_alloc_bytes = 0;
+
+void* operator new(size_t size) {
+  ++num_allocs; num_alloc_bytes += size;
+  void *p = malloc(size ? size : 1);
+  if ( p == NULL ) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  ++num_allocs; num_alloc_bytes += size;
+  void *p = malloc(size ? size : 1);
+  if ( p == NULL ) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) throw() { free(p); }
+void operator delete[](void *p) throw() { free(p); }
+
+//--- Operators ---//
+
+// Parameters are the defaults of the corresponding MainWindow settings
+static void loop(DLFLObjectPtr obj) { loopSubdivide(obj); }
+static void checkerBoard(DLFLObjectPtr obj) { checkerBoardRemeshing(obj,0.33); }
+static void simplest(DLFLObjectPtr obj) { simplestSubdivide(obj); }
+static void vertexCutting(DLFLObjectPtr obj) { vertexCuttingSubdivide(obj,0.25); }
+static void pentagonal2(DLFLObjectPtr obj) { pentagonalSubdivide2(obj,0.75); }
+static void pentagonal(DLFLObjectPtr obj) { pentagonalSubdivide(obj,0.0); }
+static void honeycomb(DLFLObjectPtr obj) { honeycombSubdivide(obj); }
+static void dooSabin(DLFLObjectPtr obj) { dooSabinSubdivide(obj,true); }
+static void dooSabinBC(DLFLObjectPtr obj) { dooSabinSubdivideBC(obj,true); }
+static void dooSabinBCNew(DLFLObjectPtr obj) { dooSabinSubdivideBCNew(obj,1.0,1.0); }
+static void cornerCutting(DLFLObjectPtr obj) { cornerCuttingSubdivide(obj,9.0/16.0); }
+static void modifiedCornerCutting(DLFLObjectPtr obj) { modifiedCornerCuttingSubdivide(obj,0.25); }
+static void modifiedCornerCutting2(DLFLObjectPtr obj) { modifiedCornerCuttingSubdivide2(obj,0.25); }
+static void root4(DLFLObjectPtr obj) { root4Subdivide(obj,0.0,0.0); }
+static void catmullClark(DLFLObjectPtr obj) { catmullClarkSubdivide(obj); }
+static void star(DLFLObjectPtr obj) { starSubdivide(obj,0.0); }
+static void sqrt3(DLFLObjectPtr obj) { sqrt3Subdivide(obj); }
+static void fractal(DLFLObjectPtr obj) { fractalSubdivide(obj,1.0); }
+static void stellate(DLFLObjectPtr obj) { stellateSubdivide(obj); }
+static void twoStellate(DLFLObjectPtr obj) { twostellateSubdivide(obj,0.0,0.0); }
+static void dome(DLFLObjectPtr obj) { domeSubdivide(obj,1.0,1.0); }
+static void dual1264(DLFLObjectPtr obj) { dual1264Subdivide(obj,0.7); }
+static void loopStyle(DLFLObjectPtr obj) { loopStyleSubdivide(obj,1.0); }
+static void quadFaces(DLFLObjectPtr obj) { subdivideAllFaces(obj,true); }
+static void triFaces(DLFLObjectPtr obj) { subdivideAllFaces(obj,false); }
+static void triangulate(DLFLObjectPtr obj) { triangulateAllFaces(obj); }
+static void dual(DLFLObjectPtr obj) { createDual(obj,true); }
+static void crust(DLFLObjectPtr obj) { createCrust(obj,0.5); }
+static void wireframe(DLFLObjectPtr obj) { makeWireframe(obj,0.25,true); }
+
+struct BenchOp {
+  const char *name;
+  void (*apply)(DLFLObjectPtr);
+};
+
+static const BenchOp ops[] = {
+  { "loop", loop },
+  { "checkerboard", checkerBoard },
+  { "simplest", simplest },
+  { "vertexcutting", vertexCutting },
+  { "pentagonal2", pentagonal2 },
+  { "pentagonal", pentagonal },
+  { "honeycomb", honeycomb },
+  { "doosabin", dooSabin },
+  { "doosabinbc", dooSabinBC },
+  { "doosabinbcnew", dooSabinBCNew },
+  { "cornercutting", cornerCutting },
+  { "modifiedcornercutting", modifiedCornerCutting },
+  { "modifiedcornercutting2", modifiedCornerCutting2 },
+  { "root4", root4 },
+  { "catmullclark", catmullClark },
+  { "star", star },
+  { "sqrt3", sqrt3 },
+  { "fractal", fractal },
+  { "stellate", stellate },
+  { "twostellate", twoStellate },
+  { "dome", dome },
+  { "dual1264", dual1264 },
+  { "loopstyle", loopStyle },
+  { "quadfaces", quadFaces },
+  { "trifaces", triFaces },
+  { "triangulate", triangulate },
+  { "dual", dual },
+  { "crust", crust },
+  { "wireframe", wireframe }
+};
+static const int num_ops = sizeof(ops)/sizeof(ops[0]);
+
+//--- Results ---//
+
+enum BenchStatus { BenchOK=0, BenchLoadFailed, BenchCrashed, BenchTimeout };
+static const char *status_names[] = { "ok", "load_failed", "crashed", "timeout" };
+
+// One row of output. Written by the child through a pipe.
+struct BenchRecord {
+  int level;
+  int status;
+  double wall_ms;
+  long peak_rss_kb;
+  long allocs;
+  long alloc_bytes;
+  long vertices;
+  long edges;
+  long faces;
+};
+
+static double wallTime(void) {
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec*1000.0 + tv.tv_usec/1000.0;
+}
+
+static long peakRSS(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF,&ru);
+#ifdef __APPLE__
+  return ru.ru_maxrss / 1024; // bytes on OS X
+#else
+  return ru.ru_maxrss;
+#endif
+}
+
+static void writeRecord(int fd, const BenchRecord& rec) {
+  const char *buf = (const char *)&rec;
+  size_t done = 0;
+  while ( done < sizeof(rec) ) {
+    ssize_t n = write(fd,buf+done,sizeof(rec)-done);
+    if ( n <= 0 ) return;
+    done += n;
+  }
+}
+
+static void setCounts(BenchRecord& rec, DLFLObjectPtr obj) {
+  rec.vertices = obj->num_vertices();
+  rec.edges = obj->num_edges();
+  rec.faces = obj->num_faces();
+}
+
+// Runs in the child process
+static void runLevels(int fd, const std::string& mesh, const BenchOp& op,
+                      int levels, long maxfaces) {
+  BenchRecord rec;
+  memset(&rec,0,sizeof(rec));
+
+  std::vector<char> filename(mesh.begin(),mesh.end()); filename.push_back('\0');
+  char nomtl[] = "";
+  DLFLObjectPtr obj = readObjectFile(&filename[0],nomtl);
+  if ( obj == NULL ) {
+    rec.status = BenchLoadFailed;
+    writeRecord(fd,rec);
+    return;
+  }
+
+  for (int level=1; level <= levels; ++level) {
+    if ( (long)obj->num_faces() > maxfaces ) break;
+    num_allocs = 0; num_alloc_bytes = 0;
+    double start = wallTime();
+    op.apply(obj);
+    rec.wall_ms = wallTime() - start;
+    rec.allocs = num_allocs; rec.alloc_bytes = num_alloc_bytes;
+    rec.level = level;
+    rec.status = BenchOK;
+    rec.peak_rss_kb = peakRSS();
+    setCounts(rec,obj);
+    writeRecord(fd,rec);
+  }
+}
+
+//--- Output ---//
+
+static std::string baseName(const std::string& path) {
+  std::string::size_type slash = path.find_last_of("/\\");
+  std::string name = ( slash == std::string::npos ) ? path : path.substr(slash+1);
+  std::string::size_type dot = name.rfind('.');
+  return ( dot == std::string::npos ) ? name : name.substr(0,dot);
+}
+
+static bool json = false;
+static int num_rows = 0;
+
+static void printHeader(FILE *out) {
+  if ( json ) fprintf(out,"[\n");
+  else fprintf(out,"mesh,op,level,status,wall_ms,peak_rss_kb,allocs,alloc_bytes,vertices,edges,faces\n");
+}
+
+static void printRecord(FILE *out, const std::string& mesh, const char *op, const BenchRecord& rec) {
+  if ( json ) {
+    fprintf(out,"%s  {\"mesh\": \"%s\", \"op\": \"%s\", \"level\": %d, \"status\": \"%s\", "
+            "\"wall_ms\": %.3f, \"peak_rss_kb\": %ld, \"allocs\": %ld, \"alloc_bytes\": %ld, "
+            "\"vertices\": %ld, \"edges\": %ld, \"faces\": %ld}",
+            num_rows ? ",\n" : "", mesh.c_str(), op, rec.level, status_names[rec.status],
+            rec.wall_ms, rec.peak_rss_kb, rec.allocs, rec.alloc_bytes,
+            rec.vertices, rec.edges, rec.faces);
+  } else {
+    fprintf(out,"%s,%s,%d,%s,%.3f,%ld,%ld,%ld,%ld,%ld,%ld\n",
+            mesh.c_str(), op, rec.level, status_names[rec.status],
+            rec.wall_ms, rec.peak_rss_kb, rec.allocs, rec.alloc_bytes,
+            rec.vertices, rec.edges, rec.faces);
+  }
+  ++num_rows;
+  fflush(out);
+}
+
+static void printFooter(FILE *out) {
+  if ( json ) fprintf(out,"%s]\n", num_rows ? "\n" : "");
+}
+
+//--- Limit surface check ---//
+
+static void printLimitHeader(FILE *out) {
+  if ( json ) fprintf(out,"[\n");
+  else fprintf(out,"mesh,scheme,level,status,faces,max_error\n");
+}
+
+static void printLimitRecord(FILE *out, const std::string& mesh, const char *scheme,
+                             int level, const char *status, long faces, double error) {
+  if ( json ) {
+    fprintf(out,"%s  {\"mesh\": \"%s\", \"scheme\": \"%s\", \"level\": %d, \"status\": \"%s\", "
+            "\"faces\": %ld, \"max_error\": %.3e}",
+            num_rows ? ",\n" : "", mesh.c_str(), scheme, level, status, faces, error);
+  } else {
+    fprintf(out,"%s,%s,%d,%s,%ld,%.3e\n", mesh.c_str(), scheme, level, status, faces, error);
+  }
+  ++num_rows;
+  fflush(out);
+}
+
+// Catmull-Clark only moves the old vertices, so each is compared with its
+// own limit point
+static double catmullClarkError(const DLFLVertexPtrArray& verts, const Vector3dArray& limit) {
+  double error = 0.0;
+  for (size_t i=0; i < verts.size(); ++i)
+    error = std::max(error,normsqr(verts[i]->coords - limit[i]));
+  return sqrt(error);
+}
+
+// Doo-Sabin replaces the vertices, the face a vertex turns into shrinks to
+// its limit point. The nearest vertex of the refined mesh is taken.
+static double dooSabinError(DLFLObjectPtr obj, const Vector3dArray& limit) {
+  Vector3dArray coords;
+  coords.reserve(obj->num_vertices());
+  for (DLFLVertexPtrList::iterator it=obj->beginVertex(); it != obj->endVertex(); ++it)
+    coords.push_back((*it)->coords);
+  double error = 0.0;
+  for (size_t i=0; i < limit.size(); ++i) {
+    double nearest = -1.0;
+    for (size_t j=0; j < coords.size(); ++j) {
+      double d = normsqr(coords[j] - limit[i]);
+      if ( nearest < 0.0 || d < nearest ) nearest = d;
+    }
+    error = std::max(error,nearest);
+  }
+  return sqrt(error);
+}
+
+// Returns false if the error didn't shrink on some level
+static bool checkLimit(FILE *out, const std::string& mesh, bool doosabin,
+                       int levels, long maxfaces) {
+  std::string name = baseName(mesh);
+  const char *scheme = doosabin ? "doosabin" : "catmullclark";
+  std::vector<char> filename(mesh.begin(),mesh.end()); filename.push_back('\0');
+  char nomtl[] = "";
+  DLFLObjectPtr obj = readObjectFile(&filename[0],nomtl);
+  if ( obj == NULL ) {
+    printLimitRecord(out,name,scheme,0,"load_failed",-1,0.0);
+    return false;
+  }
+  if ( !hasClosedVertexRings(obj) ) {
+    printLimitRecord(out,name,scheme,0,"skipped",obj->num_faces(),0.0);
+    delete obj;
+    return true;
+  }
+
+  Vector3d min, max;
+  obj->boundingBox(min,max);
+  double diagonal = norm(max - min);
+  if ( diagonal <= 0.0 ) diagonal = 1.0;
+
+  DLFLVertexPtrArray verts;
+  Vector3dArray limit;
+  Vector3d p, t1, t2, n;
+  for (DLFLVertexPtrList::iterator it=obj->beginVertex(); it != obj->endVertex(); ++it) {
+    if ( (*it)->valence() < 3 ) continue;
+    verts.push_back(*it);
+    if ( doosabin ) {
+      dooSabinVertexLimitFrame(*it,p,t1,t2,n);
+      limit.push_back(p);
+    } else limit.push_back(catmullClarkLimitPoint(*it));
+  }
+
+  double last = ( doosabin ? dooSabinError(obj,limit) : catmullClarkError(verts,limit) ) / diagonal;
+  printLimitRecord(out,name,scheme,0,"ok",obj->num_faces(),last);
+
+  bool passed = true;
+  for (int level=1; level <= levels; ++level) {
+    if ( (long)obj->num_faces() > maxfaces ) break;
+    double error;
+    if ( doosabin ) {
+      dooSabinSubdivide(obj,true);
+      error = dooSabinError(obj,limit) / diagonal;
+    } else {
+      catmullClarkSubdivide(obj);
+      error = catmullClarkError(verts,limit) / diagonal;
+    }
+    // Meshes whose vertices are on the limit surface already stay there
+    bool ok = ( error <= 0.75*last || error < 1.0e-12 );
+    printLimitRecord(out,name,scheme,level,ok ? "ok" : "failed",obj->num_faces(),error);
+    passed = passed && ok;
+    last = error;
+  }
+  delete obj;
+  return passed;
+}
+
+//--- Driver ---//
+
+// Fork a child to run one operator on one mesh and print what it reports
+static void benchmark(FILE *out, const std::string& mesh, const BenchOp& op,
+                      int levels, long maxfaces, int timeout) {
+  std::string name = baseName(mesh);
+  int fds[2];
+  if ( pipe(fds) != 0 ) { perror("pipe"); exit(1); }
+
+  pid_t pid = fork();
+  if ( pid < 0 ) { perror("fork"); exit(1); }
+  if ( pid == 0 ) {
+    close(fds[0]);
+    int devnull = open("/dev/null",O_WRONLY);
+    if ( devnull >= 0 ) { dup2(devnull,1); dup2(devnull,2); }
+    alarm(timeout);
+    runLevels(fds[1],mesh,op,levels,maxfaces);
+    _exit(0);
+  }
+
+  close(fds[1]);
+  BenchRecord rec;
+  int last_level = 0;
+  size_t got = 0;
+  ssize_t n;
+  while ( (n = read(fds[0],(char *)&rec+got,sizeof(rec)-got)) > 0 ) {
+    got += n;
+    if ( got == sizeof(rec) ) {
+      printRecord(out,name,op.name,rec);
+      last_level = rec.level; got = 0;
+    }
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid,&status,0);
+  if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+    memset(&rec,0,sizeof(rec));
+    rec.level = last_level+1;
+    rec.status = ( WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM ) ? BenchTimeout : BenchCrashed;
+    rec.vertices = rec.edges = rec.faces = -1;
+    printRecord(out,name,op.name,rec);
+  }
+}
+
+static void listMeshes(const std::string& dir, std::vector<std::string>& meshes) {
+  DIR *dp = opendir(dir.c_str());
+  if ( dp == NULL ) return;
+  struct dirent *de;
+  while ( (de = readdir(dp)) != NULL ) {
+    std::string name = de->d_name;
+    if ( name.size() > 4 && name.compare(name.size()-4,4,".obj") == 0 )
+      meshes.push_back(dir + "/" + name);
+  }
+  closedir(dp);
+  std::sort(meshes.begin(),meshes.end());
+}
+
+static bool selected(const std::string& list, const char *name) {
+  if ( list.empty() ) return true;
+  std::string padded = "," + list + ",";
+  return padded.find(std::string(",") + name + ",") != std::string::npos;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: dlflbench [-objs dir] [-levels n] [-maxfaces n] [-ops a,b,...]\n"
+          "                 [-threads n] [-timeout s] [-format csv|json] [-o file]\n"
+          "                 [-list] [-limit] [mesh.obj ...]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  std::string objdir = "../objs", oplist, outfile;
+  std::vector<std::string> meshes;
+  int levels = 3, timeout = 300;
+  long maxfaces = 250000;
+  bool limit = false;
+
+  for (int i=1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasval = ( i+1 < argc );
+    if ( arg == "-list" ) {
+      for (int j=0; j < num_ops; ++j) printf("%s\n",ops[j].name);
+      return 0;
+    } else if ( arg == "-objs" && hasval ) objdir = argv[++i];
+    else if ( arg == "-levels" && hasval ) levels = atoi(argv[++i]);
+    else if ( arg == "-maxfaces" && hasval ) maxfaces = atol(argv[++i]);
+    else if ( arg == "-ops" && hasval ) oplist = argv[++i];
+    else if ( arg == "-threads" && hasval ) setNumThreads(atoi(argv[++i]));
+    else if ( arg == "-timeout" && hasval ) timeout = atoi(argv[++i]);
+    else if ( arg == "-o" && hasval ) outfile = argv[++i];
+    else if ( arg == "-limit" ) limit = true;
+    else if ( arg == "-format" && hasval ) {
+      std::string format = argv[++i];
+      if ( format == "json" ) json = true;
+      else if ( format != "csv" ) usage();
+    }
+    else if ( arg[0] == '-' ) usage();
+    else meshes.push_back(arg);
+  }
+
+  if ( meshes.empty() ) listMeshes(objdir,meshes);
+  if ( meshes.empty() ) {
+    fprintf(stderr,"dlflbench: no meshes found in %s\n",objdir.c_str());
+    return 1;
+  }
+
+  FILE *out = stdout;
+  if ( !outfile.empty() ) {
+    out = fopen(outfile.c_str(),"w");
+    if ( out == NULL ) { perror(outfile.c_str()); return 1; }
+  }
+
+  if ( limit ) {
+    // The check runs in this process, the library output is discarded here
+    fflush(stdout);
+    if ( out == stdout ) {
+      out = fdopen(dup(1),"w");
+      if ( out == NULL ) { perror("dup"); return 1; }
+    }
+    int devnull = open("/dev/null",O_WRONLY);
+    if ( devnull >= 0 ) dup2(devnull,1);
+
+    bool passed = true;
+    printLimitHeader(out);
+    for (size_t m=0; m < meshes.size(); ++m) {
+      passed = checkLimit(out,meshes[m],false,levels,maxfaces) && passed;
+      passed = checkLimit(out,meshes[m],true,levels,maxfaces) && passed;
+    }
+    printFooter(out);
+    fclose(out);
+    return passed ? 0 : 1;
+  }
+
+  printHeader(out);
+  for (size_t m=0; m < meshes.size(); ++m)
+    for (int i=0; i < num_ops; ++i)
+      if ( selected(oplist,ops[i].name) )
+        benchmark(out,meshes[m],ops[i],levels,maxfaces,timeout);
+  printFooter(out);
+
+  if ( out != stdout ) fclose(out);
+  return 0;
+}
@@ -0,0 +1,23 @@
+# Command line benchmark for the DLFL operators. See DLFLBench.cc for usage.
+# Build the libraries first (include/include.pro), then qmake && make here.
+TEMPLATE = app
+CONFIG -= qt
+CONFIG += console release warn_off
+TARGET = dlflbench
+DESTDIR = ../../bin
+INCLUDEPATH += ../include ../vecmat ../dlflcore ../dlflaux
+
+CONFIG(WITH_OPENMP) {
+ QMAKE_CXXFLAGS += -fopenmp
+ QMAKE_LFLAGS += -fopenmp
+}
+
+macx {
+ CONFIG -= app_bundle
+ CONFIG += x86 ppc
+}
+
+QMAKE_LFLAGS += -L../../lib
+LIBS += -ldlflaux -ldlflcore -lvecmat
+
+SOURCES += DLFLBench.cc
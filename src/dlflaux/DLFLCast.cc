@@ -37,6 +37,7 @@ namespace DLFL {
       normalize(buffer); 
       vertexptr->coords = buffer; /*+center;*/
     }
+    obj->changed();
   }
 
   void planarize( DLFLObjectPtr obj ) {
@@ -161,6 +162,7 @@ namespace DLFL {
        
       vertexptr->coords = new_pos;
     }
+    obj->changed();
   }
 
 } // end namespace
@@ -3,16 +3,11 @@
 // Source code for DLFLConvexHull class
 
 #include "DLFLConvexHull.h"
-#include "DLFLSubdiv.h"
 #include <DLFLCore.h>
+#include <DLFLProgress.h>
 
 namespace DLFL {
 
-  long DLFLConvexHull::remove = 1;               // Edge needs to be removed
-  long DLFLConvexHull::border = 2;                  // Edge is a border edge
-  long DLFLConvexHull::visible = 1;        // Face is visible from new point
-  long DLFLConvexHull::invisible = 2;    // Face is invisible from new point
-
   // Are the 3 given points colinear?
   bool DLFLConvexHull::colinear(const Vector3d& p1, const Vector3d& p2, const Vector3d& p3) {
     // 3 points are colinear if the area of the triangle formed by them is zero
@@ -52,178 +47,299 @@ namespace DLFL {
     return 0;
   }
 
-  bool DLFLConvexHull::doubleTriangle( ) {
-    InputVertex iv1,iv2,iv3;
-    DLFLFaceVertexPtrArray fvptrArray; // Esan
-    int numverts = vertices.size();
-    int i;
-  
-    i=0; iv1 = vertices[i]; iv2 = vertices[i+1]; iv3 = vertices[i+2];
-    while ( DLFLConvexHull::colinear(iv1.point,iv2.point,iv3.point) ) {
-      i++;
-      if ( i+2 >= numverts ) return false; // All points are colinear
+  // A face of the hull during quickhull. Edge k goes from v[k] to v[(k+1)%3]
+  // and adj[k] is the face on the other side of it
+  struct QHFace {
+    int v[3], adj[3];
+    Vector3d normal; double offset;     // Plane of the face, normal points out
+    IntArray outside;                   // Points above the face (conflict list)
+    IntArray coplanar;                  // Points on the face, not above any face
+    int furthest; double furthestdist;  // Point of outside furthest from the face
+    bool alive;
+    int visit;
+
+    QHFace() : offset(0.0), furthest(-1), furthestdist(0.0), alive(true), visit(-1) {
+      v[0] = v[1] = v[2] = adj[0] = adj[1] = adj[2] = -1;
     }
 
-    // Set the processed flag for the 3 input vertices chosen for initial triangle
-    vertices[0].processed = vertices[1].processed = vertices[2].processed = true;
-
-    Vector3dArray triangle;
-    triangle.resize(3);
-    triangle[0] = iv1.point; triangle[1] = iv2.point; triangle[2] = iv3.point;
-
-    // Create two "twin" faces
-    createFace(triangle);
-
-    DLFLFacePtr tfp = firstFace(); // Face which is in the given order (iv1,iv2,iv3)
-
-    // Added by Esan
-    tfp->getCorners(fvptrArray);
-    (fvptrArray[0]->getVertexPtr())->CHullIndex = vertices[0].index;
-    (fvptrArray[1]->getVertexPtr())->CHullIndex = vertices[1].index;
-    (fvptrArray[2]->getVertexPtr())->CHullIndex = vertices[2].index;
-    // End additions by Esan
-
-    // Find a fourth noncoplanar vertex to form the tetrahedron
-    for (i=0; i < numverts; ++i) {
-      int volsign = DLFLConvexHull::volumeSign(tfp,vertices[i].point);
-      if ( vertices[i].processed == false && volsign != 0) {
-	// Make sure this vertex is the first one added
-	// Swap this vertex with the vertex at the beginning of the array
-	// Even if the first vertex in the array is part of the initial triangle, it doesn't
-	// affect anything, since it's already been processed and will not be considered again
-	InputVertex temp = vertices[0];
-	temp.index = vertices[0].index; // Esan
-	vertices[0] = vertices[i]; vertices[i] = temp;
-	vertices[0].index = vertices[i].index; vertices[i].index = temp.index; // Esan
-	break;
-      }
+    double distance(const Vector3d& p) const {
+      return normal*p - offset;
     }
-    if ( i == numverts ) return false; // All points are coplanar
+  };
 
-    return true;
-  }
+  typedef vector<QHFace> QHFaceArray;
 
-  bool DLFLConvexHull::addOne(InputVertex& iv) {
-    // Add given vertex to hull
-    // Assumes that iv has not been processed yet
-
-    Vector3d p = iv.point;
-    bool foundvisible = false;
-  
-    // Mark the faces that are visible from p (iv)
-    DLFLFacePtrList::iterator ffirst, flast;
-    DLFLFacePtr fp;
-  
-    ffirst = face_list.begin(); flast = face_list.end();
-    while ( ffirst != flast ) {
-      fp = (*ffirst); ++ffirst;
-      if ( DLFLConvexHull::volumeSign(fp,p) < 0 ) {
-	fp->flags = DLFLConvexHull::visible;
-	foundvisible = true;
-      } else
-	fp->flags = DLFLConvexHull::invisible;
-    }
+  static void makeQHFace(QHFaceArray& faces, const Vector3dArray& p, int a, int b, int c) {
+    QHFace face;
+    face.v[0] = a; face.v[1] = b; face.v[2] = c;
+    face.normal = (p[b]-p[a]) % (p[c]-p[a]);
+    normalize(face.normal);
+    face.offset = face.normal*p[a];
+    faces.push_back(face);
+  }
 
-    // If no faces are visible from p then p is inside the hull
-    if ( foundvisible == false ) {
-      iv.onhull = false;
-      return false;
+  // Put point i in the conflict list of the first face in [first,last) which it
+  // is above, or else in the coplanar list of a face it is on.
+  // Returns 1, 0 or -1 if the point went in a conflict list, in a coplanar
+  // list or is strictly inside all those faces
+  static int assignPoint(QHFaceArray& faces, int first, int last,
+                          const Vector3dArray& p, int i, double tol) {
+    int onface = -1;
+    for (int f=first; f < last; ++f) {
+      double dist = faces[f].distance(p[i]);
+      if ( dist > tol ) {
+        faces[f].outside.push_back(i);
+        if ( dist > faces[f].furthestdist ) {
+          faces[f].furthestdist = dist; faces[f].furthest = i;
+        }
+        return 1;
+      }
+      if ( onface < 0 && dist > -tol ) onface = f;
     }
+    if ( onface < 0 ) return -1;
+    faces[onface].coplanar.push_back(i);
+    return 0;
+  }
 
-    // Mark edges in the interior of visible region for deletion
-    // Create a new face based on each border edge
-    // A border edge is one where only one of the adjacent faces is visible
-    DLFLEdgePtrList::iterator efirst, elast;
-    DLFLEdgePtr ep;
-    DLFLFacePtr fp1,fp2;
-    DLFLEdgePtrList remove_list; // List of edges to be removed
-    DLFLEdgePtrList border_list; // List of border edges
-
-    efirst = edge_list.begin(); elast = edge_list.end();
-    while ( efirst != elast ) {
-      ep = (*efirst); ++efirst;
-      ep->getFacePointers(fp1,fp2);
-      if ( fp1->flags == DLFLConvexHull::visible && fp2->flags == DLFLConvexHull::visible ) {
-	// Interior edge : add edge to remove_list
-	remove_list.push_back(ep);
-      } else if ( fp1->flags == DLFLConvexHull::visible || fp2->flags == DLFLConvexHull::visible ) {
-	// Border edge : add edge to border_list
-	border_list.push_back(ep);
+  int quickHull(const Vector3dArray& p, IntArray& triangles, vector<bool>* onhull) {
+    int num_points = p.size();
+    triangles.clear();
+    if ( onhull ) onhull->assign(num_points,false);
+    if ( num_points < 4 ) return -1;
+
+    // Tolerance for the distance of a point to a plane, relative to the extent of the points
+    int extreme[6] = { 0, 0, 0, 0, 0, 0 }; // Min and max along each axis
+    Vector3d maxabs;
+    for (int i=0; i < num_points; ++i) {
+      for (int k=0; k < 3; ++k) {
+        if ( p[i][k] < p[extreme[2*k]][k] ) extreme[2*k] = i;
+        if ( p[i][k] > p[extreme[2*k+1]][k] ) extreme[2*k+1] = i;
+        if ( Abs(p[i][k]) > maxabs[k] ) maxabs[k] = Abs(p[i][k]);
       }
     }
+    double tol = ZERO * (maxabs[0]+maxabs[1]+maxabs[2]);
+
+    // Initial tetrahedron. The two extreme points furthest apart, the point
+    // furthest from the line through them and the point furthest from the plane
+    int i0 = 0, i1 = 0, i2 = -1, i3 = -1;
+    double maxdist = 0.0, dist;
+    for (int j=0; j < 6; ++j)
+      for (int k=j+1; k < 6; ++k) {
+        dist = normsqr(p[extreme[j]]-p[extreme[k]]);
+        if ( dist > maxdist ) {
+          maxdist = dist; i0 = extreme[j]; i1 = extreme[k];
+        }
+      }
+    if ( maxdist <= tol*tol ) return -1;
 
-    // Go through remove_list and remove all edges
-    while ( !remove_list.empty() ) {
-      ep = remove_list.front(); remove_list.pop_front();
-      deleteEdge(this,ep,true);
+    Vector3d linedir = normalized(p[i1]-p[i0]);
+    maxdist = 0.0;
+    for (int i=0; i < num_points; ++i) {
+      dist = norm((p[i]-p[i0]) % linedir);
+      if ( dist > maxdist ) { maxdist = dist; i2 = i; }
     }
+    if ( maxdist <= tol ) return -1; // All points are colinear
 
-    // Find the face bounded by the border edges - call it the conebase
-    // This can be done by taking any border edge and finding the face
-    // adjacent to it which is not invisible.
-    DLFLFacePtr conebase = NULL;
+    Vector3d planenormal = normalized((p[i1]-p[i0]) % (p[i2]-p[i0]));
+    maxdist = 0.0;
+    for (int i=0; i < num_points; ++i) {
+      dist = Abs(planenormal*(p[i]-p[i0]));
+      if ( dist > maxdist ) { maxdist = dist; i3 = i; }
+    }
+    if ( maxdist <= tol ) return -1; // All points are coplanar
+
+    // Faces of the tetrahedron, oriented away from the fourth point
+    QHFaceArray faces;
+    faces.reserve(4*num_points);
+    if ( planenormal*(p[i3]-p[i0]) > 0.0 ) std::swap(i1,i2);
+    makeQHFace(faces,p,i0,i1,i2);
+    makeQHFace(faces,p,i0,i3,i1);
+    makeQHFace(faces,p,i1,i3,i2);
+    makeQHFace(faces,p,i2,i3,i0);
+    for (int f=0; f < 4; ++f)
+      for (int k=0; k < 3; ++k) {
+        int a = faces[f].v[k], b = faces[f].v[(k+1)%3];
+        for (int g=0; g < 4; ++g)
+          for (int j=0; j < 3; ++j)
+            if ( faces[g].v[j] == b && faces[g].v[(j+1)%3] == a ) faces[f].adj[k] = g;
+      }
 
-    ep = border_list.front();
-    ep->getFacePointers(fp1,fp2);
+    vector<bool> isvertex(num_points,false);
+    isvertex[i0] = isvertex[i1] = isvertex[i2] = isvertex[i3] = true;
 
-    if ( fp1->flags == DLFLConvexHull::invisible ) conebase = fp2;
-    else if ( fp2->flags == DLFLConvexHull::invisible ) conebase = fp1;
-    else {
-      // This should not happen. Problem somewhere
-      cout << "Oops! Something went wrong somewhere!" << endl;
-      return false;
+    // Points which are not in a conflict list are done
+    int num_inside = 0, num_done = 4, where;
+    for (int i=0; i < num_points; ++i) {
+      if ( isvertex[i] ) continue;
+      where = assignPoint(faces,0,4,p,i,tol);
+      if ( where < 0 ) ++num_inside;
+      if ( where <= 0 ) ++num_done;
     }
 
-    // Subdivide the conebase face using triangles. This will create a new point
-    // at the centroid, which can then simply be moved to the apex of the cone
-    subdivideFace(this,conebase,false);
-
-    // The centroid will be the last DLFLVertex in the vertex_list
-    DLFLVertexPtr apex = vertex_list.back();
+    // Add the furthest point of a face with a non-empty conflict list to the
+    // hull until there are no such faces left
+    IntArray pending, visible, horizonface, horizonedge, points;
+    IntArray startingat(num_points,-1);
+    for (int f=0; f < 4; ++f)
+      if ( !faces[f].outside.empty() ) pending.push_back(f);
+
+    int iteration = 0;
+    while ( !pending.empty() ) {
+      int f = pending.back(); pending.pop_back();
+      if ( !faces[f].alive || faces[f].outside.empty() ) continue;
+
+      int apex = faces[f].furthest;
+      const Vector3d& ap = p[apex];
+      isvertex[apex] = true;
+
+      // Find the faces visible from the apex, starting from f, and the
+      // horizon edges between visible and hidden faces, in order around
+      // the horizon
+      visible.clear(); horizonface.clear(); horizonedge.clear();
+      faces[f].visit = iteration;
+      visible.push_back(f);
+      for (int n=0; n < (int)visible.size(); ++n) {
+        QHFace& vf = faces[visible[n]];
+        for (int k=0; k < 3; ++k) {
+          int g = vf.adj[k];
+          if ( faces[g].visit == iteration ) continue;
+          if ( faces[g].distance(ap) > tol ) {
+            faces[g].visit = iteration;
+            visible.push_back(g);
+          }
+        }
+      }
+      for (int n=0; n < (int)visible.size(); ++n) {
+        QHFace& vf = faces[visible[n]];
+        for (int k=0; k < 3; ++k)
+          if ( faces[vf.adj[k]].visit != iteration ) {
+            horizonface.push_back(visible[n]); horizonedge.push_back(k);
+          }
+      }
 
-    // Adjust coordinates of the apex to be the new point we are adding to the hull
-    apex->coords = p;
-    apex->CHullIndex = iv.index;
+      // Create a face from every horizon edge to the apex. Edge 0 of the new
+      // face is the horizon edge, edge 1 goes to the apex and edge 2 back.
+      int firstnew = faces.size();
+      for (int n=0; n < (int)horizonface.size(); ++n) {
+        int vfi = horizonface[n], k = horizonedge[n];
+        int a = faces[vfi].v[k], b = faces[vfi].v[(k+1)%3], g = faces[vfi].adj[k];
+        int nf = faces.size();
+        makeQHFace(faces,p,a,b,apex);
+        faces[nf].adj[0] = g;
+        for (int j=0; j < 3; ++j)
+          if ( faces[g].adj[j] == vfi && faces[g].v[(j+1)%3] == a ) faces[g].adj[j] = nf;
+        startingat[a] = nf;
+      }
+      int lastnew = faces.size();
+      for (int nf=firstnew; nf < lastnew; ++nf) {
+        int b = faces[nf].v[1];
+        int next = startingat[b];
+        faces[nf].adj[1] = next;
+        faces[next].adj[2] = nf;
+      }
 
-    return true;
-  }
-  
+      // Move the points of the visible faces to the new faces. Vertices of
+      // visible faces which are not on the horizon are no longer on the hull
+      for (int n=0; n < (int)visible.size(); ++n) {
+        QHFace& vf = faces[visible[n]];
+        vf.alive = false;
+        for (int j=0; j < 3; ++j) {
+          int i = vf.v[j];
+          if ( i == apex || !isvertex[i] || startingat[i] >= 0 ) continue;
+          isvertex[i] = false;
+          where = assignPoint(faces,firstnew,lastnew,p,i,tol);
+          if ( where < 0 ) ++num_inside;
+          if ( where > 0 ) --num_done;
+        }
+        for (int j=0; j < (int)vf.outside.size(); ++j) {
+          int i = vf.outside[j];
+          if ( i == apex ) continue;
+          where = assignPoint(faces,firstnew,lastnew,p,i,tol);
+          if ( where < 0 ) ++num_inside;
+          if ( where <= 0 ) ++num_done;
+        }
+        for (int j=0; j < (int)vf.coplanar.size(); ++j) {
+          where = assignPoint(faces,firstnew,lastnew,p,vf.coplanar[j],tol);
+          if ( where < 0 ) ++num_inside;
+          if ( where > 0 ) --num_done;
+        }
+        IntArray().swap(vf.outside); IntArray().swap(vf.coplanar);
+      }
+      for (int nf=firstnew; nf < lastnew; ++nf) startingat[faces[nf].v[0]] = -1;
+      for (int nf=firstnew; nf < lastnew; ++nf)
+        if ( !faces[nf].outside.empty() ) pending.push_back(nf);
 
-  bool DLFLConvexHull::constructHull( ) {
-    // Create Initial double-triangle
-    if ( doubleTriangle() == false ) {
-      cout << "Could not form initial polytope" << endl;
-      return false;
+      ++iteration; ++num_done;
+      if ( !reportProgress(num_done,num_points) ) return -1;
     }
 
-    // Go through list of InputVertices and add ones which have not been processed yet
-    InputVertex iv;
-    bool retval = true; // Tells us if any vertex is inside convex hull
-    for (int i=0; i < vertices.size(); ++i) {
-      iv = vertices[i];
-      if ( !iv.processed ) {
-	iv.index = vertices[i].index; // Esan
-	iv.processed = true;
-	retval = addOne(iv);
-      }
+    // Collect the faces which are left
+    for (int f=0; f < (int)faces.size(); ++f) {
+      if ( !faces[f].alive ) continue;
+      triangles.push_back(faces[f].v[0]);
+      triangles.push_back(faces[f].v[1]);
+      triangles.push_back(faces[f].v[2]);
     }
-    return retval;
+    if ( onhull ) onhull->swap(isvertex);
+    return num_inside;
   }
 
   // Create a convex hull from given list of vertices
   // Old object is destroyed
   bool DLFLConvexHull::createHull(const Vector3dArray& p) {
     reset(); // Inherited from DLFLObject class
-    vertices.clear(); vertices.resize(p.size());
-    for (int i=0; i < p.size(); ++i) {
-      vertices[i].point = p[i];
-      vertices[i].index = i;
-      vertices[i].processed = false;
+
+    IntArray triangles;
+    vector<bool> onhull;
+    int num_inside = quickHull(p,triangles,&onhull);
+    if ( num_inside < 0 ) {
+      cout << "Could not form initial polytope" << endl;
+      return false;
+    }
+
+    // Vertices in the order of the points
+    int num_points = p.size();
+    DLFLVertexPtrArray verts(num_points,NULL);
+    for (int i=0; i < num_points; ++i) {
+      if ( !onhull[i] ) continue;
+      verts[i] = new DLFLVertex(p[i]);
+      verts[i]->CHullIndex = i;
+      addVertexPtr(verts[i]);
+    }
+
+    // Faces, with corner 3*t+k for corner k of triangle t
+    int num_triangles = triangles.size()/3;
+    DLFLFaceVertexPtrArray corners(3*num_triangles);
+    for (int t=0; t < num_triangles; ++t) {
+      DLFLFacePtr fp = new DLFLFace;
+      for (int k=0; k < 3; ++k) {
+        corners[3*t+k] = new DLFLFaceVertex;
+        corners[3*t+k]->setVertexPtr(verts[triangles[3*t+k]]);
+        fp->addVertexPtr(corners[3*t+k]);
+      }
+      fp->updateFacePointers();
+      fp->addFaceVerticesToVertices();
+      addFacePtr(fp);
     }
 
-    bool retval = constructHull();
+    // Edges. Corner c starts the edge from its vertex to the next one in its
+    // triangle, which is matched with the corner going the other way
+    map<pair<int,int>,int> halfedges;
+    for (int c=0; c < 3*num_triangles; ++c) {
+      int a = triangles[c], b = triangles[3*(c/3)+(c+1)%3];
+      map<pair<int,int>,int>::iterator it = halfedges.find(make_pair(b,a));
+      if ( it == halfedges.end() ) {
+        halfedges[make_pair(a,b)] = c;
+      } else {
+        DLFLEdgePtr ep = new DLFLEdge;
+        ep->setFaceVertexPointers(corners[it->second],corners[c],false);
+        ep->updateFaceVertices();
+        addEdgePtr(ep);
+        halfedges.erase(it);
+      }
+    }
 
-    return retval;
+    return (num_inside == 0);
   }
 
 } // end namespace
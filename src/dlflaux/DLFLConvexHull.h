@@ -11,71 +11,32 @@
 
 namespace DLFL {
 
+  /*
+    Convex hull of a set of points by quickhull. Only the points are looked at,
+    no DLFL elements are created. Every point outside the current hull is kept
+    in the conflict list of one face it is above, so a point added to the hull
+    is only compared with the faces it replaces, not with the whole hull.
+    The faces of the hull are returned in triangles as triples of indices into
+    p, counter-clockwise seen from outside. If onhull is given, it is set to
+    true for the points which are vertices of the hull.
+    Returns the number of points strictly inside the hull (points on the
+    boundary which are not vertices don't count), or -1 if the points don't
+    span a volume or the computation was cancelled (see DLFLProgress).
+  */
+  int quickHull(const Vector3dArray& p, IntArray& triangles, vector<bool>* onhull = NULL);
+
   class DLFLConvexHull : public DLFLObject {
-  protected :
-
-    // Bit flags for use during hull construction
-    static long remove;                   // Edge needs to be removed
-    static long border;                      // Edge is a border edge
-    static long visible;            // Face is visible from new point
-    static long invisible;        // Face is invisible from new point
-
-    // Structure for storing the input vertices
-    struct InputVertex {
-    public :
-
-      Vector3d point;                      // Coordinates of point
-      bool processed;            // Has this point been processed?
-      bool onhull;                   // Is this point on the hull?
-      int index;                 // Used in column modeling - Esan
-
-      InputVertex()
-	: point(), processed(false), onhull(false)
-      {}
-
-      InputVertex(const Vector3d& p)
-	: point(p), processed(false), onhull(false)
-      {}
-          
-      InputVertex(const InputVertex& iv)
-	: point(iv.point), processed(iv.processed), onhull(iv.onhull)
-      {}
-
-      ~InputVertex()
-      {}
-
-      InputVertex& operator = (const InputVertex& iv) {
-	point = iv.point; processed = iv.processed; onhull = iv.onhull;
-	return (*this);
-      }
-    };
-     
-
-    typedef vector<InputVertex> InputVertexArray;
-    typedef list<InputVertex> InputVertexList;
-     
-    InputVertexArray vertices; // Input vertices for hull construction
-     
   public :
 
     // Default constructor
     DLFLConvexHull()
-      : DLFLObject(), vertices()
+      : DLFLObject()
     {}
 
-    // Construct from given array of Vector3ds
-    DLFLConvexHull(const Vector3dArray& p)
-      : DLFLObject(), vertices()
-    {
-      vertices.resize(p.size());
-      for (int i=0; i < (int)p.size(); ++i)
-	vertices[i].point = p[i];
-    }
-
   private :
     // Copy constructor
     DLFLConvexHull(const DLFLConvexHull& dchull)
-      : DLFLObject(), vertices(dchull.vertices)
+      : DLFLObject()
     {}
 
   public :
@@ -89,28 +50,19 @@ namespace DLFL {
     }
 
   public :
-    // Create a convex hull from given list of vertices
+    // Create a convex hull from given list of vertices. The hull is found with
+    // quickHull and the DLFL object is built from the triangles in one pass.
+    // CHullIndex of each vertex is the index of its point.
     // Old object is destroyed
+    // Returns false if any of the given points is inside the convex hull
     bool createHull(const Vector3dArray& p);
 
-    //--- Subroutines for creation of Convex Hull ---//
-
     // Are the 3 given points co-linear?
     static bool colinear(const Vector3d& p1, const Vector3d& p2, const Vector3d& p3);
 
     // Find sign of volume of tetrahedron formed by given face and given point
     // If given face is not a triangle returns 0.
     static int volumeSign(DLFLFacePtr face, const Vector3d& p);
-
-    // Create the initial polytope
-    bool doubleTriangle( );
-     
-    // Add a vertex from the list to the convex hull
-    bool addOne(InputVertex& iv);
-
-    // Construct the hull from given array of points
-    // Returns false is any of the given points is not on the convex hull
-    bool constructHull( );
   };
 
 } // end namespace
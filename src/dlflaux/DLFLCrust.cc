@@ -7,6 +7,8 @@
 
 #include <DLFLCore.h>
 #include <DLFLCoreExt.h>
+#include <DLFLParallel.h>
+#include <DLFLProgress.h>
 #include "DLFLConvexHull.h"
 #include "DLFLConnect.h"
 #include "DLFLSubdiv.h"
@@ -14,18 +16,61 @@
 namespace DLFL {
 
   /*
-    Create a crust for this object.
-    Creates an inner (outer if thickness is negative) surface
-    duplicating the existing surface and moving every vertex along
-    the average normal at the vertex for the given distance.
-    Boolean flag indicates if crust should be of uniform thickness
-    which means thickness at vertices will be adjusted to account
-    for normal averaging.
+    Store the normals at the corners of the faces. Every face only writes
+    its own corners, so the faces are done in parallel.
   */
+  static void storeCrustNormals(const DLFLFacePtrArray& faces) {
+    int num_faces = faces.size();
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_faces; ++i)
+      faces[i]->storeNormals();
+  }
 
-  void createCrust(DLFLObjectPtr obj, double thickness, bool uniform) {
-    if ( !isNonZero(thickness) ) return;
+  /*
+    Positions of the vertices moved along the average normal for a crust
+    of the given thickness, using the normals stored at the corners.
+    If thickness is negative the vertices move outward, otherwise inward.
+    Only reads the object, so the vertices are done in parallel.
+  */
+  static void crustOffsets(const DLFLVertexPtrArray& verts, double thickness, bool uniform,
+                           Vector3dArray& newpos) {
+    int num_verts = verts.size();
+    newpos.resize(num_verts);
+#pragma omp parallel
+    {
+      Vector3dArray normals;
+      Vector3d avenormal;
+      double mod_thickness; // Modified thickness for uniform thickness shells
+#pragma omp for schedule(static)
+      for (int i=0; i < num_verts; ++i) {
+        DLFLVertexPtr vp = verts[i];
+
+        // If uniform thickness is required, adjust thickness appropriately
+        if ( uniform ) {
+          avenormal = vp->getNormals(normals);
+          mod_thickness = 0.0;
+          for (int j=0; j < normals.size(); ++j)
+            mod_thickness += thickness/(avenormal*normals[j]);
+          mod_thickness /= normals.size();
+        } else {
+          avenormal = vp->averageNormal();
+          mod_thickness = thickness;
+        }
+        // Negative sign because the normal is outward
+        // Use the modified thickness
+        newpos[i] = vp->coords - mod_thickness*avenormal;
+      }
+    }
+  }
 
+  /*
+    Append a copy of the object with the faces reversed and fill the arrays
+    storing information for crust modeling. The normals at the corners of
+    the original faces must be stored already: the corners of the copy get
+    them with the opposite sign, which is what storing the normals of the
+    reversed faces would give.
+  */
+  static void appendCrustCopy(DLFLObjectPtr obj) {
     // Clear the arrays used to store crust modeling information
     crustfp1.clear(); crustfp2.clear();
 
@@ -34,91 +79,84 @@ namespace DLFL {
     crustfp1.resize(crust_num_old_faces,NULL);
     crustfp2.resize(crust_num_old_faces,NULL);
 
-    StringStream dlflstream; // Stream used to duplicate the object
-    StringStream mtlstream; // Stream used to duplicate the object
-
-    // Write the object in DLFL format with the faces reversed
-    obj->writeDLFL(dlflstream,mtlstream, true);
-
-    int num_old_verts = obj->num_vertices();
-
-    // Read back from the stream and append to existing object
-    obj->readDLFL(dlflstream,mtlstream, false);
+    // Append a copy of the object with the faces reversed
+    obj->appendCopy(*obj,true);
 
     // Fill the arrays storing information for crust modeling
-    // Since we are traversing the faces, also compute and store
-    // the normals at corners of each face for use later
     DLFLFacePtrList::iterator fl_first, fl_last;
     DLFLFacePtr fp;
     int num_faces = 0;
     fl_first = obj->beginFace(); fl_last = obj->endFace();
     while ( num_faces < crust_num_old_faces ) {
       fp = *fl_first;
-      crustfp1[num_faces] = fp; fp->makeUnique(); fp->storeNormals();
+      crustfp1[num_faces] = fp; fp->makeUnique();
       ++fl_first; ++num_faces;
     }
     num_faces = 0;
     while ( fl_first != fl_last ) {
       fp = *fl_first;
-      crustfp2[num_faces] = fp; fp->makeUnique(); fp->storeNormals();
+      crustfp2[num_faces] = fp; fp->makeUnique();
       ++fl_first; ++num_faces;
     }
 
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_faces; ++i) {
+      DLFLFaceVertexPtr head = crustfp2[i]->front(), current = head;
+      if ( head == NULL ) continue;
+      do {
+        current->normal = -current->normal;
+        current = current->next();
+      } while ( current != head );
+    }
+  }
+
+  /*
+    Move the original vertices (the first newpos.size() vertices) or their
+    copies appended after them to the given positions
+  */
+  static void moveCrustVertices(DLFLObjectPtr obj, bool copies, const Vector3dArray& newpos) {
+    DLFLVertexPtrArray verts;
+    obj->getVertices(verts);
+    int num_old_verts = newpos.size();
+    int first = ( copies ) ? num_old_verts : 0;
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_old_verts; ++i)
+      verts[first+i]->coords = newpos[i];
+  }
+
+  /*
+    Create a crust for this object.
+    Creates an inner (outer if thickness is negative) surface
+    duplicating the existing surface and moving every vertex along
+    the average normal at the vertex for the given distance.
+    Boolean flag indicates if crust should be of uniform thickness
+    which means thickness at vertices will be adjusted to account
+    for normal averaging.
+  */
+
+  void createCrust(DLFLObjectPtr obj, double thickness, bool uniform) {
+    if ( !isNonZero(thickness) ) return;
+
+    // Compute the geometry on the original surface before any change to
+    // the object: the normals at the corners of the faces and from them the
+    // new positions of the vertices. The reversed copy has the same normals
+    // with the opposite sign, so it would give the same positions.
+    DLFLFacePtrArray faces;
+    DLFLVertexPtrArray verts;
+    Vector3dArray newpos;
+    obj->getFaces(faces); obj->getVertices(verts);
+    storeCrustNormals(faces);
+    crustOffsets(verts,thickness,uniform,newpos);
+
+    // The copy is most of the work, progress is only reported around it
+    if ( !reportProgress(1,4) ) return;
+    appendCrustCopy(obj);
+    if ( !reportProgress(3,4) ) return;
+
     // If thickness is negative move the old vertices outward
     // Otherwise move the new vertices inward
-    DLFLVertexPtrList::iterator vl_first, vl_last;
-    DLFLVertexPtr vp;
-    Vector3dArray normals;
-    Vector3d avenormal, newpos;
-    double mod_thickness; // Modified thickness for uniform thickness shells
-    int num_verts = 0;
-	//negative thickness
-    if ( thickness < 0.0 ) {
-      vl_first = obj->beginVertex();
-      while ( num_verts < num_old_verts ) {
-				vp = (*vl_first); ++vl_first; ++num_verts;
+    moveCrustVertices(obj,thickness > 0.0,newpos);
 
-				// If uniform thickness is required, adjust thickness appropriately
-				if ( uniform ) {
-				  avenormal = vp->getNormals(normals);
-				  mod_thickness = 0.0;
-				  for (int i=0; i < normals.size(); ++i)
-				    mod_thickness += thickness/(avenormal*normals[i]);
-				  mod_thickness /= normals.size();
-				} else {
-				  avenormal = vp->averageNormal();
-				  mod_thickness = thickness;
-				}
-				// Negative sign because thickness is negative and normal is outward
-				// Use the modified thickness
-				newpos = vp->coords - mod_thickness*avenormal;
-				vp->coords = newpos;
-      }
-    }
-	//thickness > 0
-	else {
-      vl_first = obj->beginVertex(); vl_last = obj->endVertex();
-      advance(vl_first,num_old_verts);
-      while ( vl_first != vl_last ) {
-				vp = (*vl_first); ++vl_first;
-				// If uniform thickness is required, adjust thickness appropriately
-				if ( uniform ) {
-				  avenormal = vp->getNormals(normals);
-				  mod_thickness = 0.0;
-				  for (int i=0; i < normals.size(); ++i)
-				    mod_thickness += thickness/(avenormal*normals[i]);
-				  mod_thickness /= normals.size();
-				}
-				else {
-				  avenormal = vp->averageNormal();
-				  mod_thickness = thickness;
-				}
-				// Positive sign because thickness is positive and normal is inward
-				// Use the modified thickness
-				newpos = vp->coords + mod_thickness*avenormal;
-				vp->coords = newpos;
-      }
-    }
     // Find and store the min. id for the face list
     crust_min_face_id = (obj->firstFace())->getID();
   }
@@ -133,19 +171,24 @@ namespace DLFL {
   void createCrustWithScaling(DLFLObjectPtr obj, double scale_factor) {
     if ( !isNonZero(scale_factor) ) return;
 
-    // Clear the arrays used to store crust modeling information
-    crustfp1.clear(); crustfp2.clear();
+    createCrustWithScaling(obj,scale_factor,crustfp1,crustfp2);
+    crust_num_old_faces = crustfp1.size();
 
-    // Resize the arrays to appropriate size
-    crust_num_old_faces = obj->num_faces();
-    crustfp1.resize(crust_num_old_faces,NULL);
-    crustfp2.resize(crust_num_old_faces,NULL);
+    // Find and store the min. id for the face list
+    crust_min_face_id = (obj->firstFace())->getID();
+  }
+
+  void createCrustWithScaling(DLFLObjectPtr obj, double scale_factor,
+                              DLFLFacePtrArray& outer_faces, DLFLFacePtrArray& inner_faces) {
+    if ( !isNonZero(scale_factor) ) return;
 
-    StringStream dlflstream; // Stream used to duplicate the object
-    StringStream mtlstream; // Stream used to duplicate the object
+    // Clear the arrays used to store crust modeling information
+    outer_faces.clear(); inner_faces.clear();
 
-    // Write the object in DLFL format with the faces reversed
-    obj->writeDLFL(dlflstream, mtlstream, true);
+    // Resize the arrays to appropriate size
+    int num_old_faces = obj->num_faces();
+    outer_faces.resize(num_old_faces,NULL);
+    inner_faces.resize(num_old_faces,NULL);
 
     int num_old_verts = 0;
     Vector3d objcen;
@@ -159,23 +202,25 @@ namespace DLFL {
     }
     objcen /= num_old_verts;
 
-    // Read back from the stream and append to existing object
-    obj->readDLFL(dlflstream, mtlstream, false);
+    // Append a copy of the object with the faces reversed
+    if ( !reportProgress(1,4) ) return;
+    obj->appendCopy(*obj,true);
+    if ( !reportProgress(3,4) ) return;
 
     // Fill the arrays storing information for crust modeling
     DLFLFacePtrList::iterator fl_first, fl_last;
     DLFLFacePtr fp;
     int num_faces = 0;
     fl_first = obj->beginFace(); fl_last = obj->endFace();
-    while ( num_faces < crust_num_old_faces ) {
+    while ( num_faces < num_old_faces ) {
       fp = *fl_first;
-      crustfp1[num_faces] = fp; fp->makeUnique();
+      outer_faces[num_faces] = fp; fp->makeUnique();
       ++fl_first; ++num_faces;
     }
     num_faces = 0;
     while ( fl_first != fl_last ) {
       fp = *fl_first;
-      crustfp2[num_faces] = fp; fp->makeUnique();
+      inner_faces[num_faces] = fp; fp->makeUnique();
       ++fl_first; ++num_faces;
     }
 
@@ -208,9 +253,6 @@ namespace DLFL {
 				vp->coords = newpos;
       }
     }
-
-    // Find and store the min. id for the face list
-    crust_min_face_id = (obj->firstFace())->getID();
   }
 
   void cmMakeHole(DLFLObjectPtr obj, DLFLFacePtr fp, bool cleanup) {
@@ -267,190 +309,101 @@ namespace DLFL {
 
 	}
 
-  void createCrustForWireframe(DLFLObjectPtr obj, double thickness) {
-
-		bool uniform = true;
-
-    if ( !isNonZero(thickness) ) return;
-
-    // Clear the arrays used to store crust modeling information
-    crustfp1.clear(); crustfp2.clear();
-
-    // Resize the arrays to appropriate size
-    crust_num_old_faces = obj->num_faces();
-    crustfp1.resize(crust_num_old_faces,NULL);
-    crustfp2.resize(crust_num_old_faces,NULL);
-
-    StringStream dlflstream; // Stream used to duplicate the object
-    StringStream mtlstream; // Stream used to duplicate the object
-
-    // Write the object in DLFL format with the faces reversed
-    obj->writeDLFL(dlflstream,mtlstream, true);
-
-    int num_old_verts = obj->num_vertices();
-
-    // Read back from the stream and append to existing object
-    obj->readDLFL(dlflstream, mtlstream, false);
+  /*
+    Direction in which a vertex of the crust for a wireframe moves: the
+    intersection of the planes through the two edges of the vertex in the
+    face marked for making a hole, perpendicular to the neighbouring faces.
+    Only reads the object.
+  */
+  static Vector3d wireframeOffsetDirection(DLFLVertexPtr vp) {
+    DLFLFaceVertexPtr fvp1,fvp2,fvp0, fvp3, fvp4, fvptemp, fvptemp1, fvptemp2;
+    DLFLFacePtr fphole = NULL, fp1, fp2, fp;
+    DLFLEdgePtr ep1, ep0;
+    Vector3d v0, v1, v2, v3, v4, n1, n2, n3 ,n4;
+    DLFLFaceVertexPtrList fvplist;
+    fvplist=vp->getFaceVertexList();
+
+    // get the face that has the current vertex as one of its vertices
+    // and is marked for making a hole
+    DLFLFaceVertexPtrList::iterator first = fvplist.begin(), last = fvplist.end();
+    while ( first != last ) {
+      fvptemp = (*first);
+      fp = fvptemp->getFacePtr();
 
-    // Fill the arrays storing information for crust modeling
-    // Since we are traversing the faces, also compute and store
-    // the normals at corners of each face for use later
-    DLFLFacePtrList::iterator fl_first, fl_last;
-    DLFLFacePtr fp;
-    int num_faces = 0;
-    fl_first = obj->beginFace(); fl_last = obj->endFace();
-    while ( num_faces < crust_num_old_faces ) {
-      fp = *fl_first;
-      crustfp1[num_faces] = fp; fp->makeUnique(); fp->storeNormals();
-      ++fl_first; ++num_faces;
-    }
-    num_faces = 0;
-    while ( fl_first != fl_last ) {
-      fp = *fl_first;
-      crustfp2[num_faces] = fp; fp->makeUnique(); fp->storeNormals();
-      ++fl_first; ++num_faces;
+      if ( fp->getType() == FTHole ) {
+        fphole = fp; break;
+      }
+      ++first;
     }
+    fp = fphole;
+
+    fvp0 = vp->getFaceVertexInFace(fp);
+    fvp1 = fvp0->next();
+    fvp2 = fvp0->prev();
+
+    // Get the two edges originating from the present vertex
+    ep0 = fvp0->getEdgePtr(); ep1 = fvp2->getEdgePtr();
+
+    // For the edge starting at v0 to wards v1
+    ep0->getFacePointers(fp1,fp2);
+
+    // get the face to NOT be holed
+    if ( fp1->getType() == FTHole ) fp = fp2;
+    else fp = fp1;
+
+    // get the three face vertices
+    fvptemp = vp->getFaceVertexInFace(fp);
+    fvptemp1 = fvptemp->next();
+    fvp3 = fvptemp1;
+
+    // For the edge starting at v1 towards v0
+    // Same as before after this
+    ep1->getFacePointers(fp1, fp2);
+    if ( fp1->getType() == FTHole ) fp = fp2;
+    else fp = fp1;
+
+    fvptemp = vp->getFaceVertexInFace(fp);
+    fvptemp2 = fvptemp->prev();
+    fvp4 = fvptemp2;
+
+    // Get the vertex coordinates of the five face vertices found
+    v0 = fvp0->getVertexCoords();
+    v1 = fvp1->getVertexCoords();
+    v2 = fvp2->getVertexCoords();
+    v3 = fvp3->getVertexCoords();
+    v4 = fvp4->getVertexCoords();
+
+    n1 = normalized( (v1-v0) % (v3-v0) );
+    n2 = normalized( n1 % (v1-v0) );
+    n3 = normalized( (v2-v0)% ( v4-v0) );
+    n4 = normalized( (v2-v0) % n3 );
+    return normalized(n2 % n4); // normal is the direction in which the new_pos will lie.
+  }
 
-    // If thickness is negative move the old vertices outward
-    // Otherwise move the new vertices inward
+  void createCrustForWireframe(DLFLObjectPtr obj, double thickness) {
+    if ( !isNonZero(thickness) ) return;
 
-    DLFLVertexPtrList::iterator vl_first, vl_first_old, vl_last;
-    DLFLVertexPtr vp,vpNew;
-    Vector3d normal, newpos;
-	  Vector3dArray normals;
-	  Vector3d avenormal;
-	  double mod_thickness; // Modified thickness for uniform thickness shells
-	  int num_verts = 0;
-
-    if ( thickness < 0.0 ) {
-	    vl_first = obj->beginVertex();
-	    while ( num_verts < num_old_verts ) {
-					vp = (*vl_first); ++vl_first; ++num_verts;
-
-					// If uniform thickness is required, adjust thickness appropriately
-					if ( uniform ) {
-					  avenormal = vp->getNormals(normals);
-					  mod_thickness = 0.0;
-					  for (int i=0; i < normals.size(); ++i)
-					    mod_thickness += thickness/(avenormal*normals[i]);
-					  mod_thickness /= normals.size();
-					} else {
-					  avenormal = vp->averageNormal();
-					  mod_thickness = thickness;
-					}
-					// Negative sign because thickness is negative and normal is outward
-					// Use the modified thickness
-					newpos = vp->coords - mod_thickness*avenormal;
-					vp->coords = newpos;
-	    }
+    // Compute all the new positions on the original surface before any
+    // change to the object, as in createCrust
+    DLFLFacePtrArray faces;
+    DLFLVertexPtrArray verts;
+    Vector3dArray newpos;
+    obj->getFaces(faces); obj->getVertices(verts);
+    storeCrustNormals(faces);
+
+    // If thickness is negative move the old vertices outward, with uniform thickness
+    // Otherwise move the new vertices inward, away from the holes
+    if ( thickness < 0.0 ) crustOffsets(verts,thickness,true,newpos);
+    else {
+      int num_verts = verts.size();
+      newpos.resize(num_verts);
+#pragma omp parallel for schedule(static)
+      for (int i=0; i < num_verts; ++i)
+        newpos[i] = verts[i]->coords - thickness*wireframeOffsetDirection(verts[i]);
     }
-    if ( thickness > 0.0 ) {
-      vl_first = obj->beginVertex(); vl_first_old= obj->beginVertex();
-      for (int i = 0; i < num_old_verts; i++)
-				++vl_first_old;
-
-				      while (  num_verts < num_old_verts) {
-				vpNew = (*vl_first_old); vp = (*vl_first); ++vl_first; ++num_verts; ++vl_first_old;
-
-				DLFLFaceVertexPtrList fvpList;
-				DLFLFaceVertexPtr fvp1,fvp2,fvp0, fvp3, fvp4, fvptemp, fvptemp1, fvptemp2;
-				DLFLFacePtr fphole, fp1, fp2, fp;
-				DLFLEdgePtr ep1, ep0;
-				Vector3d v0, v1, v2, v3, v4, n1, n2, n3 ,n4, ntemp;
-				DLFLFaceVertexPtrList fvplist;
-				fvplist=vp->getFaceVertexList();
-
-				// get the face that has the current vertex as one of its vertices
-				// and is marked for making a hole
-				DLFLFaceVertexPtrList::iterator first = fvplist.begin(), last = fvplist.end();
-				while ( first != last ) {
-					fvptemp = (*first);
-					fp = fvptemp->getFacePtr();
-
-				 	if ( fp->getType() == FTHole ) {
-				   	fphole = fp; break;
-				 	}
-				 	++first;
-				}
-				fp = fphole;
 
-				fvp0 = vp->getFaceVertexInFace(fp);
-				fvp1 = fvp0->next();
-				fvp2 = fvp0->prev();
-
-				// get vertex pointers
-				// vp1 = fvp1->getVertexPtr(); vp2 = fvp2->getVertexPtr();
-
-				// Get the two edges originating from the present vertex
-				ep0 = fvp0->getEdgePtr(); ep1 = fvp2->getEdgePtr();
-
-				// For the edge starting at v0 to wards v1
-				ep0->getFacePointers(fp1,fp2);
-
-				// get the face to NOT be holed
-				if ( fp1->getType() == FTHole ) fp = fp2;
-				else fp = fp1;
-
-				// get the three face vertices
-				fvptemp = vp->getFaceVertexInFace(fp);
-				fvptemp1 = fvptemp->next();
-
-				// get the vertices of the other two vertices in the face
-				//vptemp1 = fvptemp1->getVertexPtr();
-
-				fvp3 = fvptemp1;
-
-				// For the edge starting at v1 towards v0
-				// Same as before after this
-				ep1->getFacePointers(fp1, fp2);
-				if ( fp1->getType() == FTHole ) fp = fp2;
-				else fp = fp1;
-
-				fvptemp = vp->getFaceVertexInFace(fp);
-				fvptemp2 = fvptemp->prev();
-
-				//vptemp2 = fvptemp2->getVertexPtr();
-				fvp4 = fvptemp2;
-
-				// Get the vertex coordinates of the five face vertices found
-				v0 = fvp0->getVertexCoords();
-				v1 = fvp1->getVertexCoords();
-				v2 = fvp2->getVertexCoords();
-				v3 = fvp3->getVertexCoords();
-				v4 = fvp4->getVertexCoords();
-
-				n1 = normalized( (v1-v0) % (v3-v0) );
-				n2 = normalized( n1 % (v1-v0) );
-				n3 = normalized( (v2-v0)% ( v4-v0) );
-				n4 = normalized( (v2-v0) % n3 );
-				normal = normalized(n2 % n4); // normal is the direction in which the new_pos will lie.
-
-				newpos = vpNew->coords - thickness*normal;
-				vpNew->coords = newpos;
-				      }
-				// vl_first = obj->beginVertex(); vl_last = obj->endVertex();
-				// 		    advance(vl_first,num_old_verts);
-				// 		    while ( vl_first != vl_last ) {
-				// 		vp = (*vl_first); ++vl_first;
-				// 		// If uniform thickness is required, adjust thickness appropriately
-				// 		if ( uniform ) {
-				// 		  avenormal = vp->getNormals(normals);
-				// 		  mod_thickness = 0.0;
-				// 		  for (int i=0; i < normals.size(); ++i)
-				// 		    mod_thickness += thickness/(avenormal*normals[i]);
-				// 		  mod_thickness /= normals.size();
-				// 		}
-				// 		else {
-				// 		  avenormal = vp->averageNormal();
-				// 		  mod_thickness = thickness;
-				// 		}
-				// 		// Positive sign because thickness is positive and normal is inward
-				// 		// Use the modified thickness
-				// 		newpos = vp->coords + mod_thickness*avenormal;
-				// 		vp->coords = newpos;
-				// 		    }
-
-    }
+    appendCrustCopy(obj);
+    moveCrustVertices(obj,thickness > 0.0,newpos);
 
     // Find and store the min. id for the face list
     crust_min_face_id = (obj->firstFace())->getID();
@@ -467,16 +420,10 @@ namespace DLFL {
     crustfp1.resize(crust_num_old_faces,NULL);
     crustfp2.resize(crust_num_old_faces,NULL);
 
-    StringStream dlflstream; // Stream used to duplicate the object
-    StringStream mtlstream; // Stream used to duplicate the object
-
-    // Write the object in DLFL format with the faces reversed
-    obj->writeDLFL(dlflstream,mtlstream, true);
-
     int num_old_verts = obj->num_vertices();
 
-    // Read back from the stream and append to existing object
-    obj->readDLFL(dlflstream,mtlstream, false);
+    // Append a copy of the object with the faces reversed
+    obj->appendCopy(*obj,true);
 
     // Fill the arrays storing information for crust modeling
     // Since we are traversing the faces, also compute and store
@@ -613,6 +560,110 @@ namespace DLFL {
     crust_min_face_id = (obj->firstFace())->getID();
   }
 
+  /*
+    Rings of numSides points for the columns of a wireframe around every
+    edge of a vertex, far enough from the vertex for the columns not to
+    overlap. Returns the corners of the vertex in the order of the rings and
+    the axis of each ring. Only reads the object: the normals of the faces
+    at vertices of valence 2 must have been computed already.
+  */
+  static void wireframeRings(DLFLVertexPtr vp, double thickness, int numSides,
+                             DLFLFaceVertexPtrArray& fvparray, Vector3dArray& ring,
+                             Vector3dArray& axes) {
+    DLFLEdgePtr eptr, eptr_temp1, eptr_temp2;
+    DLFLFacePtr tmpfptr1, tmpfptr2;
+    DLFLFaceVertexPtr tmpfvptr, dirFvp1, dirFvp2;
+    Vector3d edgeVector, xyz, dir, edgeVec1, edgeVec2, axis, start_point;
+    Vector3d Xaxis(1,0,0), Yaxis(0,1,0), vec, PonAxs, Ndir1, Ndir2;
+    float angle, cosT1, T1, L;
+    int numFvps;
+
+    fvparray.clear(); ring.clear(); axes.clear();
+    vp->getFaceVertices(fvparray);
+    float length;
+    if ( fvparray.size() != 1 ) {
+      tmpfvptr = fvparray[0];
+      numFvps = fvparray.size();
+      fvparray.clear();
+      fvparray.push_back(tmpfvptr);
+      for (int i=1; i < numFvps; i++) {
+        tmpfvptr = tmpfvptr->vnext();
+        fvparray.push_back(tmpfvptr);
+      }
+
+      length = -99999;	// the largest length for the vertex
+
+      //FIND THE LARGEST DISTANCE FORM THE VERTEX FOR THE NEW FACE TO BE PUT if
+      for (int  i=0; i<fvparray.size(); i++) {
+        eptr_temp1 = (fvparray[i])->getEdgePtr();
+        for (int  ii=0; ii<fvparray.size(); ii++) {
+          eptr_temp2 = (fvparray[ii])->getEdgePtr();
+          if (eptr_temp1->getID() != eptr_temp2->getID()) {
+            edgeVec1 = (eptr_temp1->getOtherVertexPointer(vp))->getCoords() - vp->getCoords();
+            edgeVec2 = (eptr_temp2->getOtherVertexPointer(vp))->getCoords() - vp->getCoords();
+            edgeVec1 =normalized(edgeVec1);
+            edgeVec2 =normalized(edgeVec2);
+            cosT1 = edgeVec1*edgeVec2; //axis;
+            T1 = acos(cosT1);
+            L= thickness/tan(T1/2);
+            if (L > length)  length = L + fabs(cosT1*thickness)+ 0.001*thickness;
+          }//if
+        }//for
+      }//for largest distance
+
+    }// valence 1
+    else length = 0;
+
+    ring.reserve(fvparray.size()*numSides); axes.reserve(fvparray.size());
+    for (int i=0; i < fvparray.size(); i++) {
+      double projected_length;
+      eptr = (fvparray[i])->getEdgePtr();
+      eptr->getFacePointers(tmpfptr1,tmpfptr2);
+      edgeVector = normalized((eptr->getOtherVertexPointer(vp))->getCoords() - vp->getCoords());
+      axis = edgeVector;
+      if ( fvparray.size() == 1 ) {
+        vec = Xaxis;
+        if ( fabs(axis*vec) == 1 ) vec = Yaxis;
+        dir = normalized(edgeVector % vec);
+      }
+      else if ( fvparray.size() == 2 )
+        dir = (((tmpfptr1)->getNormal() +(tmpfptr2)->getNormal())/2);
+      else {
+        dirFvp1 = vp->getFaceVertexInFace(tmpfptr1);
+        dirFvp2 = vp->getFaceVertexInFace(tmpfptr2);
+        Ndir1 = ((dirFvp1->next())->getVertexCoords() - vp->getCoords()) %
+          ((dirFvp1->prev())->getVertexCoords() - vp->getCoords());
+        Ndir2 = ((dirFvp2->next())->getVertexCoords() - vp->getCoords()) %
+          ((dirFvp2->prev())->getVertexCoords() - vp->getCoords());
+        dir = (normalized(Ndir1) + normalized(Ndir2))/2;
+      }
+
+      //start point with axis translated to origin (+vertex - vertex)
+      length += 0.0001;
+      start_point = length*axis+ normalized(dir) * thickness + vp->getCoords();
+      projected_length = (start_point - vp->getCoords())*axis ;
+      start_point = start_point + (( length)-projected_length) * axis;
+      PonAxs = vp->getCoords() + (length) * axis;
+      dir = normalized(start_point -PonAxs );
+      start_point = PonAxs +  dir*thickness;
+      start_point = start_point -vp->getCoords() ;
+      for (int j=0; j < numSides; j++) {
+        //calculate new point
+        angle = ((2*3.15)/numSides)*j;
+        Quaternion rot;
+        rot.setAxisAndAngle(axis, angle);
+        normalize(rot);
+        Quaternion rotp;
+        rotp = rot * start_point * conjugate(rot);
+        xyz.set(rotp[0],rotp[1],rotp[2]);
+
+        //move back from origin
+        ring.push_back(xyz + vp->getCoords());
+      }
+      axes.push_back(normalized(axis));
+    }
+  }
+
   void createWireframeWithSegments(DLFLObjectPtr obj, double thickness, int numSides) {
     DLFLFacePtrArray edge_connect_fparray, temp_face_array;
     DLFLEdgePtrArray edge_array, temp_edge_ptr_array;
@@ -620,20 +671,19 @@ namespace DLFL {
 
     DLFLEdgePtrList::iterator el_first, el_last;
     DLFLFacePtrList::iterator fl_first, fl_last;
-    DLFLVertexPtrList::iterator vl_first, vl_last, vl_tempLast;
 
-    DLFLEdgePtr eptr = NULL,eptr_temp1,eptr_temp2, ep_temp;
+    DLFLEdgePtr eptr = NULL, ep_temp;
     DLFLVertexPtr  vp,newvptr,temp_vptr,VListPtr, vp1, vp2;
-    DLFLFacePtr tmpfptr1, fp1_temp, fp2_temp,tmpfptr2,valOneFace;
-    DLFLFaceVertexPtr tmpfvptr, tmp_ch_fvp, dirFvp1,dirFvp2;
+    DLFLFacePtr fp1_temp, fp2_temp,valOneFace;
+    DLFLFaceVertexPtr tmp_ch_fvp;
 
-    Vector3d edgeVector, xyz, dir, edgeVec1, edgeVec2, axis,start_point,faceNormal, P0,P1,P2, normal;
-    Vector3dArray vertlist, edge_connect_normals,temp_vertlist, temp_chface_vertlist;
+    Vector3d faceNormal, P0,P1,P2;
+    Vector3dArray vertlist, edge_connect_normals, temp_chface_vertlist;
 
-    int count = 0,numFvps=0, edgeID, min_edge_id, index;
-    float angle,cosT1,cosT2,T1,T2,L,L1,L2;
+    int count = 0, edgeID, min_edge_id, index;
+    float cosT2,T2,L1,L2;
     int numVerts, num_original_edges;
-    Vector3d zeroVec(0,0,0), Xaxis(1,0,0), Yaxis(0,1,0), vec,PonAxs,vec1, Ndir1, Ndir2,VListVec;
+    Vector3d zeroVec(0,0,0), vec1, VListVec;
     double A[3], B[3],C[3], D[3];
 
     bool match,jointCreated,vertListSizeMatch,allFacesMatched;
@@ -641,7 +691,8 @@ namespace DLFL {
     StringStream dlflstream;
     StringStream mtlstream;
 
-    obj->writeDLFL(dlflstream,mtlstream,false);
+    // A cancelled copy is incomplete, it mustn't be read back
+    if ( !obj->writeDLFL(dlflstream,mtlstream,false) ) return;
 
     // Read back from the stream and append to existing object
     obj->readDLFL(dlflstream,mtlstream, true);
@@ -659,53 +710,43 @@ namespace DLFL {
 
     el_first = obj->beginEdge(); el_last = obj->endEdge();
     numVerts = obj->num_vertices();
-    vl_first = obj->beginVertex(); vl_last = obj->endVertex();
-    int num =0;
-
-    while ( num<numVerts ) {
-      vp =(*vl_first);
 
-      ++vl_first; num++;
-      fvparray.clear();
+    // Compute the rings of all the vertices in parallel before any change
+    // to the object. Vertices of valence 2 use the normals of their faces
+    DLFLVertexPtrArray verts;
+    DLFLFacePtrArray faces;
+    obj->getVertices(verts); obj->getFaces(faces);
+    int num_faces = faces.size();
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_faces; ++i) {
+      DLFLFaceVertexPtr head = faces[i]->front(), current = head;
+      if ( head == NULL ) continue;
+      do {
+        if ( current->getVertexPtr()->numEdges() == 2 ) {
+          faces[i]->computeNormal(); break;
+        }
+        current = current->next();
+      } while ( current != head );
+    }
 
-      vp->getFaceVertices(fvparray);
-      float length;
-      if ( fvparray.size() != 1 ) {
-	tmpfvptr = fvparray[0];
-	numFvps = fvparray.size();
-	fvparray.clear();
-	fvparray.push_back(tmpfvptr);
-	for (int i=1; i < numFvps; i++) {
-	  tmpfvptr = tmpfvptr->vnext();
-	  fvparray.push_back(tmpfvptr);
-	}
+    std::vector<DLFLFaceVertexPtrArray> vertex_corners(numVerts);
+    std::vector<Vector3dArray> vertex_rings(numVerts), vertex_axes(numVerts);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < numVerts; ++i)
+      wireframeRings(verts[i],thickness,numSides,vertex_corners[i],vertex_rings[i],vertex_axes[i]);
 
-	vp->getEdges(edge_array);
-	length = -99999;	// the largest length for the vertex
-
-	//FIND THE LARGEST DISTANCE FORM THE VERTEX FOR THE NEW FACE TO BE PUT if
-	for (int  i=0; i<fvparray.size(); i++) {
-	  eptr_temp1 = (fvparray[i])->getEdgePtr();
-	  for (int  ii=0; ii<fvparray.size(); ii++) {
-	    eptr_temp2 = (fvparray[ii])->getEdgePtr();
-	    if (eptr_temp1->getID() != eptr_temp2->getID()) {
-	      edgeVec1 = (eptr_temp1->getOtherVertexPointer(vp))->getCoords() - vp->getCoords();
-	      edgeVec2 = (eptr_temp2->getOtherVertexPointer(vp))->getCoords() - vp->getCoords();
-	      edgeVec1 =normalized(edgeVec1);
-	      edgeVec2 =normalized(edgeVec2);
-	      cosT1 = edgeVec1*edgeVec2; //axis;
-	      T1 = acos(cosT1);
-	      L= thickness/tan(T1/2);
-	      if (L > length)  length = L + fabs(cosT1*thickness)+ 0.001*thickness;
-	    }//if
-	  }//for
-	}//for largest distance
+    Vector3dArray axes;
+    int num =0;
 
-      }// valence 1
-      else length = 0;
+    while ( num<numVerts ) {
+      if ( !reportProgress(num,numVerts) ) return;
+      vp = verts[num];
+      fvparray.swap(vertex_corners[num]);
+      vertlist.swap(vertex_rings[num]);
+      axes.swap(vertex_axes[num]);
+      ++num;
 
       for (int i=0; i < fvparray.size(); i++) {
-	double projected_length;
 	eptr = (fvparray[i])->getEdgePtr();
 	edgeID = eptr->getID();
 	index = 2*(edgeID -  min_edge_id);
@@ -715,59 +756,13 @@ namespace DLFL {
 
 	eptr->setType(ETChull);
 
-	eptr->getFacePointers(tmpfptr1,tmpfptr2);
-	edgeVector = normalized((eptr->getOtherVertexPointer(vp))->getCoords() - vp->getCoords());
-	axis = edgeVector;
-	if ( fvparray.size() == 1 ) {
-	  vec = Xaxis;
-	  if ( fabs(axis*vec) == 1 ) vec = Yaxis;
-	  dir = normalized(edgeVector % vec);
-	}
-	else if ( fvparray.size() == 2 )
-	  dir = (((tmpfptr1)->computeNormal() +(tmpfptr2)->computeNormal())/2);
-	else {
-	  dirFvp1 = vp->getFaceVertexInFace(tmpfptr1);
-	  dirFvp2 = vp->getFaceVertexInFace(tmpfptr2);
-	  Ndir1 = ((dirFvp1->next())->getVertexCoords() - vp->getCoords()) %
-	    ((dirFvp1->prev())->getVertexCoords() - vp->getCoords());
-	  Ndir2 = ((dirFvp2->next())->getVertexCoords() - vp->getCoords()) %
-	    ((dirFvp2->prev())->getVertexCoords() - vp->getCoords());
-	  dir = (normalized(Ndir1) + normalized(Ndir2))/2;
-	}
-
-	//start point with axis translated to origin (+vertex - vertex)
-	length += 0.0001;
-	start_point = length*axis+ normalized(dir) * thickness + vp->getCoords();
-	projected_length = (start_point - vp->getCoords())*axis ;
-	start_point = start_point + (( length)-projected_length) * axis;
-	PonAxs = vp->getCoords() + (length) * axis;
-	dir = normalized(start_point -PonAxs );
-	start_point = PonAxs +  dir*thickness;
-	start_point = start_point -vp->getCoords() ;
-	for (int j=0; j < numSides; j++) {
-	  //calculate new point
-	  angle = ((2*3.15)/numSides)*j;
-	  Quaternion rot;
-	  rot.setAxisAndAngle(axis, angle);
-	  normalize(rot);
-	  Quaternion rotp;
-	  rotp = rot * start_point * conjugate(rot);
-	  xyz.set(rotp[0],rotp[1],rotp[2]);
-
-	  //move back from origin
-	  xyz = xyz + vp->getCoords();
-	  vertlist.push_back(xyz);       //vertlist for vertex convex hull
-	  temp_vertlist.push_back(xyz);  //vertlist for each edge face
-	}
 	if ( fvparray.size() == 1 ) {
-	  obj->createFace(temp_vertlist);
+	  obj->createFace(vertlist);
 	  fl_last = obj->endFace();
 	  --fl_last;--fl_last;
 	  valOneFace = *fl_last;
 	}
-	normal= axis;
-	edge_connect_normals[index] = normalized(normal);
-	temp_vertlist.clear();
+	edge_connect_normals[index] = axes[i];
       }//for
 
       //join the corresponding vertices of the new faces created for this vertex
@@ -1046,61 +1041,30 @@ namespace DLFL {
 
 	//selects all faces with same number of vertices as the face passed to the function
 	//initializes them in fparray by reference
+	//the selections are looked up in the match index of the object, which is only
+	//rebuilt when the object has changed
 	void selectMatchingFaces(DLFLObjectPtr obj, DLFLFacePtr fptr, DLFLFacePtrArray &fparray) {
-		fparray.clear();
-		DLFLFacePtrList::iterator fl_first=obj->beginFace(), fl_last = obj->endFace();
-
-		while ( fl_first != fl_last )	{
-			if ( (*fl_first)->size() == fptr->size() ) fparray.push_back(*fl_first);
-			fl_first++;
-		}
+		obj->matchIndex().facesWithSize(fptr->size(),fparray);
 	}
 
 	void selectMatchingEdges(DLFLObjectPtr obj, DLFLEdgePtr eptr, DLFLEdgePtrArray &eparray) {
-		eparray.clear();
-		DLFLEdgePtrList::iterator el_first=obj->beginEdge(), el_last = obj->endEdge();
-		DLFLVertexPtr vp1,vp2,v2,v1;
+		DLFLVertexPtr v2,v1;
 		eptr->getVertexPointers(v2,v1);
-		while ( el_first != el_last )	{
-			(*el_first)->getVertexPointers(vp1,vp2);
-
-			if ( (vp1->numEdges() == v1->numEdges() && vp2->numEdges() == v2->numEdges()) ||
-			 		 (vp1->numEdges() == v2->numEdges() && vp2->numEdges() == v1->numEdges())   ) {
-				eparray.push_back(*el_first);
-			}
-			el_first++;
-		}
+		obj->matchIndex().edgesWithValences(v1->numEdges(),v2->numEdges(),eparray);
 	}
 
 	void selectMatchingVertices(DLFLObjectPtr obj, DLFLVertexPtr vptr, DLFLVertexPtrArray &vparray) {
-		vparray.clear();
-		DLFLVertexPtrList::iterator vl_first=obj->beginVertex(), vl_last = obj->endVertex();
-
-		while ( vl_first != vl_last )	{
-			if ( (*vl_first)->numEdges() == vptr->numEdges() ) vparray.push_back(*vl_first);
-			vl_first++;
-		}
+		obj->matchIndex().verticesWithValence(vptr->numEdges(),vparray);
 	}
 
 	void selectFacesByArea(DLFLObjectPtr obj, DLFLFacePtr fptr, DLFLFacePtrArray &fparray, float delta ){
-		fparray.clear();
-		DLFLFacePtrList::iterator fl_first=obj->beginFace(), fl_last = obj->endFace();
 		float area = fptr->getArea();
-		while ( fl_first != fl_last )	{
-			if ( (*fl_first)->getArea() <= (area+delta) && (*fl_first)->getArea() >= (area-delta) ) fparray.push_back(*fl_first);
-			fl_first++;
-		}
+		obj->matchIndex().facesWithArea(area-delta,area+delta,fparray);
 	}
 
 	void selectFacesByColor(DLFLObjectPtr obj, DLFLFacePtr fptr, DLFLFacePtrArray &fparray, float delta ){
 		//use delta later...
-		fparray.clear();
-		DLFLFacePtrList::iterator fl_first=obj->beginFace(), fl_last = obj->endFace();
-		DLFLMaterialPtr matl = fptr->material();
-		while ( fl_first != fl_last )	{
-			if ( (*fl_first)->material() == matl ) fparray.push_back(*fl_first);
-			fl_first++;
-		}
+		obj->matchIndex().facesWithMaterial(fptr->material(),fparray);
 	}
 
   void punchHoles( DLFLObjectPtr obj ) {
@@ -1117,8 +1081,10 @@ namespace DLFL {
       }
       ++fl_first;
     }
+    size_t num_holes = hole_faces.size(), count = 0;
     fl_first = hole_faces.begin(); fl_last = hole_faces.end();
     while ( fl_first != fl_last ) {
+      if ( !reportProgress(count++,num_holes) ) return;
       fp = (*fl_first); ++fl_first;
       fp->resetType();
       cmMakeHole(obj, fp,true);
@@ -1129,15 +1095,24 @@ namespace DLFL {
     // Make a wireframe from the given model.
 
     // First do a modified corner-cutting subdivision
-    modifiedCornerCuttingSubdivide(obj,crust_thickness);
+    {
+      DLFLProgressRange range(0.0,0.4);
+      modifiedCornerCuttingSubdivide(obj,crust_thickness);
+    }
+    if ( progressCancelled() ) return;
 
     // Split Valence 2 vertices if 'split' flag is true
     if ( split ) splitValence2Vertices(obj,-1.0);
 
     // Create a crust with specified thickness
-    createCrustForWireframe(obj,crust_thickness);
+    {
+      DLFLProgressRange range(0.4,0.4);
+      createCrustForWireframe(obj,crust_thickness);
+    }
+    if ( progressCancelled() ) return;
 
     // Punch holes to get the wireframe
+    DLFLProgressRange range(0.8,0.2);
     punchHoles(obj);
   }
 
@@ -1145,15 +1120,24 @@ namespace DLFL {
     // Make a wireframe from the given model.
 		// std::cout << crust_thickness << "\t" << crust_width << "\n";
     // First do a modified corner-cutting subdivision
-    modifiedCornerCuttingSubdivide(obj,crust_width);
+    {
+      DLFLProgressRange range(0.0,0.4);
+      modifiedCornerCuttingSubdivide(obj,crust_width);
+    }
+    if ( progressCancelled() ) return;
 
     // Split Valence 2 vertices if 'split' flag is true
     if ( split ) splitValence2Vertices(obj,-1.0);
 
     // Create a crust with specified thickness
-    createCrustForWireframe(obj,crust_thickness);
+    {
+      DLFLProgressRange range(0.4,0.4);
+      createCrustForWireframe(obj,crust_thickness);
+    }
+    if ( progressCancelled() ) return;
 
     // Punch holes to get the wireframe
+    DLFLProgressRange range(0.8,0.2);
     punchHoles(obj);
   }
 
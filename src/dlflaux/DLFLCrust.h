@@ -35,6 +35,15 @@ namespace DLFL {
     w.r.t centroid of object.
   */
   void createCrustWithScaling(DLFLObjectPtr obj, double scale_factor = 0.9 );
+
+  /*
+    Same as above, but the faces of the outer and the inner surface are
+    returned in the given arrays instead of the arrays for crust modeling,
+    which are left alone. Face i of the inner surface is the copy of face i
+    of the outer surface.
+  */
+  void createCrustWithScaling(DLFLObjectPtr obj, double scale_factor,
+                              DLFLFacePtrArray& outer_faces, DLFLFacePtrArray& inner_faces);
   void cmMakeHole(DLFLObjectPtr obj, DLFLFacePtr fp, bool cleanup = true );
   void createCrustForWireframe(DLFLObjectPtr obj, double thickness = 0.1 );
   void createCrustForWireframe2(DLFLObjectPtr obj, double scale_factor = 0.1 );
@@ -1,77 +1,124 @@
 /*** ***/
 
 #include "DLFLDual.h"
-#include "DLFLSubdiv.h"
 #include <DLFLCore.h>
+#include <DLFLParallel.h>
 
 namespace DLFL {
 
-  void createDual(DLFLObjectPtr obj, bool accurate) {
-    // Using "correct" methods seems to be VERY slow
-    // We will use it only if we want accurate dual
-    // Otherwise we will use old method
-    if ( accurate ) {
-      // Dual operation using face subdivision into quads,
-      // followed by deleting old edges and cleanup of winged vertices
-
-      // Keep count of old number of vertices
-      // All old edges have to be deleted. But since old edges will be subdivided
-      // we have to access the edges through the old vertices
-      int num_old_verts = obj->num_vertices();
-
-      DLFLVertexPtrList::iterator vpfirst, vplast;
-      DLFLVertexPtr vp;
-       
-
-      // Do quad subdivision of all faces
-      subdivideAllFaces(obj,true);
-
-      /*
-      cout << "Vertex 16 is of degree " << 
-        obj->getVertexPtrID(16)->valence() << endl;
-      DLFLFaceVertexPtrList fvpList = obj->getVertexPtrID(16)->getFaceVertexList();
-      for (DLFLFaceVertexPtrList::iterator it = fvpList.begin();
-          it != fvpList.end(); ++it){
-        cout << (*it)->next()->getVertexPtr()->getID() << ",";
-      }
-      cout << endl;
-      for (DLFLFaceVertexPtrList::iterator it = fvpList.begin();
-          it != fvpList.end(); ++it){
-        (*it)->getFacePtr()->boundaryWalk();
-      }
-      return;
-      */
-
-      // Go through all the old vertices and delete all edges connected to them
-      int vcount = 0;
-      DLFLEdgePtrArray eparray;
-      vpfirst = obj->beginVertex(); vplast = obj->endVertex();
-      // deleteEdge may remove vertices.
-      DLFLEdgePtrArray to_be_removed;
-      while( vcount < num_old_verts ) {
-        vp = (*vpfirst); ++vpfirst; ++vcount;
-        vp->getEdges(eparray);
-        for (int i=0; i < eparray.size(); ++i)
-          to_be_removed.push_back(eparray[i]);
-          //deleteEdge(obj,eparray[i],true);
+  static void createDualDirect(DLFLObjectPtr obj) {
+    // Every face gives a vertex at its centroid, every vertex gives a face
+    // with one corner for each of its corners and every edge gives the edge
+    // crossing it. The dual elements are built from the old ones in one pass
+    // and the old elements are removed at the end.
+    DLFLFacePtrArray faces; obj->getFaces(faces);
+    DLFLVertexPtrArray verts; obj->getVertices(verts);
+    DLFLEdgePtrArray edges; obj->getEdges(edges);
+    int num_faces = faces.size(), num_verts = verts.size(), num_edges = edges.size();
+
+    // Number the corners face by face. A dual corner has the index of its corner,
+    // cornerface gives the face (and so the dual vertex) of each corner
+    IntArray cornerface;
+    DLFLFaceVertexPtr head, current;
+    for (int i=0; i < num_faces; ++i) {
+      head = current = faces[i]->front();
+      if ( head == NULL ) continue;
+      do {
+        current->setIndex(cornerface.size());
+        cornerface.push_back(i);
+        current = current->next();
+      } while ( current != head );
+    }
+    int num_corners = cornerface.size();
+
+    // The centroids give the coordinates of the dual vertices and the
+    // attributes of the dual corners
+    Vector3dArray cens(num_faces), normals(num_faces);
+    Vector2dArray texcoords(num_faces);
+    vector<RGBColor> colors(num_faces);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_faces; ++i)
+      faces[i]->getCentroids(cens[i],texcoords[i],colors[i],normals[i]);
+
+    // The corners of the dual face of each vertex. They go opposite to the
+    // rotation order around the vertex, like the faces around a vertex do
+    IntArray firstcorner(num_verts+1,0), numcorners(num_verts,0);
+    for (int i=0; i < num_verts; ++i)
+      firstcorner[i+1] = firstcorner[i] + verts[i]->valence();
+    IntArray dualcorners(firstcorner[num_verts]);
+#pragma omp parallel
+    {
+      DLFLFaceVertexPtrArray fvparray;
+#pragma omp for schedule(static)
+      for (int i=0; i < num_verts; ++i) {
+        if ( verts[i]->valence() == 0 ) continue;
+        verts[i]->getOrderedFaceVertices(fvparray);
+        int n = std::min((int)fvparray.size(),firstcorner[i+1]-firstcorner[i]);
+        for (int j=0; j < n; ++j)
+          dualcorners[firstcorner[i]+j] = fvparray[(n-j)%n]->getIndex();
+        numcorners[i] = n;
       }
+    }
+
+    // Create the dual elements
+    DLFLVertexPtrArray newverts(num_faces);
+    for (int i=0; i < num_faces; ++i)
+      newverts[i] = new DLFLVertex(cens[i]);
+
+    DLFLFaceVertexPtrArray newcorners(num_corners);
+    for (int i=0; i < num_corners; ++i) {
+      int f = cornerface[i];
+      newcorners[i] = new DLFLFaceVertex;
+      newcorners[i]->setVertexPtr(newverts[f]);
+      newcorners[i]->normal = normals[f];
+      newcorners[i]->texcoord = texcoords[f];
+      newcorners[i]->color = colors[f];
+    }
 
-      for (DLFLEdgePtrArray::iterator it = to_be_removed.begin();
-          it != to_be_removed.end(); ++it) {
-          deleteEdge(obj, *it, true);
+    // A dual face takes the material of the face of its first corner
+    DLFLFacePtrArray newfaces(num_verts,NULL);
+    for (int i=0; i < num_verts; ++i) {
+      if ( numcorners[i] == 0 ) continue;
+      newfaces[i] = new DLFLFace(faces[cornerface[dualcorners[firstcorner[i]]]]->material());
+      for (int j=0; j < numcorners[i]; ++j)
+        newfaces[i]->addVertexPtr(newcorners[dualcorners[firstcorner[i]+j]]);
+      newfaces[i]->updateFacePointers();
+      newfaces[i]->addFaceVerticesToVertices();
+    }
 
+    // The dual of an edge leaves the dual vertex of each of its faces at
+    // the dual corner of the corner following the edge in that face
+    DLFLEdgePtrArray newedges(num_edges);
+    DLFLFaceVertexPtr fvp1, fvp2;
+    for (int i=0; i < num_edges; ++i) {
+      edges[i]->getFaceVertexPointers(fvp1,fvp2);
+      newedges[i] = new DLFLEdge;
+      newedges[i]->setFaceVertexPointers(newcorners[fvp1->next()->getIndex()],
+                                         newcorners[fvp2->next()->getIndex()],false);
+      newedges[i]->updateFaceVertices();
+    }
 
-          /*
-          DLFLVertexPtr vp1 = obj->getVertexPtrID(16);
-          if (vp1->getID() == 16 && vp1->valence() == 2) { 
-            cout << "16 becomes valence 2!!!" << endl;
-            break;
-          }
-          */
-      }
+    // Replace the old elements with the new ones
+    for (int i=0; i < num_faces; ++i) {
+      obj->removeFace(faces[i]); delete faces[i];
+    }
+    for (int i=0; i < num_edges; ++i) {
+      obj->removeEdge(edges[i]); delete edges[i];
+    }
+    for (int i=0; i < num_verts; ++i) {
+      obj->removeVertex(verts[i]); delete verts[i];
+    }
+    for (int i=0; i < num_faces; ++i) obj->addVertexPtr(newverts[i]);
+    for (int i=0; i < num_edges; ++i) obj->addEdgePtr(newedges[i]);
+    for (int i=0; i < num_verts; ++i)
+      if ( newfaces[i] ) obj->addFacePtr(newfaces[i]);
+  }
 
-      // Cleanup valence-2 vertices
-      cleanupWingedVertices(obj);
+  void createDual(DLFLObjectPtr obj, bool accurate) {
+    // The accurate dual is built directly from the corners of the object.
+    // Otherwise we will use old method, which goes through an OBJ stream
+    if ( accurate ) {
+      createDualDirect(obj);
     } else {
       // Go through list of faces and create centroids
       // Also make sure face ids are consecutive
@@ -3,10 +3,72 @@
 
 #include "DLFLExtrude.h"
 #include <DLFLCore.h>
+#include <DLFLParallel.h>
+#include <DLFLProgress.h>
 #include "DLFLConnect.h"
 
 namespace DLFL {
 
+	// Coordinates of the copy of a face made by duplicateFace
+	static void duplicateFaceCoords(DLFLFacePtr fptr, const Vector3d& dir, double offset, double rot, double sf,
+																	Vector3dArray& newverts) {
+		Vector3d ndir = normalized(dir);
+
+		fptr->getVertexCoords(newverts);
+
+		// Scale the new vertices about their centroid if scale factor is not 1.0 or 0.0
+		sf = Abs(sf);
+		if ( isNonZero(sf) && ( Abs(sf-1.0) > ZERO ) ) 
+			scale(newverts,sf);
+       
+		// Rotate the new vertices if rotation is not 0.0
+		if ( isNonZero(rot) ) 
+			rotate(newverts,ndir,rot*M_PI/180.0);
+       
+		// Translate the new vertices by given amount along given direction
+		if ( Abs(offset) > ZERO ) {
+			translate(newverts,ndir,offset);
+		}
+	}
+
+	// Coordinates of the end face of a Doo-Sabin extrusion
+	static void dooSabinFaceCoords(DLFLFacePtr fptr, double d, const Vector3d& dir, double twist, double sf,
+																 Vector3dArray& newverts) {
+		Vector3d ndir = normalized(dir);
+		Vector3dArray oldverts;
+
+		fptr->getVertexCoords(oldverts);
+		uint numverts = oldverts.size();           // No. of vertices in original face
+
+		// New vertices will be computed using the twist factor
+		newverts.assign(numverts,d*ndir);
+		for (int i=0; i < numverts-1; ++i) {
+			newverts[i] += (1.0-twist)*oldverts[i] + twist*oldverts[i+1];
+		}
+		newverts[numverts-1] += (1.0-twist)*oldverts[numverts-1] + twist*oldverts[0];
+
+		double coef;
+		Vector3d p;
+		for (int i=0; i < numverts; ++i) {
+			p.reset();
+			for (int j=0; j < numverts; ++j) {
+				if ( i == j ) 
+					coef = 0.25 + 5.0/(4.0*numverts);
+				else 
+					coef = ( 3.0 + 2.0*cos(2.0*(i-j)*M_PI/numverts) ) / (4.0*numverts);
+				p += coef*newverts[j];
+			}
+			oldverts[i] = p;
+		}
+
+		// Scale the new vertices about their centroid if scale factor is not 1.0 or 0.0
+		sf = Abs(sf);
+		if ( isNonZero(sf) && ( Abs(sf-1.0) > ZERO ) ) 
+			scale(oldverts,sf);
+
+		newverts.swap(oldverts);
+	}
+
 	DLFLFacePtrArray duplicateFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double offset, double rot, double sf) {
 		// Duplicate the given face, use face normal for direction of offset
 		Vector3d dir = fptr->computeNormal();
@@ -23,24 +85,8 @@ namespace DLFL {
 		DLFLFaceVertexPtr head;
 		head = fptr->front();
 		if ( head ) {
-			Vector3d ndir = normalized(dir);//p-p-0o9i
 			Vector3dArray newverts;
-
-			fptr->getVertexCoords(newverts);
-
-			// Scale the new vertices about their centroid if scale factor is not 1.0 or 0.0
-			sf = Abs(sf);
-			if ( isNonZero(sf) && ( Abs(sf-1.0) > ZERO ) ) 
-				scale(newverts,sf);
-       
-			// Rotate the new vertices if rotation is not 0.0
-			if ( isNonZero(rot) ) 
-				rotate(newverts,ndir,rot*M_PI/180.0);
-       
-			// Translate the new vertices by given amount along given direction
-			if ( Abs(offset) > ZERO ) {
-				translate(newverts,ndir,offset);
-			}
+			duplicateFaceCoords(fptr,dir,offset,rot,sf,newverts);
 
 			new_faces = obj->createFace(newverts,fptr->material());
 
@@ -292,6 +338,7 @@ namespace DLFL {
       endface = theface;
       ++scherk_collins_twist;
     }
+    return endface;
   }
 
 	DLFLFacePtr extrudeFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir, double rot, double sf) {
@@ -365,39 +412,10 @@ namespace DLFL {
 		DLFLFaceVertexPtr head;
 		head = fptr->front();
 		if ( head ) {
-			Vector3d ndir = normalized(dir);
-			Vector3dArray oldverts,newverts;
-
-			fptr->getVertexCoords(oldverts);
-			uint numverts = oldverts.size();           // No. of vertices in original face
-
-			// New vertices will be computed using the twist factor
-			newverts.resize(numverts,d*ndir);
-			for (int i=0; i < numverts-1; ++i) {
-				newverts[i] += (1.0-twist)*oldverts[i] + twist*oldverts[i+1];
-			}
-			newverts[numverts-1] += (1.0-twist)*oldverts[numverts-1] + twist*oldverts[0];
-
-			double coef;
-			Vector3d p;
-			for (int i=0; i < numverts; ++i) {
-				p.reset();
-				for (int j=0; j < numverts; ++j) {
-					if ( i == j ) 
-						coef = 0.25 + 5.0/(4.0*numverts);
-					else 
-						coef = ( 3.0 + 2.0*cos(2.0*(i-j)*M_PI/numverts) ) / (4.0*numverts);
-					p += coef*newverts[j];
-				}
-				oldverts[i] = p;
-			}
-
-			// Scale the new vertices about their centroid if scale factor is not 1.0 or 0.0
-			sf = Abs(sf);
-			if ( isNonZero(sf) && ( Abs(sf-1.0) > ZERO ) ) 
-				scale(oldverts,sf);
+			Vector3dArray newverts;
+			dooSabinFaceCoords(fptr,d,dir,twist,sf,newverts);
        
-			obj->createFace(oldverts,fptr->material());
+			obj->createFace(newverts,fptr->material());
 
 			// Get pointer to the first newly created face (second from last)
 			DLFLFacePtrList::reverse_iterator rfirst = obj->rbeginFace();
@@ -423,6 +441,58 @@ namespace DLFL {
 		return exface;
 	}
 
+	// The kinds of batched extrusion. They only differ in how the end face is
+	// computed and how it is connected to the extruded face.
+	enum BatchExtrusion { BatchCubical, BatchTriangulated, BatchDooSabin };
+
+	static DLFLFacePtrArray extrudeFacesBatch(DLFLObjectPtr obj, const DLFLFacePtrArray& faces, BatchExtrusion kind,
+																						double d, int num, double rot, double sf) {
+		// rot is the twist for Doo-Sabin extrusions
+		DLFLFacePtrArray endfaces(faces);
+		int numfaces = endfaces.size();
+		vector<Vector3dArray> newverts(numfaces);
+
+		for (int level=0; level < num; ++level) {
+			// Extruding a face only adds elements, the other faces keep their
+			// vertices, so the end faces of this level can all be computed up front
+#pragma omp parallel for schedule(static)
+			for (int i=0; i < numfaces; ++i) {
+				DLFLFacePtr fp = endfaces[i];
+				if ( fp == NULL || fp->front() == NULL ) continue;
+				Vector3d dir = fp->computeNormal();
+				normalize(dir);
+				if ( kind == BatchDooSabin ) dooSabinFaceCoords(fp,d,dir,rot,sf,newverts[i]);
+				else duplicateFaceCoords(fp,dir,d,rot,sf,newverts[i]);
+			}
+
+			for (int i=0; i < numfaces; ++i) {
+				if ( !reportProgress(level*numfaces+i,num*numfaces) ) return endfaces;
+				DLFLFacePtr fp = endfaces[i];
+				if ( fp == NULL || fp->front() == NULL ) continue;
+				DLFLFacePtrArray new_faces = obj->createFace(newverts[i],fp->material());
+
+				// The second new face is the one facing the old face
+				DLFLFaceVertexPtr fvp1, fvp2;
+				fvp1 = fp->firstVertex(); fvp2 = new_faces[1]->firstVertex();
+				if ( kind == BatchTriangulated ) dualConnectFaces(obj,fvp1,fvp2);
+				else connectFaces(obj,fvp1,fvp2);
+				endfaces[i] = new_faces[0];
+				newverts[i].clear();
+			}
+		}
+		return endfaces;
+	}
+
+	DLFLFacePtrArray extrudeFaces(DLFLObjectPtr obj, const DLFLFacePtrArray& faces, double d, int num,
+																double rot, double sf, bool triangulate_new_faces) {
+		return extrudeFacesBatch(obj,faces,(triangulate_new_faces ? BatchTriangulated : BatchCubical),d,num,rot,sf);
+	}
+
+	DLFLFacePtrArray extrudeFacesDS(DLFLObjectPtr obj, const DLFLFacePtrArray& faces, double d, int num,
+																	double twist, double sf) {
+		return extrudeFacesBatch(obj,faces,BatchDooSabin,d,num,twist,sf);
+	}
+
 	DLFLFacePtr extrudeDualFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, double rot, double sf, bool mesh) {
 		// Extrude the given face along its normal for a given distance
 		// Rotate and scale the new face w.r.t. old face by given parameters
@@ -521,6 +591,11 @@ namespace DLFL {
 
 	void stellateFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir) {
 		// Stellation is like extrusion but creates a cone instead of a cylinder
+		stellateFaceAt(obj,fptr,fptr->geomCentroid()+d*dir);
+	}
+
+	void stellateFaceAt(DLFLObjectPtr obj, DLFLFacePtr fptr, const Vector3d& tip) {
+		// Stellate the given face with the tip of the cone at the given point
 		DLFLMaterialPtr matl = fptr->material();
 		DLFLEdgePtr lastedge;
 		DLFLFacePtr fptr1;
@@ -529,7 +604,7 @@ namespace DLFL {
 		bool done;
 
 		// Create the point sphere which will be the tip of the cone
-		fvp1 = obj->createPointSphere(fptr->geomCentroid()+d*dir,matl);
+		fvp1 = obj->createPointSphere(tip,matl);
 	   
 		fvp2 = fptr->firstVertex();
 
@@ -48,6 +48,21 @@ namespace DLFL {
   DLFLFacePtr extrudeFaceDS(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir, double twist = 0.0, double sf = 1.0);
   DLFLFacePtr extrudeFaceDS(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir, int num, double twist = 0.0, double sf = 1.0);
 
+  /*
+    Batched extrusion of many faces, for example all selected faces. The
+    result is the same mesh as extruding the faces one after the other with
+    extrudeFace(obj,fptr,d,num,rot,sf) (extrudeFaceScherkCollins when
+    triangulating) or extrudeFaceDS, only the new elements are created in a
+    different order. For every level the end faces of all faces are computed
+    at once (in parallel) before any face is connected, the connections are
+    then made in one serial pass. The faces must be distinct.
+    Returns the end faces, in the order of the given faces.
+  */
+  DLFLFacePtrArray extrudeFaces(DLFLObjectPtr obj, const DLFLFacePtrArray& faces, double d, int num,
+      double rot = 0.0, double sf = 1.0, bool triangulate_new_faces = false);
+  DLFLFacePtrArray extrudeFacesDS(DLFLObjectPtr obj, const DLFLFacePtrArray& faces, double d, int num,
+      double twist = 0.0, double sf = 1.0);
+
   DLFLFacePtr extrudeDualFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, double rot=0.0, double sf=1.0, bool mesh=false);
   DLFLFacePtr extrudeDualFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, int num, double rot=0.0, double sf=1.0, bool mesh=false);
   DLFLFacePtr extrudeDualFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir, double rot=0.0, double sf=1.0, bool mesh=false);
@@ -55,6 +70,7 @@ namespace DLFL {
     
   void stellateFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d);
   void stellateFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d, const Vector3d& dir);
+  void stellateFaceAt(DLFLObjectPtr obj, DLFLFacePtr fptr, const Vector3d& tip);
 
   void doubleStellateFace(DLFLObjectPtr obj, DLFLFacePtr fptr, double d);
 
@@ -0,0 +1,348 @@
+/*** ***/
+
+#include "DLFLLimitSurface.h"
+#include <DLFLCoreExt.h>
+
+namespace DLFL {
+
+  // Uniform cubic B-spline basis functions and their derivatives
+  static void cubicBSplineBasis(double t, double b[4], double db[4]) {
+    double s = 1.0 - t, t2 = t*t, t3 = t2*t;
+    b[0] = s*s*s / 6.0;
+    b[1] = ( 3.0*t3 - 6.0*t2 + 4.0 ) / 6.0;
+    b[2] = ( -3.0*t3 + 3.0*t2 + 3.0*t + 1.0 ) / 6.0;
+    b[3] = t3 / 6.0;
+    db[0] = -s*s / 2.0;
+    db[1] = ( 3.0*t2 - 4.0*t ) / 2.0;
+    db[2] = ( -3.0*t2 + 2.0*t + 1.0 ) / 2.0;
+    db[3] = t2 / 2.0;
+  }
+
+  // Uniform quadratic B-spline basis functions and their derivatives
+  static void quadraticBSplineBasis(double t, double b[3], double db[3]) {
+    double s = 1.0 - t;
+    b[0] = s*s / 2.0;
+    b[1] = ( -2.0*t*t + 2.0*t + 1.0 ) / 2.0;
+    b[2] = t*t / 2.0;
+    db[0] = -s;
+    db[1] = 1.0 - 2.0*t;
+    db[2] = t;
+  }
+
+  // Normalize the cross product of the tangents and make it agree with the
+  // given reference normal. If the tangents are degenerate the reference
+  // normal is used instead.
+  static void orientFrame(Vector3d& t1, Vector3d& t2, Vector3d& n, const Vector3d& ref) {
+    n = t1 % t2;
+    if ( normsqr(n) < 1.0e-20 ) {
+      n = normalized(ref);
+      return;
+    }
+    normalize(n);
+    if ( n*ref < 0.0 ) {
+      n = -n; swap(t1,t2);
+    }
+  }
+
+  // Reference normal at a vertex : sum of the corner cross products
+  static Vector3d cornerNormalSum(const DLFLFaceVertexPtrArray& corners) {
+    Vector3d ref;
+    for (int j=0; j < corners.size(); ++j) {
+      Vector3d p = corners[j]->getVertexCoords();
+      ref += (corners[j]->next()->getVertexCoords() - p) % (corners[j]->prev()->getVertexCoords() - p);
+    }
+    return ref;
+  }
+
+  static Vector3d faceCentroid(DLFLFacePtr fp) {
+    return fp->geomSum() / double(fp->size());
+  }
+
+  void catmullClarkLimitFrame(DLFLVertexPtr vp, Vector3d& p,
+                              Vector3d& t1, Vector3d& t2, Vector3d& n) {
+    // Take the 1-ring through one virtual Catmull-Clark step. After that step
+    // the ring is made only of quads, so the quad mesh limit masks
+    // (Halstead et al.) can be used for meshes with arbitrary faces.
+    DLFLFaceVertexPtrArray corners;
+    vp->getOrderedCorners(corners);
+    int valence = corners.size();
+    p = vp->coords; t1.reset(); t2.reset(); n.reset();
+    if ( valence == 0 ) return;
+
+    // Corners are in vnext order, so edge j (from vp to next of corner j) is
+    // shared by face j and face j+1
+    Vector3dArray facepts(valence), edgepts(valence);
+    for (int j=0; j < valence; ++j)
+      facepts[j] = faceCentroid(corners[j]->getFacePtr());
+
+    Vector3d Q, R, V = vp->coords;
+    for (int j=0; j < valence; ++j) {
+      Vector3d e = corners[j]->next()->getVertexCoords();
+      edgepts[j] = ( V + e + facepts[j] + facepts[(j+1)%valence] ) / 4.0;
+      Q += facepts[j]; R += (V + e) / 2.0;
+    }
+    Q /= double(valence); R /= double(valence);
+    Vector3d Vnew = ( Q + 2.0*R + (valence-3.0)*V ) / double(valence);
+
+    // Limit position
+    Vector3d esum, fsum;
+    for (int j=0; j < valence; ++j) {
+      esum += edgepts[j]; fsum += facepts[j];
+    }
+    double dn = double(valence);
+    p = ( dn*dn*Vnew + 4.0*esum + fsum ) / ( dn*(dn+5.0) );
+
+    // Limit tangents. In the refined ring the diagonal between edge points
+    // j and j+1 is face point j+1.
+    Vector3d ref = cornerNormalSum(corners);
+    if ( valence >= 3 ) {
+      double An = 1.0 + cos(2.0*M_PI/dn) + cos(M_PI/dn)*sqrt( 2.0*(9.0 + cos(2.0*M_PI/dn)) );
+      for (int j=0; j < valence; ++j) {
+        double c0 = cos(2.0*M_PI*j/dn), c1 = cos(2.0*M_PI*(j+1)/dn);
+        double s0 = sin(2.0*M_PI*j/dn), s1 = sin(2.0*M_PI*(j+1)/dn);
+        const Vector3d& f = facepts[(j+1)%valence];
+        t1 += An*c0*edgepts[j] + (c0+c1)*f;
+        t2 += An*s0*edgepts[j] + (s0+s1)*f;
+      }
+    } else {
+      // Degenerate ring - use the directions to the neighbouring edge points
+      t1 = edgepts[0] - p; t2 = edgepts[valence-1] - p;
+    }
+    orientFrame(t1,t2,n,ref);
+  }
+
+  Vector3d catmullClarkLimitPoint(DLFLVertexPtr vp) {
+    Vector3d p, t1, t2, n;
+    catmullClarkLimitFrame(vp,p,t1,t2,n);
+    return p;
+  }
+
+  // Store computed limit positions and normals back into the object
+  static void setLimitPositions(DLFLObjectPtr obj, const Vector3dArray& pos,
+                                const Vector3dArray& nrm) {
+    DLFLVertexPtrList::iterator vfirst = obj->beginVertex(), vlast = obj->endVertex();
+    DLFLFaceVertexPtrArray corners;
+    int i = 0;
+    while ( vfirst != vlast ) {
+      DLFLVertexPtr vp = (*vfirst); ++vfirst;
+      vp->coords = pos[i];
+      vp->setNormal(nrm[i]);
+      vp->getFaceVertices(corners);
+      for (int j=0; j < corners.size(); ++j)
+        corners[j]->setNormal(nrm[i]);
+      ++i;
+    }
+    obj->changed();
+  }
+
+  bool hasClosedVertexRings(DLFLObjectPtr obj) {
+    DLFLVertexPtrList::iterator vfirst = obj->beginVertex(), vlast = obj->endVertex();
+    while ( vfirst != vlast ) {
+      DLFLFaceVertexPtrList corners = (*vfirst)->getFaceVertexList(); ++vfirst;
+      if ( corners.empty() ) continue;
+      DLFLFaceVertexPtr start = corners.front(), fvp = start;
+      for (size_t k=0; k < corners.size() && fvp != NULL; ++k) fvp = fvp->vnext();
+      if ( fvp != start ) return false;
+    }
+    return true;
+  }
+
+  bool projectToCatmullClarkLimit(DLFLObjectPtr obj) {
+    if ( !hasClosedVertexRings(obj) ) return false;
+    // All positions have to be computed before any vertex is moved
+    Vector3dArray pos, nrm;
+    pos.reserve(obj->num_vertices()); nrm.reserve(obj->num_vertices());
+    DLFLVertexPtrList::iterator vfirst = obj->beginVertex(), vlast = obj->endVertex();
+    Vector3d p, t1, t2, n;
+    while ( vfirst != vlast ) {
+      catmullClarkLimitFrame(*vfirst,p,t1,t2,n); ++vfirst;
+      pos.push_back(p); nrm.push_back(n);
+    }
+    setLimitPositions(obj,pos,nrm);
+    return true;
+  }
+
+  bool isRegularCatmullClarkFace(DLFLFacePtr fp) {
+    if ( fp == NULL || fp->size() != 4 ) return false;
+    DLFLFaceVertexPtr fvp = fp->front();
+    for (int k=0; k < 4; ++k) {
+      if ( fvp->getEdgePtr() == NULL || fvp->vertex->valence() != 4 ) return false;
+      // The face across the next edge and the diagonal face at this corner.
+      // The face across the previous edge is checked by the previous corner.
+      DLFLFaceVertexPtr vn = fvp->vnext();
+      if ( vn->getFacePtr()->size() != 4 ) return false;
+      if ( vn->vnext()->getFacePtr()->size() != 4 ) return false;
+      fvp = fvp->next();
+    }
+    return true;
+  }
+
+  bool getCatmullClarkPatchPoints(DLFLFacePtr fp, Vector3d (&cp)[4][4]) {
+    if ( !isRegularCatmullClarkFace(fp) ) return false;
+
+    // For corner k of the face, with a = direction to the next corner and
+    // b = direction to the previous corner, the diagonal face d (2 steps
+    // around the vertex) has d->next at -a, d->prev at -b and
+    // d->next->next at -a-b. The grid offsets of the 4 corners and their
+    // a, b directions are tabulated below.
+    static const int corner[4][2] = { {1,1}, {2,1}, {2,2}, {1,2} };
+    static const int adir[4][2] = { {1,0}, {0,1}, {-1,0}, {0,-1} };
+    static const int bdir[4][2] = { {0,1}, {-1,0}, {0,-1}, {1,0} };
+
+    DLFLFaceVertexPtr fvp = fp->front();
+    for (int k=0; k < 4; ++k) {
+      int i = corner[k][0], j = corner[k][1];
+      DLFLFaceVertexPtr d = fvp->vnext()->vnext();
+      cp[i][j] = fvp->getVertexCoords();
+      cp[i-adir[k][0]][j-adir[k][1]] = d->next()->getVertexCoords();
+      cp[i-bdir[k][0]][j-bdir[k][1]] = d->prev()->getVertexCoords();
+      cp[i-adir[k][0]-bdir[k][0]][j-adir[k][1]-bdir[k][1]] = d->next()->next()->getVertexCoords();
+      fvp = fvp->next();
+    }
+    return true;
+  }
+
+  void bsplineToBezierPatch(const Vector3d (&cp)[4][4], Vector3d (&bp)[4][4]) {
+    // Change of basis for one parameter direction
+    static const double M[4][4] = { { 1.0/6.0, 4.0/6.0, 1.0/6.0, 0.0 },
+                                    { 0.0, 4.0/6.0, 2.0/6.0, 0.0 },
+                                    { 0.0, 2.0/6.0, 4.0/6.0, 0.0 },
+                                    { 0.0, 1.0/6.0, 4.0/6.0, 1.0/6.0 } };
+    Vector3d tmp[4][4];
+    for (int i=0; i < 4; ++i)
+      for (int j=0; j < 4; ++j) {
+        tmp[i][j].reset();
+        for (int k=0; k < 4; ++k) tmp[i][j] += M[i][k]*cp[k][j];
+      }
+    for (int i=0; i < 4; ++i)
+      for (int j=0; j < 4; ++j) {
+        bp[i][j].reset();
+        for (int k=0; k < 4; ++k) bp[i][j] += M[j][k]*tmp[i][k];
+      }
+  }
+
+  bool evaluateCatmullClarkPatch(DLFLFacePtr fp, double u, double v,
+                                 Vector3d& p, Vector3d& du, Vector3d& dv,
+                                 Vector3d& n) {
+    Vector3d cp[4][4];
+    if ( !getCatmullClarkPatchPoints(fp,cp) ) return false;
+
+    double bu[4], dbu[4], bv[4], dbv[4];
+    cubicBSplineBasis(u,bu,dbu); cubicBSplineBasis(v,bv,dbv);
+    p.reset(); du.reset(); dv.reset();
+    for (int i=0; i < 4; ++i)
+      for (int j=0; j < 4; ++j) {
+        p += (bu[i]*bv[j])*cp[i][j];
+        du += (dbu[i]*bv[j])*cp[i][j];
+        dv += (bu[i]*dbv[j])*cp[i][j];
+      }
+    n = normalized(du % dv);
+    return true;
+  }
+
+  // Level 1 Doo-Sabin point for a corner, using the weights of
+  // computeDooSabinCoords
+  static Vector3d dooSabinCornerPoint(DLFLFaceVertexPtr fvp) {
+    int numpts = fvp->getFacePtr()->size();
+    Vector3d p;
+    DLFLFaceVertexPtr cur = fvp;
+    for (int k=0; k < numpts; ++k) {
+      double coef;
+      if ( k == 0 ) coef = 1.0/4.0 + 5.0/(4.0*numpts);
+      else coef = ( 3.0 + 2.0*cos(2.0*k*M_PI/numpts) ) / (4.0*numpts);
+      p += coef*cur->getVertexCoords();
+      cur = cur->next();
+    }
+    return p;
+  }
+
+  // Limit point and frame of a polygon under Doo-Sabin. The polygon is
+  // invariant under the face mask, so the limit point is its centroid and the
+  // tangent plane is spanned by its first Fourier components.
+  static void dooSabinPolygonFrame(const Vector3dArray& pts, const Vector3d& ref,
+                                   Vector3d& p, Vector3d& t1, Vector3d& t2, Vector3d& n) {
+    int numpts = pts.size();
+    p.reset(); t1.reset(); t2.reset();
+    for (int i=0; i < numpts; ++i) {
+      double theta = 2.0*M_PI*i/numpts;
+      p += pts[i];
+      t1 += cos(theta)*pts[i]; t2 += sin(theta)*pts[i];
+    }
+    if ( numpts > 0 ) {
+      p /= double(numpts);
+      t1 *= 2.0/numpts; t2 *= 2.0/numpts;
+    }
+    orientFrame(t1,t2,n,ref);
+  }
+
+  void dooSabinLimitFrame(DLFLFacePtr fp, Vector3d& p,
+                          Vector3d& t1, Vector3d& t2, Vector3d& n) {
+    Vector3dArray pts;
+    fp->getVertexCoords(pts);
+    Vector3d c, ref;
+    computeCentroidAndNormal(pts,c,ref);
+    dooSabinPolygonFrame(pts,ref,p,t1,t2,n);
+  }
+
+  void dooSabinVertexLimitFrame(DLFLVertexPtr vp, Vector3d& p,
+                                Vector3d& t1, Vector3d& t2, Vector3d& n) {
+    DLFLFaceVertexPtrArray corners;
+    vp->getOrderedCorners(corners);
+    Vector3dArray pts(corners.size());
+    for (int j=0; j < corners.size(); ++j)
+      pts[j] = dooSabinCornerPoint(corners[j]);
+    dooSabinPolygonFrame(pts,cornerNormalSum(corners),p,t1,t2,n);
+  }
+
+  bool projectToDooSabinLimit(DLFLObjectPtr obj) {
+    if ( !hasClosedVertexRings(obj) ) return false;
+    Vector3dArray pos, nrm;
+    pos.reserve(obj->num_vertices()); nrm.reserve(obj->num_vertices());
+    DLFLVertexPtrList::iterator vfirst = obj->beginVertex(), vlast = obj->endVertex();
+    Vector3d p, t1, t2, n;
+    while ( vfirst != vlast ) {
+      dooSabinVertexLimitFrame(*vfirst,p,t1,t2,n); ++vfirst;
+      pos.push_back(p); nrm.push_back(n);
+    }
+    setLimitPositions(obj,pos,nrm);
+    return true;
+  }
+
+  bool evaluateDooSabinPatch(DLFLVertexPtr vp, double u, double v,
+                             Vector3d& p, Vector3d& du, Vector3d& dv,
+                             Vector3d& n) {
+    DLFLFaceVertexPtrArray corners;
+    vp->getOrderedCorners(corners);
+    if ( corners.size() != 4 ) return false;
+    for (int k=0; k < 4; ++k)
+      if ( corners[k]->getFacePtr()->size() != 4 ) return false;
+
+    // Going around the vertex the 4 faces are in the quadrants (+a,+b),
+    // (+a,-b), (-a,-b), (-a,+b) where a and b are the next and previous
+    // directions of the first corner. The grid is set up so that index 0
+    // is on the +a (+b) side.
+    Vector3d cp[3][3];
+    cp[1][1] = vp->coords;
+    cp[0][1] = corners[0]->next()->getVertexCoords();
+    cp[0][0] = corners[0]->next()->next()->getVertexCoords();
+    cp[1][2] = corners[1]->next()->getVertexCoords();
+    cp[0][2] = corners[1]->next()->next()->getVertexCoords();
+    cp[2][1] = corners[2]->next()->getVertexCoords();
+    cp[2][2] = corners[2]->next()->next()->getVertexCoords();
+    cp[1][0] = corners[3]->next()->getVertexCoords();
+    cp[2][0] = corners[3]->next()->next()->getVertexCoords();
+
+    double bu[3], dbu[3], bv[3], dbv[3];
+    quadraticBSplineBasis(u,bu,dbu); quadraticBSplineBasis(v,bv,dbv);
+    p.reset(); du.reset(); dv.reset();
+    for (int i=0; i < 3; ++i)
+      for (int j=0; j < 3; ++j) {
+        p += (bu[i]*bv[j])*cp[i][j];
+        du += (dbu[i]*bv[j])*cp[i][j];
+        dv += (bu[i]*dbv[j])*cp[i][j];
+      }
+    n = normalized(du % dv);
+    return true;
+  }
+
+} // end namespace
@@ -0,0 +1,116 @@
+/*** ***/
+
+#ifndef _DLFLLIMITSURFACE_H_
+#define _DLFLLIMITSURFACE_H_
+
+#include <DLFLObject.h>
+
+/*
+  Exact limit surface evaluation for Catmull-Clark and Doo-Sabin.
+
+  Instead of subdividing 4-5 times to get a smooth looking surface, the
+  points, tangents and normals of the limit surface can be computed directly
+  from the control mesh using the eigen-analysis of the subdivision matrix.
+  Regular regions of the limit surface are uniform B-spline patches, which
+  can be evaluated at arbitrary parameter values.
+*/
+
+namespace DLFL {
+
+  /*
+    The limit points need the corners around every vertex to form a closed
+    ring. That isn't the case for an open mesh which was read in, whose
+    boundary has no limit points.
+  */
+  bool hasClosedVertexRings(DLFLObjectPtr obj);
+
+  //--- Catmull-Clark ---//
+
+  /*
+    Compute the limit position, the two limit tangents and the (unit) limit
+    normal at the given vertex. Works for faces of any size - the 1-ring is
+    taken through one virtual subdivision step first, so the mesh itself
+    is not modified.
+  */
+  void catmullClarkLimitFrame(DLFLVertexPtr vp, Vector3d& p,
+                              Vector3d& t1, Vector3d& t2, Vector3d& n);
+  Vector3d catmullClarkLimitPoint(DLFLVertexPtr vp);
+
+  /*
+    Move every vertex of the object to its limit position and set the vertex
+    and corner normals to the limit normals.
+    Returns false (and doesn't touch the object) if the object doesn't have
+    closed vertex rings.
+  */
+  bool projectToCatmullClarkLimit(DLFLObjectPtr obj);
+
+  /*
+    A face is regular if it is a quadrilateral, all of its vertices have
+    valence 4 and all 8 faces around it are quadrilaterals. The limit surface
+    over a regular face is a uniform bicubic B-spline patch.
+  */
+  bool isRegularCatmullClarkFace(DLFLFacePtr fp);
+
+  /*
+    Get the 4x4 B-spline control grid of a regular face. cp[i][j] is indexed
+    with i along the first edge of the face (front -> front->next) and j
+    along the last edge (front -> front->prev).
+    Returns false if the face is not regular.
+  */
+  bool getCatmullClarkPatchPoints(DLFLFacePtr fp, Vector3d (&cp)[4][4]);
+
+  /*
+    Convert a uniform bicubic B-spline control grid to the equivalent
+    bicubic Bezier control grid (for export).
+  */
+  void bsplineToBezierPatch(const Vector3d (&cp)[4][4], Vector3d (&bp)[4][4]);
+
+  /*
+    Evaluate the limit surface over a regular face at parameters (u,v) in
+    [0,1]x[0,1]. (0,0) is the first corner of the face, u runs towards the
+    next corner and v runs towards the previous corner. Returns the point,
+    the two partial derivatives and the unit normal.
+    Returns false (and doesn't touch the outputs) if the face is not regular.
+  */
+  bool evaluateCatmullClarkPatch(DLFLFacePtr fp, double u, double v,
+                                 Vector3d& p, Vector3d& du, Vector3d& dv,
+                                 Vector3d& n);
+
+  //--- Doo-Sabin ---//
+
+  /*
+    Each face of a Doo-Sabin mesh shrinks to its centroid. Compute that limit
+    point, the two limit tangents and the unit limit normal for a face.
+  */
+  void dooSabinLimitFrame(DLFLFacePtr fp, Vector3d& p,
+                          Vector3d& t1, Vector3d& t2, Vector3d& n);
+
+  /*
+    The limit point of a vertex is the limit point of the face that the
+    vertex produces in the next Doo-Sabin step.
+  */
+  void dooSabinVertexLimitFrame(DLFLVertexPtr vp, Vector3d& p,
+                                Vector3d& t1, Vector3d& t2, Vector3d& n);
+
+  /*
+    Move every vertex of the object to the limit point of its vertex-face and
+    set the vertex and corner normals to the limit normals.
+    Returns false (and doesn't touch the object) if the object doesn't have
+    closed vertex rings.
+  */
+  bool projectToDooSabinLimit(DLFLObjectPtr obj);
+
+  /*
+    The limit surface around a valence 4 vertex whose 4 faces are quads is a
+    uniform biquadratic B-spline patch with the 9 vertices of those faces as
+    control points. The patch spans the 4 face centroids. (0,0) is the
+    centroid of the face of the first corner of the vertex.
+    Returns false if the vertex is not regular.
+  */
+  bool evaluateDooSabinPatch(DLFLVertexPtr vp, double u, double v,
+                             Vector3d& p, Vector3d& du, Vector3d& dv,
+                             Vector3d& n);
+
+} // end namespace
+
+#endif // _DLFLLIMITSURFACE_H_
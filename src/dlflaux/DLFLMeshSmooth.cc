@@ -83,6 +83,7 @@ namespace DLFL {
       vertexptr->coords = new_pos;
       average-=average; 
     }
+    obj->changed();
   }
 
 } // end namespace
@@ -5,6 +5,7 @@
 
 #include <DLFLCore.h>
 #include <DLFLCoreExt.h>
+#include <DLFLProgress.h>
 #include <DLFLObject.h>
 #include "DLFLConvexHull.h"
 #include "DLFLConnect.h"
@@ -13,8 +14,40 @@
 
 namespace DLFL {
 
-	DLFLEdgePtr HalfEdgePair::last_connected1 = NULL;
-	DLFLEdgePtr HalfEdgePair::last_connected2 = NULL;
+	/*
+		Make the connections for the given half-edge pairs, closest pair first.
+		Once an edge has been connected, the other pairs which contain it are
+		skipped. The array is sorted only once and then taken from the end like
+		a priority queue - pairs which are equally close are taken in reverse
+		order. Only the edges already connected are remembered, so there is no
+		need to go through the remaining pairs after every connection.
+	*/
+	static void connectHalfEdgePairs(DLFLObjectPtr obj, HalfEdgePairArray& heparray, bool verbose) {
+		// Sort heparray according to distance. Use STL stable_sort algorithm
+		stable_sort(heparray.begin(), heparray.end(), greater_than);
+
+		if ( verbose ) {
+			cout << "Possible connections: reverse sorted" << endl;
+			for (int i=0; i < (int)heparray.size(); ++i) {
+				heparray[i].print();
+			}
+			cout << "Making Connections" << endl;
+		}
+
+		set<DLFLEdgePtr> connected;
+		for (int i=(int)heparray.size()-1; i >= 0; --i) {
+			const HalfEdgePair& hep = heparray[i];
+			if ( connected.count(hep.ep1) || connected.count(hep.ep2) ) continue;
+			if ( verbose ) hep.print();
+
+			// Make connection
+			connectEdges(obj,
+				hep.ep1,(hep.ep1)->getOtherFacePointer(hep.fp1),
+				hep.ep2,(hep.ep2)->getOtherFacePointer(hep.fp2));
+			connected.insert(hep.ep1); connected.insert(hep.ep2);
+		}
+		heparray.clear();
+	}
 
 	void tripleConnectFaces( DLFLObjectPtr obj, DLFLFacePtr fp1, DLFLFacePtr fp2, DLFLFacePtr fp3){ 
 		// Connect 3 faces. Connects closest edges between each pair of faces
@@ -142,34 +175,8 @@ namespace DLFL {
 		heparray[i].print();
 	}
 
-		// Sort heparray according to distance. Use STL stable_sort algorithm
-	stable_sort(heparray.begin(), heparray.end(), greater_than);
-
-	cout << "Possible connections: reverse sorted" << endl;
-	for (int i=0; i < (int)heparray.size(); ++i) {
-		heparray[i].print();
-	}
-
-	cout << "Making Connections" << endl;
-		// Go through heparray and start making connections. Once a connection is
-		// made, remove all other HalfEdgePairs which contain already connected edges
-		// NOTE: Traversal is from the end of the array.
-	HalfEdgePair hep;
-	while ( !heparray.empty() ) {
-		hep = heparray.back(); heparray.pop_back();
-		hep.print();
-			// Make connection
-
-		connectEdges( obj, 
-			hep.ep1, (hep.ep1)->getOtherFacePointer(hep.fp1),
-			hep.ep2, (hep.ep2)->getOtherFacePointer(hep.fp2) );
-
-			// Remove all HalfEdgePairs from heparray which contain any of the
-			// two edges in hep
-		HalfEdgePair::last_connected1 = hep.ep1;
-		HalfEdgePair::last_connected2 = hep.ep2;
-		heparray.erase(remove_if(heparray.begin(), heparray.end(), contains_connected),heparray.end());
-	}
+		// Go through heparray and start making connections.
+	connectHalfEdgePairs(obj,heparray,true);
 }
 
 void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fp) {
@@ -187,8 +194,8 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fp) {
 	}
 	cen_cen /= num_faces;
 
-	DLFLEdgePtrList cedges; // Use linked list, not array, to simplify erase operations
-	DLFLFacePtrList cfaces; // Faces for candidate edges (we need half-edges to connect)
+	DLFLEdgePtrArray cedges; // Candidate edges
+	DLFLFacePtrArray cfaces; // Faces for candidate edges (we need half-edges to connect)
 
 		//--- NOTE ---//
 		// In the list of faces, the other face for the edge is stored, instead of the
@@ -211,6 +218,14 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fp) {
 	}
 
 		// cedges now contains all the candidate edges
+		// Find the face defining the half-edge for each of them and its centroid
+	int num_cedges = cedges.size();
+	DLFLFacePtrArray cofaces(num_cedges);
+	Vector3dArray cocen(num_cedges);
+	for (int i=0; i < num_cedges; ++i) {
+		cofaces[i] = cedges[i]->getOtherFacePointer(cfaces[i]);
+		cocen[i] = cofaces[i]->geomCentroid();
+	}
 
 		/*
 	Find all possible connections among the candidate edges
@@ -219,77 +234,38 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fp) {
 		half-edges in different faces
 		*/
 
-		HalfEdgePairArray heparray;
-	DLFLEdgePtr eptr;
-	DLFLFacePtr fptr;
-	DLFLFacePtrList::iterator fpfirst;
-	DLFLEdgePtrList::iterator epfirst, eplast;
+	HalfEdgePairArray heparray;
 	double cosangle = cos(5.0*M_PI/180.0); // Tolerance for parallel planes check
 	double min_planarity = cosangle;
-	while ( !cedges.empty() ) {
-		eptr = cedges.front(); cedges.pop_front();
-		fptr = cfaces.front(); cfaces.pop_front();
-
-			// Go through remaining edges. Find edge which is closest
-			// but is not in the same face as ep
-		epfirst = cedges.begin(); eplast = cedges.end();
-		fpfirst = cfaces.begin();
-		DLFLEdgePtr temp_ep;
-		DLFLFacePtr temp_fp, ofp, temp_ofp;
-		while ( epfirst != eplast ) {
-			temp_ep = (*epfirst); temp_fp = (*fpfirst);
-			ofp = eptr->getOtherFacePointer(fptr);
-			temp_ofp = temp_ep->getOtherFacePointer(temp_fp);
-			if ( ofp != temp_ofp ) { // Different faces
-				HalfEdgePair hep(eptr,temp_ep,fptr,temp_fp);
+	for (int i=0; i < num_cedges; ++i) {
+			// Go through remaining edges
+		for (int j=i+1; j < num_cedges; ++j) {
+			if ( cofaces[i] != cofaces[j] ) { // Different faces
+				HalfEdgePair hep(cedges[i],cedges[j],cfaces[i],cfaces[j]);
 		// Check if plane formed by the two half-edges will be parallel
 		// to the plane formed by the centroid's of the two faces and
 		// the overall centroid calculated above. Also check for planarity
 		// If planarity is less than a specified value, discard the pair
-			Vector3d fpcen, temp_fpcen;
-			Vector3d n; // Normal to above mentioned plane
-			fpcen = ofp->geomCentroid(); temp_fpcen = temp_ofp->geomCentroid();
-			n = normalized( (fpcen-cen_cen)%(temp_fpcen-cen_cen) );
-
-			if ( isNonZero(normsqr(n)) &&
-				(hep.planarity > min_planarity) &&
-			(Abs(n*hep.normal) < cosangle) ) {
+				Vector3d n; // Normal to above mentioned plane
+				n = normalized( (cocen[i]-cen_cen)%(cocen[j]-cen_cen) );
+
+				if ( isNonZero(normsqr(n)) &&
+					(hep.planarity > min_planarity) &&
+					(Abs(n*hep.normal) < cosangle) ) {
 			// Add this half-edge pair to the array
-				heparray.push_back(hep);
-			} else {
-			// For debug
+					heparray.push_back(hep);
+				}
 			}
 		}
-		++epfirst; ++fpfirst;
 	}
-}
-
-		// Sort heparray according to distance. Use STL stable_sort algorithm
-stable_sort(heparray.begin(), heparray.end(), greater_than);
 
 		// Before inserting the new edges, keep count of old edges.
 		// Newly inserted edges will then be checked for redundant ones
 		// and cleaned up if necessary
 int num_old_edges = obj->num_edges();
 
-		// Go through heparray and start making connections. Once a connection is
-		// made, remove all other HalfEdgePairs which contain already connected edges
-		// NOTE: Traversal is from the end of the array.
-HalfEdgePair hep;
-while ( !heparray.empty() ) {
-	hep = heparray.back(); heparray.pop_back();
-			// Make connection
-
-	connectEdges(obj,
-		hep.ep1,(hep.ep1)->getOtherFacePointer(hep.fp1),
-		hep.ep2,(hep.ep2)->getOtherFacePointer(hep.fp2));
-
-			// Remove all HalfEdgePairs from heparray which contain any of the
-			// two edges in hep
-	HalfEdgePair::last_connected1 = hep.ep1;
-	HalfEdgePair::last_connected2 = hep.ep2;
-	heparray.erase(remove_if(heparray.begin(), heparray.end(), contains_connected),heparray.end());
-}
+		// Go through heparray and start making connections.
+connectHalfEdgePairs(obj,heparray,false);
 
 		// Go through newly inserted edges and cleanup ones which are redundant
 DLFLEdgePtrList::iterator el_first, el_last;
@@ -446,8 +422,9 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fparray, double min_f
 	}
 
 		// If convex hull of initial vertices excludes any point, we don't proceed any further
-	DLFLConvexHull convexhull;
-	if ( convexhull.createHull(chvertices) == false ) {
+		// Only the points are needed while searching, the DLFL hull is made at the end
+	IntArray chtriangles;
+	if ( quickHull(chvertices,chtriangles) != 0 ) {
 		cout << "Initial convex hull excludes atleast one vertex!" << endl;
 		cout << "Multi-connect faces aborted." << endl;
 		return;
@@ -482,7 +459,7 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fparray, double min_f
 		}
 
 			// We now have the vertices to compute the convex hull
-		ptinside = !convexhull.createHull(chvertices);
+		ptinside = ( quickHull(chvertices,chtriangles) != 0 );
 
 		efactor_diff = 0.5 * Abs(efactor-efactor_prev);
 		efactor_prev = efactor;
@@ -518,6 +495,8 @@ void multiConnectFaces(DLFLObjectPtr obj, DLFLFacePtrArray fparray, double min_f
 
 		// We have converged to the convex hull closest to the boundary convex hull
 		// given the constraints.
+	DLFLConvexHull convexhull;
+	convexhull.createHull(chvertices);
 
 		// Do edge cleanup on convex hull to remove redundant edges
 	edgeCleanup(&convexhull);
@@ -670,17 +649,15 @@ void multiConnectMidpoints( DLFLObjectPtr obj ) {
 	DLFLVertexPtrList::iterator vl_first, vl_last;
 	vl_first = obj->beginVertex(); vl_last = obj->endVertex();
 
-	DLFLFaceVertexPtrList fvplist;
-	DLFLFaceVertexPtrList::iterator fvp_first,fvp_last;
+	DLFLFaceVertexPtrArray fvparray;
 	DLFLFaceVertexPtr fvp1, fvp2;
 	DLFLMaterialPtr matl = (obj->firstFace())->material();
 	int num_verts = 0;
 	while ( vl_first != vl_last && num_verts < num_old_verts ) {
-		fvplist = (*vl_first)->getFaceVertexList(); ++vl_first; ++num_verts;  
+		(*vl_first)->getFaceVertices(fvparray); ++vl_first; ++num_verts;
 
-		fvp_first = fvplist.begin(); fvp_last = fvplist.end();
-		while ( fvp_first != fvp_last ) {
-			fvp2 = fvp1 = (*fvp_first); ++fvp_first;
+		for (int i=0; i < (int)fvparray.size(); ++i) {
+			fvp2 = fvp1 = fvparray[i];
 
 	// Insert an edge between previous and next corners
 	// Adjust for self-loops. If there is a self loop, go one more step
@@ -707,12 +684,11 @@ void multiConnectMidpoints( DLFLObjectPtr obj ) {
 	DLFLFaceVertexPtr fvp,fvplink[2]; // Corners which are to be connected for each midpoint
 	int corner_index; // Index into the above array
 	while ( vl_first != vl_last ) {
-		fvplist = (*vl_first)->getFaceVertexList(); ++vl_first;
+		(*vl_first)->getFaceVertices(fvparray); ++vl_first;
 
-		fvp_first = fvplist.begin(); fvp_last = fvplist.end();
 		corner_index = 0;
-		while ( fvp_first != fvp_last && corner_index < 2 ) {
-			fvp = (*fvp_first); ++fvp_first;
+		for (int i=0; i < (int)fvparray.size() && corner_index < 2; ++i) {
+			fvp = fvparray[i];
 
 	// Look at previous and next vertices. If both are new, then
 	// pick this one and store in array
@@ -749,11 +725,11 @@ void multiConnectCrust( DLFLObjectPtr obj, double scale_factor) {
 	else if ( scale_factor > 1.0 ) scale_factor = 1.0;
 
 		// First create scaled crust.
-	createCrustWithScaling(obj,scale_factor);
+		// crustfp1 contains old faces, crustfp2 contains new faces from inner shell
+	DLFLFacePtrArray crustfp1, crustfp2;
+	createCrustWithScaling(obj,scale_factor,crustfp1,crustfp2);
 
-		// The crust-modeling arrays would have been filled now.
 		// Go through those arrays and punch holes after doing zero-length extrusion
-		// crustfp1 contains old faces, crustfp2 contains new faces from inner shell
 	int num_holes = crustfp1.size();
 	DLFLFacePtr fp1, exfp1, fp2;
 	DLFLFaceVertexPtr fvp1, fvp2;
@@ -787,11 +763,11 @@ void modifiedMultiConnectCrust(DLFLObjectPtr obj, double scale_factor) {
 	int count = 0;
 
 		// First create scaled crust.
-	createCrustWithScaling(obj,scale_factor);
+		// crustfp1 contains old faces, crustfp2 contains new faces from inner shell
+	DLFLFacePtrArray crustfp1, crustfp2;
+	createCrustWithScaling(obj,scale_factor,crustfp1,crustfp2);
 
-		// The crust-modeling arrays would have been filled now.
 		// Do zero length extrusions of the faces in the outer shell
-		// crustfp1 contains old faces, crustfp2 contains new faces from inner shell
 		// Replace the crustfp1 array to contain the extruded end faces
 		// Don't punch holes yet
 	int num_holes = crustfp1.size();
@@ -885,15 +861,16 @@ void createSponge( DLFLObjectPtr obj, double thickness, double collapse_threshol
 	DLFLFacePtr fp, newfp1, newfp2;
 	fl_first = obj->beginFace(); fl_last = obj->endFace();
 	num_faces = 0;
+	size_t num_steps = num_old_faces+num_old_edges+num_old_verts;
 	while ( fl_first != fl_last && num_faces < num_old_faces ) {
+		if ( !reportProgress(num_faces,num_steps) ) return;
 		fp = (*fl_first); ++fl_first; ++num_faces;
 
-			// Create face for inner shell
-		duplicateFacePlanarOffset(obj,fp,-thickness,0.0,thickness,fractional_thickness);
-
-			// Get the two newly inserted faces
-		DLFLFacePtrList::reverse_iterator temp = obj->rbeginFace();
-		newfp1 = (*temp); ++temp; newfp2 = (*temp);
+			// Create face for inner shell. Get the two newly inserted faces:
+			// the one facing the old face is the last one
+		newfp2 = duplicateFacePlanarOffset(obj,fp,-thickness,0.0,thickness,fractional_thickness);
+		if ( newfp2 == NULL ) continue;
+		newfp1 = obj->lastFace();
 
 			// With respect to the outer shell, newfp1 faces inwards and newfp2 faces outwards
 			// When creating the inner shell we want to reverse the surface
@@ -945,11 +922,13 @@ void createSponge( DLFLObjectPtr obj, double thickness, double collapse_threshol
 	el_first = obj->beginEdge(); el_last = obj->endEdge();
 	if ( fractional_thickness ) {
 		while ( count < num_old_edges ) {
+			if ( !reportProgress(num_old_faces+count,num_steps) ) return;
 			ep = (*el_first); ++el_first; ++count;
 			trisectEdge(obj,ep,thickness*ep->length(),false,true);
 		}
 	} else {
 		while ( count < num_old_edges ) {
+			if ( !reportProgress(num_old_faces+count,num_steps) ) return;
 			ep = (*el_first); ++el_first; ++count;
 			trisectEdge(obj,ep,thickness,false,true);
 		}
@@ -969,6 +948,7 @@ void createSponge( DLFLObjectPtr obj, double thickness, double collapse_threshol
 	count = 0;
 	vfirst = obj->beginVertex(); vlast = obj->endVertex();
 	while ( count < num_old_verts ) {
+		if ( !reportProgress(num_old_faces+num_old_edges+count,num_steps) ) return;
 		vp = (*vfirst); ++vfirst; ++count;
 		vp->getFaceVertices(fvparray);
 		for (int i=0; i < (int)fvparray.size(); ++i) {
@@ -1098,13 +1078,4 @@ void createSponge( DLFLObjectPtr obj, double thickness, double collapse_threshol
     return false;
   }
 
-  bool contains_connected(const HalfEdgePair& hep)
-  {
-    if ( hep.ep1 == HalfEdgePair::last_connected1 ||
-         hep.ep1 == HalfEdgePair::last_connected2 ||
-         hep.ep2 == HalfEdgePair::last_connected1 ||
-         hep.ep2 == HalfEdgePair::last_connected2 ) return true;
-    return false;
-  }
-
 } // end namespace
@@ -16,9 +16,6 @@ namespace DLFL {
     // according to priority for connection.
   public :
 
-    // Pointers to edges which were most recently connected
-    static DLFLEdgePtr last_connected1, last_connected2; 
-
     DLFLEdgePtr ep1, ep2; // Edges to be connected
     DLFLFacePtr fp1, fp2; // Faces which define the half-edges to be connected
     // These faces define the half-edges that will remain valid even after
@@ -118,19 +115,6 @@ namespace DLFL {
       return false;
     }
 */
-    // Checks to see if given HalfEdgePair contains an edge which
-    // was most recently connected. Uses the stored static variables
-    // to do the comparison. Assumes variables have been set.
-    friend bool contains_connected(const HalfEdgePair& hep);
-/*
-    friend bool contains_connected(const HalfEdgePair& hep) {
-      if ( hep.ep1 == HalfEdgePair::last_connected1 ||
-	   hep.ep1 == HalfEdgePair::last_connected2 ||
-	   hep.ep2 == HalfEdgePair::last_connected1 ||
-	   hep.ep2 == HalfEdgePair::last_connected2 ) return true;
-      return false;
-    }
-*/
 
     void print(void) const {
       if ( ep1 && ep2 )
@@ -193,7 +177,6 @@ namespace DLFL {
 
   bool less_than(const HalfEdgePair& hep1, const HalfEdgePair& hep2);
   bool greater_than(const HalfEdgePair& hep1, const HalfEdgePair& hep2);
-  bool contains_connected(const HalfEdgePair& hep);
 
 } // end namespace
 
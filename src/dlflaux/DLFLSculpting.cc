@@ -1,6 +1,11 @@
 /*** ***/
 #include "DLFLSculpting.h"
 #include "DLFLConnect.h"
+#include <DLFLParallel.h>
+#include <algorithm>
+#include <set>
+#include <cfloat>
+#include <cmath>
 
 namespace DLFL {
 
@@ -13,8 +18,10 @@ namespace DLFL {
 			varray[i++] = (*first)->getCoords();
 			++first;
 		}
+		// The object is left alone if the hull couldn't be made or making it
+		// was cancelled
 		DLFLConvexHull chull;
-		chull.createHull(varray);
+		if ( !chull.createHull(varray) ) return;
 		obj->reset();
 		obj->splice(chull);
 	}
@@ -133,710 +140,450 @@ namespace DLFL {
 		fvp1 = fp1->firstVertex(); fvp2 = fp2->firstVertex();
 		connectFaces(cube,fvp1,fvp2);
 
+		CutPlaneArray planes;
 		for(int j=0;j<cverts.size();j++){
-			//printf("processing %d of %d\n",j+1,cverts.size());
-			// (j==cverts.size()) return;	
 			DLFLVertexPtr vp= cverts.at(j);
-			Vector3d normal = vp->computeNormal();
-			peelByPlane(cube,normal,vp->getCoords());		
+			planes.push_back(CutPlane(vp->computeNormal(),vp->getCoords()));
 		}
+		cutByPlanes(cube,planes,true);
 
 		return cube;
 	}
 
-	void peelByPlane( DLFLObjectPtr obj, Vector3d normal,Vector3d P0) {   
-
-		DLFLVertexPtr vp1, vp2, vnew;
-		normal = normalized(normal);
-
-		DLFLEdgePtrArray edgestodel,edges;
-		DLFLEdgePtr ep;
-		DLFLFaceVertexPtrArray corner_list, newcorners;
-
-		Vector3d p1, p2,pnew;
-		float d1, d2;
-		int c=0;
+	/*
+		Batched plane cutting.
+
+		Every plane is first resolved against the current mesh in parallel -
+		the vertices on its positive side, the edges between them which will be
+		deleted and the edges which cross the plane together with the exact
+		crossing point. Planes whose regions don't share any vertex don't
+		affect each other, so they are all applied in one serial sweep. A plane
+		which shares a vertex with an earlier plane is deferred to the next
+		round and resolved again against the updated mesh. In global mode this
+		keeps the result the same as applying the planes one after the other.
+
+		In local mode the region of a deferred plane can grow through the new
+		vertices of the planes applied before it. If it grows into a plane
+		which was applied in an earlier round the two are applied in the order
+		of the rounds instead, and a deferred plane whose seed was removed
+		continues from the new vertices of the cut which removed it.
+	*/
+
+	static inline double planeDistance(const CutPlane& plane, const Vector3d& p) {
+		return plane.normal*(p - plane.point);
+	}
 
-		edgestodel.clear(); edges.clear();
+	// Largest signed distance of a point in the box [lo,hi] from a cutting plane
+	static inline double maxPlaneDistance(const CutPlane& plane, const Vector3d& lo, const Vector3d& hi) {
+		Vector3d center = (lo + hi)*0.5, half = (hi - lo)*0.5;
+		return planeDistance(plane,center) + fabs(plane.normal[0])*half[0]
+			+ fabs(plane.normal[1])*half[1] + fabs(plane.normal[2])*half[2];
+	}
 
-		obj->getEdges(edges);
-		float EPS = 0.000001;
-
-		//check interssection of all edges w slicing plane	
-		for(int i=0; i<edges.size();i++){
-			ep = edges.at(i);	
-			ep->getVertexPointers(vp1,vp2);
-			p1 = vp1->getCoords();
-			p2 = vp2->getCoords();
-			float d1 = normal*(p1 - P0);
-			float d2 = normal*(p2 - P0);
-
-			//if both vertices of the edge are on (+) side
-			if ((d1>0)&&(d2>0))
-				edgestodel.push_back(ep);
-
-			//if one end is - one end is +
-			if ( ((d1*d2)<0) || ((d1>0)&&(d2==0)) || ((d1==0)&&(d2>0)) ){
-				vnew = subdivideEdge(obj,ep);
-				if (d1>0)
-					edgestodel.push_back(vnew->getEdgeTo(vp1));
-				else
-					edgestodel.push_back(vnew->getEdgeTo(vp2));
-
-	//make planar
-				pnew = vnew->getCoords();
-				Vector3d ne = normalized(p2-p1);
-				float t = ( normal * ( P0 - pnew) ) / (normal * ne);
-				vnew->setCoords(pnew + ne*t);		
-
-				vnew->getFaceVertices(corner_list);	
-				newcorners.push_back(corner_list.at(0));
-				newcorners.push_back(corner_list.at(1));
-			}
+	// A node of the bounding volume hierarchy over the vertices, used to find
+	// the vertices on the positive side of a plane in global mode
+	struct CutBVHNode {
+		Vector3d lo, hi;
+		int begin, end;
+		int left, right;
+	};
+
+	struct CutAxisLess {
+		const Vector3dArray& pos;
+		int axis;
+		CutAxisLess(const Vector3dArray& p, int a) : pos(p), axis(a) {}
+		bool operator () (int i, int j) const {
+			return pos[i][axis] < pos[j][axis];
 		}
-		DLFLFaceVertexPtr cp1,cp2;
-
-		for(int i =0; i<newcorners.size();i++){
-			cp1 = newcorners.at(i);
-			for(int j =0; j<newcorners.size();j++){
-				if (i==j) continue;
-				cp2 = newcorners.at(j);
-				if (cp1->getFacePtr()==cp2->getFacePtr()){
-					insertEdge(obj,cp1,cp2);
-					continue;
-				}
+	};
+
+	static int buildCutBVH(const Vector3dArray& pos, IntArray& order, int begin, int end,
+												 vector<CutBVHNode>& nodes) {
+		CutBVHNode node;
+		node.begin = begin; node.end = end;
+		node.left = node.right = -1;
+		node.lo = node.hi = pos[order[begin]];
+		for (int i=begin+1; i < end; ++i) {
+			const Vector3d& p = pos[order[i]];
+			for (int k=0; k < 3; ++k) {
+				if ( p[k] < node.lo[k] ) node.lo[k] = p[k];
+				if ( p[k] > node.hi[k] ) node.hi[k] = p[k];
 			}
 		}
-
-		for(int i=0;i<edgestodel.size();i++)
-			deleteEdge(obj,edgestodel.at(i));
-
-		edgestodel.clear();
-	}
-
-	void visitVertex(DLFLObjectPtr obj, DLFLVertexPtr vp,DLFLEdgePtr from,Vector3d normal,Vector3d P0){
-
-		if (vp->isvisited) return;
-		vp->isvisited = 1;
-		Vector3d p1 = vp->getCoords();
-		float d1 = normal*(p1 - P0);
-		//if (d1<0) return;
-		DLFLEdgePtrArray vedges;
-		if (vp){
-			vp->getEdges(vedges);
-			int size = vedges.size();
-
-		 	//check interssection of all edges w slicing plane	
-		  for(int i=0; i<size;i++){
-				DLFLEdgePtr ep = vedges.at(i);
-				if (ep==from) continue;
-				if (ep->isvisited) continue;
-				ep->isvisited = 1;
-				DLFLVertexPtr evp1,evp2,vp2;
-			 	ep->getVertexPointers(evp1,evp2);
-				vp2 = (vp==evp1)?evp2:evp1;
-				Vector3d p2 = vp2->getCoords();
-				float d2 = normal*(p2 - P0);
-
-				//if both vertices of the edge are on (+) side
-				if ((d1>0)&&(d2>0)){
-					//ep->istodel = 1;
-					edges2del[e2dsize++] = ep;
-					visitVertex(obj, vp2, ep, normal, P0);
-				}
-
-				//if (ep->istodel) continue;
-				//if one end is - one end is +
-				if ( ((d1*d2)<0) || ((d1>0)&&(d2==0)) || ((d1==0)&&(d2>0)) ){
-					int id = getCutIndex(ep);
-					DLFLVertexPtr vnew = subdivideEdge(obj, ep);
-					if (d1>0){
-						//vnew->getEdgeTo(vp)->istodel = 1;
-						edges2del[e2dsize++] = vnew->getEdgeTo(vp);
-						if (id!=-1){
-							sedges[id] = vnew->getEdgeTo(vp2);
-							sverts[id] = vnew;
-						}
-
-					}else{
-						//fillet
-						//vnew->getEdgeTo(vp2)->istodel = 1;
-						//edges2del[e2dsize++] = vnew->getEdgeTo(vp2);
-					}
-					//make planar
-					Vector3d pnew = vnew->getCoords();
-					Vector3d ne = normalized(p2-p1);
-					float t = ( normal * ( P0 - pnew) ) / (normal * ne);
-					vnew->setCoords(pnew + ne*t);
-					DLFLFaceVertexPtrArray fvlist;
-					vnew->getFaceVertices(fvlist);	
-					newcorners[ncsize++] = fvlist.at(0);
-					newcorners[ncsize++] = fvlist.at(1);
-				}
-		  }
+		int id = nodes.size();
+		nodes.push_back(node);
+		if ( end - begin > 8 ) {
+			Vector3d ext = node.hi - node.lo;
+			int axis = 0;
+			if ( ext[1] > ext[axis] ) axis = 1;
+			if ( ext[2] > ext[axis] ) axis = 2;
+			int mid = (begin + end)/2;
+			std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end,
+											 CutAxisLess(pos,axis));
+			int left = buildCutBVH(pos,order,begin,mid,nodes);
+			int right = buildCutBVH(pos,order,mid,end,nodes);
+			nodes[id].left = left; nodes[id].right = right;
 		}
+		return id;
 	}
-	
-	void localCut(DLFLObjectPtr obj, DLFLVertexPtr vp,Vector3d normal,Vector3d P0){
-
-		if(!vp) return;
-		DLFLVertexPtrArray verts;
-		DLFLEdgePtrArray edges;
-		obj->getVertices(verts);
-		obj->getEdges(edges);
 
-		for(int i=0;i<verts.size();i++)
-			verts.at(i)->isvisited=0;
-		
-		for(int i=0;i<edges.size();i++)
-			edges.at(i)->isvisited=0;
-
-		int size = obj->num_edges();
-		newcorners = new DLFLFaceVertexPtr[size];
-		edges2del  = new DLFLEdgePtr[size];
-		e2dsize=0;
-		ncsize=0;
-		visitVertex(obj, vp,0,normal,P0);
-
-	//connect new corners
-		DLFLFaceVertexPtr cp1,cp2;
-		for(int i =0; i<ncsize;i++){
-			cp1 = newcorners[i];
-			for(int j =0; j<ncsize;j++){
-				if (i==j) continue;
-				cp2 = newcorners[j];
-				if ( cp1->getFacePtr() == cp2->getFacePtr() ){
-					insertEdge(obj, cp1,cp2);
-					continue;
-				}
+	// Indices of all vertices with a positive distance from the plane
+	static void positiveVertices(const vector<CutBVHNode>& nodes, const Vector3dArray& pos,
+															 const IntArray& order, const CutPlane& plane, IntArray& result) {
+		if ( nodes.empty() ) return;
+		IntArray stack;
+		stack.push_back(0);
+		while ( !stack.empty() ) {
+			const CutBVHNode& node = nodes[stack.back()];
+			stack.pop_back();
+			if ( maxPlaneDistance(plane,node.lo,node.hi) <= 0.0 ) continue;
+			if ( node.left < 0 ) {
+				for (int i=node.begin; i < node.end; ++i)
+					if ( planeDistance(plane,pos[order[i]]) > 0.0 ) result.push_back(order[i]);
+			} else {
+				stack.push_back(node.left);
+				stack.push_back(node.right);
 			}
 		}
+	}
 
-	//delete edges
-		for(int i=0;i<e2dsize;i++){
-			// printf("edge %d: %x\n",i,edges2del[i]);
-			edges2del[i]->isdummy=0;
+	// The changes a single plane makes to the mesh
+	struct PlaneCut {
+		DLFLVertexPtrArray inside;    // Vertices on the positive side, removed by the cut
+		DLFLVertexPtrArray touched;   // inside vertices and the far ends of the crossing edges
+		DLFLEdgePtrArray deledges;    // Edges with both ends inside
+		DLFLEdgePtrArray cutedges;    // Edges crossing the plane
+		Vector3dArray cutpoints;      // Crossing points
+		DLFLVertexPtrArray cutends;   // Inside end of each crossing edge
+		DLFLVertexPtrArray newverts;  // Vertices created on the crossing edges
+	};
+
+	// Local mode - collect the vertices on the positive side which are connected
+	// to the seed through edges with both ends on the positive side
+	static void connectedPositiveVertices(const CutPlane& plane, DLFLVertexPtrArray& inside) {
+		if ( plane.seed == NULL || planeDistance(plane,plane.seed->getCoords()) <= 0.0 ) return;
+		set<DLFLVertexPtr> visited;
+		visited.insert(plane.seed);
+		inside.push_back(plane.seed);
+		for (int i=0; i < (int)inside.size(); ++i) {
+			DLFLEdgePtrArray vedges;
+			inside[i]->getEdges(vedges);
+			for (int j=0; j < (int)vedges.size(); ++j) {
+				DLFLVertexPtr vp = vedges[j]->getOtherVertexPointer(inside[i]);
+				if ( visited.find(vp) != visited.end() ) continue;
+				if ( planeDistance(plane,vp->getCoords()) <= 0.0 ) continue;
+				visited.insert(vp);
+				inside.push_back(vp);
+			}
 		}
+	}
 
-		for(int i=0;i<e2dsize;i++){
-			DLFLEdgePtr ep = edges2del[i];
-
-			for(int j=i+1;j<e2dsize;j++){
-				if (ep==edges2del[j]) {
-					// printf("ayni egde %d = %d = %x\n",i,j,ep);
-					ep->isdummy=1;
+	// Find the edges to be deleted and the edges crossing the plane
+	static void resolvePlaneCut(const CutPlane& plane, PlaneCut& cut) {
+		cut.touched = cut.inside;
+		for (int i=0; i < (int)cut.inside.size(); ++i) {
+			DLFLVertexPtr vp = cut.inside[i];
+			Vector3d p = vp->getCoords();
+			double d = planeDistance(plane,p);
+			DLFLEdgePtrArray vedges;
+			vp->getEdges(vedges);
+			for (int j=0; j < (int)vedges.size(); ++j) {
+				DLFLEdgePtr ep = vedges[j];
+				DLFLVertexPtr op = ep->getOtherVertexPointer(vp);
+				Vector3d q = op->getCoords();
+				double dq = planeDistance(plane,q);
+				if ( dq > 0.0 ) {
+					// Both ends are inside, add the edge only once
+					if ( vp < op ) cut.deledges.push_back(ep);
+				} else {
+					cut.cutedges.push_back(ep);
+					cut.cutpoints.push_back(p + (q-p)*(d/(d-dq)));
+					cut.cutends.push_back(vp);
+					cut.touched.push_back(op);
 				}
 			}
 		}
 
-		for(int i=0;i<e2dsize;i++){
-			deleteEdge(obj, edges2del[i]);
-		}
-
 	}
-	// void localCut( DLFLObjectPtr obj, DLFLVertexPtr vp,Vector3d normal,Vector3d P0 ){
-	// 
-	// 	DLFLVertexPtrArray verts;
-	// 	
-	// 	// for(int i=0;i<verts.size();i++)
-	// 	// 	verts.at(i)->isvisited=0;
-	// 	
-	// 	int size = obj->num_edges();
-	//  		newcorners = new DLFLFaceVertexPtr[size];
-	// 	edges2del  = new DLFLEdgePtr[size];
-	// 	e2dsize=0;
-	// 	ncsize=0;
-	// 	obj->visitVertex(vp,0,normal,P0);
-	// 	
-	// 	//connect new corners
-	// 	DLFLFaceVertexPtr cp1,cp2;
-	// 	for(int i =0; i<ncsize;i++){
-	// 		cp1 = newcorners[i];
-	// 		for(int j =0; j<ncsize;j++){
-	// 			if (i==j) continue;
-	// 			cp2 = newcorners[j];
-	// 			if ( cp1->getFacePtr() == cp2->getFacePtr() ){
-	// 				insertEdge(cp1,cp2);
-	// 				continue;
-	// 			}
-	// 		}
-	// 	}
-	// 	
-	// 	//delete edges
-	// 	for(int i=0;i<e2dsize;i++)
-	// 		deleteEdge(edges2del[i]);
-	// 	
-	// 
-	// }
-
-	void performCutting( DLFLObjectPtr obj, int type,float offsetE,float offsetV,bool global,bool selected) {
-
-		// if (type==204){
-		// 	// truncateEdges(offsetE);
-		// 	return;
-		// }
-		// global = false;
-
-		DLFLEdgePtrArray edges;
-		DLFLVertexPtrArray verts;
-		DLFLFacePtrArray faces;
 
-		cutcount = 0;
-		int vcount = 0;
-		int num=0;
-
-		Vector3d * locs, * norms;
-		obj->getEdges(edges);
-		obj->getVertices(verts);
-		obj->getFaces(faces);
-		int esize 	= edges.size();
-		int vsize		= verts.size();
-		int fsize 	= faces.size();
-		int totalsize 	= esize+vsize+fsize;
-		locs   		= new Vector3d[totalsize];
-		norms  		= new Vector3d[totalsize];
-		sverts 		= new DLFLVertexPtr[totalsize];
-		sedges 		= new DLFLEdgePtr[esize];
-
-		//this loops through all edges??? why?
-		for(int i=0;i<esize;i++){
-			sverts[cutcount]=0;
-
-			DLFLEdgePtr e = edges.at(i);
-			if ( ((selected)&&(!e->ismarked)) || (type==201) ) continue;
-
-			DLFLVertexPtr v1,v2,v;
-			e->getVertexPointers(v1,v2);
-
-			int vnum=0;
-			Vector3d * vlocs = new Vector3d[v1->valence() + v2->valence()];
-
-			for(int j=0;j<2;j++){
-				v =(j)?v2:v1;
-				DLFLEdgePtrArray vedges;
-				v->getEdges(vedges);
-				for(int k=0;k<vedges.size();k++){
-					DLFLEdgePtr ve = vedges.at(k);
-					if (ve==e) continue;
-					DLFLVertexPtr ev1,ev2;
-					ve->getVertexPointers(ev1,ev2);
-					if (ev2==v){
-						ev2 = ev1;
-						ev1 = v;  
-					}
-					vlocs[vnum++] = (ev2->getCoords() - ev1->getCoords())*offsetE + ev1->getCoords();
-				}
-			}
+	// Split the crossing edges, connect the new corners across each face
+	// and delete the part on the positive side
+	static void applyPlaneCut(DLFLObjectPtr obj, PlaneCut& cut) {
+		DLFLFaceVertexPtrArray newcorners;
+		DLFLEdgePtrArray edgestodel = cut.deledges;
+		for (int i=0; i < (int)cut.cutedges.size(); ++i) {
+			DLFLVertexPtr vnew = subdivideEdge(obj,cut.cutedges[i]);
+			vnew->setCoords(cut.cutpoints[i]);
+			edgestodel.push_back(vnew->getEdgeTo(cut.cutends[i]));
+			cut.newverts.push_back(vnew);
+
+			DLFLFaceVertexPtrArray fvlist;
+			vnew->getFaceVertices(fvlist);
+			newcorners.push_back(fvlist[0]);
+			newcorners.push_back(fvlist[1]);
+		}
 
-			//calculate the normal and position 
-			Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-			for(int j=0;j<vnum;j++)
-				mid = mid + vlocs[j];
-			mid = mid / ((float)vnum);
-
-			for(int j=0;j<vnum;j++){
-				vec = (mid - vlocs[j]);
-				if (j==0){
-					vecp = vec;
-					continue;
-				}
-				n = n + vecp % vec;
+		for (int i=0; i < (int)newcorners.size(); ++i) {
+			DLFLFaceVertexPtr cp1 = newcorners[i];
+			for (int j=0; j < (int)newcorners.size(); ++j) {
+				if ( i == j ) continue;
+				DLFLFaceVertexPtr cp2 = newcorners[j];
+				if ( cp1->getFacePtr() == cp2->getFacePtr() )
+					insertEdge(obj,cp1,cp2);
 			}
-
-			DLFLFacePtr f1,f2;
-			e->getFacePointers(f1,f2);
-			norms[cutcount] = normalized(f1->computeNormal()+f2->computeNormal());
-			locs[cutcount] = mid;
-			sverts[cutcount] = v1;
-			sedges[cutcount] = e;
-			cutcount++;
 		}
 
-		//loop through all vertices
-		for(int i = 0; i<vsize;i++){
-			sverts[cutcount]=0;
-
-			DLFLVertexPtr vp = verts.at(i);
-			if ( ((selected)&&(!vp->ismarked))||(type==200) ) continue;
-
-			DLFLEdgePtrArray vedges;
-			vp->getEdges(vedges);
-
-			int vnum=0;
-			Vector3d * vlocs = new Vector3d[vp->valence()];
-
-			for(int k=0;k<vedges.size();k++){
+		for (int i=0; i < (int)edgestodel.size(); ++i)
+			deleteEdge(obj,edgestodel[i]);
+	}
 
-				DLFLEdgePtr ve = vedges.at(k);
-				DLFLVertexPtr ev1,ev2;
-				ve->getVertexPointers(ev1,ev2);
-				if (ev2==vp){
-					ev2 = ev1;
-					ev1 = vp;  
+	void cutByPlanes( DLFLObjectPtr obj, const CutPlaneArray& planes, bool global ) {
+		CutPlaneArray remaining = planes;
+		for (int i=0; i < (int)remaining.size(); ++i)
+			remaining[i].normal = normalized(remaining[i].normal);
+		vector<PlaneCut> cuts(remaining.size());
+		vector<bool> resolved(remaining.size(),false);
+
+		while ( !remaining.empty() ) {
+			int num = remaining.size();
+			IntArray toresolve;
+			for (int i=0; i < num; ++i)
+				if ( !resolved[i] ) toresolve.push_back(i);
+
+			// Global mode looks up the positive side of each plane in a
+			// hierarchy built over all vertices
+			DLFLVertexPtrArray verts;
+			Vector3dArray pos;
+			IntArray order;
+			vector<CutBVHNode> nodes;
+			if ( global && !toresolve.empty() ) {
+				obj->getVertices(verts);
+				pos.resize(verts.size()); order.resize(verts.size());
+				for (int i=0; i < (int)verts.size(); ++i) {
+					pos[i] = verts[i]->getCoords();
+					order[i] = i;
 				}
-				vlocs[vnum++] = (ev2->getCoords() - ev1->getCoords())*offsetV + ev1->getCoords();
+				if ( !verts.empty() ) buildCutBVH(pos,order,0,verts.size(),nodes);
 			}
 
-			//calculate the normal and position for bevelling
-			Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-			for(int j=0;j<vnum;j++)
-				mid = mid + vlocs[j];
-			mid = mid / ((float)vnum);
-
-			norms[cutcount] = vp->computeNormal();
-			locs[cutcount] = mid;
-			sverts[cutcount] = vp;
-			cutcount++;
-		}
-
-		//cut by face mode
-		if (type==203) {
-			//loop through all faces
-			for(int i = 0; i<fsize;i++){
-				sverts[cutcount]=0;
-
-				DLFLFacePtr fp = faces.at(i);
-				if ( ((selected)&&(!fp->ismarked))) continue;
-
-				DLFLVertexPtrArray fverts;
-				DLFLFaceVertexPtrArray fcorners;
-				DLFLVertexPtr v;
-				int vnum=0;
-				fp->getCorners(fcorners);
-
-				for(int j=0;j<fcorners.size();j++){
-					DLFLFaceVertexPtr fv = fcorners.at(j);
-					fverts.push_back(fv->getVertexPtr());
+#pragma omp parallel for schedule(static)
+			for (int k=0; k < (int)toresolve.size(); ++k) {
+				int i = toresolve[k];
+				cuts[i] = PlaneCut();
+				if ( global ) {
+					IntArray vindex;
+					positiveVertices(nodes,pos,order,remaining[i],vindex);
+					std::sort(vindex.begin(),vindex.end());
+					for (int j=0; j < (int)vindex.size(); ++j)
+						cuts[i].inside.push_back(verts[vindex[j]]);
+				} else {
+					connectedPositiveVertices(remaining[i],cuts[i].inside);
 				}
+				resolvePlaneCut(remaining[i],cuts[i]);
+			}
 
-				Vector3d * vlocs = new Vector3d[fverts.size()*10];
-
-				for(int j=0;j<fverts.size();j++){
-					v = fverts.at(j);
-					DLFLEdgePtrArray vedges;
-					v->getEdges(vedges);
-
-					for(int k=0;k<vedges.size();k++){
-						DLFLEdgePtr ve = vedges.at(k);
-						DLFLFacePtr ef1,ef2;
-						ve->getFacePointers(ef1,ef2);
-						if ((ef1==fp )||(ef2==fp)) continue;
-						DLFLVertexPtr ev1,ev2;
-						ve->getVertexPointers(ev1,ev2);
-						if (ev2==v){
-							ev2 = ev1;
-							ev1 = v;  
-						}
-						vlocs[vnum++] = (ev2->getCoords() - ev1->getCoords())*offsetV + ev1->getCoords();
-					}
-				}
-
-
-			//calculate the normal and position for beveling
-				Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-				for(int j=0;j<vnum;j++)
-					mid = mid + vlocs[j];
-				mid = mid / ((float)vnum);
-
-				norms[cutcount] = fp->computeNormal();
-				locs[cutcount] = mid;
-				float dmax = -999;
-				DLFLVertexPtr vp,svp;
-				for(int j=0;j<fverts.size();j++){
-					DLFLVertexPtr vp = fverts.at(j);
-					float d = norms[cutcount]*(vp->getCoords() - mid);
-				// printf("d:%f\n",d);
-					if (d>dmax){
-						dmax = d;
-						svp = vp;
-					}
+			// Each touched vertex is stamped with the first plane touching it.
+			// A plane which finds a stamp from an earlier plane has to wait.
+			for (int i=0; i < num; ++i)
+				for (int j=0; j < (int)cuts[i].touched.size(); ++j)
+					cuts[i].touched[j]->isvisited = 0;
+
+			vector<bool> accepted(num,true);
+			for (int i=0; i < num; ++i) {
+				const DLFLVertexPtrArray& touched = cuts[i].touched;
+				for (int j=0; j < (int)touched.size(); ++j) {
+					if ( touched[j]->isvisited == 0 ) touched[j]->isvisited = i+1;
+					else if ( touched[j]->isvisited != (uint)(i+1) ) accepted[i] = false;
 				}
-				sverts[cutcount] = svp;
-				cutcount++;
 			}
-			}//end if type == 203
 
-			for(int i = 0; i<cutcount;i++){
-				if (global)
-					peelByPlane(obj,norms[i],locs[i]);	
-				else	localCut(obj, sverts[i],norms[i],locs[i]);
+			// A waiting plane only has to be resolved again if it shares a
+			// vertex with a plane applied in this round. A waiting local cut
+			// whose seed is removed continues from the new vertices of the
+			// cut which removed it.
+			IntArray seedowner(num,-1);
+			for (int i=0; i < num; ++i) {
+				if ( accepted[i] ) continue;
+				const DLFLVertexPtrArray& touched = cuts[i].touched;
+				for (int j=0; resolved[i] && j < (int)touched.size(); ++j)
+					if ( accepted[touched[j]->isvisited-1] ) resolved[i] = false;
+				if ( remaining[i].seed == NULL ) continue;
+				int owner = remaining[i].seed->isvisited - 1;
+				if ( owner >= 0 && accepted[owner] &&
+						 planeDistance(remaining[owner],remaining[i].seed->getCoords()) > 0.0 )
+					seedowner[i] = owner;
 			}
 
-			delete [] norms;
-			delete [] locs;
-			delete [] sverts;
-			delete [] sedges;
-	}//end performCutting Function
-
-	void cutSelectedFaces( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
-
-				// bool global = false;
-
-				vector<DLFLVertexPtr>::iterator vit;
-				vector<DLFLEdgePtr>::iterator eit,eit2;
-				vector<DLFLFacePtr>::iterator fit,fit2;
-				DLFLFacePtrArray sfptrarr = obj->sel_fptr_array;
-
-				DLFLEdgePtrArray edges;
-				DLFLVertexPtrArray verts;
-				DLFLFacePtrArray faces;
-
-				cutcount = 0;
-				int vcount = 0;
-				int num=0;
-
-				Vector3d * locs, * norms;
-				obj->getEdges(edges);
-				obj->getVertices(verts);
-				obj->getFaces(faces);
-				int esize 	= edges.size();
-				int vsize		= verts.size();
-				int fsize 	= faces.size();
-				int totalsize 	= esize+vsize+fsize;
-				locs   		= new Vector3d[totalsize];
-				norms  		= new Vector3d[totalsize];
-				sverts 		= new DLFLVertexPtr[totalsize];
-				sedges 		= new DLFLEdgePtr[esize];
-
-
-			//loop through all faces
-				for(fit = sfptrarr.begin(); fit != sfptrarr.end(); fit++, cutcount++){
-			// std::cout << "in side selected face loop!\n";
-					sverts[cutcount]=0;
-
-					DLFLVertexPtrArray fverts;
-					DLFLFaceVertexPtrArray fcorners;
-					DLFLVertexPtr v;
-					int vnum=0;
-					(*fit)->getCorners(fcorners);
-
-					for(int j=0;j<fcorners.size();j++){
-						DLFLFaceVertexPtr fv = fcorners.at(j);
-						fverts.push_back(fv->getVertexPtr());
+			for (int i=0; i < num; ++i)
+				if ( accepted[i] ) applyPlaneCut(obj,cuts[i]);
+
+			CutPlaneArray deferred;
+			vector<PlaneCut> deferredcuts;
+			vector<bool> deferredresolved;
+			for (int i=0; i < num; ++i) {
+				if ( accepted[i] ) continue;
+				CutPlane plane = remaining[i];
+				if ( seedowner[i] >= 0 ) {
+					const DLFLVertexPtrArray& newverts = cuts[seedowner[i]].newverts;
+					double dmax = 0.0;
+					plane.seed = NULL;
+					for (int j=0; j < (int)newverts.size(); ++j) {
+						double d = planeDistance(plane,newverts[j]->getCoords());
+						if ( d > dmax ) { dmax = d; plane.seed = newverts[j]; }
 					}
-
-					Vector3d * vlocs = new Vector3d[fverts.size()*10];
-
-					for(int j=0;j<fverts.size();j++){
-						v = fverts.at(j);
-						DLFLEdgePtrArray vedges;
-						v->getEdges(vedges);
-
-						for(int k=0;k<vedges.size();k++){
-							DLFLEdgePtr ve = vedges.at(k);
-							DLFLFacePtr ef1,ef2;
-							ve->getFacePointers(ef1,ef2);
-							if ((ef1==(*fit) )||(ef2==(*fit))) continue;
-							DLFLVertexPtr ev1,ev2;
-							ve->getVertexPointers(ev1,ev2);
-							if (ev2==v){
-								ev2 = ev1;
-								ev1 = v;  
-							}
-							vlocs[vnum++] = (ev2->getCoords() - ev1->getCoords())*offsetV + ev1->getCoords();
-						}
-					}
-
-			//calculate the normal and position for beveling
-					Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-					for(int j=0;j<vnum;j++)
-						mid = mid + vlocs[j];
-					mid = mid / ((float)vnum);
-
-					norms[cutcount] = (*fit)->computeNormal();
-					locs[cutcount] = mid;
-					float dmax = -999;
-					DLFLVertexPtr vp,svp;
-					for(int j=0;j<fverts.size();j++){
-						DLFLVertexPtr vp = fverts.at(j);
-						float d = norms[cutcount]*(vp->getCoords() - mid);
-				// printf("d:%f\n",d);
-						if (d>dmax){
-							dmax = d;
-							svp = vp;
-						}
-					}
-					sverts[cutcount] = svp;
+					if ( plane.seed == NULL ) continue;
 				}
+				deferred.push_back(plane);
+				deferredcuts.push_back(cuts[i]);
+				deferredresolved.push_back(resolved[i]);
+			}
+			remaining.swap(deferred);
+			cuts.swap(deferredcuts);
+			resolved.swap(deferredresolved);
+		}
+	}
 
-				for(int i = 0; i<cutcount;i++){
-					if (global)
-						peelByPlane(obj,norms[i],locs[i]);	
-					else	localCut(obj, sverts[i],norms[i],locs[i]);
-				}
-
-				delete [] norms;
-				delete [] locs;
-				delete [] sverts;
-				delete [] sedges;
-	}//end cutselectedFaces Function
-
-	void cutSelectedEdges( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
-
-		// bool global = false;
-		vector<DLFLVertexPtr>::iterator vit;
-		vector<DLFLEdgePtr>::iterator eit,eit2;
-		DLFLEdgePtrArray septrarr = obj->sel_eptr_array;
-
-		DLFLEdgePtrArray edges;
-		DLFLVertexPtrArray verts;
-		DLFLFacePtrArray faces;
+	void peelByPlane( DLFLObjectPtr obj, Vector3d normal,Vector3d P0) {
+		cutByPlanes(obj,CutPlaneArray(1,CutPlane(normal,P0)),true);
+	}
 
-		cutcount = 0;
-		int vcount = 0;
-		int num=0;
+	void localCut(DLFLObjectPtr obj, DLFLVertexPtr vp,Vector3d normal,Vector3d P0){
+		if(!vp) return;
+		cutByPlanes(obj,CutPlaneArray(1,CutPlane(normal,P0,vp)),false);
+	}
 
-		Vector3d * locs, * norms;
-		obj->getEdges(edges);
-		obj->getVertices(verts);
-		obj->getFaces(faces);
-		int esize 	= edges.size();
-		int vsize		= verts.size();
-		int fsize 	= faces.size();
-		int totalsize 	= esize+vsize+fsize;
-		locs   		= new Vector3d[totalsize];
-		norms  		= new Vector3d[totalsize];
-		sverts 		= new DLFLVertexPtr[totalsize];
-		sedges 		= new DLFLEdgePtr[esize];
-
-		//this loops through all edges??? why?
-		for(eit = septrarr.begin(); eit != septrarr.end(); eit++, cutcount++){
-		sverts[cutcount]=0;
-
-		DLFLVertexPtr vp1,vp2,v;
-		(*eit)->getVertexPointers(vp1,vp2);
+	// Cutting plane for an edge: through the average of the points at offset
+	// along the other edges at both ends, normal to the two adjacent faces
+	static CutPlane edgeCutPlane( DLFLEdgePtr e, float offsetE ) {
+		DLFLVertexPtr v1,v2;
+		e->getVertexPointers(v1,v2);
 
 		int vnum=0;
-		Vector3d * vlocs = new Vector3d[vp1->valence() + vp2->valence()];
-
+		Vector3d mid(0,0,0);
 		for(int j=0;j<2;j++){
-		v =(j)?vp2:vp1;
-		DLFLEdgePtrArray vedges;
-		v->getEdges(vedges);
-
-		for(eit2 = vedges.begin(); eit2 != vedges.end(); eit2++){
-			if ( (*eit2) == (*eit) ) continue;
-			DLFLVertexPtr ev1,ev2;
-			(*eit2)->getVertexPointers(ev1,ev2);
-			if (ev2==v){
-				ev2 = ev1;
-				ev1 = v;  
+			DLFLVertexPtr v =(j)?v2:v1;
+			DLFLEdgePtrArray vedges;
+			v->getEdges(vedges);
+			for(int k=0;k<(int)vedges.size();k++){
+				if (vedges[k]==e) continue;
+				DLFLVertexPtr ov = vedges[k]->getOtherVertexPointer(v);
+				mid += (ov->getCoords() - v->getCoords())*offsetE + v->getCoords();
+				vnum++;
 			}
-			vlocs[vnum++] = (ev2->getCoords() - ev1->getCoords())*offsetE + ev1->getCoords();
-		}
-		}
-
-		//calculate the normal and position 
-		Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-		for(int j=0;j<vnum;j++)
-		mid += vlocs[j];
-		mid /= ((float)vnum);
-
-		for(int j=0;j<vnum;j++){
-		vec = (mid - vlocs[j]);
-		if (j==0){
-			vecp = vec;
-			continue;
-		}
-		n = n + vecp % vec;
 		}
+		if (vnum) mid /= (double)vnum;
 
 		DLFLFacePtr f1,f2;
-		(*eit)->getFacePointers(f1,f2);
-		norms[cutcount] = normalized(f1->computeNormal()+f2->computeNormal());
-		locs[cutcount] = mid;
-		sverts[cutcount] = vp1;
-		sedges[cutcount] = (*eit);
-		// cutcount++;
-		}
+		e->getFacePointers(f1,f2);
+		return CutPlane(f1->computeNormal()+f2->computeNormal(),mid,v1);
+	}
 
+	// Cutting plane for a vertex: through the average of the points at offset
+	// along its edges, normal to the vertex
+	static CutPlane vertexCutPlane( DLFLVertexPtr vp, float offsetV ) {
+		DLFLEdgePtrArray vedges;
+		vp->getEdges(vedges);
 
-		for(int i = 0; i<cutcount;i++){
-		if (global)
-		peelByPlane(obj,norms[i],locs[i]);	
-		else	localCut(obj, sverts[i],norms[i],locs[i]);
+		Vector3d mid(0,0,0);
+		for(int k=0;k<(int)vedges.size();k++){
+			DLFLVertexPtr ov = vedges[k]->getOtherVertexPointer(vp);
+			mid += (ov->getCoords() - vp->getCoords())*offsetV + vp->getCoords();
 		}
+		if (!vedges.empty()) mid /= (double)vedges.size();
 
-		delete [] norms;
-		delete [] locs;
-		delete [] sverts;
-		delete [] sedges;
-	}//end performCutting Function
+		return CutPlane(vp->computeNormal(),mid,vp);
+	}
 
-	void cutSelectedVertices( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
+	// Cutting plane for a face: through the average of the points at offset
+	// along the edges leaving the face, normal to the face. The cut starts at
+	// the face vertex furthest on the positive side.
+	static CutPlane faceCutPlane( DLFLFacePtr fp, float offsetV ) {
+		DLFLFaceVertexPtrArray fcorners;
+		fp->getCorners(fcorners);
+
+		int vnum=0;
+		Vector3d mid(0,0,0);
+		for(int j=0;j<(int)fcorners.size();j++){
+			DLFLVertexPtr v = fcorners[j]->getVertexPtr();
+			DLFLEdgePtrArray vedges;
+			v->getEdges(vedges);
+			for(int k=0;k<(int)vedges.size();k++){
+				DLFLEdgePtr ve = vedges[k];
+				DLFLFacePtr ef1,ef2;
+				ve->getFacePointers(ef1,ef2);
+				if ((ef1==fp)||(ef2==fp)) continue;
+				DLFLVertexPtr ov = ve->getOtherVertexPointer(v);
+				mid += (ov->getCoords() - v->getCoords())*offsetV + v->getCoords();
+				vnum++;
+			}
+		}
+		if (vnum) mid /= (double)vnum;
+
+		CutPlane plane(normalized(fp->computeNormal()),mid);
+		double dmax = -DBL_MAX;
+		for(int j=0;j<(int)fcorners.size();j++){
+			DLFLVertexPtr vp = fcorners[j]->getVertexPtr();
+			double d = planeDistance(plane,vp->getCoords());
+			if (d>dmax){
+				dmax = d;
+				plane.seed = vp;
+			}
+		}
+		return plane;
+	}
 
-		// bool global = false;
-		vector<DLFLVertexPtr>::iterator vit;
-		vector<DLFLEdgePtr>::iterator eit;
-		DLFLVertexPtrArray svptrarr = obj->sel_vptr_array;
+	void performCutting( DLFLObjectPtr obj, int type,float offsetE,float offsetV,bool global,bool selected) {
 
 		DLFLEdgePtrArray edges;
 		DLFLVertexPtrArray verts;
 		DLFLFacePtrArray faces;
+		CutPlaneArray planes;
 
-		cutcount = 0;
-		int vcount = 0;
-		int num=0;
-
-		Vector3d * locs, * norms;
 		obj->getEdges(edges);
 		obj->getVertices(verts);
 		obj->getFaces(faces);
-		int esize 	= edges.size();
-		int vsize		= verts.size();
-		int fsize 	= faces.size();
-		int totalsize 	= esize+vsize+fsize;
-		locs   		= new Vector3d[totalsize];
-		norms  		= new Vector3d[totalsize];
-		sverts 		= new DLFLVertexPtr[totalsize];
-		sedges 		= new DLFLEdgePtr[esize];
-
-		//loop through all selected vertices
-		cutcount = 0;
-		for(vit = svptrarr.begin(); vit != svptrarr.end(); vit++, cutcount++){
-			sverts[cutcount]=0;
 
-			DLFLEdgePtrArray vedges;
-			(*vit)->getEdges(vedges);
-
-			int vnum=0;
-			Vector3d * vlocs = new Vector3d[(*vit)->valence()];
-
-		//loop through the edges for the current vertex
-			for(eit = vedges.begin(); eit != vedges.end(); eit++){
-		// DLFLEdgePtr ep = vedges.at(k);
-				DLFLVertexPtr vp1,vp2;
-				(*eit)->getVertexPointers(vp1,vp2);
-		//swap the vertex pointers if necessary
-				if (vp2== (*vit)){
-					vp2 = vp1;
-					vp1 = (*vit);  
-				}
-				vlocs[vnum++] = (vp2->getCoords() - vp1->getCoords())*offsetV + vp1->getCoords();
-			}
+		if (type!=201)
+			for(int i=0;i<(int)edges.size();i++)
+				if ( !selected || edges[i]->ismarked )
+					planes.push_back(edgeCutPlane(edges[i],offsetE));
 
-		//calculate the normal and position for bevelling
-			Vector3d vecp,vec,n(0,0,0),nprev,norm(0,0,0),mid(0,0,0);
-			for(int j=0;j<vnum;j++)
-				mid += vlocs[j];
-			mid /= ((float)vnum);
+		if (type!=200)
+			for(int i=0;i<(int)verts.size();i++)
+				if ( !selected || verts[i]->ismarked )
+					planes.push_back(vertexCutPlane(verts[i],offsetV));
 
-			norms[cutcount] = (*vit)->computeNormal();
-			locs[cutcount] = mid;
-			sverts[cutcount] = (*vit);
-		}
+		//cut by face mode
+		if (type==203)
+			for(int i=0;i<(int)faces.size();i++)
+				if ( !selected || faces[i]->ismarked )
+					planes.push_back(faceCutPlane(faces[i],offsetV));
 
-		for(int i = 0; i<cutcount;i++){
-			if (global)
-				peelByPlane(obj,norms[i],locs[i]);	
-			else	
-				localCut(obj, sverts[i],norms[i],locs[i]);
-		}
+		cutByPlanes(obj,planes,global);
+	}//end performCutting Function
 
-		delete [] norms;
-		delete [] locs;
-		delete [] sverts;
-		delete [] sedges;
+	void cutSelectedFaces( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
+		const DLFLFacePtrArray& sfptrarr = obj->sel_fptr_array;
+		CutPlaneArray planes;
+		for(int i=0;i<(int)sfptrarr.size();i++)
+			planes.push_back(faceCutPlane(sfptrarr[i],offsetV));
+		cutByPlanes(obj,planes,global);
+	}//end cutselectedFaces Function
+
+	void cutSelectedEdges( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
+		const DLFLEdgePtrArray& septrarr = obj->sel_eptr_array;
+		CutPlaneArray planes;
+		for(int i=0;i<(int)septrarr.size();i++)
+			planes.push_back(edgeCutPlane(septrarr[i],offsetE));
+		cutByPlanes(obj,planes,global);
+	}//end cutSelectedEdges Function
+
+	void cutSelectedVertices( DLFLObjectPtr obj, float offsetE,float offsetV, bool global,bool selected) {
+		const DLFLVertexPtrArray& svptrarr = obj->sel_vptr_array;
+		CutPlaneArray planes;
+		for(int i=0;i<(int)svptrarr.size();i++)
+			planes.push_back(vertexCutPlane(svptrarr[i],offsetV));
+		cutByPlanes(obj,planes,global);
 	}//end cutSelectedVertices Function
 
 	int isMarked(DLFLVertexPtr vp){
@@ -897,16 +644,4 @@ namespace DLFL {
 			}
 		}
 	}
-
-	int getCutIndex(DLFLVertexPtr vp){
-		for(int i=0;i<cutcount;i++)
-			if (sverts[i]==vp) return i;
-		return -1;
-	}
-
-	int getCutIndex(DLFLEdgePtr ep){
-		for(int i=0;i<cutcount;i++)
-			if (sedges[i]==ep) return i;
-		return -1;
-	}
 } // end namespace
@@ -1,5 +1,8 @@
 /*** ***/
 
+#ifndef _DLFLSCULPTING_H_
+#define _DLFLSCULPTING_H_
+
 #include <DLFLObject.h>
 #include <DLFLCore.h>
 #include <DLFLCoreExt.h>
@@ -10,22 +13,50 @@ namespace DLFL {
   static int s = 0;
   static DLFLConvexHull * convexhull = NULL;
 
-  //new changes; these needs to be declared outside the function for local-cut
-  static DLFLVertexPtr * sverts;
-  static DLFLEdgePtr * sedges;
-  static int cutcount;
-	static DLFLFaceVertexPtr * newcorners;
-	static DLFLEdgePtr * edges2del;
-	// DLFLVertexPtr * sverts;
-	// DLFLEdgePtr * sedges;
-	// int cutcount;
-	static int e2dsize, ncsize;
-	
+  /*
+    A cutting plane. The part of the mesh on the positive side of the plane
+    (the side the normal points to) is cut away. In local mode only the
+    vertices on the positive side which are connected to the seed vertex
+    through the positive side are removed; a local cut whose seed is not on
+    the positive side does nothing.
+  */
+  struct CutPlane {
+    Vector3d normal;
+    Vector3d point;
+    DLFLVertexPtr seed;
+
+    CutPlane()
+      : normal(), point(), seed(NULL)
+    {}
+
+    CutPlane(const Vector3d& n, const Vector3d& p, DLFLVertexPtr vp = NULL)
+      : normal(n), point(p), seed(vp)
+    {}
+  };
+
+  typedef vector<CutPlane> CutPlaneArray;
+
   void createConvexHull( DLFLObjectPtr obj );
 
   void createDualConvexHull( DLFLObjectPtr obj );
   DLFLObjectPtr createDualConvexHull( DLFLObjectPtr obj, const Vector3dArray &ovarray);
 
+  /*
+    Cut the object with all the planes. Planes whose cut regions don't
+    overlap are resolved in parallel and applied together, a plane which
+    overlaps an earlier one waits until that one is applied. If global is
+    true the result is the same as cutting with the planes one after the
+    other in the given order.
+    If global is false the planes cut locally around their seed vertices and
+    there is no such guarantee. A waiting plane can grow through the new
+    vertices of earlier cuts into a plane applied in an earlier round, the
+    two are then applied in the order of the rounds rather than the given
+    order. A plane whose seed was removed by an earlier cut starts from the
+    new vertex of that cut furthest on its positive side, and is dropped if
+    there is none.
+  */
+  void cutByPlanes( DLFLObjectPtr obj, const CutPlaneArray& planes, bool global );
+
   void peelByPlane( DLFLObjectPtr obj, Vector3d normal,Vector3d P0);
 	void localCut(DLFLObjectPtr obj, DLFLVertexPtr vp,Vector3d normal,Vector3d P0);
 		
@@ -36,7 +67,7 @@ namespace DLFL {
 	
 	int isMarked(DLFLVertexPtr vp);
 	void autoMarkEdges(DLFLObjectPtr obj);
-	int getCutIndex(DLFLVertexPtr vp);
-	int getCutIndex(DLFLEdgePtr ep);
 	
 } // end namespace
+
+#endif // _DLFLSCULPTING_H_
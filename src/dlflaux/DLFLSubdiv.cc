@@ -3,77 +3,103 @@
 #include "DLFLSubdiv.h"
 #include <DLFLCore.h>
 #include <DLFLCoreExt.h>
+#include <DLFLParallel.h>
+#include <DLFLProgress.h>
 #include "DLFLExtrude.h"
 #include "DLFLConnect.h"
+#include "DLFLDual.h"
 
 namespace DLFL {
 
+  // Arrays used by the subdivision schemes. subdivide() keeps one of these
+  // across levels so that they are not reallocated for every level.
+  struct SubdivScratch {
+    DLFLEdgePtrArray edges;
+    DLFLVertexPtrArray verts;
+    DLFLFacePtrArray faces;
+    Vector3dArray coords;
+    DLFLFaceVertexPtrArray fvparray;
+  };
+
+  static void loopSubdivide( DLFLObjectPtr obj, SubdivScratch& scratch );
+  static void sqrt3Subdivide( DLFLObjectPtr obj, SubdivScratch& scratch );
+
   void loopSubdivide( DLFLObjectPtr obj ) {
+    SubdivScratch scratch;
+    loopSubdivide(obj,scratch);
+  }
+
+  static void loopSubdivide( DLFLObjectPtr obj, SubdivScratch& scratch ) {
     // Perform Loop subdivision
 
+    // The geometry passes run in parallel. Each iteration only reads the old
+    // coordinates and writes to its own edge/array slot, so the result
+    // doesn't depend on the number of threads. Topology changes are serial.
+    DLFLEdgePtrArray& edges = scratch.edges;
+    DLFLVertexPtrArray& verts = scratch.verts;
+    obj->getEdges(edges);
+    obj->getVertices(verts);
+    int num_old_edges = edges.size(), num_old_verts = verts.size();
+
     // For every edge compute the new point coordinates and store in the aux coord
-    DLFLEdgePtrList::iterator efirst, elast;
-    DLFLEdgePtr ep;
-    DLFLFaceVertexPtr fvp1, fvp2, fvp1p1, fvp1n2, fvp2p1, fvp2n2;
-    Vector3d p1,p2,p1p1,p1n2,p2p1,p2n2;
-    Vector3d newpt;
-    int num_old_edges = 0;
-    efirst = obj->beginEdge(); elast = obj->endEdge();
-    while ( efirst != elast ) {
-      ep = (*efirst); ++efirst; ++num_old_edges;
-      ep->getFaceVertexPointers(fvp1,fvp2);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_old_edges; ++i) {
+      DLFLFaceVertexPtr fvp1, fvp2, fvp1p1, fvp1n2, fvp2p1, fvp2n2;
+      edges[i]->getFaceVertexPointers(fvp1,fvp2);
       fvp1p1 = fvp1->prev(); fvp1n2 = (fvp1->next())->next();
       fvp2p1 = fvp2->prev(); fvp2n2 = (fvp2->next())->next();
-      p1 = fvp1->getVertexCoords(); p2 = fvp2->getVertexCoords();
-      p1p1 = fvp1p1->getVertexCoords(); p2p1 = fvp2p1->getVertexCoords();
-      p1n2 = fvp1n2->getVertexCoords(); p2n2 = fvp2n2->getVertexCoords();
-      newpt = (p1+p2)*3.0/8.0 + (p1p1+p1n2+p2p1+p2n2)*1.0/16.0;
-      ep->setAuxCoords(newpt);
-    }
-
-    // For every vertex compute the new point coordinates and adjust the coordinate
-    DLFLVertexPtrList::iterator vfirst, vlast;
-    DLFLVertexPtr vp;
-    DLFLFaceVertexPtrArray fvparray;
-    Vector3d op, p;
-    int valence, num_old_verts=0;
-    double beta;
-    vfirst = obj->beginVertex(); vlast = obj->endVertex();
-    while ( vfirst != vlast ) {
-      vp = (*vfirst); ++vfirst; ++num_old_verts;
-      vp->getFaceVertices(fvparray);
-      valence = fvparray.size();
-      if ( valence > 0 ) {
-				p = vp->coords;
-				op.reset();
-				for (int i=0; i < valence; ++i)
-					op += (fvparray[i]->next())->getVertexCoords();
-	
-				beta = ( 0.625 - sqr( 0.375 + 0.25 * cos( 2.0*M_PI/double(valence) ) ) ) / double(valence);
-	
-				vp->coords = op * beta + (1.0 - valence*beta)*p;
+      edges[i]->setAuxCoords((fvp1->getVertexCoords()+fvp2->getVertexCoords())*3.0/8.0 +
+                             (fvp1p1->getVertexCoords()+fvp1n2->getVertexCoords()+
+                              fvp2p1->getVertexCoords()+fvp2n2->getVertexCoords())*1.0/16.0);
+    }
+
+    // For every vertex compute the new point coordinates. They are stored
+    // separately and copied afterwards so that neighbours see the old coordinates
+    Vector3dArray& newcoords = scratch.coords;
+    newcoords.resize(num_old_verts);
+#pragma omp parallel
+    {
+      DLFLFaceVertexPtrArray fvparray;
+      Vector3d op;
+      int valence;
+      double beta;
+#pragma omp for schedule(static)
+      for (int i=0; i < num_old_verts; ++i) {
+        verts[i]->getFaceVertices(fvparray);
+        valence = fvparray.size();
+        newcoords[i] = verts[i]->coords;
+        if ( valence > 0 ) {
+          op.reset();
+          for (int j=0; j < valence; ++j)
+            op += (fvparray[j]->next())->getVertexCoords();
+
+          beta = ( 0.625 - sqr( 0.375 + 0.25 * cos( 2.0*M_PI/double(valence) ) ) ) / double(valence);
+
+          newcoords[i] = op * beta + (1.0 - valence*beta)*newcoords[i];
+        }
       }
     }
+    for (int i=0; i < num_old_verts; ++i)
+      verts[i]->coords = newcoords[i];
 
     // Subdivide each old edge and set coordinate of new point to be the aux coord
-    int count=0;
-    efirst = obj->beginEdge(); elast = obj->endEdge();
-    while ( efirst != elast && count < num_old_edges ) {
-      ep = (*efirst); ++efirst; ++count;
-      newpt = ep->getAuxCoords(); ep->resetAuxCoords();
-      vp = subdivideEdge(obj,ep); vp->coords = newpt;
+    DLFLVertexPtr vp;
+    Vector3d newpt;
+    for (int i=0; i < num_old_edges; ++i) {
+      if ( !reportProgress(i,num_old_edges+num_old_verts) ) return;
+      newpt = edges[i]->getAuxCoords(); edges[i]->resetAuxCoords();
+      vp = subdivideEdge(obj,edges[i]); vp->coords = newpt;
     }
 
     // Connect newly created midpoints in each face
     // Go through all old vertices (before edge subdivision) and
     // go through all corners for each vertex and connect previous and next corners
-    vfirst = obj->beginVertex(); vlast = obj->endVertex();
-    count = 0;
-    while ( vfirst != vlast && count < num_old_verts ) {
-      vp = (*vfirst); ++vfirst; ++count;
-      vp->getFaceVertices(fvparray);
-      for (int i=0; i < fvparray.size(); ++i)
-				insertEdge(obj,fvparray[i]->prev(),fvparray[i]->next());
+    DLFLFaceVertexPtrArray& fvparray = scratch.fvparray;
+    for (int i=0; i < num_old_verts; ++i) {
+      if ( !reportProgress(num_old_edges+i,num_old_edges+num_old_verts) ) return;
+      verts[i]->getFaceVertices(fvparray);
+      for (int j=0; j < fvparray.size(); ++j)
+        insertEdge(obj,fvparray[j]->prev(),fvparray[j]->next());
     }
   }
 
@@ -580,10 +606,9 @@ namespace DLFL {
     }
   }
 
-  bool dooSabinSubdivide(DLFLObjectPtr obj,bool check/*, QProgressDialog *progress*/) {		
+  bool dooSabinSubdivide(DLFLObjectPtr obj,bool check) {		
     // Regular Doo-Sabin subdivision scheme
 
-    cout << "DooSabin:" << std::clock() / (double)CLOCKS_PER_SEC << endl;
     // Go through list of faces and create new inner faces for each face
     DLFLFacePtrList::iterator fl_first, fl_last;
     DLFLEdgePtrList::iterator el_first, el_last;
@@ -598,18 +623,14 @@ namespace DLFL {
     int num_old_faces, num_old_edges, num_old_verts;
     int num_faces, num_edges, num_verts;
     int eistart, edgeindex;
-  	// int progressvalue = 0; // progress bar test dave
+    int progressvalue = 0, num_steps;
 	
     num_old_verts = obj->num_vertices();
     num_old_faces = obj->num_faces();
     num_old_edges = obj->num_edges();
 
-		//testing qprogressbar - need to figure out a way to do this without putting qt
-		//into the dlfl libraries
-		// if (progress) {
-		// 	progress->setMaximum(num_old_faces*2+num_old_edges*2+num_old_verts);
-		// 	progress->setValue(progressvalue);
-		// }
+    // Progress is reported through DLFLProgress
+    num_steps = num_old_faces*2+num_old_edges*2+num_old_verts;
 
     // Apply make-unique on the obj->num_edges to make sure all Edge IDs are consecutive
     obj->makeEdgesUnique();
@@ -620,16 +641,9 @@ namespace DLFL {
     // Find starting edge ID to use as offset.
     eistart = (obj->firstEdge())->getID();
 
-    cout << "DooSabin:" << std::clock() / (double)CLOCKS_PER_SEC << endl;
     fl_first = obj->beginFace(); fl_last = obj->endFace(); num_faces = 0;
     while ( fl_first != fl_last && num_faces < num_old_faces ) {
-			// //update progress bar status - dave
-			// if (progress){
-			// 	progress->setValue(progressvalue++);
-			// 	// QApplication::processEvents();
-			// 	if (progress->wasCanceled())
-			// 		return false;
-			// }
+      if ( !reportProgress(progressvalue++,num_steps) ) return false;
       fp = (*fl_first);
 
       fp->getVertexCoords(vertex_coords);
@@ -686,20 +700,13 @@ namespace DLFL {
       }
       ++fl_first; ++num_faces;
     }
-    cout << "DooSabin:" << std::clock() / (double)CLOCKS_PER_SEC << endl;
 
     // Go through the face_list,obj->num_edges and vertex_list 
     // and destroy all the old faces, edges and vertices
     num_faces = 0; 
     fl_first = obj->beginFace(); fl_last = obj->endFace();
     while ( fl_first != fl_last && num_faces < num_old_faces ) {
-			//progress bar stuff - dave
-			// if (progress){
-			// 	progress->setValue(progressvalue++);
-			// 	// QApplication::processEvents();
-			// 	if (progress->wasCanceled())
-			// 		return false;
-			// }
+      if ( !reportProgress(progressvalue++,num_steps) ) return false;
       fp = (*fl_first); ++fl_first; ++num_faces;
       obj->removeFace(fp); delete fp;
     }
@@ -707,14 +714,7 @@ namespace DLFL {
     num_edges = 0; 
     el_first = obj->beginEdge(); el_last = obj->endEdge();
     while ( el_first != el_last && num_edges < num_old_edges ) {
-			//progress bar shit - dave
-			// if (progress){
-			// 	progress->setValue(progressvalue++);
-			// 	// QApplication::processEvents();
-			// 	if (progress->wasCanceled())
-			// 		return false;
-			// }
-			
+      if ( !reportProgress(progressvalue++,num_steps) ) return false;
       ep = (*el_first); ++el_first; ++num_edges;
       obj->removeEdge(ep); delete ep;
     }
@@ -722,29 +722,16 @@ namespace DLFL {
     num_verts = 0; 
     vl_first = obj->beginVertex(); vl_last = obj->endVertex();
     while ( vl_first != vl_last && num_verts < num_old_verts ) {
-			//progress bar stuff - dave
-			// if (progress){
-			// 	progress->setValue(progressvalue++);
-			// 	// QApplication::processEvents();
-			// 	if (progress->wasCanceled())
-			// 		return false;
-			// }
+      if ( !reportProgress(progressvalue++,num_steps) ) return false;
 
       vp = (*vl_first); ++vl_first; ++num_verts;
       obj->removeVertex(vp); delete vp;
     }
 
-    cout << "DooSabin:" << std::clock() / (double)CLOCKS_PER_SEC << endl;
     // Go through eplist1,fplist1 and eplist2,fplist2 and connect corresponding half-edges
     DLFLFacePtr fp1, fp2, tfp1, tfp2;
     for (int i=0; i < num_old_edges; ++i) {
-			//progress bar stuff - dave
-			// if (progress){
-			// 	progress->setValue(progressvalue++);
-			// 	// QApplication::processEvents();
-			// 	if (progress->wasCanceled())
-			// 		return false;
-			// }
+      if ( !reportProgress(progressvalue++,num_steps) ) return false;
 
       if ( eplist1[i] != NULL && eplist2[i] != NULL ) {
 				// Find the faces adjacent to the edges which are of type FTNew
@@ -764,10 +751,7 @@ namespace DLFL {
 				cout << "NULL pointers found! i = " << i << " "
 						 << eplist1[i] << " -- " << eplist2[i] << endl;
     }
-		// //progress bar stuff - dave
-		// if (progress)
-		// 	progress->setValue(num_old_faces*2+num_old_edges*2+num_old_verts);
-    cout << "DooSabin:" << std::clock() / (double)CLOCKS_PER_SEC << endl;
+    reportProgress(num_steps,num_steps);
 		return true;
   }
 
@@ -1460,7 +1444,10 @@ namespace DLFL {
     fistart = (*fl_first)->getID();
 
     num_old_faces = num_faces; num_faces = 0;
+    num_old_edges = obj->num_edges();
+    int num_steps = num_old_faces + 3*num_old_edges; // For progress reporting
     while ( fl_first != fl_last && num_faces < num_old_faces ) {
+      if ( !reportProgress(num_faces,num_steps) ) return;
       fp = (*fl_first); ++fl_first; ++num_faces;
       faceindex = fp->getID() - fistart;
       fvp = obj->createPointSphere(fp->getAuxCoords(),fp->material());
@@ -1477,7 +1464,7 @@ namespace DLFL {
     DLFLVertexPtrArray vplist;
     DLFLFaceVertexPtrArray fvparray;
     int connindex, numconn;
-    num_edges = 0; num_old_edges = obj->num_edges();
+    num_edges = 0;
     connindex = 0; numconn = 2*num_old_edges;
   
     fvplist.resize(numconn,NULL); vplist.resize(numconn,NULL);
@@ -1485,6 +1472,7 @@ namespace DLFL {
     el_first = obj->beginEdge(); el_last = obj->endEdge();
     fvparray.reserve(2);
     while ( el_first != el_last && num_edges < num_old_edges ) {
+      if ( !reportProgress(num_old_faces+num_edges,num_steps) ) return;
       ep = (*el_first); ++el_first; ++num_edges;
 
       edgept = ep->getAuxCoords(); ep->resetAuxCoords();
@@ -1508,6 +1496,7 @@ namespace DLFL {
     // Make all connections
     DLFLFaceVertexPtr fvp1, fvp2;
     for (int j=0; j < numconn; ++j) {
+      if ( !reportProgress(num_old_faces+num_old_edges+j,num_steps) ) return;
       fvp1 = fvplist[j];
        
       // Find the face-vertex referring to vp which is in the same face as fvp1
@@ -1582,26 +1571,35 @@ namespace DLFL {
 
   }
 
-  void sqrt3Subdivide( DLFLObjectPtr obj ) { // Doug
+  void sqrt3Subdivide( DLFLObjectPtr obj ) {
+    SubdivScratch scratch;
+    sqrt3Subdivide(obj,scratch);
+  }
+
+  static void sqrt3Subdivide( DLFLObjectPtr obj, SubdivScratch& scratch ) { // Doug
     // Sqrt(3) subdivision
 
     // Commonly used variables
     DLFLFacePtrList::iterator fl_first, fl_last;
     DLFLFacePtr fp;
     int num_faces, num_old_faces, num_old_edges;
-  
-    num_faces = 0;
-    num_old_faces = obj->num_faces();
+
+    DLFLFacePtrArray& faces = scratch.faces;
+    obj->getFaces(faces);
+    num_old_faces = faces.size();
     num_old_edges = obj->num_edges();
 
-    fl_first = obj->beginFace(); fl_last = obj->endFace();
+    // Compute the centroids of all the faces in parallel
+    Vector3dArray& centroids = scratch.coords;
+    centroids.resize(num_old_faces);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num_old_faces; ++i)
+      centroids[i] = faces[i]->geomCentroid();
 
     //Stellate all the faces
-    while ( num_faces < num_old_faces ) {
-      fp = (*fl_first); 
-      ++fl_first; 
-      stellateFace(obj,fp, 0.0);
-      ++num_faces;
+    for (int i=0; i < num_old_faces; ++i) {
+      if ( !reportProgress(i,3*num_old_faces) ) return;
+      stellateFaceAt(obj,faces[i],centroids[i]);
     }
   
     // Delete the old edges
@@ -1611,6 +1609,7 @@ namespace DLFL {
     int num_edges = 0; 
   
     while ( el_first != el_last && num_edges < num_old_edges ) {
+      if ( !reportProgress(num_old_edges+num_edges,3*num_old_edges) ) return;
       ep = (*el_first); ++el_first; ++num_edges;
       deleteEdge(obj,ep,true);
     }
@@ -1622,6 +1621,7 @@ namespace DLFL {
     fl_first = obj->beginFace(); fl_last = obj->endFace();
 
     while ( num_faces < num_old_faces ) {
+      if ( !reportProgress(2*num_old_faces+num_faces,3*num_old_faces) ) return;
       fp = (*fl_first);
       ++fl_first;
       ++num_faces;
@@ -2432,4 +2432,75 @@ namespace DLFL {
     triangulateFaces( obj, obj->getFaceList() );
   }
 
+  bool subdivide(DLFLObjectPtr obj, DLFLSubdivScheme scheme, int levels) {
+    // Use the same defaults as the individual functions. Schemes which
+    // don't have defaults use the defaults of the GUI.
+    double param1 = 0.0, param2 = 0.0;
+    switch ( scheme ) {
+    case STCheckerBoard : param1 = 0.33; break;
+    case STVertexCutting : param1 = 0.25; break;
+    case STPentagonal2 : param1 = 0.75; break;
+    case STDooSabin : case STDooSabinBC : param1 = 1.0; break;
+    case STDooSabinBCNew : param1 = 1.0; param2 = 1.0; break;
+    case STCornerCutting : param1 = 9.0/16.0; break;
+    case STModifiedCornerCutting : param1 = 0.25; break;
+    case STModifiedCornerCutting2 : param1 = 0.25; break;
+    case STFractal : param1 = 1.0; break;
+    case STDome : param1 = 1.0; param2 = 1.0; break;
+    case STDual1264 : param1 = 0.7; break;
+    case STLoopStyle : param1 = 1.0; break;
+    case STAllFaces : param1 = 1.0; break;
+    default : break;
+    }
+    return subdivide(obj,scheme,levels,param1,param2);
+  }
+
+  bool subdivide(DLFLObjectPtr obj, DLFLSubdivScheme scheme, int levels,
+                 double param1, double param2) {
+    // Apply all the levels back to back. Nothing outside the mesh itself
+    // (normals, patches, undo) is updated between levels.
+    SubdivScratch scratch;
+    for (int level=0; level < levels; ++level) {
+      // Each level gets an equal share of the progress
+      DLFLProgressRange range(double(level)/levels,1.0/levels);
+      if ( !reportProgress(0,1) ) return false;
+      switch ( scheme ) {
+      case STLoop : loopSubdivide(obj,scratch); break;
+      case STCheckerBoard : checkerBoardRemeshing(obj,param1); break;
+      case STSimplest : simplestSubdivide(obj); break;
+      case STVertexCutting : vertexCuttingSubdivide(obj,param1); break;
+      case STPentagonal : pentagonalSubdivide(obj,param1); break;
+      case STPentagonal2 : pentagonalSubdivide2(obj,param1); break;
+      case STHoneycomb : honeycombSubdivide(obj); break;
+      case STDooSabin :
+        if ( !dooSabinSubdivide(obj,param1 != 0.0) ) return false;
+        break;
+      case STDooSabinBC : dooSabinSubdivideBC(obj,param1 != 0.0); break;
+      case STDooSabinBCNew : dooSabinSubdivideBCNew(obj,param1,param2); break;
+      case STCornerCutting : cornerCuttingSubdivide(obj,param1); break;
+      case STModifiedCornerCutting : modifiedCornerCuttingSubdivide(obj,param1); break;
+      case STModifiedCornerCutting2 : modifiedCornerCuttingSubdivide2(obj,param1); break;
+      case STRoot4 : root4Subdivide(obj,param1,param2); break;
+      case STCatmullClark : catmullClarkSubdivide(obj); break;
+      case STStar : starSubdivide(obj,param1); break;
+      case STSqrt3 : sqrt3Subdivide(obj,scratch); break;
+      case STFractal : fractalSubdivide(obj,param1); break;
+      case STStellate : stellateSubdivide(obj); break;
+      case STTwoStellate : twostellateSubdivide(obj,param1,param2); break;
+      case STDome : domeSubdivide(obj,param1,param2); break;
+      case STDual1264 : dual1264Subdivide(obj,param1); break;
+      case STLoopStyle : loopStyleSubdivide(obj,param1); break;
+      case STAllFaces : subdivideAllFaces(obj,param1 != 0.0); break;
+      case STTriangulate : triangulateAllFaces(obj); break;
+      case STRoot3 :
+        createDual(obj,true); // Use accurate method
+        honeycombSubdivide(obj);
+        createDual(obj,true);
+        break;
+      default : return false;
+      }
+    }
+    return reportProgress(1,1);
+  }
+
 } // end namespace
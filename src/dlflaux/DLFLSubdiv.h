@@ -7,6 +7,48 @@
 
 namespace DLFL {
 
+  // Schemes for subdivide()
+  enum DLFLSubdivScheme {
+    STLoop=0,
+    STCheckerBoard,
+    STSimplest,
+    STVertexCutting,
+    STPentagonal,
+    STPentagonal2,
+    STHoneycomb,
+    STDooSabin,
+    STDooSabinBC,
+    STDooSabinBCNew,
+    STCornerCutting,
+    STModifiedCornerCutting,
+    STModifiedCornerCutting2,
+    STRoot4,
+    STCatmullClark,
+    STStar,
+    STSqrt3,
+    STFractal,
+    STStellate,
+    STTwoStellate,
+    STDome,
+    STDual1264,
+    STLoopStyle,
+    STAllFaces,
+    STTriangulate,
+    STRoot3 };
+
+  /*
+    Apply the given number of levels of a scheme in one call. Nothing but the
+    mesh is updated between levels, so callers should recompute normals,
+    patches etc. (and push undo) once around the whole call. param1 and param2
+    are the parameters of the scheme's function in the order declared below;
+    bool parameters are true if non-zero. The version without parameters uses
+    the default values. Returns false if a level failed (Doo-Sabin check) or
+    the operation was cancelled through DLFLProgress.
+  */
+  bool subdivide(DLFLObjectPtr obj, DLFLSubdivScheme scheme, int levels=1);
+  bool subdivide(DLFLObjectPtr obj, DLFLSubdivScheme scheme, int levels,
+                 double param1, double param2=0.0);
+
   void loopSubdivide( DLFLObjectPtr obj );
   void checkerBoardRemeshing(DLFLObjectPtr obj, double thickness=0.33);
   void simplestSubdivide( DLFLObjectPtr obj );
@@ -14,7 +56,7 @@ namespace DLFL {
   void pentagonalSubdivide2(DLFLObjectPtr obj, double scale_factor=0.75);
   void pentagonalSubdivide(DLFLObjectPtr obj, double offset=0);
   void honeycombSubdivide(DLFLObjectPtr obj);
-  bool dooSabinSubdivide(DLFLObjectPtr obj, bool check=true /*,QProgressDialog *progress = 0*/);
+  bool dooSabinSubdivide(DLFLObjectPtr obj, bool check=true);
   void dooSabinSubdivideBC(DLFLObjectPtr obj, bool check=true);
   void dooSabinSubdivideBCNew(DLFLObjectPtr obj, double sf, double length);
   void cornerCuttingSubdivide(DLFLObjectPtr obj, float alpha);
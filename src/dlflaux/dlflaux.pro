@@ -19,6 +19,12 @@ macx {
  #LIBS += -lvecmat -ldlflcore
 }
 
+CONFIG(WITH_OPENMP) {
+ # run the geometry passes of the operators in parallel
+ QMAKE_CXXFLAGS += -fopenmp
+ QMAKE_LFLAGS += -fopenmp
+}
+
 HEADERS +=  \
           	DLFLCast.h  \
           	DLFLConnect.h  \
@@ -26,6 +32,7 @@ HEADERS +=  \
           	DLFLCrust.h  \
           	DLFLDual.h  \
           	DLFLExtrude.h  \
+          	DLFLLimitSurface.h  \
           	DLFLMeshSmooth.h  \
           	DLFLMultiConnect.h  \
           	DLFLSculpting \
@@ -38,6 +45,7 @@ SOURCES +=  \
           	DLFLCrust.cc  \
           	DLFLDual.cc  \
           	DLFLExtrude.cc  \
+          	DLFLLimitSurface.cc  \
           	DLFLMeshSmooth.cc  \
           	DLFLMultiConnect.cc  \
           	DLFLSculpting.cc \
@@ -7,9 +7,20 @@
 #include "DLFLCore.h"
 #include <cmath>
 #include <cassert>
+#include <cstdio>
 
 namespace DLFL {
 
+// Puts the changes of a core operation into the journal of the object,
+// see DLFLObject::beginChanges
+class ChangeScope {
+public :
+  ChangeScope(DLFLObjectPtr obj) : object(obj) { object->beginChanges(); }
+  ~ChangeScope() { object->endChanges(); }
+private :
+  DLFLObjectPtr object;
+};
+
 /***************
  * Insert Edge *
  ***************/
@@ -76,6 +87,7 @@ DLFLEdgePtr insertEdgeCoFacial(DLFLObjectPtr obj, DLFLFaceVertexPtr fvptr1,
   //Insert an edge between 2 corners in the same face.Doesn 't check if both
   // corners are in the same face or not
   // Insertion of the Edge will split the Face into 2 faces
+  ChangeScope scope(obj);
   DLFLFacePtr fp = fvptr1->getFacePtr();
   DLFLMaterialPtr matl = fp->material();
 
@@ -142,6 +154,7 @@ DLFLEdgePtr insertEdgeCoFacial(DLFLObjectPtr obj, DLFLFaceVertexPtr fvptr1,
 
   //Add new face to face list
   obj->addFacePtr(newfaceptr);
+  obj->changedFace(fp);
 
   //Create the new Edge and do necessary updates
   edgeptr = new DLFLEdge;
@@ -159,6 +172,7 @@ DLFLEdgePtr insertEdgeNonCoFacial(
     DLFLFaceVertexPtr fvptr2, DLFLMaterialPtr matl) {
   //Insert an edge between 2 corners belonging to different faces
   // Doesn 't check if the corners belong to different faces
+  ChangeScope scope(obj);
   DLFLFacePtr fp1 = fvptr1->getFacePtr();
   DLFLFacePtr fp2 = fvptr2->getFacePtr();
 
@@ -230,6 +244,7 @@ DLFLEdgePtr insertEdgeNonCoFacial(
   newedgeptr->setFaceVertexPointers(fvptr1, fvptr2);
   obj->addEdgePtr(newedgeptr);
   newedgeptr->updateFaceVertices();
+  obj->changedFace(newfaceptr);
 
   return newedgeptr;
 }
@@ -265,8 +280,10 @@ std::vector<int> deleteEdgeID(DLFLObjectPtr obj, uint edgeId, bool cleanup) {
 
 DLFLFacePtrArray deleteEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool cleanup) {
   if (edgeptr == NULL) return DLFLFacePtrArray();
-  if (find(obj->beginEdge(), obj->endEdge(), edgeptr) == obj->endEdge())
+  // The edge may have been deleted already (cleanup passes queue edges)
+  if (obj->getEdgeIdx().find(edgeptr) == obj->getEdgeIdx().end())
      return DLFLFacePtrArray();
+  ChangeScope scope(obj);
   DLFLFaceVertexPtr fvpV1, fvpV2;
   DLFLFacePtr f1, f2;
 
@@ -330,6 +347,7 @@ DLFLFacePtrArray deleteEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool cleanup
     obj->removeFace(f2);
     delete f2;
     rfpa.push_back(f1);
+    obj->changedFace(f1);
   } else {
     //Two edge sides belong to same face
 
@@ -388,6 +406,7 @@ DLFLFacePtrArray deleteEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool cleanup
     
     //Add the new Face to the FaceList
     obj->addFacePtr(nfp);
+    obj->changedFace(f1);
 
     //If f1 ends up being a point sphere, reset the EdgePtr field of it 's only corner
     if (f1->size() == 1) {
@@ -466,6 +485,7 @@ DLFLVertexPtr collapseEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool cleanup)
   //Collapse an edge - merge two vertices into one after removing in - between edge
   if (edgeptr == NULL)
     return NULL;
+  ChangeScope scope(obj);
 
   //If the edge is a self - loop, just delete the edge with cleanup
   if (edgeptr->isSelfLoop()) {
@@ -525,6 +545,9 @@ DLFLVertexPtr collapseEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool cleanup)
     vp1->addToFaceVertexList(fvparray[i]);
   }
 
+  //All faces around vp1 have changed
+  obj->changedVertex(vp1);
+
   //Delete Vertex 2(vp2) from Vertex list and free memory
   obj->removeVertex(vp2);
   delete vp2;
@@ -598,6 +621,7 @@ DLFLVertexPtr subdivideEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool set_typ
 
   //Edge subdivision will work whether the two Edge sides belong to different Faces
   // or not.
+  ChangeScope scope(obj);
   DLFLVertexPtr nvp = new DLFLVertex;
 
   obj->addVertexPtr(nvp);
@@ -671,6 +695,9 @@ DLFLVertexPtr subdivideEdge(DLFLObjectPtr obj, DLFLEdgePtr edgeptr, bool set_typ
   fvpV1->setEdgePtr(nep1);
   fvpV2->setEdgePtr(nep2);
 
+  obj->changedFace(f1);
+  obj->changedFace(f2);
+
   return nvp;
 }
 
@@ -866,14 +893,18 @@ DLFLObjectPtr readObjectFile(char* filename, char *mtlfilename) {
   char* ext = strrchr(filename, '.');
 
   if(strcasecmp(ext,".obj") == 0) {
-    obj->readObject(file, mtlfile);
+    // Cancelled, nothing is returned rather than part of the object
+    if(!obj->readObject(file, mtlfile)) {
+      delete obj;
+      return NULL;
+    }
     obj->setFilename(filename);
   } else if(strcasecmp(ext,".dlfl") == 0) {
     obj->readDLFL(file, mtlfile);
     obj->setFilename(filename);
   } else {
     delete obj;
-    obj = NULL;
+    return NULL;
   }
 
   obj->computeNormals();
@@ -898,12 +929,12 @@ bool writeObjectFile(DLFLObject *obj, char* filename, char *mtlfilename) {
     return false;
    
   char* ext = strrchr(filename, '.');
-  bool wrote = false;
+  bool wrote = true;
   if(strcasecmp(ext,".obj") == 0) {
-    obj->writeObject(file, mtlfile, true, true);
+    wrote = obj->writeObject(file, mtlfile, true, true);
     //obj->setFilename(filename);
   } else if(strcasecmp(ext,".dlfl") == 0) {
-    obj->writeDLFL(file, mtlfile, false);
+    wrote = obj->writeDLFL(file, mtlfile, false);
     //obj->setFilename(filename);
   }	else if(strcasecmp(ext,".m") == 0) {
     obj->writeLG3d(file, false);
@@ -911,11 +942,13 @@ bool writeObjectFile(DLFLObject *obj, char* filename, char *mtlfilename) {
   }	else if(strcasecmp(ext,".stl") == 0) {
     obj->writeSTL(file);
     //obj->setFilename(filename);
-  }
+  } else wrote = false;
   if (mtlfilename != NULL) {
     mtlfile.close();
   }
   file.close();
+  // Don't leave part of a file behind
+  if (!wrote) std::remove(filename);
   return wrote;
 }
 
@@ -997,12 +1030,14 @@ void cleanup2gons(DLFLObjectPtr obj) {
   // delete one of the edges.
   // We don't check for infinite loop, since if an edge belongs
   // to a 2-gon deleting it will not create a new face
+  // Deleting the edge removes one of the faces on its sides, which
+  // may come later in the list, so check that the face is still there
   DLFLFacePtrList face_list = obj->getFaceList();
   DLFLFacePtrList::iterator ffirst=face_list.begin(), flast=face_list.end();
   DLFLFacePtr fp;
   while (ffirst != flast) {
     fp = (*ffirst); ++ffirst;
-    if (fp && fp->size() == 2) {
+    if (fp && obj->getFaceIdx().count(fp) && fp->size() == 2) {
       // Face is a 2-gon.
       // Get one of the edges in the face and delete it
       DLFLFaceVertexPtr fvp = fp->front();
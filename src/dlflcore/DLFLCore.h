@@ -119,6 +119,7 @@ namespace DLFL {
   void edgeCleanup(DLFLObjectPtr obj, const DLFLEdgePtrList& edges);
   void edgeCleanup(DLFLObjectPtr obj, const DLFLEdgePtrArray& edges);
 
+
   void cleanup2gons(DLFLObjectPtr obj);
   /**
    * Cleanup Valence 2 vertices (winged vertices)
@@ -133,6 +134,8 @@ namespace DLFL {
   /* Create a DLFL object from an input stream which should contain
    * an object in OBJ format */
   DLFLObject* readObjectFile(char* filename, char *mtlfilename =NULL);
+  /* Returns false if the file couldn't be written or writing was cancelled,
+   * nothing of the file is left then */
   bool writeObjectFile(
       DLFLObject *obj, char* filename = NULL, char *mtlfilename=NULL);
 
@@ -516,6 +516,7 @@ namespace DLFL {
 
   void DLFLFaceVertex::setType(DLFLFaceVertexType type) { fvtType = type; };
   void DLFLFaceVertex::resetType( ) { fvtType = FVTNormal; };
+  void DLFLFaceVertex::setIndex(uint newindex) { index = newindex; };
    
   // Reset to original state
   void DLFLFaceVertex::reset( ) {
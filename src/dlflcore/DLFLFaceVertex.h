@@ -140,6 +140,7 @@ public :
 
   void setType(DLFLFaceVertexType type) ;
   void resetType( ) ;
+  void setIndex(uint newindex) ;
    
   // Reset to original state
   void reset( ) ;
@@ -219,6 +220,7 @@ private:
   void reverse( ) ;
 
   friend class DLFLFace;
+  friend class DLFLObject; // For the structural copy of objects
 
 public :
 
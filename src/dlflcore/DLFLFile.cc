@@ -1,6 +1,7 @@
 /*** ***/
 
 #include "DLFLObject.h"
+#include "DLFLProgress.h"
 #include <cstdio>
 #include <cstring>
 
@@ -18,11 +19,30 @@ namespace DLFL {
 
 	static char *dname;
 
-	void DLFLObject::readObject(istream& i, istream &imtl) {
+	// Reading reports progress by position in the stream. tellg is not free,
+	// so it is only checked every few lines
+	static const int progress_lines = 1024;
+
+	static size_t streamLength(istream& i) {
+		streampos start = i.tellg();
+		if (start < 0) return 0;
+		i.seekg(0,ios::end);
+		streampos end = i.tellg();
+		i.seekg(start);
+		return (end > start) ? size_t(end - start) : 0;
+	}
+
+	static bool reportStreamProgress(istream& i, streampos start, size_t length) {
+		streampos pos = i.tellg();
+		if (pos < 0 || length == 0) return reportProgress(0,0);
+		return reportProgress(size_t(pos - start),length);
+	}
+
+	bool DLFLObject::readObject(istream& i, istream &imtl) {
 		// std::cout << "reading obj file \n";
 		if (!i) {
 			cerr  << "Incomplete OBJ file." << endl;
-			return;
+			return false;
 		}
 
 		// Clear the object first
@@ -57,8 +77,19 @@ namespace DLFL {
 		// long i = 0;
 		// int currentMaterial = -1;
 
+		streampos start = i.tellg();
+		size_t length = streamLength(i);
+		int lines = 0;
+
 		// Read each line and set the Vertex, Normal, Face, Color or Texture
+		// If cancelled the part read so far is thrown away, rather than
+		// leaving a mesh which looks complete but isn't
 		while (i) {
+			if (++lines % progress_lines == 0 && !reportStreamProgress(i,start,length)) {
+				vertex_array.clear();
+				reset();
+				return false;
+			}
 			removeWhiteSpace(i); i.get(c); i.get(c2);
 			if (c == 'm' && c2 == 't') {
 				char mtlfilename[256], mtlfilepath[512];
@@ -172,9 +203,10 @@ namespace DLFL {
 		updateFaceList();
 		
 		// std::cout << "done reading obj\n;";
+		return true;
 	}
 
-	void DLFLObject::writeObject(ostream& o, ostream &omtl, bool with_normals, bool with_tex_coords) {
+	bool DLFLObject::writeObject(ostream& o, ostream &omtl, bool with_normals, bool with_tex_coords) {
 		//write mtl file
 		if (!omtl.fail())
 			writeMTL(omtl);
@@ -221,6 +253,7 @@ namespace DLFL {
 		ff = face_list.begin();
 		DLFLMaterialPtr mptr = (*ff)->material();
 		o << "usemtl " << mptr->name << "\n";						
+		size_t num_written = 0; // for progress reporting
 		
 		if (with_normals) {
 			uint normal_id_start = 1;
@@ -232,6 +265,7 @@ namespace DLFL {
 						mptr = (*ff)->material();
 						o << "usemtl " << mptr->name << "\n";						
 					}
+					if (!reportProgress(num_written++,face_list.size())) return false;
 					(*ff)->objWriteWithNormalsAndTexCoords(o,min_id,normal_id_start,tex_id_start);
 					++ff;
 				}
@@ -244,6 +278,7 @@ namespace DLFL {
 						o << "usemtl " << mptr->name << "\n";						
 					}
 					
+					if (!reportProgress(num_written++,face_list.size())) return false;
 					(*ff)->objWriteWithNormals(o,min_id,normal_id_start);
 					++ff;
 				}
@@ -258,6 +293,7 @@ namespace DLFL {
 					o << "usemtl " << mptr->name << "\n";						
 				}
 				
+				if (!reportProgress(num_written++,face_list.size())) return false;
 				(*ff)->objWriteWithTexCoords(o,min_id,tex_id_start);
 				++ff;
 			}
@@ -269,12 +305,14 @@ namespace DLFL {
 					mptr = (*ff)->material();
 					o << "usemtl " << mptr->name << "\n";						
 				}				
+				if (!reportProgress(num_written++,face_list.size())) return false;
 				(*ff)->objWrite(o,min_id);
 				++ff;
 			}
 		}
 
 		o << "# " << face_list.size() << " faces" << endl << endl;
+		return true;
 	}//end write object function
 
 	void DLFLObject::readDLFL(istream& i, istream &imtl,  bool clearold) {
@@ -335,8 +373,15 @@ namespace DLFL {
 		if (c2 != '\n') readTillEOL(i);
 		c = ' ';
 		
+		// Progress is reported but reading can't be cancelled half way,
+		// the face vertices are only linked up at the end
+		streampos start = i.tellg();
+		size_t length = streamLength(i);
+		int lines = 0;
+
 		// Read the vertices first. Stop when we get to a '#' sign at the beginning of a line
 		while (i && c != '#') {
+			if (++lines % progress_lines == 0) reportStreamProgress(i,start,length);
 			i.get(c); i.get(c2);
 			if (c == 'v' && c2 == ' ') {
 				// Read a vertex specification
@@ -366,6 +411,7 @@ namespace DLFL {
 		if (c2 != '\n') readTillEOL(i);
 		c = ' ';
 		while (i && c != '#') {
+			if (++lines % progress_lines == 0) reportStreamProgress(i,start,length);
 			i.get(c); i.get(c2);
 			if (c == 'f' && c2 == 'v') {
 				// std::cout << "reading a face vertex\n";
@@ -393,6 +439,7 @@ namespace DLFL {
 
 		c = ' ';
 		while (i && c != '#') {
+			if (++lines % progress_lines == 0) reportStreamProgress(i,start,length);
 			i.get(c); i.get(c2);
 			if (c == 'e' && c2 == ' ') {
 				// Read a edge specification
@@ -418,6 +465,7 @@ namespace DLFL {
 		if (c2 != '\n') readTillEOL(i);
 		c = ' ';
 		while (i && c != '#') {
+			if (++lines % progress_lines == 0) reportStreamProgress(i,start,length);
 			i.get(c); i.get(c2);
 			if (c == 'u' && c2 == 's') {
 				i.get(c);i.get(c);i.get(c);i.get(c);i.get(c);
@@ -473,7 +521,7 @@ namespace DLFL {
 		// printEdgeList();
 	}
 
-	void DLFLObject::writeDLFL(ostream& o, ostream &omtl, bool reverse_faces) {
+	bool DLFLObject::writeDLFL(ostream& o, ostream &omtl, bool reverse_faces) {
 		//write the mtl file if it exists
 		if (!omtl.fail()) {
 			// std::cout<<"mtl file did not fail.\n";
@@ -487,10 +535,14 @@ namespace DLFL {
 
 		// std::cout << "writing dlfl\t" << mFilename << "\n";
 		
+		// Stop writing if cancelled, the output is incomplete then
+		size_t num_steps = vertex_list.size() + face_list.size();
+
 		// Write the vertex list next. Update the vertex index also
 		DLFLVertexPtrList::iterator vf = vertex_list.begin(), vl = vertex_list.end();
 		uint vindex = 0;
 		while (vf != vl) {
+			if (vindex % progress_lines == 0 && !reportProgress(vindex,num_steps)) return false;
 			(*vf)->writeDLFL(o,vindex++);
 			++vf;
 		}
@@ -499,8 +551,9 @@ namespace DLFL {
 		// Write the facevertices and update the face vertex index also
 		DLFLFacePtrList::iterator ff = face_list.begin(), fl = face_list.end();		
 		DLFLFacePtr fptr;
-		uint fvindex = 0;
+		uint fvindex = 0, findex = 0;
 		while (ff != fl) {
+			if (findex++ % progress_lines == 0 && !reportProgress(vindex+findex,num_steps)) return false;
 			fptr = (*ff);
 			DLFLFaceVertexPtr head;
 			head = fptr->front();
@@ -533,7 +586,7 @@ namespace DLFL {
 		}
 
 		o << '#' << endl;
-		DLFLMaterialPtr mptr = (*ff)->material();
+		DLFLMaterialPtr mptr = NULL;
 		// o << "usemtl " << mptr->name << "\n";						
 		// Write the face list
 		ff = face_list.begin(); fl = face_list.end();
@@ -558,6 +611,7 @@ namespace DLFL {
 			}
 		}
 		o << '#' << endl;
+		return true;
 	}
 
 	bool DLFLObject::readMTL(istream &i) {
@@ -630,7 +684,7 @@ namespace DLFL {
 
 		Vector3dArray coords; int i=0, j=0;		
 		if (selected) {
-			vector<DLFLFacePtr>::iterator ff = this->sel_fptr_array.begin(), 
+			DLFLFacePtrArray::const_iterator ff = this->sel_fptr_array.begin(), 
 																		fl = this->sel_fptr_array.end();
 			// Write the object in LG3d (*.m) format for use with the LiveGraphics3D live.jar java archive from Mathworld.com
 			o << "Graphics3D[{";
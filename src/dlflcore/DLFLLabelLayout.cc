@@ -0,0 +1,153 @@
+/*** ***/
+
+/**
+ * \file DLFLLabelLayout.cc
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "DLFLLabelLayout.h"
+#include "DLFLObject.h"
+#include "DLFLParallel.h"
+
+namespace DLFL {
+
+  // Orders points by their depth, the third of the four numbers of each
+  struct LessDepth {
+    const double *points;
+    bool operator () (int i, int j) const { return points[4*i+2] < points[4*j+2]; }
+  };
+
+  DLFLLabelLayout::DLFLLabelLayout(const double proj[16], const double model[16], const int view[4])
+    : region(proj,model,view,view[0]+0.5*view[2],view[1]+0.5*view[3],view[2],view[3]),
+      cell_width(40.0), cell_height(20.0), per_cell(1), occluder(NULL) {
+    for (int c=0; c < 4; ++c)
+      for (int r=0; r < 4; ++r) {
+        matrix[c*4+r] = 0.0;
+        for (int k=0; k < 4; ++k) matrix[c*4+r] += proj[k*4+r]*model[c*4+k];
+      }
+    for (int i=0; i < 16; ++i) modelview[i] = model[i];
+    for (int i=0; i < 4; ++i) viewport[i] = view[i];
+  }
+
+  void DLFLLabelLayout::setCells(double w, double h, int num) {
+    cell_width = std::max(w,1.0); cell_height = std::max(h,1.0);
+    per_cell = ( num > 0 ) ? num : INT_MAX;
+  }
+
+  void DLFLLabelLayout::layout(const DLFLVertexPtrArray& vertices, std::vector<Label>& labels) const {
+    layout(Vertices,vector<const void *>(vertices.begin(),vertices.end()),labels);
+  }
+
+  void DLFLLabelLayout::layout(const DLFLEdgePtrArray& edges, std::vector<Label>& labels) const {
+    layout(Edges,vector<const void *>(edges.begin(),edges.end()),labels);
+  }
+
+  void DLFLLabelLayout::layout(const DLFLFacePtrArray& faces, std::vector<Label>& labels) const {
+    layout(Faces,vector<const void *>(faces.begin(),faces.end()),labels);
+  }
+
+  Vector3d DLFLLabelLayout::anchor(Kind kind, const void *element) {
+    if ( kind == Vertices ) return ((DLFLVertexPtr)element)->coords;
+    if ( kind == Edges ) {
+      DLFLVertexPtr vp1, vp2;
+      ((DLFLEdgePtr)element)->getVertexPointers(vp1,vp2);
+      return 0.5*(vp1->coords + vp2->coords);
+    }
+    return ((DLFLFacePtr)element)->geomCentroid();
+  }
+
+  void DLFLLabelLayout::ownFaces(Kind kind, const void *element, DLFLFacePtrArray& faces) {
+    faces.clear();
+    if ( kind == Vertices ) {
+      ((DLFLVertexPtr)element)->getFaces(faces);
+    } else if ( kind == Edges ) {
+      DLFLFacePtr fp1, fp2;
+      ((DLFLEdgePtr)element)->getFacePointers(fp1,fp2);
+      faces.push_back(fp1); faces.push_back(fp2);
+    } else {
+      faces.push_back((DLFLFacePtr)element);
+    }
+  }
+
+  void DLFLLabelLayout::layout(Kind kind, const std::vector<const void *>& elements,
+                               std::vector<Label>& labels) const {
+    labels.clear();
+
+    // The cells cover the window and a cell around it, for the labels
+    // which start outside but reach into it
+    double xmin = viewport[0] - cell_width, ymin = viewport[1] - cell_height;
+    int columns = (int)ceil(viewport[2]/cell_width) + 2;
+    int rows = (int)ceil(viewport[3]/cell_height) + 2;
+
+    // Window position, depth and squared distance from the eye of every
+    // point, and its cell, -1 if out of view
+    int num = elements.size();
+    vector<double> points(4*num);
+    vector<int> cells(num);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num; ++i) {
+      Vector3d p = anchor(kind,elements[i]);
+      double c[4], e[3];
+      for (int r=0; r < 4; ++r)
+        c[r] = matrix[r]*p[0] + matrix[4+r]*p[1] + matrix[8+r]*p[2] + matrix[12+r];
+      for (int r=0; r < 3; ++r)
+        e[r] = modelview[r]*p[0] + modelview[4+r]*p[1] + modelview[8+r]*p[2] + modelview[12+r];
+      cells[i] = -1;
+      if ( c[3] <= 0.0 ) continue;
+      double *point = &points[4*i];
+      point[0] = viewport[0] + 0.5*(c[0]/c[3] + 1.0)*viewport[2];
+      point[1] = viewport[1] + 0.5*(c[1]/c[3] + 1.0)*viewport[3];
+      point[2] = c[2]/c[3];
+      point[3] = e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+      if ( point[2] < -1.0 || point[2] > 1.0 ) continue;
+      int column = (int)floor((point[0] - xmin)/cell_width), row = (int)floor((point[1] - ymin)/cell_height);
+      if ( column >= 0 && column < columns && row >= 0 && row < rows ) cells[i] = row*columns + column;
+    }
+
+    // The points in view, by cell
+    vector<int> first(columns*rows+1,0);
+    for (int i=0; i < num; ++i)
+      if ( cells[i] >= 0 ) ++first[cells[i]+1];
+    for (int c=0; c < columns*rows; ++c) first[c+1] += first[c];
+    vector<int> order(first.back()), next(first.begin(),first.end()-1);
+    for (int i=0; i < num; ++i)
+      if ( cells[i] >= 0 ) order[next[cells[i]]++] = i;
+    if ( order.empty() ) return;
+
+    double dmin = points[4*order[0]+3], dmax = dmin;
+    for (int j=1; j < (int)order.size(); ++j) {
+      dmin = std::min(dmin,points[4*order[j]+3]);
+      dmax = std::max(dmax,points[4*order[j]+3]);
+    }
+
+    // The nearest labels of each cell which can be seen
+    LessDepth less = { &points[0] };
+    DLFLFacePtrArray own;
+    for (int c=0; c < columns*rows; ++c) {
+      vector<int>::iterator begin = order.begin() + first[c], end = order.begin() + first[c+1];
+      if ( begin == end ) continue;
+      if ( occluder || end - begin <= per_cell ) std::sort(begin,end,less);
+      else std::partial_sort(begin,begin+per_cell,end,less);
+
+      int taken = 0;
+      for (vector<int>::iterator it = begin; it != end && taken < per_cell; ++it) {
+        int i = *it;
+        if ( occluder ) {
+          ownFaces(kind,elements[i],own);
+          if ( occluder->pickIndex().isHidden(region,anchor(kind,elements[i]),own) ) continue;
+        }
+        Label label;
+        if ( kind == Vertices ) label.id = ((DLFLVertexPtr)elements[i])->getID();
+        else if ( kind == Edges ) label.id = ((DLFLEdgePtr)elements[i])->getID();
+        else label.id = ((DLFLFacePtr)elements[i])->getID();
+        label.x = points[4*i]; label.y = points[4*i+1];
+        label.nearness = ( dmax > dmin ) ? (dmax - points[4*i+3])/(dmax - dmin) : 1.0;
+        labels.push_back(label);
+        ++taken;
+      }
+    }
+  }
+
+} // end namespace
@@ -0,0 +1,69 @@
+/*** ***/
+
+/**
+ * \file DLFLLabelLayout.h
+ */
+
+#ifndef _DLFL_LABEL_LAYOUT_HH_
+#define _DLFL_LABEL_LAYOUT_HH_
+
+#include <vector>
+#include "DLFLCommon.h"
+#include "DLFLPickIndex.h"
+
+namespace DLFL {
+
+  /*
+    Where to draw the ID labels of vertices, edges and faces - at a vertex,
+    the middle of an edge, the centroid of a face - so that showing them
+    stays quick on large objects.
+
+    All the points are projected at once. Those outside the window are
+    dropped, and the window is cut into cells about the size of a label,
+    each of which gets only its nearest few labels. Optionally labels
+    hidden behind faces of the object are dropped too, found with the
+    faces of its pick index. So at most a few labels per cell are drawn,
+    however many elements the object has.
+  */
+  class DLFLLabelLayout {
+  public :
+    struct Label {
+      uint id;                                 // ID of the element
+      double x, y;                             // Window coordinates, as glViewport
+      double nearness;                         // 1 for the nearest in the window, 0 for the farthest
+    };
+
+    // The matrices are column major, as from glGetDoublev, and the modelview
+    // matrix takes the coordinates of the elements
+    DLFLLabelLayout(const double projection[16], const double modelview[16], const int viewport[4]);
+
+    // At most num labels in each w by h pixel cell of the window, 0 for no
+    // limit
+    void setCells(double w, double h, int num);
+    // Leave out the labels hidden behind faces of an object, NULL for none
+    void setOccluder(DLFLObjectPtr obj) { occluder = obj; }
+
+    void layout(const DLFLVertexPtrArray& vertices, std::vector<Label>& labels) const;
+    void layout(const DLFLEdgePtrArray& edges, std::vector<Label>& labels) const;
+    void layout(const DLFLFacePtrArray& faces, std::vector<Label>& labels) const;
+
+  private :
+    enum Kind { Vertices, Edges, Faces };
+
+    void layout(Kind kind, const std::vector<const void *>& elements, std::vector<Label>& labels) const;
+    // Where the label of an element goes, and the faces it lies on
+    static Vector3d anchor(Kind kind, const void *element);
+    static void ownFaces(Kind kind, const void *element, DLFLFacePtrArray& faces);
+
+    DLFLPickIndex::Region region;              // The whole window
+    double matrix[16];                         // projection * modelview
+    double modelview[16];
+    int viewport[4];
+    double cell_width, cell_height;
+    int per_cell;
+    DLFLObjectPtr occluder;
+  };
+
+} // end namespace
+
+#endif /* _DLFL_LABEL_LAYOUT_HH_ */
@@ -0,0 +1,118 @@
+/*** ***/
+
+/**
+ * \file DLFLMatchIndex.cc
+ */
+
+#include <algorithm>
+#include "DLFLMatchIndex.h"
+#include "DLFLObject.h"
+
+namespace DLFL {
+
+  DLFLMatchIndex::DLFLMatchIndex(DLFLObjectPtr obj)
+    : object(obj), generation(0), built(0) {
+  }
+
+  void DLFLMatchIndex::invalidate() {
+    built = 0;
+    face_sizes.clear();
+    face_areas.clear();
+    face_materials.clear();
+    vertex_valences.clear();
+    edge_valences.clear();
+  }
+
+  static bool lessFaceArea(const pair<float,DLFLFacePtr>& fa1,
+                           const pair<float,DLFLFacePtr>& fa2) {
+    if ( fa1.first != fa2.first ) return fa1.first < fa2.first;
+    return fa1.second->getID() < fa2.second->getID();
+  }
+
+  static bool areaBelow(const pair<float,DLFLFacePtr>& fa, float area) {
+    return fa.first < area;
+  }
+
+  void DLFLMatchIndex::update(Part part) {
+    if ( generation != object->getGeneration() ) {
+      invalidate();
+      generation = object->getGeneration();
+    }
+    if ( built & part ) return;
+
+    if ( part == VertexValences ) {
+      DLFLVertexPtrList::const_iterator vf = object->getVertexList().begin(),
+                                        vl = object->getVertexList().end();
+      while ( vf != vl ) {
+        vertex_valences[(*vf)->numEdges()].push_back(*vf);
+        ++vf;
+      }
+    } else if ( part == EdgeValences ) {
+      DLFLEdgePtrList::const_iterator ef = object->getEdgeList().begin(),
+                                      el = object->getEdgeList().end();
+      DLFLVertexPtr vp1, vp2;
+      uint val1, val2;
+      while ( ef != el ) {
+        (*ef)->getVertexPointers(vp1,vp2);
+        val1 = vp1->numEdges(); val2 = vp2->numEdges();
+        if ( val1 > val2 ) std::swap(val1,val2);
+        edge_valences[ValencePair(val1,val2)].push_back(*ef);
+        ++ef;
+      }
+    } else {
+      DLFLFacePtrList::iterator ff = object->beginFace(), fl = object->endFace();
+      if ( part == FaceAreas ) face_areas.reserve(object->num_faces());
+      while ( ff != fl ) {
+        if ( part == FaceSizes ) face_sizes[(*ff)->size()].push_back(*ff);
+        else if ( part == FaceAreas ) face_areas.push_back(FaceArea((*ff)->getArea(),*ff));
+        else face_materials[(*ff)->material()].push_back(*ff);
+        ++ff;
+      }
+      if ( part == FaceAreas ) std::sort(face_areas.begin(),face_areas.end(),lessFaceArea);
+    }
+    built |= part;
+  }
+
+  void DLFLMatchIndex::facesWithSize(uint size, DLFLFacePtrArray& fparray) {
+    update(FaceSizes);
+    fparray.clear();
+    map<uint,DLFLFacePtrArray>::const_iterator it = face_sizes.find(size);
+    if ( it != face_sizes.end() ) fparray = it->second;
+  }
+
+  void DLFLMatchIndex::facesWithArea(float minarea, float maxarea, DLFLFacePtrArray& fparray) {
+    update(FaceAreas);
+    fparray.clear();
+    // First face with an area of at least minarea
+    vector<FaceArea>::const_iterator first = face_areas.begin(), last = face_areas.end();
+    first = std::lower_bound(first,last,minarea,areaBelow);
+    while ( first != last && first->first <= maxarea ) {
+      fparray.push_back(first->second);
+      ++first;
+    }
+  }
+
+  void DLFLMatchIndex::facesWithMaterial(DLFLMaterialPtr matl, DLFLFacePtrArray& fparray) {
+    update(FaceMaterials);
+    fparray.clear();
+    map<DLFLMaterialPtr,DLFLFacePtrArray>::const_iterator it = face_materials.find(matl);
+    if ( it != face_materials.end() ) fparray = it->second;
+  }
+
+  void DLFLMatchIndex::verticesWithValence(uint valence, DLFLVertexPtrArray& vparray) {
+    update(VertexValences);
+    vparray.clear();
+    map<uint,DLFLVertexPtrArray>::const_iterator it = vertex_valences.find(valence);
+    if ( it != vertex_valences.end() ) vparray = it->second;
+  }
+
+  void DLFLMatchIndex::edgesWithValences(uint valence1, uint valence2, DLFLEdgePtrArray& eparray) {
+    update(EdgeValences);
+    eparray.clear();
+    if ( valence1 > valence2 ) std::swap(valence1,valence2);
+    map<ValencePair,DLFLEdgePtrArray>::const_iterator it =
+      edge_valences.find(ValencePair(valence1,valence2));
+    if ( it != edge_valences.end() ) eparray = it->second;
+  }
+
+} // end namespace
@@ -0,0 +1,67 @@
+/*** ***/
+
+/**
+ * \file DLFLMatchIndex.h
+ */
+
+#ifndef _DLFL_MATCH_INDEX_HH_
+#define _DLFL_MATCH_INDEX_HH_
+
+#include <map>
+#include <utility>
+#include "DLFLCommon.h"
+
+namespace DLFL {
+
+  /*
+    Index of the elements of an object by signature, for the "select
+    matching" operations: faces by size, area and material, vertices by
+    valence and edges by the (unordered) valences of their end vertices.
+
+    Each part of the index is built on first use with one pass over the
+    object and is rebuilt when the generation of the object has changed
+    since (see DLFLObject::changed()). After that a query only costs the
+    size of its result. Areas are kept sorted, so a range of areas is found
+    by binary search.
+
+    The index belongs to its object - get it with DLFLObject::matchIndex().
+  */
+  class DLFLMatchIndex {
+  public :
+    DLFLMatchIndex(DLFLObjectPtr obj);
+
+    // The arrays are cleared first. Elements come in the order of the lists
+    // of the object, except for facesWithArea which gives them by area.
+    void facesWithSize(uint size, DLFLFacePtrArray& fparray);
+    void facesWithArea(float minarea, float maxarea, DLFLFacePtrArray& fparray);
+    void facesWithMaterial(DLFLMaterialPtr matl, DLFLFacePtrArray& fparray);
+    void verticesWithValence(uint valence, DLFLVertexPtrArray& vparray);
+    void edgesWithValences(uint valence1, uint valence2, DLFLEdgePtrArray& eparray);
+
+    // Throw away everything, the parts are built again when needed
+    void invalidate();
+
+  private :
+    typedef std::pair<uint,uint> ValencePair;
+    typedef std::pair<float,DLFLFacePtr> FaceArea;
+
+    enum Part { FaceSizes = 1, FaceAreas = 2, FaceMaterials = 4,
+                VertexValences = 8, EdgeValences = 16 };
+
+    // Make sure the given part is up to date
+    void update(Part part);
+
+    DLFLObjectPtr object;
+    unsigned long generation;                  // Generation of object when built
+    int built;                                 // Parts built since then
+
+    std::map<uint, DLFLFacePtrArray> face_sizes;
+    std::vector<FaceArea> face_areas;          // Sorted by area
+    std::map<DLFLMaterialPtr, DLFLFacePtrArray> face_materials;
+    std::map<uint, DLFLVertexPtrArray> vertex_valences;
+    std::map<ValencePair, DLFLEdgePtrArray> edge_valences;
+  };
+
+} // end namespace
+
+#endif /* _DLFL_MATCH_INDEX_HH_ */
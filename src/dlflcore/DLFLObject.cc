@@ -14,7 +14,8 @@ namespace DLFL {
   DLFLObject::DLFLObject()
     : position(), scale_factor(1), rotation(),
       vertex_list(), edge_list(), face_list(), /* patch_list(), patchsize(4)*/ 
-      vertex_idx(), edge_idx(), face_idx() {
+      vertex_idx(), face_idx(), edge_idx(),
+      generation(0), change_depth(0), journal_start(0), match_index(NULL), render_buffers(NULL), overlay_buffers(NULL), pick_index(NULL) {
     assignID();
     // Add a default material
     matl_list.push_back(new DLFLMaterial("default",0.5,0.5,0.5));
@@ -25,6 +26,10 @@ namespace DLFL {
   /// Destructor
   DLFLObject::~DLFLObject() {
     clearLists();
+    delete match_index;
+    delete render_buffers;
+    delete overlay_buffers;
+    delete pick_index;
     if(mFilename) { delete [] mFilename; mFilename = NULL; }
     if(mDirname) { delete [] mDirname; mDirname = NULL; }
   };
@@ -47,6 +52,8 @@ namespace DLFL {
     if (vertex_idx.find(vp) != vertex_idx.end()) vertex_list.erase(vertex_idx[vp]); 
     else vertex_list.remove(vp);
     vertex_idx.erase(vp);
+    if (change_depth > 0) changedVertex(vp);
+    else changed();
   };
 
   void DLFLObject::removeEdge(DLFLEdgePtr ep) {
@@ -54,6 +61,8 @@ namespace DLFL {
     if (edge_idx.find(ep) != edge_idx.end()) edge_list.erase(edge_idx[ep]); 
     else edge_list.remove(ep);
     edge_idx.erase(ep);
+    if (change_depth > 0) changedEdge(ep);
+    else changed();
   };
 
   void DLFLObject::removeFace(DLFLFacePtr fp) {
@@ -61,6 +70,8 @@ namespace DLFL {
     if (face_idx.find(fp) != face_idx.end()) face_list.erase(face_idx[fp]); 
     else face_list.remove(fp);
     face_idx.erase(fp); 
+    if (change_depth > 0) changedFace(fp);
+    else changed();
   };
 
   void DLFLObject::assignID() {
@@ -70,46 +81,147 @@ namespace DLFL {
   /// Copy Constructor - make proper copy, don't just copy pointers
   DLFLObject::DLFLObject(const DLFLObject& dlfl)
     : position(dlfl.position), scale_factor(dlfl.scale_factor), rotation(dlfl.rotation),
-      vertex_list(dlfl.vertex_list), edge_list(dlfl.edge_list), face_list(dlfl.face_list), matl_list(dlfl.matl_list),
-      //patch_list(dlfl.patch_list), patchsize(dlfl.patchsize),
-      uID(dlfl.uID) {
-    for (DLFLVertexPtrList::iterator it = vertex_list.begin();
-        it != vertex_list.end(); ++it) vertex_idx[*it] = it;
-    for (DLFLEdgePtrList::iterator it = edge_list.begin();
-        it != edge_list.end(); ++it) edge_idx[*it] = it;
-    for (DLFLFacePtrList::iterator it = face_list.begin();
-        it != face_list.end(); ++it) face_idx[*it] = it;
+      vertex_list(), edge_list(), face_list(), matl_list(),
+      vertex_idx(), face_idx(), edge_idx(),
+      generation(0), change_depth(0), journal_start(0), match_index(NULL), render_buffers(NULL), overlay_buffers(NULL), pick_index(NULL), uID(dlfl.uID), mFilename(NULL), mDirname(NULL) {
+    copyElements(dlfl);
+    if ( dlfl.mFilename ) setFilename(dlfl.mFilename);
+    if ( dlfl.mDirname ) setDirname(dlfl.mDirname);
   };
 
   // Assignment operator
   DLFLObject& DLFLObject::operator=(const DLFLObject& dlfl) {
-    position = dlfl.position;
-    scale_factor = dlfl.scale_factor;
-    rotation = dlfl.rotation;
+    if ( this != &dlfl ) {
+      // Build the copy first and exchange it with our mesh. The old mesh
+      // is destroyed with the temporary
+      DLFLObject temp(dlfl);
+      swap(temp);
+      std::swap(mFilename,temp.mFilename);
+      std::swap(mDirname,temp.mDirname);
+    }
+    return (*this);
+  };
 
-    // Destroy the existing object
-    clearLists();
+  void DLFLObject::swap(DLFLObject& dlfl) {
+    std::swap(position,dlfl.position);
+    std::swap(scale_factor,dlfl.scale_factor);
+    std::swap(rotation,dlfl.rotation);
+    vertex_list.swap(dlfl.vertex_list);
+    edge_list.swap(dlfl.edge_list);
+    face_list.swap(dlfl.face_list);
+    matl_list.swap(dlfl.matl_list);
+    // The iterators in the index maps stay valid, they move with the lists
+    vertex_idx.swap(dlfl.vertex_idx);
+    edge_idx.swap(dlfl.edge_idx);
+    face_idx.swap(dlfl.face_idx);
+    edgeMap.swap(dlfl.edgeMap);
+    faceMap.swap(dlfl.faceMap);
+    std::swap(uID,dlfl.uID);
+    // Both objects have a different mesh now
+    changed(); dlfl.changed();
+  };
 
-    // Copy the lists from the new object
-    vertex_list = dlfl.vertex_list;
-    edge_list = dlfl.edge_list;
-    face_list = dlfl.face_list;
-    matl_list = dlfl.matl_list;
-    //patch_list = dlfl.patch_list;
-    //patchsize = dlfl.patchsize;
-    for (DLFLVertexPtrList::iterator it = vertex_list.begin();
-        it != vertex_list.end(); ++it) vertex_idx[*it] = it;
-    for (DLFLEdgePtrList::iterator it = edge_list.begin();
-        it != edge_list.end(); ++it) edge_idx[*it] = it;
-    for (DLFLFacePtrList::iterator it = face_list.begin();
-        it != face_list.end(); ++it) face_idx[*it] = it;
- 
-    edgeMap = dlfl.edgeMap;
-    faceMap = dlfl.faceMap;
-
-    uID = dlfl.uID;
-    return (*this);
+  void DLFLObject::copyElements(const DLFLObject& dlfl) {
+    // Materials. There are only a few, so a map is good enough
+    map<DLFLMaterialPtr,DLFLMaterialPtr> newmatls;
+    DLFLMaterialPtrList::const_iterator mf = dlfl.matl_list.begin(), ml = dlfl.matl_list.end();
+    DLFLMaterialPtr mptr, newmptr;
+    while ( mf != ml ) {
+      mptr = (*mf); ++mf;
+      newmptr = new DLFLMaterial(mptr->name,mptr->color);
+      newmptr->Ka = mptr->Ka; newmptr->Kd = mptr->Kd; newmptr->Ks = mptr->Ks;
+      matl_list.push_back(newmptr);
+      newmatls[mptr] = newmptr;
+    }
+
+    // Vertices. The index of the old vertex is the index of the copy.
+    // The face-vertex lists are filled in at the end
+    DLFLVertexPtrArray newverts; newverts.reserve(dlfl.vertex_list.size());
+    DLFLVertexPtrList::const_iterator vf = dlfl.vertex_list.begin(), vl = dlfl.vertex_list.end();
+    DLFLVertexPtr vptr, newvptr;
+    while ( vf != vl ) {
+      vptr = (*vf); ++vf;
+      vptr->index = newverts.size();
+      newvptr = new DLFLVertex(*vptr);
+      newvptr->fvpList.clear();
+      newvptr->ismarked = vptr->ismarked; newvptr->isvisited = vptr->isvisited;
+      newvptr->CHullIndex = vptr->CHullIndex;
+      addVertexPtr(newvptr);
+      newverts.push_back(newvptr);
+    }
+
+    // Face vertices, face by face. The links are remapped with the faces
+    DLFLFaceVertexPtrArray newcorners; newcorners.reserve(2*dlfl.edge_list.size());
+    DLFLFacePtrList::const_iterator ff = dlfl.face_list.begin(), fl = dlfl.face_list.end();
+    DLFLFaceVertexPtr head, current, newfvptr;
+    while ( ff != fl ) {
+      head = (*ff)->head; ++ff;
+      if ( head == NULL ) continue;
+      current = head;
+      do {
+        current->index = newcorners.size();
+        newfvptr = new DLFLFaceVertex(*current);
+        newfvptr->vertex = newverts[current->vertex->index];
+        newfvptr->backface = current->backface;
+        newfvptr->epEPtr = NULL;
+        newcorners.push_back(newfvptr);
+        current = current->fvpNext;
+      } while ( current != head );
+    }
+
+    // Edges
+    DLFLEdgePtrList::const_iterator ef = dlfl.edge_list.begin(), el = dlfl.edge_list.end();
+    DLFLEdgePtr eptr, neweptr;
+    while ( ef != el ) {
+      eptr = (*ef); ++ef;
+      neweptr = new DLFLEdge(*eptr);
+      neweptr->fvpV1 = newcorners[eptr->fvpV1->index];
+      neweptr->fvpV2 = newcorners[eptr->fvpV2->index];
+      neweptr->ismarked = eptr->ismarked; neweptr->isdummy = eptr->isdummy;
+      neweptr->istodel = eptr->istodel; neweptr->isvisited = eptr->isvisited;
+      neweptr->updateFaceVertices();
+      addEdgePtr(neweptr);
+    }
+
+    // Faces
+    DLFLFacePtr fptr, newfptr;
+    DLFLFaceVertexPtr newcurrent;
+    ff = dlfl.face_list.begin();
+    while ( ff != fl ) {
+      fptr = (*ff); ++ff;
+      newfptr = new DLFLFace(fptr->matl_ptr ? newmatls[fptr->matl_ptr] : NULL);
+      newfptr->uID = fptr->uID;
+      newfptr->ftType = fptr->ftType;
+      newfptr->auxcoords = fptr->auxcoords; newfptr->auxnormal = fptr->auxnormal;
+      newfptr->centroid = fptr->centroid; newfptr->normal = fptr->normal;
+      newfptr->flags = fptr->flags; newfptr->ismarked = fptr->ismarked;
+      head = fptr->head;
+      if ( head ) {
+        newfptr->head = newcorners[head->index];
+        current = head;
+        do {
+          newcurrent = newcorners[current->index];
+          newcurrent->fvpNext = newcorners[current->fvpNext->index];
+          newcurrent->fvpPrev = newcorners[current->fvpPrev->index];
+          newcurrent->fpFPtr = newfptr;
+          current = current->fvpNext;
+        } while ( current != head );
+      }
+      addFacePtr(newfptr);
+    }
+
+    // Face-vertex lists of the vertices, in the same order as the original
+    DLFLFaceVertexPtrList::const_iterator fvf, fvl;
+    vf = dlfl.vertex_list.begin();
+    for (size_t i=0; i < newverts.size(); ++i, ++vf) {
+      fvf = (*vf)->fvpList.begin(); fvl = (*vf)->fvpList.end();
+      while ( fvf != fvl ) {
+        newverts[i]->fvpList.push_back(newcorners[(*fvf)->index]);
+        ++fvf;
+      }
+    }
   };
+
   // Free all the pointers in the lists and clear the lists
   void DLFLObject::clearLists() {
     clear(vertex_list);
@@ -122,6 +234,7 @@ namespace DLFL {
     //destroyPatches();
     edgeMap.clear();
     faceMap.clear();
+    changed();
   };
 
   // Compute the genus of the mesh using Euler formula
@@ -175,6 +288,101 @@ namespace DLFL {
     edge_list.splice(edge_list.end(),object.edge_list);
     face_list.splice(face_list.end(),object.face_list);
     matl_list.splice(matl_list.end(),object.matl_list);
+    // Spliced iterators stay valid, so the indices can be moved over as well
+    vertex_idx.insert(object.vertex_idx.begin(),object.vertex_idx.end());
+    edge_idx.insert(object.edge_idx.begin(),object.edge_idx.end());
+    face_idx.insert(object.face_idx.begin(),object.face_idx.end());
+    edgeMap.insert(object.edgeMap.begin(),object.edgeMap.end());
+    faceMap.insert(object.faceMap.begin(),object.faceMap.end());
+    object.vertex_idx.clear(); object.edge_idx.clear(); object.face_idx.clear();
+    object.edgeMap.clear(); object.faceMap.clear();
+    changed(); object.changed();
+  }
+
+  void DLFLObject::appendCopy(const DLFLObject& object, bool reversed) {
+    // The elements are appended at the end of our lists, which are the same
+    // lists as those of object when copying ourselves. Only go over the
+    // elements that were there to begin with.
+    size_t num_verts = object.vertex_list.size();
+    size_t num_edges = object.edge_list.size();
+    size_t num_faces = object.face_list.size();
+
+    DLFLVertexPtrArray newverts; newverts.reserve(num_verts);
+    DLFLFaceVertexPtrArray newcorners; newcorners.reserve(2*num_edges);
+
+    // Copy the vertices. The index of the old vertex is the index of the copy
+    DLFLVertexPtrList::const_iterator vf = object.vertex_list.begin();
+    DLFLVertexPtr vptr, newvptr;
+    for (size_t i=0; i < num_verts; ++i, ++vf) {
+      vptr = (*vf); vptr->setIndex(i);
+      newvptr = new DLFLVertex(vptr->coords);
+      addVertexPtr(newvptr);
+      newverts.push_back(newvptr);
+    }
+
+    // Copy the face vertices, face by face
+    DLFLFacePtrList::const_iterator ff = object.face_list.begin();
+    DLFLFaceVertexPtr head, current, newfvptr;
+    for (size_t i=0; i < num_faces; ++i, ++ff) {
+      head = (*ff)->front();
+      if ( head == NULL ) continue;
+      current = head;
+      do {
+        current->setIndex(newcorners.size());
+        newfvptr = new DLFLFaceVertex;
+        newfvptr->vertex = newverts[current->vertex->getIndex()];
+        newfvptr->normal = current->normal;
+        newfvptr->texcoord = current->texcoord;
+        newcorners.push_back(newfvptr);
+        current = current->next();
+      } while ( current != head );
+    }
+
+    // Copy the edges. When the faces are reversed, the edge starts at the
+    // corners following the original corners (see DLFLEdge::writeDLFLReverse)
+    DLFLEdgePtrList::const_iterator ef = object.edge_list.begin();
+    DLFLFaceVertexPtr fvp1, fvp2;
+    DLFLEdgePtr neweptr;
+    for (size_t i=0; i < num_edges; ++i, ++ef) {
+      (*ef)->getFaceVertexPointers(fvp1,fvp2);
+      if ( reversed ) {
+        fvp1 = fvp1->next(); fvp2 = fvp2->next();
+      }
+      neweptr = new DLFLEdge;
+      neweptr->setFaceVertexPointers(newcorners[fvp1->getIndex()],newcorners[fvp2->getIndex()],false);
+      neweptr->updateFaceVertices();
+      addEdgePtr(neweptr);
+    }
+
+    // Copy the faces. Use our own material with the same name
+    ff = object.face_list.begin();
+    DLFLFacePtr newfptr;
+    DLFLMaterialPtr mptr = NULL, newmptr = NULL;
+    for (size_t i=0; i < num_faces; ++i, ++ff) {
+      head = (*ff)->front();
+      if ( head == NULL ) continue;
+      if ( mptr != (*ff)->material() ) {
+        mptr = (*ff)->material(); newmptr = mptr;
+        if ( mptr && &object != this ) {
+          newmptr = findMaterial(mptr->name);
+          if ( newmptr == NULL ) {
+            newmptr = new DLFLMaterial(mptr->name,mptr->color);
+            matl_list.push_back(newmptr);
+          }
+        }
+      }
+
+      newfptr = new DLFLFace;
+      current = head;
+      do {
+        newfptr->addVertexPtr(newcorners[current->getIndex()]);
+        current = reversed ? current->prev() : current->next();
+      } while ( current != head );
+      newfptr->setMaterial(newmptr);
+      newfptr->updateFacePointers();
+      newfptr->addFaceVerticesToVertices();
+      addFacePtr(newfptr);
+    }
   }
 
   // Reverse the orientation of all faces in the object
@@ -194,6 +402,7 @@ namespace DLFL {
       (*ffirst)->reverse();
       ++ffirst;
     }
+    changed();
   }
 
   bool DLFLObject::edgeExists(DLFLVertexPtr vptr1, DLFLVertexPtr vptr2) {
@@ -257,6 +466,7 @@ namespace DLFL {
       }
       ++first;
     }
+    changed();
   }
 
   void DLFLObject::randomAssignTexCoords() {
@@ -267,6 +477,7 @@ namespace DLFL {
       (*first)->randomAssignTexCoords();
       ++first;
     }
+    changed();
   }
 
   DLFLFacePtrArray DLFLObject::createFace(
@@ -274,6 +485,7 @@ namespace DLFL {
     // Create 2 new faces with the given vertex coordinates. The 2 faces will have the same
     // vertices and share the same edges, but will have opposite rotation orders.
     // This essentially creates a 2 manifold with 2 faces with no volume.
+    // The new elements are journaled, like those of the core operations.
     int numverts = verts.size();
     DLFLFacePtr newface1, newface2;
     DLFLVertexPtr vptr, tempvptr;
@@ -281,6 +493,7 @@ namespace DLFL {
     DLFLFaceVertexPtr fvptr;
 
     if (matl == NULL) matl = firstMaterial();
+    beginChanges();
   
     newface1 = new DLFLFace; newface2 = new DLFLFace;
 
@@ -333,6 +546,7 @@ namespace DLFL {
       addEdgePtr(eptr);
       current1 = current1->next(); current2 = current2->prev();
     }
+    endChanges();
 
 		DLFLFacePtrArray newverts;
 		newverts.push_back(newface1);
@@ -562,21 +776,41 @@ namespace DLFL {
     addFacePtr(faceptr->copy());
   }
 
-  void DLFLObject::computeNormals() {
-    DLFLVertexPtrList::iterator first, last;
+  // Recompute the corner normals of a face, true if any of them changed
+  static bool updateCornerNormals(DLFLFacePtr faceptr) {
+    bool changed = false;
+    DLFLFaceVertexPtr head = faceptr->front(), current = head;
+    if (head == NULL) return false;
+    do {
+      Vector3d normal = current->normal;
+      current->updateNormal();
+      if (normal[0] != current->normal[0] || normal[1] != current->normal[1] ||
+          normal[2] != current->normal[2]) changed = true;
+      current = current->next();
+    } while (current != head);
+    return changed;
+  }
 
-    first = vertex_list.begin(); last = vertex_list.end();
-    while (first != last) {
-      (*first)->updateNormal();
-      ++first;
-    }
+  void DLFLObject::computeNormals() {
+    // Corner and face normals first. Only the faces whose corner normals
+    // came out different are journaled as changed.
     DLFLFacePtrList::iterator ffirst, flast;
 
     ffirst = face_list.begin(); flast = face_list.end();
     while (ffirst != flast) {
+      if (updateCornerNormals(*ffirst)) changedFace(*ffirst);
       (*ffirst)->updateNormal();
       ++ffirst;
     }
+
+    // The vertex normals are the averages of the corner normals
+    DLFLVertexPtrList::iterator first, last;
+
+    first = vertex_list.begin(); last = vertex_list.end();
+    while (first != last) {
+      (*first)->updateNormal(false);
+      ++first;
+    }
   }
   /*
 		void DLFLObject::deleteVertex(uint vertex_index) {
@@ -766,6 +1000,8 @@ namespace DLFL {
     // **** WARNING!!! **** Pointer will be freed when list is deleted
     // vertex_list.push_back(vertexptr);
     vertex_idx[vertexptr] = vertex_list.insert(vertex_list.end(), vertexptr);
+    if (change_depth > 0) changedVertex(vertexptr);
+    else changed();
   };
 
   void DLFLObject::addEdgePtr(DLFLEdgePtr edgeptr) {
@@ -774,6 +1010,8 @@ namespace DLFL {
     // edge_list.push_back(edgeptr);
     edge_idx[edgeptr] = edge_list.insert(edge_list.end(), edgeptr);
     edgeMap[edgeptr->getID()] = (unsigned int)edgeptr;
+    if (change_depth > 0) changedEdge(edgeptr);
+    else changed();
   };
 
   void DLFLObject::addFacePtr(DLFLFacePtr faceptr) {
@@ -785,6 +1023,114 @@ namespace DLFL {
     // face_list.push_back(faceptr);
     face_idx[faceptr] = face_list.insert(face_list.end(), faceptr);
     faceMap[faceptr->getID()] = (unsigned int)faceptr;
+    if (change_depth > 0) changedFace(faceptr);
+    else changed();
+  };
+
+  unsigned long DLFLObject::getGeneration() const {
+    return generation;
+  };
+
+  void DLFLObject::changed() {
+    ++generation;
+    restartJournal();
+  };
+
+  void DLFLObject::restartJournal() {
+    face_changes.clear();
+    edge_changes.clear();
+    vertex_changes.clear();
+    journal_start = generation;
+  };
+
+  void DLFLObject::trimJournal() {
+    // Past a quarter of the object, patching costs about as much as rebuilding
+    size_t size = face_changes.size() + edge_changes.size() + vertex_changes.size();
+    if (size > 1024 && size > (face_idx.size() + edge_idx.size() + vertex_idx.size()) / 4)
+      restartJournal();
+  };
+
+  void DLFLObject::beginChanges() {
+    ++change_depth;
+  };
+
+  void DLFLObject::endChanges() {
+    if (change_depth > 0) --change_depth;
+  };
+
+  void DLFLObject::changedFace(DLFLFacePtr faceptr) {
+    ++generation;
+    face_changes.push_back(make_pair(generation,faceptr));
+    trimJournal();
+  };
+
+  void DLFLObject::changedEdge(DLFLEdgePtr edgeptr) {
+    ++generation;
+    edge_changes.push_back(make_pair(generation,edgeptr));
+    trimJournal();
+  };
+
+  void DLFLObject::changedVertex(DLFLVertexPtr vertexptr) {
+    ++generation;
+    vertex_changes.push_back(make_pair(generation,vertexptr));
+    trimJournal();
+  };
+
+  // Copy the elements journaled after gen, without duplicates
+  template <class T>
+  static void journalSince(const vector< pair<unsigned long,T> >& journal,
+                           unsigned long gen, vector<T>& elements) {
+    elements.clear();
+    // The journal is ordered by generation
+    typename vector< pair<unsigned long,T> >::const_reverse_iterator
+      it = journal.rbegin(), last = journal.rend();
+    while (it != last && it->first > gen) {
+      elements.push_back(it->second);
+      ++it;
+    }
+    std::sort(elements.begin(),elements.end());
+    elements.erase(std::unique(elements.begin(),elements.end()),elements.end());
+  }
+
+  bool DLFLObject::changesSince(unsigned long gen, DLFLFacePtrArray& faces,
+                                DLFLEdgePtrArray& edges, DLFLVertexPtrArray& vertices) const {
+    if (gen < journal_start) return false;
+    journalSince(face_changes,gen,faces);
+    journalSince(edge_changes,gen,edges);
+    journalSince(vertex_changes,gen,vertices);
+    return true;
+  };
+
+  bool DLFLObject::hasFace(DLFLFacePtr faceptr) const {
+    return (face_idx.find(faceptr) != face_idx.end());
+  };
+
+  bool DLFLObject::hasEdge(DLFLEdgePtr edgeptr) const {
+    return (edge_idx.find(edgeptr) != edge_idx.end());
+  };
+
+  bool DLFLObject::hasVertex(DLFLVertexPtr vertexptr) const {
+    return (vertex_idx.find(vertexptr) != vertex_idx.end());
+  };
+
+  DLFLMatchIndex& DLFLObject::matchIndex() {
+    if (match_index == NULL) match_index = new DLFLMatchIndex(this);
+    return *match_index;
+  };
+
+  DLFLRenderBuffers& DLFLObject::renderBuffers() {
+    if (render_buffers == NULL) render_buffers = new DLFLRenderBuffers(this);
+    return *render_buffers;
+  };
+
+  DLFLOverlayBuffers& DLFLObject::overlayBuffers() {
+    if (overlay_buffers == NULL) overlay_buffers = new DLFLOverlayBuffers(this);
+    return *overlay_buffers;
+  };
+
+  DLFLPickIndex& DLFLObject::pickIndex() {
+    if (pick_index == NULL) pick_index = new DLFLPickIndex(this);
+    return *pick_index;
   };
 
   DLFLVertexPtr DLFLObject::getVertexPtr(uint index) const {
@@ -937,6 +1283,7 @@ namespace DLFL {
     }
     //add the fresh blank gray material
     // matl_list.push_back(mptr);
+    changed();
   }
 
   DLFLMaterialPtr DLFLObject::addMaterial(RGBColor color) {
@@ -961,6 +1308,7 @@ namespace DLFL {
   void DLFLObject::setColor(const RGBColor& col) {
     // matl_list[0] is always the default material
     matl_list.front()->setColor(col);
+    changed();
   };
 
   //-- Geometric Transformations --//
@@ -979,6 +1327,7 @@ namespace DLFL {
       vp = (*vfirst); ++vfirst;
       vp->transform(tmat);
     }
+    changed();
   }
 
   // Apply GL transformations before rendering
@@ -8,6 +8,7 @@
 #define _DLFL_OBJECT_HH_
 
 #include <map>
+#include <set>
 /**
 * TRANSLATOR DLFL::DLFLObject
 *   
@@ -29,6 +30,11 @@
 #include "DLFLEdge.h"
 #include "DLFLFace.h"
 #include "DLFLMaterial.h"
+#include "DLFLMatchIndex.h"
+#include "DLFLRenderBuffers.h"
+#include "DLFLOverlayBuffers.h"
+#include "DLFLPickIndex.h"
+#include "DLFLSelectionSet.h"
 #include "Transform.h"
 
 namespace DLFL {
@@ -49,22 +55,16 @@ class DLFLObject {
  public:
   static Transformation tr;                         // For doing GL transformations
 
-  DLFLVertexPtrArray sel_vptr_array; // List of selected DLFLVertex pointers
-
-  DLFLEdgePtrArray sel_eptr_array; // List of selected DLFLEdge pointers
-  DLFLFacePtrArray sel_fptr_array; // List of selected DLFLFace pointers
-  DLFLFaceVertexPtrArray sel_fvptr_array; // List of selected DLFLFaceVertex pointers
+  DLFLVertexSelection sel_vptr_array; // Selected DLFLVertex pointers
+  DLFLEdgeSelection sel_eptr_array; // Selected DLFLEdge pointers
+  DLFLFaceSelection sel_fptr_array; // Selected DLFLFace pointers
+  DLFLFaceVertexSelection sel_fvptr_array; // Selected DLFLFaceVertex pointers
 
   void clearSelected();
 
   HashMap faceMap;
   HashMap edgeMap;
 
-  static DLFLVertexPtrArray vparray;                // For selection
-  static DLFLEdgePtrArray   eparray;                // For selection
-  static DLFLFacePtrArray   fparray;                // For selection
-  static DLFLFaceVertexPtrArray fvparray;           // For selection
-
   Vector3d           position;                      // Position of object
   Vector3d           scale_factor;                  // Scale of object
   Quaternion         rotation;                      // Rotation of object
@@ -84,6 +84,17 @@ protected :
   map<DLFLVertexPtr, DLFLVertexPtrList::iterator> vertex_idx;
   map<DLFLFacePtr, DLFLFacePtrList::iterator> face_idx;
   map<DLFLEdgePtr, DLFLEdgePtrList::iterator> edge_idx;
+
+  unsigned long generation;                         // Bumped on every change
+  int change_depth;                                 // Nesting depth of core operations
+  unsigned long journal_start;                      // Journal has the changes after this
+  vector< pair<unsigned long, DLFLFacePtr> > face_changes;     // Journal, by generation
+  vector< pair<unsigned long, DLFLEdgePtr> > edge_changes;
+  vector< pair<unsigned long, DLFLVertexPtr> > vertex_changes;
+  DLFLMatchIndex *match_index;                      // Built on first use
+  DLFLRenderBuffers *render_buffers;                // Built on first use
+  DLFLOverlayBuffers *overlay_buffers;              // Built on first use
+  DLFLPickIndex *pick_index;                        // Built on first use
   //TMPatchFacePtrList patch_list;     // List of patch faces
   //int patchsize;         // Size of each patch
      
@@ -96,13 +107,33 @@ protected :
   // Free all the pointers in the lists and clear the lists
   void clearLists();
 
-private :
-  /// Copy Constructor - make proper copy, don't just copy pointers
-  DLFLObject(const DLFLObject& dlfl);
+  // Empty the change journal, it starts at the current generation
+  void restartJournal();
+  // Restart the journal if it has grown too long
+  void trimJournal();
 
-  // Assignment operator
+public :
+  /*
+    Copy constructor and assignment make a deep copy of the object. All
+    elements (with their IDs, types and attributes) and the materials are
+    duplicated in one pass over the lists, the pointers between them are
+    remapped through the vertex and face-vertex indices of the source.
+    The copy is a snapshot of the object, which can be brought back later
+    with swap() - see the undo list in the GUI.
+  */
+  DLFLObject(const DLFLObject& dlfl);
   DLFLObject& operator=(const DLFLObject& dlfl);
 
+  // Exchange the meshes of the two objects in constant time. Nothing is copied
+  // and no pointers to elements become invalid, the elements just change owner.
+  // The file and directory names stay with the object.
+  void swap(DLFLObject& dlfl);
+
+private :
+  // Add copies of all elements and materials of the given object. Used by the
+  // copy constructor and assignment.
+  void copyElements(const DLFLObject& dlfl);
+
 public :
   // Dump contents of this object
   void dump(ostream& o) const;
@@ -199,6 +230,13 @@ public :
   // pointers in this object will become invalid.
   void splice(DLFLObject& object);
 
+  // Append a copy of the given object (which can be this object) to this object.
+  // If reversed is true the orientation of the copied faces is reversed.
+  // Gives the same result as writing the object with writeDLFL and reading
+  // it back with readDLFL, without going through a stream. Uses the vertex
+  // and face-vertex indices of the given object.
+  void appendCopy(const DLFLObject& object, bool reversed = false);
+
   // Reverse the orientation of all faces in the object
   // This also requires reversing all edges in the object
   void reverse();
@@ -215,6 +253,59 @@ public :
   void addFace(DLFLFacePtr faceptr);                // Insert a copy
   void addFacePtr(DLFLFacePtr faceptr);
 
+
+  //--- Generation ---//
+  // The generation counts the changes to the object, so anything derived from
+  // the mesh can tell whether it is out of date. Adding and removing elements
+  // (and so every operation in DLFLCore) advances it, as do the operations on
+  // the whole object (reset, swap, splice, reverse, freezeTransformations,
+  // the texture coordinate assignments, ...) and computeNormals, if any
+  // normal came out different.
+  // Changes made to the elements directly - moving vertices, assigning
+  // materials - have to be announced with changed().
+  unsigned long getGeneration() const;
+  void changed();
+
+  //--- Change journal ---//
+  // Besides counting the changes the object keeps a journal of the elements
+  // they were made to, so what is derived from the mesh can be patched
+  // instead of rebuilt (see DLFLRenderBuffers). Between beginChanges and
+  // endChanges - the core operations in DLFLCore - every element added,
+  // removed or touched goes into the journal. Outside of that only the
+  // elements announced with changedFace/Edge/Vertex do, and adding or
+  // removing elements restarts the journal, as does changed(). The journal
+  // also restarts when it grows to a good part of the size of the object.
+  // changedVertex means the vertex moved, so its faces and edges changed too.
+  void beginChanges();
+  void endChanges();
+  void changedFace(DLFLFacePtr faceptr);
+  void changedEdge(DLFLEdgePtr edgeptr);
+  void changedVertex(DLFLVertexPtr vertexptr);
+
+  // The elements in the journal after the given generation, each once. They
+  // may have been removed from the object since. Returns false if the
+  // journal doesn't go back that far.
+  bool changesSince(unsigned long gen, DLFLFacePtrArray& faces,
+                    DLFLEdgePtrArray& edges, DLFLVertexPtrArray& vertices) const;
+
+  // Is the element part of this object
+  bool hasFace(DLFLFacePtr faceptr) const;
+  bool hasEdge(DLFLEdgePtr edgeptr) const;
+  bool hasVertex(DLFLVertexPtr vertexptr) const;
+
+  // Index for the "select matching" queries, see DLFLMatchIndex.h
+  DLFLMatchIndex& matchIndex();
+
+  // Triangles of the faces for drawing, see DLFLRenderBuffers.h
+  DLFLRenderBuffers& renderBuffers();
+
+  // Points and lines of the vertices, edges, centroids and normals for
+  // drawing, see DLFLOverlayBuffers.h
+  DLFLOverlayBuffers& overlayBuffers();
+
+  // Hierarchies for picking with the mouse, see DLFLPickIndex.h
+  DLFLPickIndex& pickIndex();
+
   DLFLVertexPtr getVertexPtr(uint index) const;
      
   DLFLVertexPtr getVertexPtrID(uint id) const;
@@ -253,16 +344,20 @@ public :
   void boundaryWalk(uint face_index);
   void vertexTrace(uint vertex_index);
 
-  void readObject(istream& i, istream &imtl = *static_cast<istream*>(NULL));
+  // Returns false if the file couldn't be read or reading was cancelled
+  // through DLFLProgress. The object is left empty then.
+  bool readObject(istream& i, istream &imtl = *static_cast<istream*>(NULL));
   void readObjectAlt(istream& i);
   void readDLFL(istream& i, istream &imtl = *static_cast<istream*>(NULL),
       bool clearold = true);
   bool readMTL(istream &i);
   bool writeMTL(ostream& o);
   
-  void writeObject(ostream& o, ostream &omtl = *static_cast<ostream*>(NULL),
+  // Return false if writing was cancelled through DLFLProgress. The output
+  // is incomplete then.
+  bool writeObject(ostream& o, ostream &omtl = *static_cast<ostream*>(NULL),
       bool with_normals = true, bool with_tex_coords = true);
-  void writeDLFL(ostream& o, ostream &omtl = *static_cast<ostream*>(NULL),
+  bool writeDLFL(ostream& o, ostream &omtl = *static_cast<ostream*>(NULL),
       bool reverse_faces = false);
   void writeSTL(ostream& o);
   //!< added by dave - for LiveGraphics3D support to embed 3d models into html
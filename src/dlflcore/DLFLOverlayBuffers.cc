@@ -0,0 +1,230 @@
+/*** ***/
+
+/**
+ * \file DLFLOverlayBuffers.cc
+ */
+
+#include <algorithm>
+#include "DLFLOverlayBuffers.h"
+#include "DLFLObject.h"
+#include "DLFLParallel.h"
+
+namespace DLFL {
+
+  unsigned long DLFLOverlayBuffers::last_revision = 0;
+
+  static bool lessRangeFirst(const DLFLOverlayBuffers::Range& r1,
+                             const DLFLOverlayBuffers::Range& r2) {
+    return r1.first < r2.first;
+  }
+
+  DLFLOverlayBuffers::Array::Array()
+    : per_element(1), num_points(0), built(false), generation(0), length(0.0),
+      revision_count(0), was_patched(false), patched_from(0) {
+  }
+
+  void DLFLOverlayBuffers::Array::reset(uint num) {
+    // Room for the elements added later
+    uint room = num + num/16 + 64;
+    point_array.clear();
+    point_array.resize(room*per_element);
+    num_points = 0;
+    index.clear();
+    elements.clear();
+    elements.reserve(room);
+    patched_ranges.clear();
+  }
+
+  bool DLFLOverlayBuffers::Array::place(const void *element, uint& first) {
+    std::map<const void *,uint>::iterator it = index.find(element);
+    if ( it != index.end() ) {
+      first = it->second*per_element;
+      return true;
+    }
+    if ( num_points + per_element > point_array.size() ) return false;
+    index[element] = elements.size();
+    elements.push_back(element);
+    first = num_points;
+    num_points += per_element;
+    return true;
+  }
+
+  void DLFLOverlayBuffers::Array::remove(const void *element) {
+    std::map<const void *,uint>::iterator it = index.find(element);
+    if ( it == index.end() ) return;
+    uint position = it->second, last = elements.size() - 1;
+    index.erase(it);
+    if ( position != last ) {
+      const void *moved = elements[last];
+      std::copy(point_array.begin() + last*per_element, point_array.begin() + (last+1)*per_element,
+                point_array.begin() + position*per_element);
+      elements[position] = moved;
+      index[moved] = position;
+      markRange(position*per_element,per_element);
+    }
+    elements.pop_back();
+    num_points -= per_element;
+  }
+
+  void DLFLOverlayBuffers::Array::markRange(uint first, uint count) {
+    Range range = { first, count };
+    patched_ranges.push_back(range);
+  }
+
+  void DLFLOverlayBuffers::Array::finish(bool patch, unsigned long revision) {
+    if ( patch ) {
+      // Merge the ranges which are close, fewer and larger uploads are faster
+      std::sort(patched_ranges.begin(),patched_ranges.end(),lessRangeFirst);
+      vector<Range> merged;
+      for (int i=0; i < (int)patched_ranges.size(); ++i) {
+        const Range& range = patched_ranges[i];
+        if ( !merged.empty() && range.first <= merged.back().first + merged.back().count + 32 )
+          merged.back().count = std::max(merged.back().count, range.first + range.count - merged.back().first);
+        else
+          merged.push_back(range);
+      }
+      patched_ranges.swap(merged);
+      patched_from = revision_count;
+    } else {
+      patched_ranges.clear();
+    }
+    was_patched = patch;
+    built = true;
+    revision_count = revision;
+  }
+
+  DLFLOverlayBuffers::DLFLOverlayBuffers(DLFLObjectPtr obj)
+    : object(obj) {
+    arrays[Edges].per_element = 2;
+    arrays[Normals].per_element = 2;
+  }
+
+  void DLFLOverlayBuffers::invalidate() {
+    for (int i=0; i < NumKinds; ++i) {
+      arrays[i].built = false;
+      arrays[i].reset(0);
+    }
+  }
+
+  const DLFLOverlayBuffers::Array& DLFLOverlayBuffers::update(Kind kind, double length) {
+    Array& array = arrays[kind];
+    if ( kind != Normals ) length = 0.0;
+    if ( array.built && array.length == length ) {
+      if ( array.generation == object->getGeneration() ) return array;
+      DLFLFacePtrArray faces;
+      DLFLEdgePtrArray edges;
+      DLFLVertexPtrArray vertices;
+      if ( object->changesSince(array.generation,faces,edges,vertices) &&
+           patch(kind,faces,edges,vertices) ) {
+        array.generation = object->getGeneration();
+        return array;
+      }
+    }
+    rebuild(kind,length);
+    return array;
+  }
+
+  void DLFLOverlayBuffers::rebuild(Kind kind, double length) {
+    Array& array = arrays[kind];
+    array.generation = object->getGeneration();
+    array.length = length;
+
+    // Elements in the order of their lists
+    if ( kind == Vertices ) {
+      array.reset(object->num_vertices());
+      DLFLVertexPtrList::const_iterator vf = object->getVertexList().begin(),
+                                        vl = object->getVertexList().end();
+      while ( vf != vl ) { array.elements.push_back(*vf); ++vf; }
+    } else if ( kind == Edges ) {
+      array.reset(object->num_edges());
+      DLFLEdgePtrList::const_iterator ef = object->getEdgeList().begin(),
+                                      el = object->getEdgeList().end();
+      while ( ef != el ) { array.elements.push_back(*ef); ++ef; }
+    } else {
+      array.reset(object->num_faces());
+      DLFLFacePtrList::iterator ff = object->beginFace(), fl = object->endFace();
+      while ( ff != fl ) { array.elements.push_back(*ff); ++ff; }
+    }
+    int num = array.elements.size();
+    for (int i=0; i < num; ++i) array.index[array.elements[i]] = i;
+    array.num_points = num*array.per_element;
+
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num; ++i)
+      fill(kind,array.elements[i],&array.point_array[i*array.per_element]);
+
+    array.finish(false,++last_revision);
+  }
+
+  bool DLFLOverlayBuffers::patch(Kind kind, const DLFLFacePtrArray& faces, const DLFLEdgePtrArray& edges,
+                                 const DLFLVertexPtrArray& vertices) {
+    Array& array = arrays[kind];
+
+    // The elements of this kind which changed. Moving a vertex moves its
+    // edges and the centroids of its faces.
+    vector<const void *> changed;
+    if ( kind == Vertices ) {
+      changed.assign(vertices.begin(),vertices.end());
+    } else if ( kind == Edges ) {
+      changed.assign(edges.begin(),edges.end());
+      DLFLEdgePtrArray around;
+      for (int i=0; i < (int)vertices.size(); ++i) {
+        if ( !object->hasVertex(vertices[i]) ) continue;
+        vertices[i]->getEdges(around);
+        changed.insert(changed.end(),around.begin(),around.end());
+      }
+    } else {
+      changed.assign(faces.begin(),faces.end());
+      DLFLFacePtrArray around;
+      for (int i=0; i < (int)vertices.size(); ++i) {
+        if ( !object->hasVertex(vertices[i]) ) continue;
+        vertices[i]->getFaces(around);
+        changed.insert(changed.end(),around.begin(),around.end());
+      }
+    }
+    std::sort(changed.begin(),changed.end());
+    changed.erase(std::unique(changed.begin(),changed.end()),changed.end());
+    if ( changed.size() > array.elements.size()/4 + 256 ) return false;
+
+    array.patched_ranges.clear();
+    for (int i=0; i < (int)changed.size(); ++i) {
+      const void *element = changed[i];
+      bool alive;
+      if ( kind == Vertices ) alive = object->hasVertex((DLFLVertexPtr)element);
+      else if ( kind == Edges ) alive = object->hasEdge((DLFLEdgePtr)element);
+      else alive = object->hasFace((DLFLFacePtr)element);
+
+      if ( alive ) {
+        uint first;
+        if ( !array.place(element,first) ) return false;
+        fill(kind,element,&array.point_array[first]);
+        array.markRange(first,array.per_element);
+      } else {
+        array.remove(element);
+      }
+    }
+    array.finish(true,++last_revision);
+    return true;
+  }
+
+  static void setPoint(DLFLOverlayBuffers::Point& point, const Vector3d& position) {
+    for (int i=0; i < 3; ++i) point.position[i] = position[i];
+  }
+
+  void DLFLOverlayBuffers::fill(Kind kind, const void *element, Point *points) const {
+    if ( kind == Vertices ) {
+      setPoint(points[0],((DLFLVertexPtr)element)->coords);
+    } else if ( kind == Edges ) {
+      DLFLVertexPtr vp1, vp2;
+      ((DLFLEdgePtr)element)->getVertexPointers(vp1,vp2);
+      setPoint(points[0],vp1->coords);
+      setPoint(points[1],vp2->coords);
+    } else {
+      DLFLFacePtr fp = (DLFLFacePtr)element;
+      fp->updateCentroid();
+      setPoint(points[0],fp->centroid);
+      if ( kind == Normals ) setPoint(points[1],fp->centroid + fp->getNormal()*arrays[Normals].length);
+    }
+  }
+
+} // end namespace
@@ -0,0 +1,126 @@
+/*** ***/
+
+/**
+ * \file DLFLOverlayBuffers.h
+ */
+
+#ifndef _DLFL_OVERLAY_BUFFERS_HH_
+#define _DLFL_OVERLAY_BUFFERS_HH_
+
+#include <map>
+#include <vector>
+#include "DLFLCommon.h"
+#include "DLFLRenderBuffers.h"
+
+namespace DLFL {
+
+  /*
+    The points and lines drawn over the faces of an object - the vertices,
+    the edges (wireframe and silhouette), the face centroids and the face
+    normals - in arrays of positions the renderer hands to OpenGL in one
+    call each.
+
+    Every element has a fixed number of points in its array: 1 per vertex
+    and centroid, 2 per edge and normal. The arrays are kept packed, the
+    points of a removed element are replaced with those of the last one.
+    Like DLFLRenderBuffers they are patched from the change journal of the
+    object: the elements in the journal, the edges around the vertices in
+    it and the faces around the vertices in it are filled in again, which
+    is also the only time the centroid of a face is recomputed. Otherwise
+    the array is built again.
+
+    Each array is only built and kept up to date once asked for. The
+    buffers belong to their object - get them with
+    DLFLObject::overlayBuffers().
+  */
+  class DLFLOverlayBuffers {
+  public :
+    enum Kind {
+      Vertices,                // A point per vertex
+      Edges,                   // A line per edge
+      Centroids,               // A point per face
+      Normals,                 // A line per face from its centroid
+      NumKinds
+    };
+
+    struct Point {
+      float position[3];
+    };
+
+    // A range of points of an array
+    typedef DLFLRenderBuffers::Range Range;
+
+    // The points of one kind of overlay
+    class Array {
+    public :
+      Array();
+
+      // The whole array, including room to spare after count()
+      const std::vector<Point>& points() const { return point_array; }
+      uint count() const { return num_points; }
+
+      // Same as DLFLRenderBuffers::revision, patched, patchedFrom and
+      // patchedRanges - a copy of the array can tell whether it is still
+      // current and what to copy again to bring it up to date
+      unsigned long revision() const { return revision_count; }
+      bool patched() const { return was_patched; }
+      unsigned long patchedFrom() const { return patched_from; }
+      const std::vector<Range>& patchedRanges() const { return patched_ranges; }
+
+    private :
+      friend class DLFLOverlayBuffers;
+
+      // Start over with room for num elements
+      void reset(uint num);
+      // First point of an element, which is added at the end if it is new.
+      // Returns false if the array has no room left.
+      bool place(const void *element, uint& first);
+      // Replace the points of an element with those of the last one
+      void remove(const void *element);
+      // Note points rewritten by a patch
+      void markRange(uint first, uint count);
+      // Done patching (or building), the array is now the given revision
+      void finish(bool patch, unsigned long revision);
+
+      uint per_element;                        // Points per element
+      std::vector<Point> point_array;
+      uint num_points;
+      std::map<const void *, uint> index;      // Element -> position
+      std::vector<const void *> elements;      // Position -> element
+
+      bool built;
+      unsigned long generation;                // Generation of object when updated
+      double length;                           // Length of the normals
+      unsigned long revision_count;
+      bool was_patched;
+      unsigned long patched_from;
+      std::vector<Range> patched_ranges;
+    };
+
+    DLFLOverlayBuffers(DLFLObjectPtr obj);
+
+    // The array of an overlay brought up to date with the object. The
+    // length is that of the normals, for the other overlays it is ignored.
+    const Array& update(Kind kind, double length = 0.0);
+
+    // Throw the arrays away, they are built again on the next update
+    void invalidate();
+
+  private :
+    // Lay out all elements of an array again
+    void rebuild(Kind kind, double length);
+    // Redo the changed elements, returns false if it is better to rebuild
+    bool patch(Kind kind, const DLFLFacePtrArray& faces, const DLFLEdgePtrArray& edges,
+               const DLFLVertexPtrArray& vertices);
+
+    // Fill in the points of an element
+    void fill(Kind kind, const void *element, Point *points) const;
+
+    DLFLObjectPtr object;
+    Array arrays[NumKinds];
+    static unsigned long last_revision;        // Over all arrays
+  };
+
+} // end namespace
+
+#endif /* _DLFL_OVERLAY_BUFFERS_HH_ */
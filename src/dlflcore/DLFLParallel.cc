@@ -0,0 +1,26 @@
+/*** ***/
+
+/**
+ * \file DLFLParallel.cc
+ */
+
+#include "DLFLParallel.h"
+
+namespace DLFL {
+
+  int numThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  void setNumThreads(int num) {
+#ifdef _OPENMP
+    if ( num <= 0 ) num = omp_get_num_procs();
+    omp_set_num_threads(num);
+#endif
+  }
+
+} // end namespace
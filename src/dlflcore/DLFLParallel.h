@@ -0,0 +1,35 @@
+/*** ***/
+
+/**
+ * \file DLFLParallel.h
+ */
+
+#ifndef _DLFL_PARALLEL_HH_
+#define _DLFL_PARALLEL_HH_
+
+// Thread control for the parallel geometry passes of the DLFL operators.
+// The passes are written as OpenMP loops over arrays of element pointers.
+// OpenMP keeps one pool of worker threads which is shared by all operators
+// and is sized from the number of hardware threads. When compiled without
+// OpenMP the pragmas are ignored and everything runs serially.
+//
+// Every parallel pass writes only to the element (or array slot) of its own
+// iteration and reads old geometry, so the results don't depend on the
+// number of threads. Topology changes are always done serially.
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace DLFL {
+
+  // Number of threads used by the parallel passes
+  int numThreads();
+
+  // Set the number of threads used by the parallel passes.
+  // 0 resets to one thread per hardware thread.
+  void setNumThreads(int num = 0);
+
+} // end namespace
+
+#endif /* _DLFL_PARALLEL_HH_ */
@@ -0,0 +1,667 @@
+/*** ***/
+
+/**
+ * \file DLFLPickIndex.cc
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "DLFLPickIndex.h"
+#include "DLFLObject.h"
+#include "DLFLParallel.h"
+
+namespace DLFL {
+
+  /*** Region ***/
+
+  DLFLPickIndex::Region::Region(const double projection[16], const double modelview[16],
+                                const int viewport[4], double x, double y, double w, double h,
+                                bool rnd)
+    : round(rnd) {
+    for (int c=0; c < 4; ++c)
+      for (int r=0; r < 4; ++r) {
+        matrix[c*4+r] = 0.0;
+        for (int k=0; k < 4; ++k) matrix[c*4+r] += projection[k*4+r]*modelview[c*4+k];
+      }
+
+    // The rectangle in normalized device coordinates
+    pixel[0] = 2.0/viewport[2]; pixel[1] = 2.0/viewport[3];
+    center[0] = (x - viewport[0])*pixel[0] - 1.0; center[1] = (y - viewport[1])*pixel[1] - 1.0;
+    radius[0] = 0.5*w*pixel[0]; radius[1] = 0.5*h*pixel[1];
+    setPlanes();
+  }
+
+  DLFLPickIndex::Region::Region(const Region& view, double u, double v)
+    : round(false) {
+    for (int i=0; i < 16; ++i) matrix[i] = view.matrix[i];
+    center[0] = view.center[0] + u*view.radius[0]; center[1] = view.center[1] + v*view.radius[1];
+    for (int i=0; i < 2; ++i) {
+      pixel[i] = view.pixel[i];
+      radius[i] = 0.0005*pixel[i];
+    }
+    setPlanes();
+  }
+
+  void DLFLPickIndex::Region::setPlanes() {
+    double xmin = center[0] - radius[0], xmax = center[0] + radius[0];
+    double ymin = center[1] - radius[1], ymax = center[1] + radius[1];
+
+    // Planes in clip coordinates, then pulled back through the matrix
+    double clip[6][4] = { {  1.0,  0.0,  0.0, -xmin }, { -1.0,  0.0,  0.0, xmax },
+                          {  0.0,  1.0,  0.0, -ymin }, {  0.0, -1.0,  0.0, ymax },
+                          {  0.0,  0.0,  1.0,  1.0  }, {  0.0,  0.0, -1.0, 1.0  } };
+    for (int i=0; i < 6; ++i)
+      for (int j=0; j < 4; ++j) {
+        planes[i][j] = 0.0;
+        for (int r=0; r < 4; ++r) planes[i][j] += clip[i][r]*matrix[j*4+r];
+      }
+  }
+
+  double DLFLPickIndex::Region::depth(const Vector3d& p) const {
+    double z = matrix[2]*p[0] + matrix[6]*p[1] + matrix[10]*p[2] + matrix[14];
+    double w = matrix[3]*p[0] + matrix[7]*p[1] + matrix[11]*p[2] + matrix[15];
+    return z/w;
+  }
+
+  void DLFLPickIndex::Region::project(const Vector3d& p, double q[3]) const {
+    double c[4];
+    for (int r=0; r < 4; ++r)
+      c[r] = matrix[r]*p[0] + matrix[4+r]*p[1] + matrix[8+r]*p[2] + matrix[12+r];
+    q[0] = (c[0]/c[3] - center[0])/radius[0];
+    q[1] = (c[1]/c[3] - center[1])/radius[1];
+    q[2] = c[2]/c[3];
+  }
+
+  static inline double planeDistance(const double plane[4], const Vector3d& p) {
+    return plane[0]*p[0] + plane[1]*p[1] + plane[2]*p[2] + plane[3];
+  }
+
+  // The part [s0,s1] of the segment from a to b (in the coordinates of
+  // Region::project) inside the unit circle, false if there is none
+  static bool clipToCircle(const double a[3], const double b[3], double& s0, double& s1) {
+    double du = b[0] - a[0], dv = b[1] - a[1];
+    double qa = du*du + dv*dv, qb = a[0]*du + a[1]*dv, qc = a[0]*a[0] + a[1]*a[1] - 1.0;
+    if ( qa == 0.0 ) {
+      s0 = 0.0; s1 = 1.0;
+      return qc <= 0.0;
+    }
+    double disc = qb*qb - qa*qc;
+    if ( disc < 0.0 ) return false;
+    disc = sqrt(disc);
+    s0 = std::max(0.0, (-qb - disc)/qa); s1 = std::min(1.0, (-qb + disc)/qa);
+    return s0 <= s1;
+  }
+
+  bool DLFLPickIndex::Region::contains(const Vector3d& p, double& d) const {
+    for (int i=0; i < 6; ++i)
+      if ( planeDistance(planes[i],p) < 0.0 ) return false;
+    if ( round ) {
+      double q[3];
+      project(p,q);
+      if ( q[0]*q[0] + q[1]*q[1] > 1.0 ) return false;
+    }
+    d = depth(p);
+    return true;
+  }
+
+  bool DLFLPickIndex::Region::intersects(const Vector3d& p1, const Vector3d& p2, double& d) const {
+    // Clip the segment to the planes
+    double t0 = 0.0, t1 = 1.0;
+    for (int i=0; i < 6; ++i) {
+      double d1 = planeDistance(planes[i],p1), d2 = planeDistance(planes[i],p2);
+      if ( d1 < 0.0 && d2 < 0.0 ) return false;
+      if ( d1 < 0.0 ) t0 = std::max(t0, d1/(d1-d2));
+      else if ( d2 < 0.0 ) t1 = std::min(t1, d1/(d1-d2));
+      if ( t0 > t1 ) return false;
+    }
+    Vector3d dir = p2 - p1;
+    if ( !round ) {
+      // The depth changes monotonically along the segment
+      d = std::min(depth(p1 + t0*dir), depth(p1 + t1*dir));
+      return true;
+    }
+
+    // On the screen the depth changes linearly along the segment
+    double a[3], b[3], s0, s1;
+    project(p1 + t0*dir,a); project(p1 + t1*dir,b);
+    if ( !clipToCircle(a,b,s0,s1) ) return false;
+    d = std::min(a[2] + s0*(b[2]-a[2]), a[2] + s1*(b[2]-a[2]));
+    return true;
+  }
+
+  bool DLFLPickIndex::Region::intersects(const Vector3d& p1, const Vector3d& p2, const Vector3d& p3,
+                                         double& d) const {
+    // Clip the triangle to the planes, each plane adds at most one corner
+    Vector3d poly[2][9];
+    int num = 3, from = 0;
+    poly[0][0] = p1; poly[0][1] = p2; poly[0][2] = p3;
+    for (int i=0; i < 6; ++i) {
+      const Vector3d *in = poly[from];
+      Vector3d *out = poly[1-from];
+      int numout = 0;
+      double dprev = planeDistance(planes[i],in[num-1]);
+      for (int j=0; j < num; ++j) {
+        const Vector3d& prev = in[(j+num-1)%num];
+        double dcurr = planeDistance(planes[i],in[j]);
+        if ( (dprev < 0.0) != (dcurr < 0.0) )
+          out[numout++] = prev + (dprev/(dprev-dcurr))*(in[j] - prev);
+        if ( dcurr >= 0.0 ) out[numout++] = in[j];
+        dprev = dcurr;
+      }
+      if ( numout == 0 ) return false;
+      num = numout; from = 1-from;
+    }
+    if ( !round ) {
+      // The nearest point of a flat polygon is one of its corners
+      d = depth(poly[from][0]);
+      for (int j=1; j < num; ++j) d = std::min(d, depth(poly[from][j]));
+      return true;
+    }
+
+    // On the screen the depth is linear over the polygon. The nearest point
+    // inside the circle is on an edge or on the circle.
+    double q[9][3], s0, s1;
+    for (int j=0; j < num; ++j) project(poly[from][j],q[j]);
+    bool found = false;
+    for (int j=0; j < num; ++j) {
+      const double *a = q[j], *b = q[(j+1)%num];
+      if ( !clipToCircle(a,b,s0,s1) ) continue;
+      double dj = std::min(a[2] + s0*(b[2]-a[2]), a[2] + s1*(b[2]-a[2]));
+      if ( !found || dj < d ) d = dj;
+      found = true;
+    }
+
+    // The polygon is convex, find its plane from its widest corners
+    int j1 = 1, j2 = 2;
+    double area = 0.0;
+    for (int j=1; j+1 < num; ++j) {
+      double aj = (q[j][0]-q[0][0])*(q[j+1][1]-q[0][1]) - (q[j][1]-q[0][1])*(q[j+1][0]-q[0][0]);
+      if ( fabs(aj) > fabs(area) ) { area = aj; j1 = j; j2 = j+1; }
+    }
+    if ( area == 0.0 ) return found;
+    double du1 = q[j1][0]-q[0][0], dv1 = q[j1][1]-q[0][1], dz1 = q[j1][2]-q[0][2];
+    double du2 = q[j2][0]-q[0][0], dv2 = q[j2][1]-q[0][1], dz2 = q[j2][2]-q[0][2];
+    double gu = (dz1*dv2 - dz2*dv1)/area, gv = (du1*dz2 - du2*dz1)/area;
+
+    // The nearest point of the circle, if it is inside the polygon
+    double glen = sqrt(gu*gu + gv*gv);
+    double u = ( glen > 0.0 ) ? -gu/glen : 0.0, v = ( glen > 0.0 ) ? -gv/glen : 0.0;
+    for (int j=0; j < num; ++j) {
+      const double *a = q[j], *b = q[(j+1)%num];
+      double side = (b[0]-a[0])*(v-a[1]) - (b[1]-a[1])*(u-a[0]);
+      if ( (area > 0.0) ? (side < 0.0) : (side > 0.0) ) return found;
+    }
+    double dc = q[0][2] + gu*(u-q[0][0]) + gv*(v-q[0][1]);
+    if ( !found || dc < d ) d = dc;
+    return true;
+  }
+
+  bool DLFLPickIndex::Region::overlaps(const double lo[3], const double hi[3]) const {
+    for (int i=0; i < 6; ++i) {
+      // The corner of the box farthest inside the plane
+      double dist = planes[i][3];
+      for (int j=0; j < 3; ++j) dist += planes[i][j]*( planes[i][j] >= 0.0 ? hi[j] : lo[j] );
+      if ( dist < 0.0 ) return false;
+    }
+    return true;
+  }
+
+  double DLFLPickIndex::Region::orientation(const Vector3d& p1, const Vector3d& p2,
+                                            const Vector3d& p3) const {
+    const Vector3d *p[3] = { &p1, &p2, &p3 };
+    double c[3][3];                            // x, y and w in clip coordinates
+    for (int i=0; i < 3; ++i) {
+      const Vector3d& q = *p[i];
+      c[i][0] = matrix[0]*q[0] + matrix[4]*q[1] + matrix[8]*q[2] + matrix[12];
+      c[i][1] = matrix[1]*q[0] + matrix[5]*q[1] + matrix[9]*q[2] + matrix[13];
+      c[i][2] = matrix[3]*q[0] + matrix[7]*q[1] + matrix[11]*q[2] + matrix[15];
+    }
+    return c[0][0]*(c[1][1]*c[2][2] - c[1][2]*c[2][1])
+      - c[0][1]*(c[1][0]*c[2][2] - c[1][2]*c[2][0])
+      + c[0][2]*(c[1][0]*c[2][1] - c[1][1]*c[2][0]);
+  }
+
+  /*** Index ***/
+
+  DLFLPickIndex::DLFLPickIndex(DLFLObjectPtr obj)
+    : object(obj) {
+  }
+
+  void DLFLPickIndex::invalidate() {
+    for (int i=0; i < NumKinds; ++i) {
+      Tree& tree = trees[i];
+      tree.built = false;
+      tree.elements.clear(); tree.index.clear(); tree.boxes.clear();
+      tree.order.clear(); tree.leaf.clear(); tree.nodes.clear();
+    }
+  }
+
+  DLFLPickIndex::Tree& DLFLPickIndex::update(Kind kind) {
+    Tree& tree = trees[kind];
+    if ( tree.built ) {
+      if ( tree.generation == object->getGeneration() ) return tree;
+      DLFLFacePtrArray faces;
+      DLFLEdgePtrArray edges;
+      DLFLVertexPtrArray vertices;
+      if ( object->changesSince(tree.generation,faces,edges,vertices) &&
+           refit(kind,faces,edges,vertices) ) {
+        tree.generation = object->getGeneration();
+        return tree;
+      }
+    }
+    rebuild(kind);
+    return tree;
+  }
+
+  void DLFLPickIndex::elementBox(Kind kind, const void *element, double *box) const {
+    for (int j=0; j < 3; ++j) { box[j] = 1.0e300; box[3+j] = -1.0e300; }
+    DLFLVertexPtr vp[2];
+    int num = 0;
+    if ( kind == Vertices ) {
+      vp[0] = (DLFLVertexPtr)element; num = 1;
+    } else if ( kind == Edges ) {
+      ((DLFLEdgePtr)element)->getVertexPointers(vp[0],vp[1]); num = 2;
+    } else {
+      DLFLFaceVertexPtr head = ((DLFLFacePtr)element)->front(), current = head;
+      if ( head ) do {
+        const Vector3d& p = current->vertex->coords;
+        for (int j=0; j < 3; ++j) {
+          box[j] = std::min(box[j],p[j]); box[3+j] = std::max(box[3+j],p[j]);
+        }
+        current = current->next();
+      } while ( current != head );
+    }
+    for (int i=0; i < num; ++i)
+      for (int j=0; j < 3; ++j) {
+        box[j] = std::min(box[j],vp[i]->coords[j]); box[3+j] = std::max(box[3+j],vp[i]->coords[j]);
+      }
+  }
+
+  void DLFLPickIndex::rebuild(Kind kind) {
+    Tree& tree = trees[kind];
+    tree.generation = object->getGeneration();
+    tree.elements.clear(); tree.index.clear(); tree.nodes.clear();
+
+    // Elements in the order of their lists
+    if ( kind == Vertices ) {
+      tree.elements.reserve(object->num_vertices());
+      DLFLVertexPtrList::const_iterator vf = object->getVertexList().begin(),
+                                        vl = object->getVertexList().end();
+      while ( vf != vl ) { tree.elements.push_back(*vf); ++vf; }
+    } else if ( kind == Edges ) {
+      tree.elements.reserve(object->num_edges());
+      DLFLEdgePtrList::const_iterator ef = object->getEdgeList().begin(),
+                                      el = object->getEdgeList().end();
+      while ( ef != el ) { tree.elements.push_back(*ef); ++ef; }
+    } else {
+      tree.elements.reserve(object->num_faces());
+      DLFLFacePtrList::iterator ff = object->beginFace(), fl = object->endFace();
+      while ( ff != fl ) { tree.elements.push_back(*ff); ++ff; }
+    }
+    int num = tree.elements.size();
+    tree.index.resize(num);
+    for (int i=0; i < num; ++i) tree.index[i] = std::make_pair(tree.elements[i],i);
+    std::sort(tree.index.begin(),tree.index.end());
+
+    tree.boxes.resize(6*num);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num; ++i)
+      elementBox(kind,tree.elements[i],&tree.boxes[6*i]);
+
+    // Elements which are close together are close in the order of their
+    // Morton codes, the hierarchy splits that order in halves
+    double lo[3] = { 1.0e300, 1.0e300, 1.0e300 }, hi[3] = { -1.0e300, -1.0e300, -1.0e300 };
+    for (int i=0; i < num; ++i)
+      for (int j=0; j < 3; ++j) {
+        double center = tree.boxes[6*i+j] + tree.boxes[6*i+3+j];
+        lo[j] = std::min(lo[j],center); hi[j] = std::max(hi[j],center);
+      }
+    vector< pair<uint,int> > keys(num);
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < num; ++i) {
+      uint code = 0;
+      for (int j=0; j < 3; ++j) {
+        double extent = hi[j] - lo[j];
+        uint cell = ( extent > 0.0 ) ?
+          (uint)(1023.0*(tree.boxes[6*i+j] + tree.boxes[6*i+3+j] - lo[j])/extent) : 0;
+        for (int bit=0; bit < 10; ++bit) code |= ((cell >> bit) & 1) << (3*bit + j);
+      }
+      keys[i] = std::make_pair(code,i);
+    }
+    std::sort(keys.begin(),keys.end());
+
+    tree.order.resize(num);
+    for (int i=0; i < num; ++i) tree.order[i] = keys[i].second;
+    tree.leaf.assign(num,0);
+    if ( num > 0 ) {
+      tree.nodes.reserve(num/2 + 1);
+      Node root;
+      root.parent = -1; root.first = 0; root.count = num;
+      tree.nodes.push_back(root);
+      split(tree,0,0,num);
+    }
+    tree.built = true;
+  }
+
+  void DLFLPickIndex::split(Tree& tree, int node, int first, int count) {
+    if ( count <= 4 ) {
+      tree.nodes[node].first = first; tree.nodes[node].count = count;
+      for (int i=first; i < first+count; ++i) tree.leaf[tree.order[i]] = node;
+      fitNode(tree,node);
+      return;
+    }
+
+    int half = count/2;
+    int left = tree.nodes.size();
+    Node child;
+    child.parent = node; child.first = 0; child.count = 0;
+    tree.nodes.push_back(child); tree.nodes.push_back(child);
+    tree.nodes[node].first = left; tree.nodes[node].count = 0;
+    split(tree,left,first,half);
+    split(tree,left+1,first+half,count-half);
+    fitNode(tree,node);
+  }
+
+  void DLFLPickIndex::fitNode(Tree& tree, int node) {
+    Node& n = tree.nodes[node];
+    for (int j=0; j < 3; ++j) { n.lo[j] = 1.0e300; n.hi[j] = -1.0e300; }
+    if ( n.count > 0 ) {
+      for (int i=n.first; i < n.first+n.count; ++i) {
+        const double *box = &tree.boxes[6*tree.order[i]];
+        for (int j=0; j < 3; ++j) {
+          n.lo[j] = std::min(n.lo[j],box[j]); n.hi[j] = std::max(n.hi[j],box[3+j]);
+        }
+      }
+    } else {
+      for (int c=n.first; c < n.first+2; ++c)
+        for (int j=0; j < 3; ++j) {
+          n.lo[j] = std::min(n.lo[j],tree.nodes[c].lo[j]); n.hi[j] = std::max(n.hi[j],tree.nodes[c].hi[j]);
+        }
+    }
+  }
+
+  bool DLFLPickIndex::refit(Kind kind, const DLFLFacePtrArray& faces, const DLFLEdgePtrArray& edges,
+                            const DLFLVertexPtrArray& vertices) {
+    Tree& tree = trees[kind];
+
+    // The elements of this kind which changed. Moving a vertex moves its
+    // edges and faces.
+    vector<const void *> changed;
+    if ( kind == Vertices ) {
+      changed.assign(vertices.begin(),vertices.end());
+    } else if ( kind == Edges ) {
+      changed.assign(edges.begin(),edges.end());
+      DLFLEdgePtrArray around;
+      for (int i=0; i < (int)vertices.size(); ++i) {
+        if ( !object->hasVertex(vertices[i]) ) continue;
+        vertices[i]->getEdges(around);
+        changed.insert(changed.end(),around.begin(),around.end());
+      }
+    } else {
+      changed.assign(faces.begin(),faces.end());
+      DLFLFacePtrArray around;
+      for (int i=0; i < (int)vertices.size(); ++i) {
+        if ( !object->hasVertex(vertices[i]) ) continue;
+        vertices[i]->getFaces(around);
+        changed.insert(changed.end(),around.begin(),around.end());
+      }
+    }
+    std::sort(changed.begin(),changed.end());
+    changed.erase(std::unique(changed.begin(),changed.end()),changed.end());
+    if ( changed.size() > tree.elements.size()/4 + 256 ) return false;
+
+    // Elements added or removed, the hierarchy has to be built again
+    vector<int> positions;
+    for (int i=0; i < (int)changed.size(); ++i) {
+      bool alive;
+      if ( kind == Vertices ) alive = object->hasVertex((DLFLVertexPtr)changed[i]);
+      else if ( kind == Edges ) alive = object->hasEdge((DLFLEdgePtr)changed[i]);
+      else alive = object->hasFace((DLFLFacePtr)changed[i]);
+      vector< pair<const void *,int> >::const_iterator it =
+        std::lower_bound(tree.index.begin(),tree.index.end(),std::make_pair(changed[i],-1));
+      if ( !alive || it == tree.index.end() || it->first != changed[i] ) return false;
+      positions.push_back(it->second);
+    }
+
+    // New boxes, then the nodes above them
+    for (int i=0; i < (int)positions.size(); ++i)
+      elementBox(kind,changed[i],&tree.boxes[6*positions[i]]);
+    for (int i=0; i < (int)positions.size(); ++i)
+      for (int node = tree.leaf[positions[i]]; node >= 0; node = tree.nodes[node].parent)
+        fitNode(tree,node);
+    return true;
+  }
+
+  bool DLFLPickIndex::hit(Kind kind, const void *element, const Region& region, Culling culling,
+                          double& depth) const {
+    if ( kind == Vertices )
+      return region.contains(((DLFLVertexPtr)element)->coords,depth);
+
+    if ( kind == Edges ) {
+      DLFLVertexPtr vp1, vp2;
+      ((DLFLEdgePtr)element)->getVertexPointers(vp1,vp2);
+      return region.intersects(vp1->coords,vp2->coords,depth);
+    }
+
+    // Faces are drawn as points, lines or triangle fans
+    DLFLFacePtr fp = (DLFLFacePtr)element;
+    DLFLFaceVertexPtr head = fp->front();
+    if ( head == NULL ) return false;
+    const Vector3d& p0 = head->vertex->coords;
+    DLFLFaceVertexPtr prev = head->next(), curr = prev->next();
+    if ( prev == head ) return region.contains(p0,depth);
+    if ( curr == head ) return region.intersects(p0,prev->vertex->coords,depth);
+
+    if ( culling != NoCulling ) {
+      double area = 0.0;
+      for (DLFLFaceVertexPtr p = prev, c = curr; c != head; p = c, c = c->next())
+        area += region.orientation(p0,p->vertex->coords,c->vertex->coords);
+      if ( (culling == CullBack) == (area <= 0.0) ) return false;
+    }
+
+    bool found = false;
+    double d;
+    while ( curr != head ) {
+      if ( region.intersects(p0,prev->vertex->coords,curr->vertex->coords,d) ) {
+        if ( !found || d < depth ) depth = d;
+        found = true;
+      }
+      prev = curr; curr = curr->next();
+    }
+    return found;
+  }
+
+  void DLFLPickIndex::pick(Kind kind, const Region& region, Culling culling, bool nearest, bool visible,
+                           std::vector<const void *>& hits) {
+    Tree& tree = update(kind);
+    hits.clear();
+    if ( tree.nodes.empty() ) return;
+
+    vector<int> positions;
+    int best = -1;
+    double bestdepth = 0.0, depth;
+    vector<int> stack;
+    stack.push_back(0);
+    while ( !stack.empty() ) {
+      const Node& node = tree.nodes[stack.back()];
+      stack.pop_back();
+      if ( !region.overlaps(node.lo,node.hi) ) continue;
+      if ( node.count == 0 ) {
+        stack.push_back(node.first); stack.push_back(node.first+1);
+        continue;
+      }
+      for (int i=node.first; i < node.first+node.count; ++i) {
+        int position = tree.order[i];
+        if ( !hit(kind,tree.elements[position],region,culling,depth) ) continue;
+        if ( !nearest ) positions.push_back(position);
+        else if ( best < 0 || depth < bestdepth ) { best = position; bestdepth = depth; }
+      }
+    }
+    if ( best >= 0 ) positions.push_back(best);
+
+    if ( visible && !positions.empty() ) {
+      update(Faces);
+      int num = positions.size();
+      vector<char> seen(num);
+#pragma omp parallel for schedule(dynamic,64)
+      for (int i=0; i < num; ++i)
+        seen[i] = this->visible(kind,tree.elements[positions[i]],region);
+      int kept = 0;
+      for (int i=0; i < num; ++i)
+        if ( seen[i] ) positions[kept++] = positions[i];
+      positions.resize(kept);
+    }
+
+    // In the order of the lists of the object
+    std::sort(positions.begin(),positions.end());
+    for (int i=0; i < (int)positions.size(); ++i) hits.push_back(tree.elements[positions[i]]);
+  }
+
+  bool DLFLPickIndex::visible(Kind kind, const void *element, const Region& region) const {
+    // Points of the element to look at, and the faces it lies on which
+    // can't hide it. The points of edges and faces keep away from the
+    // corners, where the faces around them meet.
+    vector<Vector3d> points;
+    DLFLFacePtrArray except;
+    if ( kind == Vertices ) {
+      DLFLVertexPtr vp = (DLFLVertexPtr)element;
+      points.push_back(vp->coords);
+      vp->getFaces(except);
+    } else if ( kind == Edges ) {
+      DLFLEdgePtr ep = (DLFLEdgePtr)element;
+      DLFLVertexPtr vp1, vp2;
+      DLFLFacePtr fp1, fp2;
+      ep->getVertexPointers(vp1,vp2);
+      ep->getFacePointers(fp1,fp2);
+      for (int i=0; i < 10; ++i) {
+        double t = 0.05 + 0.1*i;
+        points.push_back((1.0-t)*vp1->coords + t*vp2->coords);
+      }
+      except.push_back(fp1); except.push_back(fp2);
+    } else {
+      DLFLFaceVertexPtr head = ((DLFLFacePtr)element)->front(), current = head;
+      Vector3d centroid;
+      if ( head ) do {
+        points.push_back(current->vertex->coords);
+        centroid += current->vertex->coords;
+        current = current->next();
+      } while ( current != head );
+      if ( !points.empty() ) {
+        centroid /= points.size();
+        for (int i=0; i < (int)points.size(); ++i) points[i] = 0.9*points[i] + 0.1*centroid;
+        points.push_back(centroid);
+      }
+      except.push_back((DLFLFacePtr)element);
+    }
+    std::sort(except.begin(),except.end());
+
+    // Look along the lines of sight through those points in the region and
+    // through a grid over it. Seen if it is in front on one of them. An
+    // edge which crosses the region between its points is kept.
+    vector< pair<double,double> > sights;
+    double q[3], depth;
+    for (int i=0; i < (int)points.size(); ++i)
+      if ( region.contains(points[i],depth) ) {
+        region.project(points[i],q);
+        sights.push_back(std::make_pair(q[0],q[1]));
+      }
+    if ( kind == Faces )
+      for (int i=-2; i <= 2; ++i)
+        for (int j=-2; j <= 2; ++j)
+          if ( !region.isRound() || i*i + j*j <= 6 ) sights.push_back(std::make_pair(0.4*i,0.4*j));
+    bool crossed = false;
+    for (int i=0; i < (int)sights.size(); ++i) {
+      Region sight(region,sights[i].first,sights[i].second);
+      if ( !hit(kind,element,sight,NoCulling,depth) ) continue;
+      if ( !hidden(sight,depth,except) ) return true;
+      crossed = true;
+    }
+    return kind == Edges && !crossed;
+  }
+
+  bool DLFLPickIndex::hidden(const Region& sight, double depth, const DLFLFacePtrArray& except) const {
+    const Tree& tree = trees[Faces];
+    if ( tree.nodes.empty() ) return false;
+
+    double limit = depth - 1.0e-7, d;
+    vector<int> stack;
+    stack.push_back(0);
+    while ( !stack.empty() ) {
+      const Node& node = tree.nodes[stack.back()];
+      stack.pop_back();
+      if ( !sight.overlaps(node.lo,node.hi) ) continue;
+      if ( node.count == 0 ) {
+        stack.push_back(node.first); stack.push_back(node.first+1);
+        continue;
+      }
+      for (int i=node.first; i < node.first+node.count; ++i) {
+        DLFLFacePtr fp = (DLFLFacePtr)tree.elements[tree.order[i]];
+        if ( std::binary_search(except.begin(),except.end(),fp) ) continue;
+        if ( hit(Faces,fp,sight,NoCulling,d) && d < limit ) return true;
+      }
+    }
+    return false;
+  }
+
+  bool DLFLPickIndex::isHidden(const Region& region, const Vector3d& p, DLFLFacePtrArray own) {
+    update(Faces);
+    double q[3];
+    region.project(p,q);
+    std::sort(own.begin(),own.end());
+    return hidden(Region(region,q[0],q[1]),q[2],own);
+  }
+
+  DLFLVertexPtr DLFLPickIndex::pickVertex(const Region& region) {
+    vector<const void *> hits;
+    pick(Vertices,region,NoCulling,true,false,hits);
+    return hits.empty() ? NULL : (DLFLVertexPtr)hits[0];
+  }
+
+  DLFLEdgePtr DLFLPickIndex::pickEdge(const Region& region) {
+    vector<const void *> hits;
+    pick(Edges,region,NoCulling,true,false,hits);
+    return hits.empty() ? NULL : (DLFLEdgePtr)hits[0];
+  }
+
+  DLFLFacePtr DLFLPickIndex::pickFace(const Region& region, Culling culling) {
+    vector<const void *> hits;
+    pick(Faces,region,culling,true,false,hits);
+    return hits.empty() ? NULL : (DLFLFacePtr)hits[0];
+  }
+
+  void DLFLPickIndex::pickVertices(const Region& region, DLFLVertexPtrArray& vparray, bool visible) {
+    vector<const void *> hits;
+    pick(Vertices,region,NoCulling,false,visible,hits);
+    vparray.clear();
+    for (int i=0; i < (int)hits.size(); ++i) vparray.push_back((DLFLVertexPtr)hits[i]);
+  }
+
+  void DLFLPickIndex::pickEdges(const Region& region, DLFLEdgePtrArray& eparray, bool visible) {
+    vector<const void *> hits;
+    pick(Edges,region,NoCulling,false,visible,hits);
+    eparray.clear();
+    for (int i=0; i < (int)hits.size(); ++i) eparray.push_back((DLFLEdgePtr)hits[i]);
+  }
+
+  void DLFLPickIndex::pickFaces(const Region& region, DLFLFacePtrArray& fparray, Culling culling,
+                                bool visible) {
+    vector<const void *> hits;
+    pick(Faces,region,culling,false,visible,hits);
+    fparray.clear();
+    for (int i=0; i < (int)hits.size(); ++i) fparray.push_back((DLFLFacePtr)hits[i]);
+  }
+
+  DLFLFaceVertexPtr DLFLPickIndex::pickCorner(DLFLFacePtr fp, const Region& region) {
+    DLFLFaceVertexPtr best = NULL;
+    double bestdepth = 0.0, depth;
+    DLFLFaceVertexPtr head = fp->front(), current = head;
+    if ( head ) do {
+      if ( region.contains(current->vertex->coords,depth) && (best == NULL || depth < bestdepth) ) {
+        best = current; bestdepth = depth;
+      }
+      current = current->next();
+    } while ( current != head );
+    return best;
+  }
+
+} // end namespace
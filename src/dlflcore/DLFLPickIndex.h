@@ -0,0 +1,163 @@
+/*** ***/
+
+/**
+ * \file DLFLPickIndex.h
+ */
+
+#ifndef _DLFL_PICK_INDEX_HH_
+#define _DLFL_PICK_INDEX_HH_
+
+#include <utility>
+#include <vector>
+#include "DLFLCommon.h"
+
+namespace DLFL {
+
+  /*
+    Picking of vertices, edges, faces and corners under the mouse without
+    OpenGL. It finds what glRenderMode(GL_SELECT) with gluPickMatrix would
+    have: the elements drawn (as points, lines and triangle fans) into a
+    small rectangle of the window, and of those the nearest one.
+
+    The vertices, edges and faces each have a bounding volume hierarchy,
+    built when first picked from. When the elements of the object stay the
+    same and only move, the boxes of the changed elements (from the change
+    journal of the object, see DLFLObject::changesSince) and the boxes
+    above them are refit. When elements are added or removed the hierarchy
+    is built again. The index belongs to its object - get it with
+    DLFLObject::pickIndex().
+  */
+  class DLFLPickIndex {
+  public :
+    /*
+      The part of the view inside a rectangle of the window - w by h pixels
+      centered at (x,y), same as gluPickMatrix - between the near and far
+      planes. If round it is the ellipse inside the rectangle instead, as
+      the brush shows it. The matrices are column major, as from
+      glGetDoublev, and the points are in the coordinates the modelview
+      matrix applies to.
+    */
+    class Region {
+    public :
+      Region(const double projection[16], const double modelview[16], const int viewport[4],
+             double x, double y, double w, double h, bool round = false);
+      // The line of sight through a point (u,v) of another region, a
+      // thousandth of a pixel across
+      Region(const Region& view, double u, double v);
+
+      // Whether a point, segment or triangle is in the region, and the
+      // depth (-1 near to 1 far) of its nearest point in it
+      bool contains(const Vector3d& p, double& depth) const;
+      bool intersects(const Vector3d& p1, const Vector3d& p2, double& depth) const;
+      bool intersects(const Vector3d& p1, const Vector3d& p2, const Vector3d& p3,
+                      double& depth) const;
+      // False if the box is certainly outside the region
+      bool overlaps(const double lo[3], const double hi[3]) const;
+
+      // Twice the signed area of a triangle on the screen, times the w
+      // of its corners. Positive for counter-clockwise triangles in front
+      // of the eye.
+      double orientation(const Vector3d& p1, const Vector3d& p2, const Vector3d& p3) const;
+
+      bool isRound() const { return round; }
+
+      // A point in front of the eye on the screen, relative to the
+      // rectangle (-1 to 1 across it), and its depth
+      void project(const Vector3d& p, double q[3]) const;
+
+    private :
+      void setPlanes();
+      // Depth of a point in the region
+      double depth(const Vector3d& p) const;
+
+      double matrix[16];                       // projection * modelview
+      double planes[6][4];                     // Inside where a.p + d >= 0
+      double center[2], radius[2];             // Rectangle on the screen
+      double pixel[2];                         // Size of a pixel on the screen
+      bool round;
+    };
+
+    // Which faces can't be picked, as with GL_CULL_FACE
+    enum Culling { NoCulling, CullBack, CullFront };
+
+    DLFLPickIndex(DLFLObjectPtr obj);
+
+    // The nearest element in the region, NULL if there is none
+    DLFLVertexPtr pickVertex(const Region& region);
+    DLFLEdgePtr pickEdge(const Region& region);
+    DLFLFacePtr pickFace(const Region& region, Culling culling = NoCulling);
+
+    // All elements in the region. If visible, only those not hidden behind
+    // other faces at one of a few points in the region: along an edge,
+    // near the corners and at the middle of a face and on a grid over the
+    // region.
+    void pickVertices(const Region& region, DLFLVertexPtrArray& vparray, bool visible = false);
+    void pickEdges(const Region& region, DLFLEdgePtrArray& eparray, bool visible = false);
+    void pickFaces(const Region& region, DLFLFacePtrArray& fparray, Culling culling = NoCulling,
+                   bool visible = false);
+
+    // The nearest corner of a face in the region
+    static DLFLFaceVertexPtr pickCorner(DLFLFacePtr fp, const Region& region);
+
+    // Whether a point is behind one of the faces of the object, other than
+    // the given ones it lies on, seen from the eye through the region
+    bool isHidden(const Region& region, const Vector3d& p, DLFLFacePtrArray own);
+
+    // Throw the hierarchies away, they are built again on the next pick
+    void invalidate();
+
+  private :
+    enum Kind { Vertices, Edges, Faces, NumKinds };
+
+    struct Node {
+      double lo[3], hi[3];
+      int first;                               // Elements of a leaf, children otherwise
+      int count;                               // Elements of a leaf, 0 otherwise
+      int parent;
+    };
+
+    struct Tree {
+      Tree() : built(false), generation(0) {}
+
+      bool built;
+      unsigned long generation;                // Generation of object when updated
+      std::vector<const void *> elements;
+      std::vector< std::pair<const void *, int> > index; // Element -> position, sorted
+      std::vector<double> boxes;               // 6 per element, lo then hi
+      std::vector<int> order;                  // Elements in leaf order
+      std::vector<int> leaf;                   // Leaf of each element
+      std::vector<Node> nodes;                 // Root first
+    };
+
+    // Bring a hierarchy up to date with the object
+    Tree& update(Kind kind);
+    void rebuild(Kind kind);
+    // Refit the boxes of the changed elements, false if it has to be rebuilt
+    bool refit(Kind kind, const DLFLFacePtrArray& faces, const DLFLEdgePtrArray& edges,
+               const DLFLVertexPtrArray& vertices);
+    // Split the elements order[first..first+count) under a node
+    void split(Tree& tree, int node, int first, int count);
+    void fitNode(Tree& tree, int node);
+
+    void elementBox(Kind kind, const void *element, double *box) const;
+    bool hit(Kind kind, const void *element, const Region& region, Culling culling,
+             double& depth) const;
+
+    // Walk the hierarchy. With nearest only the nearest hit is kept, with
+    // visible only the hits which can be seen.
+    void pick(Kind kind, const Region& region, Culling culling, bool nearest, bool visible,
+              std::vector<const void *>& hits);
+
+    // Whether some part of an element in the region can be seen
+    bool visible(Kind kind, const void *element, const Region& region) const;
+    // Whether a face other than the given (sorted) ones is in front of a
+    // depth along a line of sight. The faces must be up to date.
+    bool hidden(const Region& sight, double depth, const DLFLFacePtrArray& except) const;
+
+    DLFLObjectPtr object;
+    Tree trees[NumKinds];
+  };
+
+} // end namespace
+
+#endif /* _DLFL_PICK_INDEX_HH_ */
@@ -0,0 +1,56 @@
+/*** ***/
+
+/**
+ * \file DLFLProgress.cc
+ */
+
+#include "DLFLProgress.h"
+
+namespace DLFL {
+
+  static DLFLProgress *current_progress = NULL;
+  static bool cancelled = false;
+  static double range_start = 0.0, range_size = 1.0;
+  static double last_fraction = -1.0;
+
+  void setProgress(DLFLProgress *progress) {
+    current_progress = progress;
+    cancelled = false;
+    range_start = 0.0; range_size = 1.0;
+    last_fraction = -1.0;
+  }
+
+  DLFLProgress* getProgress() {
+    return current_progress;
+  }
+
+  bool reportProgress(size_t done, size_t total) {
+    if ( current_progress == NULL ) return true;
+    if ( cancelled ) return false;
+
+    double fraction = range_start;
+    if ( total > 0 ) fraction += range_size * double(done) / double(total);
+
+    // Only call back for visible changes, reportProgress is called per element
+    if ( fraction - last_fraction < 0.001 && done < total ) return true;
+    last_fraction = fraction;
+
+    if ( !current_progress->update(fraction) ) cancelled = true;
+    return !cancelled;
+  }
+
+  bool progressCancelled() {
+    return cancelled;
+  }
+
+  DLFLProgressRange::DLFLProgressRange(double start, double size)
+    : oldstart(range_start), oldsize(range_size) {
+    range_start = oldstart + start*oldsize;
+    range_size = size*oldsize;
+  }
+
+  DLFLProgressRange::~DLFLProgressRange() {
+    range_start = oldstart; range_size = oldsize;
+  }
+
+} // end namespace
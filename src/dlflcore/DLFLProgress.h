@@ -0,0 +1,63 @@
+/*** ***/
+
+/**
+ * \file DLFLProgress.h
+ */
+
+#ifndef _DLFL_PROGRESS_HH_
+#define _DLFL_PROGRESS_HH_
+
+#include <cstddef>
+
+namespace DLFL {
+
+  /*
+    Progress reporting and cancellation for long running operations.
+
+    An application derives from DLFLProgress and installs an instance with
+    setProgress() for the duration of an operation. The operators call
+    reportProgress() from their main loops. Once update() returns false the
+    operation is cancelled: every further reportProgress() returns false
+    and the operators return as soon as they can. A cancelled operation
+    leaves the object in an undefined state, the caller has to restore it
+    (for example from the undo list).
+
+    The operators may run on a different thread than the application (but
+    only one operation at a time), so update() must be thread safe.
+  */
+  class DLFLProgress {
+  public :
+    virtual ~DLFLProgress() {}
+
+    // fraction is in [0,1]. Return false to cancel the operation.
+    virtual bool update(double fraction) = 0;
+  };
+
+  // Install the progress reporter for the following operations. NULL disables reporting.
+  void setProgress(DLFLProgress *progress);
+  DLFLProgress* getProgress();
+
+  // Report that done out of total units of the current operation (or range) are
+  // finished. Returns false if the operation has been cancelled.
+  bool reportProgress(size_t done, size_t total);
+
+  // Has the current operation been cancelled?
+  bool progressCancelled();
+
+  /*
+    Operations made up of other operations (e.g. several levels of subdivision)
+    give each part a range of the total. Progress reported while the range
+    exists is mapped into [start,start+size] of the enclosing range.
+  */
+  class DLFLProgressRange {
+  public :
+    DLFLProgressRange(double start, double size);
+    ~DLFLProgressRange();
+
+  private :
+    double oldstart, oldsize;
+  };
+
+} // end namespace
+
+#endif /* _DLFL_PROGRESS_HH_ */
@@ -0,0 +1,258 @@
+/*** ***/
+
+/**
+ * \file DLFLRenderBuffers.cc
+ */
+
+#include <algorithm>
+#include "DLFLRenderBuffers.h"
+#include "DLFLObject.h"
+#include "DLFLParallel.h"
+
+namespace DLFL {
+
+  unsigned long DLFLRenderBuffers::last_revision = 0;
+
+  static bool lessRangeFirst(const DLFLRenderBuffers::Range& r1,
+                             const DLFLRenderBuffers::Range& r2) {
+    return r1.first < r2.first;
+  }
+
+  DLFLRenderBuffers::DLFLRenderBuffers(DLFLObjectPtr obj)
+    : object(obj), generation(0), built(false), revision_count(0),
+      color_source(NoColor), wasted(0), was_patched(false), patched_from(0) {
+    for (int i=0; i < 4; ++i) base_color[i] = 1.0;
+  }
+
+  void DLFLRenderBuffers::invalidate() {
+    built = false;
+    vertex_array.clear();
+    batch_array.clear();
+    small_faces.clear();
+    slots.clear();
+    batch_ends.clear();
+    holes.clear();
+    wasted = 0;
+  }
+
+  bool DLFLRenderBuffers::update(ColorSource source, const double base[4]) {
+    bool same_color = ( source == color_source );
+    for (int i=0; same_color && i < 4; ++i) same_color = ( base[i] == base_color[i] );
+    if ( built && same_color ) {
+      if ( generation == object->getGeneration() ) return false;
+      DLFLFacePtrArray faces;
+      DLFLEdgePtrArray edges;
+      DLFLVertexPtrArray vertices;
+      if ( object->changesSince(generation,faces,edges,vertices) && patch(faces,vertices) ) {
+        generation = object->getGeneration();
+        return true;
+      }
+    }
+    color_source = source;
+    for (int i=0; i < 4; ++i) base_color[i] = base[i];
+    rebuild();
+    return true;
+  }
+
+  void DLFLRenderBuffers::rebuild() {
+    generation = object->getGeneration();
+    invalidate();
+
+    // Lay out the batches and find where the triangles of each face start
+    DLFLFacePtrArray faces;
+    vector<uint> offsets;
+    uint num_vertices = 0;
+    faces.reserve(object->num_faces()); offsets.reserve(object->num_faces());
+    DLFLMaterialPtrList::iterator mf = object->beginMaterial(), ml = object->endMaterial();
+    while ( mf != ml ) {
+      Batch batch;
+      batch.material = *mf; batch.first = num_vertices;
+      DLFLFacePtrList::iterator ff = (*mf)->faces.begin(), fl = (*mf)->faces.end();
+      while ( ff != fl ) {
+        uint size = (*ff)->size();
+        if ( size < 3 ) small_faces.push_back(*ff);
+        else {
+          Slot slot = { num_vertices, 3*(size-2), (uint)batch_array.size() };
+          slots[*ff] = slot;
+          faces.push_back(*ff); offsets.push_back(num_vertices);
+          num_vertices += slot.count;
+        }
+        ++ff;
+      }
+      batch.count = num_vertices - batch.first;
+      // Room for the faces added later
+      num_vertices += 3*(batch.count/48) + 3*64;
+      batch_array.push_back(batch);
+      batch_ends.push_back(num_vertices);
+      ++mf;
+    }
+    holes.resize(batch_array.size());
+
+    // Every face has its own range of the array
+    vertex_array.resize(num_vertices);
+    int numfaces = faces.size();
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < numfaces; ++i)
+      fillFace(faces[i],&vertex_array[offsets[i]]);
+
+    built = true;
+    was_patched = false;
+    patched_ranges.clear();
+    revision_count = ++last_revision;
+  }
+
+  bool DLFLRenderBuffers::patch(DLFLFacePtrArray& faces, const DLFLVertexPtrArray& vertices) {
+    // The faces around a moved vertex changed with it
+    DLFLFaceVertexPtrArray corners;
+    for (int i=0; i < (int)vertices.size(); ++i) {
+      if ( !object->hasVertex(vertices[i]) ) continue;
+      vertices[i]->getFaceVertices(corners);
+      for (int j=0; j < (int)corners.size(); ++j)
+        faces.push_back(corners[j]->getFacePtr());
+    }
+    std::sort(faces.begin(),faces.end());
+    faces.erase(std::unique(faces.begin(),faces.end()),faces.end());
+    if ( faces.size() > slots.size()/4 + 256 ) return false;
+
+    unsigned long from = revision_count;
+    patched_ranges.clear();
+    DLFLFacePtrArray fill_faces;
+    vector<uint> fill_offsets;
+    for (int i=0; i < (int)faces.size(); ++i) {
+      DLFLFacePtr fp = faces[i];
+      bool alive = object->hasFace(fp);
+      uint size = alive ? fp->size() : 0;
+      uint count = ( size < 3 ) ? 0 : 3*(size-2);
+
+      DLFLFacePtrArray::iterator sf = std::find(small_faces.begin(),small_faces.end(),fp);
+      if ( sf != small_faces.end() ) small_faces.erase(sf);
+      if ( alive && size < 3 ) small_faces.push_back(fp);
+
+      int batch = -1;
+      if ( count > 0 ) {
+        for (int b=0; b < (int)batch_array.size() && batch < 0; ++b)
+          if ( batch_array[b].material == fp->material() ) batch = b;
+        // A new material
+        if ( batch < 0 ) return false;
+      }
+
+      // Faces keep their place as long as they fit
+      std::map<DLFLFacePtr,Slot>::iterator it = slots.find(fp);
+      if ( it != slots.end() ) {
+        if ( it->second.count == count && (int)it->second.batch == batch ) {
+          fill_faces.push_back(fp); fill_offsets.push_back(it->second.first);
+          continue;
+        }
+        release(it->second);
+        slots.erase(it);
+      }
+      if ( count > 0 ) {
+        Slot slot = { 0, count, (uint)batch };
+        if ( !allocate(batch,count,slot.first) ) return false;
+        slots[fp] = slot;
+        fill_faces.push_back(fp); fill_offsets.push_back(slot.first);
+      }
+    }
+    // Compact the array if too much of it is holes
+    if ( wasted > vertex_array.size()/4 + 3*1024 ) return false;
+
+    int numfaces = fill_faces.size();
+#pragma omp parallel for schedule(static)
+    for (int i=0; i < numfaces; ++i)
+      fillFace(fill_faces[i],&vertex_array[fill_offsets[i]]);
+    for (int i=0; i < numfaces; ++i)
+      markRange(fill_offsets[i],slots[fill_faces[i]].count);
+
+    // Merge the ranges which are close, fewer and larger uploads are faster
+    std::sort(patched_ranges.begin(),patched_ranges.end(),lessRangeFirst);
+    vector<Range> merged;
+    for (int i=0; i < (int)patched_ranges.size(); ++i) {
+      const Range& range = patched_ranges[i];
+      if ( !merged.empty() && range.first <= merged.back().first + merged.back().count + 3*16 )
+        merged.back().count = std::max(merged.back().count, range.first + range.count - merged.back().first);
+      else
+        merged.push_back(range);
+    }
+    patched_ranges.swap(merged);
+
+    was_patched = true;
+    patched_from = from;
+    revision_count = ++last_revision;
+    return true;
+  }
+
+  bool DLFLRenderBuffers::allocate(uint batch, uint count, uint& first) {
+    // The first hole which is large enough
+    vector<Range>& batch_holes = holes[batch];
+    for (int i=0; i < (int)batch_holes.size(); ++i) {
+      if ( batch_holes[i].count >= count ) {
+        first = batch_holes[i].first;
+        batch_holes[i].first += count; batch_holes[i].count -= count;
+        if ( batch_holes[i].count == 0 ) batch_holes.erase(batch_holes.begin()+i);
+        wasted -= count;
+        return true;
+      }
+    }
+    // Otherwise the spare room at the end of the batch
+    Batch& b = batch_array[batch];
+    if ( b.first + b.count + count <= batch_ends[batch] ) {
+      first = b.first + b.count;
+      b.count += count;
+      return true;
+    }
+    return false;
+  }
+
+  void DLFLRenderBuffers::release(const Slot& slot) {
+    // Triangles with all corners at the origin don't cover any pixels
+    std::fill(vertex_array.begin()+slot.first,vertex_array.begin()+slot.first+slot.count,Vertex());
+    Range hole = { slot.first, slot.count };
+    holes[slot.batch].push_back(hole);
+    wasted += slot.count;
+    markRange(slot.first,slot.count);
+  }
+
+  void DLFLRenderBuffers::markRange(uint first, uint count) {
+    Range range = { first, count };
+    patched_ranges.push_back(range);
+  }
+
+  void DLFLRenderBuffers::fillFace(DLFLFacePtr fp, Vertex *vertex) const {
+    float color[4] = { 1.0, 1.0, 1.0, 1.0 };
+    if ( color_source == BaseColor ) {
+      for (int i=0; i < 4; ++i) color[i] = base_color[i];
+    } else if ( color_source == MaterialColor ) {
+      RGBColor mcolor = fp->material()->color;
+      color[0] = mcolor.r; color[1] = mcolor.g; color[2] = mcolor.b;
+      color[3] = base_color[3];
+    }
+
+    DLFLFaceVertexPtr head = fp->front(), prev = head->next(), curr = prev->next();
+    while ( curr != head ) {
+      fillVertex(head,color,vertex[0]);
+      fillVertex(prev,color,vertex[1]);
+      fillVertex(curr,color,vertex[2]);
+      vertex += 3;
+      prev = curr; curr = curr->next();
+    }
+  }
+
+  void DLFLRenderBuffers::fillVertex(DLFLFaceVertexPtr fvp, const float color[4], Vertex& vertex) const {
+    vertex.texcoord[0] = 1.0 - fvp->texcoord[0];
+    vertex.texcoord[1] = 1.0 - fvp->texcoord[1];
+    if ( color_source == CornerColor ) {
+      vertex.color[0] = fvp->color.r; vertex.color[1] = fvp->color.g;
+      vertex.color[2] = fvp->color.b; vertex.color[3] = 1.0;
+    } else if ( color_source == ModulatedCornerColor ) {
+      vertex.color[0] = base_color[0]*fvp->color.r; vertex.color[1] = base_color[1]*fvp->color.g;
+      vertex.color[2] = base_color[2]*fvp->color.b; vertex.color[3] = base_color[3];
+    } else {
+      for (int i=0; i < 4; ++i) vertex.color[i] = color[i];
+    }
+    for (int i=0; i < 3; ++i) {
+      vertex.normal[i] = fvp->normal[i];
+      vertex.position[i] = fvp->vertex->coords[i];
+    }
+  }
+
+} // end namespace
@@ -0,0 +1,150 @@
+/*** ***/
+
+/**
+ * \file DLFLRenderBuffers.h
+ */
+
+#ifndef _DLFL_RENDER_BUFFERS_HH_
+#define _DLFL_RENDER_BUFFERS_HH_
+
+#include <map>
+#include <vector>
+#include "DLFLCommon.h"
+
+namespace DLFL {
+
+  /*
+    The faces of an object cut into triangles and stored in one interleaved
+    vertex array, ready to be handed to OpenGL as a vertex buffer. The
+    renderer draws a whole object with one call per material instead of a
+    glBegin/glEnd per face.
+
+    Faces are fanned from their first corner - what GL_POLYGON does with the
+    convex faces it can draw. They are grouped by material, each material
+    has a batch of the array with some room to spare at its end. Faces with
+    fewer than 3 corners have no triangles and are listed separately.
+
+    When the object changes the arrays are patched from the change journal
+    of the object (see DLFLObject::changesSince): the faces in the journal,
+    and the faces around the vertices in it, are filled in again where they
+    are. A face which no longer fits its place leaves a hole of degenerate
+    triangles behind and moves to a hole or to the spare room of its batch.
+    When the journal doesn't go back far enough, the room runs out or the
+    holes waste too much, everything is laid out again. So is it when the
+    arrays are asked for with another coloring.
+
+    Nothing in here calls OpenGL, so the arrays can be built and checked
+    without a window. The buffers belong to their object - get them with
+    DLFLObject::renderBuffers().
+  */
+  class DLFLRenderBuffers {
+  public :
+    // Where the color of a corner comes from
+    enum ColorSource {
+      NoColor,                 // Left at white, the renderer doesn't use it
+      CornerColor,             // Color of the corner (lighting)
+      ModulatedCornerColor,    // Color of the corner times the base color
+      BaseColor,               // The base color
+      MaterialColor            // Color of the material of the face
+    };
+
+    // Same layout as GL_T2F_C4F_N3F_V3F
+    struct Vertex {
+      float texcoord[2];       // Flipped in both directions, as drawn
+      float color[4];
+      float normal[3];         // Normal of the corner
+      float position[3];
+    };
+
+    // A range of vertices of the array
+    struct Range {
+      uint first;
+      uint count;
+    };
+
+    // The triangles of the faces of one material, 3 vertices per triangle.
+    // There may be holes in between.
+    struct Batch {
+      DLFLMaterialPtr material;
+      uint first;
+      uint count;
+    };
+
+    DLFLRenderBuffers(DLFLObjectPtr obj);
+
+    // Bring the arrays up to date with the object, colored as given. The
+    // alpha of the base color is used by all color sources except NoColor
+    // and CornerColor. Returns true if anything changed.
+    bool update(ColorSource source, const double base[4]);
+
+    // The whole array, including the spare room of the batches
+    const std::vector<Vertex>& vertices() const { return vertex_array; }
+    const std::vector<Batch>& batches() const { return batch_array; }
+    // Faces with fewer than 3 corners
+    const DLFLFacePtrArray& smallFaces() const { return small_faces; }
+
+    // Changes with every update and is never the same for two different
+    // arrays, even of different objects - so a copy of the arrays (on the
+    // graphics card) can tell whether it is still current
+    unsigned long revision() const { return revision_count; }
+
+    // Whether the last update only rewrote patchedRanges() of the array of
+    // revision patchedFrom(). Otherwise it laid out the whole array again.
+    bool patched() const { return was_patched; }
+    unsigned long patchedFrom() const { return patched_from; }
+    const std::vector<Range>& patchedRanges() const { return patched_ranges; }
+
+    // Throw the arrays away, they are built again on the next update
+    void invalidate();
+
+  private :
+    // Where the triangles of a face are
+    struct Slot {
+      uint first;
+      uint count;
+      uint batch;
+    };
+
+    // Lay out all faces again
+    void rebuild();
+    // Redo the given faces and the faces around the given vertices.
+    // Returns false if it is better to rebuild.
+    bool patch(DLFLFacePtrArray& faces, const DLFLVertexPtrArray& vertices);
+    // Find room for count vertices in a batch, false if there is none
+    bool allocate(uint batch, uint count, uint& first);
+    // Turn the triangles of a slot into a hole
+    void release(const Slot& slot);
+    // Note a range rewritten by a patch
+    void markRange(uint first, uint count);
+
+    // Fill in the triangles of a face, starting at the given vertex
+    void fillFace(DLFLFacePtr fp, Vertex *vertex) const;
+    // Fill in one vertex from a corner
+    void fillVertex(DLFLFaceVertexPtr fvp, const float color[4], Vertex& vertex) const;
+
+    DLFLObjectPtr object;
+    unsigned long generation;                  // Generation of object when updated
+    bool built;
+    unsigned long revision_count;
+    static unsigned long last_revision;        // Over all buffers
+
+    ColorSource color_source;                  // Coloring when built
+    double base_color[4];
+
+    std::vector<Vertex> vertex_array;
+    std::vector<Batch> batch_array;
+    DLFLFacePtrArray small_faces;
+
+    std::map<DLFLFacePtr, Slot> slots;
+    std::vector<uint> batch_ends;              // End of the room of each batch
+    std::vector< std::vector<Range> > holes;   // Holes in each batch
+    uint wasted;                               // Vertices in holes
+
+    bool was_patched;
+    unsigned long patched_from;
+    std::vector<Range> patched_ranges;
+  };
+
+} // end namespace
+
+#endif /* _DLFL_RENDER_BUFFERS_HH_ */
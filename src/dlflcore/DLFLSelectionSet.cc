@@ -0,0 +1,95 @@
+/*** ***/
+
+/**
+ * \file DLFLSelectionSet.cc
+ */
+
+#include "DLFLSelectionSet.h"
+#include "DLFLVertex.h"
+#include "DLFLFaceVertex.h"
+#include "DLFLEdge.h"
+#include "DLFLFace.h"
+
+namespace DLFL {
+
+  // Open addressing on the address, the table at most half full
+  static size_t cornerHash(DLFLFaceVertexPtr element, size_t mask) {
+    return ((size_t(element) >> 4) * 2654435761u) & mask;
+  }
+
+  template <>
+  uint DLFLSelectionSet<DLFLFaceVertexPtr>::find(DLFLFaceVertexPtr element) const {
+    if ( slots.empty() ) return NoSlot;
+    size_t mask = slots.size()-1;
+    for (size_t h = cornerHash(element,mask); slots[h].first != NULL; h = (h+1) & mask)
+      if ( slots[h].first == element ) return slots[h].second;
+    return NoSlot;
+  }
+
+  template <>
+  uint DLFLSelectionSet<DLFLFaceVertexPtr>::add(DLFLFaceVertexPtr element) {
+    uint id = find(element);
+    if ( id != NoSlot ) return id;
+    if ( 2*(num_slots+1) > slots.size() ) {
+      std::vector<Slot> old;
+      old.swap(slots);
+      slots.assign(( old.empty() ) ? 64 : 2*old.size(),Slot(NULL,0));
+      size_t mask = slots.size()-1;
+      for (size_t i=0; i < old.size(); ++i) {
+        if ( old[i].first == NULL ) continue;
+        size_t h = cornerHash(old[i].first,mask);
+        while ( slots[h].first != NULL ) h = (h+1) & mask;
+        slots[h] = old[i];
+      }
+    }
+    size_t mask = slots.size()-1, h = cornerHash(element,mask);
+    while ( slots[h].first != NULL ) h = (h+1) & mask;
+    slots[h] = Slot(element,num_slots);
+    return num_slots++;
+  }
+
+  template <>
+  void DLFLSelectionSet<DLFLVertexPtr>::neighbours(DLFLVertexPtr element, DLFLVertexPtrArray& around) {
+    DLFLEdgePtrArray edges;
+    element->getEdges(edges);
+    around.clear();
+    for (uint i=0; i < edges.size(); ++i) {
+      DLFLVertexPtr vp1, vp2;
+      edges[i]->getVertexPointers(vp1,vp2);
+      around.push_back(( vp1 == element ) ? vp2 : vp1);
+    }
+  }
+
+  template <>
+  void DLFLSelectionSet<DLFLEdgePtr>::neighbours(DLFLEdgePtr element, DLFLEdgePtrArray& around) {
+    DLFLVertexPtr vp1, vp2;
+    DLFLEdgePtrArray edges;
+    element->getVertexPointers(vp1,vp2);
+    around.clear();
+    vp1->getEdges(edges);
+    around.insert(around.end(),edges.begin(),edges.end());
+    vp2->getEdges(edges);
+    around.insert(around.end(),edges.begin(),edges.end());
+  }
+
+  template <>
+  void DLFLSelectionSet<DLFLFacePtr>::neighbours(DLFLFacePtr element, DLFLFacePtrArray& around) {
+    DLFLEdgePtrArray edges;
+    element->getEdges(edges);
+    around.clear();
+    for (uint i=0; i < edges.size(); ++i) {
+      DLFLFacePtr fp1, fp2;
+      edges[i]->getFacePointers(fp1,fp2);
+      around.push_back(( fp1 == element ) ? fp2 : fp1);
+    }
+  }
+
+  template <>
+  void DLFLSelectionSet<DLFLFaceVertexPtr>::neighbours(DLFLFaceVertexPtr element,
+                                                       DLFLFaceVertexPtrArray& around) {
+    around.clear();
+    around.push_back(element->prev());
+    around.push_back(element->next());
+  }
+
+} // end namespace
@@ -0,0 +1,219 @@
+/*** ***/
+
+/**
+ * \file DLFLSelectionSet.h
+ */
+
+#ifndef _DLFL_SELECTION_SET_HH_
+#define _DLFL_SELECTION_SET_HH_
+
+#include <utility>
+#include <vector>
+#include "DLFLCommon.h"
+
+namespace DLFL {
+
+  /*
+    A set of selected vertices, edges, faces or corners of an object. It
+    keeps the elements in the order they were selected, which is what the
+    operations on selected elements go by, and a bit per element ID, so
+    whether an element is selected, selecting and deselecting it take the
+    same time however many are selected.
+
+    The IDs of corners are their addresses, far too sparse for that, so the
+    set numbers the corners it sees itself and finds their numbers in a
+    hash table of the addresses.
+
+    Deselected elements are only dropped from the list when the list is
+    next looked at, so deselecting many elements one after the other is
+    not quadratic either. The IDs of the elements in the list are kept
+    with them, so that doesn't look at the elements, which may have been
+    deleted from the object since they were selected.
+
+    For the code which reads the selection as an array, the set looks like
+    a const vector of the elements and converts to one.
+  */
+  template <class T>
+  class DLFLSelectionSet {
+  public :
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    DLFLSelectionSet() : num_stale(0), num_slots(0) {}
+
+    bool contains(T element) const {
+      if ( !element ) return false;
+      uint id = find(element);
+      return id < bits.size() && bits[id];
+    }
+
+    // Add an element at the end, false if it is NULL or already selected
+    bool insert(T element) {
+      if ( !element || contains(element) ) return false;
+      uint id = add(element);
+      if ( id >= bits.size() ) {
+        bits.resize(id + id/2 + 64,false);
+        listed.resize(bits.size(),false);
+      }
+      // Still in the list from before it was deselected, it goes to the end
+      if ( listed[id] ) compact();
+      bits[id] = true; listed[id] = true;
+      members.push_back(element); ids.push_back(id);
+      return true;
+    }
+
+    // False if the element was not selected
+    bool remove(T element) {
+      if ( !contains(element) ) return false;
+      bits[find(element)] = false;
+      ++num_stale;
+      return true;
+    }
+
+    // Put an element in place of the one at an index, or at the end if the
+    // index is past it. Nothing happens if the element is already selected.
+    void replace(uint index, T element) {
+      compact();
+      if ( index >= members.size() ) { insert(element); return; }
+      if ( !element || contains(element) ) return;
+      bits[ids[index]] = false; listed[ids[index]] = false;
+      uint id = add(element);
+      if ( id >= bits.size() ) {
+        bits.resize(id + id/2 + 64,false);
+        listed.resize(bits.size(),false);
+      }
+      bits[id] = true; listed[id] = true;
+      members[index] = element; ids[index] = id;
+    }
+
+    // Also gives back the memory of the bits, which may have grown large
+    void clear() {
+      std::vector<T>().swap(members); std::vector<uint>().swap(ids);
+      std::vector<bool>().swap(bits); std::vector<bool>().swap(listed);
+      std::vector<Slot>().swap(slots);
+      num_stale = 0; num_slots = 0;
+    }
+
+    void reserve(uint num) { members.reserve(num); ids.reserve(num); }
+
+    // Set operations. Added elements go at the end in the order given.
+    void assign(const std::vector<T>& elements) { clear(); unite(elements); }
+    void unite(const std::vector<T>& elements) {
+      for (uint i=0; i < elements.size(); ++i) insert(elements[i]);
+    }
+    void subtract(const std::vector<T>& elements) {
+      for (uint i=0; i < elements.size(); ++i) remove(elements[i]);
+    }
+    void intersect(const std::vector<T>& elements) {
+      DLFLSelectionSet<T> other;
+      other.unite(elements);
+      compact();
+      for (uint i=0; i < members.size(); ++i)
+        if ( !other.contains(members[i]) ) { bits[ids[i]] = false; ++num_stale; }
+    }
+    // Select all of the given elements which are not selected, in their
+    // order, and nothing else
+    void invert(const std::vector<T>& all) {
+      std::vector<T> inverse;
+      for (uint i=0; i < all.size(); ++i)
+        if ( all[i] && !contains(all[i]) ) inverse.push_back(all[i]);
+      assign(inverse);
+    }
+
+    // Add the neighbours of the selected elements - the vertices at the
+    // other ends of their edges, the edges which share a vertex with them,
+    // the faces which share an edge with them, the corners before and
+    // after them in their faces
+    void grow();
+    // Deselect the elements with a neighbour which is not selected
+    void shrink();
+
+    // The selected elements in order
+    const std::vector<T>& array() const { compact(); return members; }
+    operator const std::vector<T>&() const { return array(); }
+
+    uint size() const { return array().size(); }
+    bool empty() const { return array().empty(); }
+    T operator [] (uint index) const { return array()[index]; }
+    const_iterator begin() const { return array().begin(); }
+    const_iterator end() const { return array().end(); }
+
+  private :
+    typedef std::pair<T,uint> Slot;
+    static const uint NoSlot = ~0u;
+
+    // Where the bits of an element are, its ID except for corners. find
+    // gives NoSlot for a corner which doesn't have a number yet, add gives
+    // it one.
+    uint find(T element) const { return element->getID(); }
+    uint add(T element) { return element->getID(); }
+
+    // The elements next to one, as grow and shrink go by
+    static void neighbours(T element, std::vector<T>& around);
+
+    // Drop the deselected elements from the list
+    void compact() const {
+      if ( num_stale == 0 ) return;
+      uint kept = 0;
+      for (uint i=0; i < members.size(); ++i) {
+        if ( bits[ids[i]] ) {
+          members[kept] = members[i]; ids[kept] = ids[i]; ++kept;
+        } else {
+          listed[ids[i]] = false;
+        }
+      }
+      members.resize(kept); ids.resize(kept);
+      num_stale = 0;
+    }
+
+    mutable std::vector<T> members;            // Selected elements in order
+    mutable std::vector<uint> ids;             // IDs of the members
+    std::vector<bool> bits;                    // Selected, by ID
+    mutable std::vector<bool> listed;          // In members, by ID
+    mutable uint num_stale;                    // Deselected but still in members
+    std::vector<Slot> slots;                   // Hash table of corner numbers
+    uint num_slots;                            // Corners numbered
+  };
+
+  template <class T>
+  void DLFLSelectionSet<T>::grow() {
+    compact();
+    std::vector<T> around;
+    uint num = members.size();
+    for (uint i=0; i < num; ++i) {
+      neighbours(members[i],around);
+      unite(around);
+    }
+  }
+
+  template <class T>
+  void DLFLSelectionSet<T>::shrink() {
+    compact();
+    std::vector<T> around, boundary;
+    for (uint i=0; i < members.size(); ++i) {
+      neighbours(members[i],around);
+      for (uint j=0; j < around.size(); ++j)
+        if ( !contains(around[j]) ) { boundary.push_back(members[i]); break; }
+    }
+    subtract(boundary);
+  }
+
+  typedef DLFLSelectionSet<DLFLVertexPtr> DLFLVertexSelection;
+  typedef DLFLSelectionSet<DLFLEdgePtr> DLFLEdgeSelection;
+  typedef DLFLSelectionSet<DLFLFacePtr> DLFLFaceSelection;
+  typedef DLFLSelectionSet<DLFLFaceVertexPtr> DLFLFaceVertexSelection;
+
+  template <> uint DLFLSelectionSet<DLFLFaceVertexPtr>::find(DLFLFaceVertexPtr element) const;
+  template <> uint DLFLSelectionSet<DLFLFaceVertexPtr>::add(DLFLFaceVertexPtr element);
+
+  template <> void DLFLSelectionSet<DLFLVertexPtr>::neighbours(DLFLVertexPtr element,
+                                                               DLFLVertexPtrArray& around);
+  template <> void DLFLSelectionSet<DLFLEdgePtr>::neighbours(DLFLEdgePtr element,
+                                                             DLFLEdgePtrArray& around);
+  template <> void DLFLSelectionSet<DLFLFacePtr>::neighbours(DLFLFacePtr element,
+                                                             DLFLFacePtrArray& around);
+  template <> void DLFLSelectionSet<DLFLFaceVertexPtr>::neighbours(DLFLFaceVertexPtr element,
+                                                                   DLFLFaceVertexPtrArray& around);
+
+} // end namespace
+
+#endif /* _DLFL_SELECTION_SET_HH_ */
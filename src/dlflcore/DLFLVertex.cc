@@ -623,6 +623,10 @@ namespace DLFL {
     vtType = VTNormal;
   }
 
+  void DLFLVertex::setIndex(uint newindex) {
+    index = newindex;
+  }
+
   void DLFLVertex::setFaceVertexList(const DLFLFaceVertexPtrList& list) {
     fvpList = list;
   }
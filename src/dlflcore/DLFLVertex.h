@@ -62,6 +62,8 @@ namespace DLFL {
     // Assign a unique ID for this instance
     void assignID(void);
 
+    friend class DLFLObject; // For the structural copy of objects
+
   public :
     // Default constructor
     DLFLVertex();
@@ -123,6 +125,8 @@ namespace DLFL {
 
     void resetType(void);
 
+    void setIndex(uint newindex);
+
     // Reset type of vertex, all face-vertices and edges connected to this vertex
     void resetTypeDeep(void);
 
@@ -26,6 +26,12 @@ macx {
   QMAKE_LFLAGS_DEBUG += -pg
 }
 
+CONFIG(WITH_OPENMP) {
+ # run the geometry passes of the operators in parallel
+ QMAKE_CXXFLAGS += -fopenmp
+ QMAKE_LFLAGS += -fopenmp
+}
+
 HEADERS +=  \
           	DLFLCommon.h \
           	DLFLCore.h \
@@ -33,8 +39,16 @@ HEADERS +=  \
           	DLFLEdge.h \
           	DLFLFace.h \
           	DLFLFaceVertex.h \
+          	DLFLLabelLayout.h \
+          	DLFLMatchIndex.h \
           	DLFLMaterial.h \
           	DLFLObject.h \
+          	DLFLOverlayBuffers.h \
+          	DLFLParallel.h \
+          	DLFLPickIndex.h \
+          	DLFLProgress.h \
+          	DLFLRenderBuffers.h \
+          	DLFLSelectionSet.h \
           	DLFLVertex.h 
 
 SOURCES +=  \
@@ -46,5 +60,13 @@ SOURCES +=  \
           	DLFLFaceVertex.cc \
           	DLFLFile.cc \
             DLFLFileAlt.cc \
+          	DLFLLabelLayout.cc \
+          	DLFLMatchIndex.cc \
           	DLFLObject.cc \
+          	DLFLOverlayBuffers.cc \
+          	DLFLParallel.cc \
+          	DLFLPickIndex.cc \
+          	DLFLProgress.cc \
+          	DLFLRenderBuffers.cc \
+          	DLFLSelectionSet.cc \
           	DLFLVertex.cc
@@ -3,4 +3,9 @@ TEMPLATE = subdirs
 CONFIG += ordered
 
 SUBDIRS *= vecmat arcball dlflcore dlflaux
+
+# The benchmark needs fork and getrusage
+unix {
+ SUBDIRS *= bench
+}
   
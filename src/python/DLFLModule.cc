@@ -1,10 +1,12 @@
 /*** ***/
 
 #include <Python.h>
+#include <cfloat>
 
 #include <DLFLCore.h>
 #include <DLFLExtrude.h>
 #include <DLFLSubdiv.h>
+#include <DLFLLimitSurface.h>
 #include <DLFLDual.h>
 #include <DLFLConnect.h>
 #include <DLFLCrust.h>
@@ -46,6 +48,9 @@ static PyObject *dlfl_faces(PyObject *self, PyObject *args);
 static PyObject *dlfl_edges(PyObject *self, PyObject *args);
 static PyObject *dlfl_verts(PyObject *self, PyObject *args);
 static PyObject *dlfl_corners(PyObject *self, PyObject *args);
+static PyObject *dlfl_match_faces(PyObject *self, PyObject *args);
+static PyObject *dlfl_match_edges(PyObject *self, PyObject *args);
+static PyObject *dlfl_match_verts(PyObject *self, PyObject *args);
 
 //static PyObject *dlfl_boundary_walk(PyObject *self, PyObject *args);
 static PyObject *dlfl_walk(PyObject *self, PyObject *args);
@@ -68,10 +73,11 @@ static PyObject *dlfl_centroid(PyObject *self, PyObject *args);
 
 /* Auxiliary */
 static PyObject *dlfl_extrude(PyObject *self, PyObject *args);
-static PyObject *dlfl_subdivide(PyObject *self, PyObject *args);
+static PyObject *dlfl_subdivide(PyObject *self, PyObject *args, PyObject *kwds);
 static PyObject *dlfl_subdivide_face(PyObject *self, PyObject *args);
 static PyObject *dlfl_subdivide_faces(PyObject *self, PyObject *args);
 static PyObject *dlfl_dual(PyObject *self, PyObject *args);
+static PyObject *dlfl_limit(PyObject *self, PyObject *args);
 static PyObject *dlfl_connectEdges(PyObject *self, PyObject *args);
 static PyObject *dlfl_connectCorners(PyObject *self, PyObject *args);
 static PyObject *dlfl_connectFaces(PyObject *self, PyObject *args);
@@ -116,6 +122,9 @@ static PyMethodDef DLFLMethods[] = {
   {"edges",          dlfl_edges,          METH_VARARGS, "Grab all/selected the edges of the object"},
   {"verts",          dlfl_verts,          METH_VARARGS, "Grab all/selected the vertices of the object"},
   {"corners",        dlfl_corners,        METH_VARARGS, "Grab all/selected the face-vertices of the object"},
+  {"matchFaces",     dlfl_match_faces,    METH_VARARGS, "Faces matching a face by \"size\" (default), \"area\" (within delta) or \"color\""},
+  {"matchEdges",     dlfl_match_edges,    METH_VARARGS, "Edges whose end vertices have the same valences as those of an edge"},
+  {"matchVerts",     dlfl_match_verts,    METH_VARARGS, "Vertices with the same valence as a vertex"},
   {"walk",           dlfl_walk,           METH_VARARGS, "Walk around a face and get all of the vertices/edges in lists"},
   {"cornerWalk",     dlfl_corner_walk,    METH_VARARGS, "Walk around a face and get all of the corners in a list"},
   {"next",           dlfl_next,           METH_VARARGS, "Walk to next corner in Linked List"},
@@ -134,10 +143,11 @@ static PyMethodDef DLFLMethods[] = {
   {"centroid",      dlfl_centroid,       METH_VARARGS, "Get centroid of vertices"},
   /* Auxiliary Below */
   {"extrude",        dlfl_extrude,        METH_VARARGS, "Extrude a face"},
-  {"subdivide",      dlfl_subdivide,      METH_VARARGS, "Subdivide a mesh"},
+  {"subdivide",      (PyCFunction)dlfl_subdivide, METH_VARARGS | METH_KEYWORDS, "Subdivide a mesh"},
   {"subdivideFace",  dlfl_subdivide_face, METH_VARARGS, "Subdivide a Face"},
   {"subdivideFaces",  dlfl_subdivide_faces, METH_VARARGS, "Subdivide a list of Faces"},
   {"dual",           dlfl_dual,           METH_VARARGS, "Dual of mesh"},
+  {"limit",          dlfl_limit,          METH_VARARGS, "Move vertices to the limit surface of a subdivision scheme"},
   {"connectEdges",   dlfl_connectEdges,   METH_VARARGS, "Connect an edge on one face with another"},
   {"connectCorners", dlfl_connectCorners, METH_VARARGS, "Connect two corners (i.e. Add Hole/Handle)"},
   {"connectFaces",   dlfl_connectFaces,   METH_VARARGS, "Connect two faces (i.e. Add Hole/Handle Closest Vertex)"},
@@ -572,6 +582,87 @@ dlfl_corners(PyObject *self, PyObject *args)
   Py_INCREF(fvlist);
   return fvlist;
 }
+
+/* The matching elements are looked up in the match index of the object, see DLFLMatchIndex.h */
+static PyObject *
+dlfl_match_faces(PyObject *self, PyObject *args)
+{
+  int faceId;
+  char *kind = (char *)"size";
+  float delta = 0.1;
+
+  if( !currObj )
+    return NULL;
+  if( !PyArg_ParseTuple(args, "i|sf", &faceId, &kind, &delta) )
+    return NULL;
+
+  DLFL::DLFLFacePtr fp = currObj->findFace(faceId);
+  if( !fp )
+    return NULL;
+
+  DLFL::DLFLFacePtrArray fpa;
+  if( strcmp(kind,"area") == 0 ) {
+    float area = fp->getArea();
+    currObj->matchIndex().facesWithArea(area-delta,area+delta,fpa);
+  } else if( strcmp(kind,"color") == 0 ) {
+    currObj->matchIndex().facesWithMaterial(fp->material(),fpa);
+  } else {
+    currObj->matchIndex().facesWithSize(fp->size(),fpa);
+  }
+
+  PyObject *flist = PyList_New(fpa.size());
+  for( int i = 0; i < (int)fpa.size(); i++ )
+    PyList_SetItem(flist, i, Py_BuildValue("i", fpa[i]->getID()));
+  return flist;
+}
+
+static PyObject *
+dlfl_match_edges(PyObject *self, PyObject *args)
+{
+  int edgeId;
+
+  if( !currObj )
+    return NULL;
+  if( !PyArg_ParseTuple(args, "i", &edgeId) )
+    return NULL;
+
+  DLFL::DLFLEdgePtr ep = currObj->findEdge(edgeId);
+  if( !ep )
+    return NULL;
+
+  DLFL::DLFLVertexPtr vp1, vp2;
+  ep->getVertexPointers(vp1,vp2);
+  DLFL::DLFLEdgePtrArray epa;
+  currObj->matchIndex().edgesWithValences(vp1->numEdges(),vp2->numEdges(),epa);
+
+  PyObject *elist = PyList_New(epa.size());
+  for( int i = 0; i < (int)epa.size(); i++ )
+    PyList_SetItem(elist, i, Py_BuildValue("i", epa[i]->getID()));
+  return elist;
+}
+
+static PyObject *
+dlfl_match_verts(PyObject *self, PyObject *args)
+{
+  int vertId;
+
+  if( !currObj )
+    return NULL;
+  if( !PyArg_ParseTuple(args, "i", &vertId) )
+    return NULL;
+
+  DLFL::DLFLVertexPtr vp = currObj->findVertex(vertId);
+  if( !vp )
+    return NULL;
+
+  DLFL::DLFLVertexPtrArray vpa;
+  currObj->matchIndex().verticesWithValence(vp->numEdges(),vpa);
+
+  PyObject *vlist = PyList_New(vpa.size());
+  for( int i = 0; i < (int)vpa.size(); i++ )
+    PyList_SetItem(vlist, i, Py_BuildValue("i", vpa[i]->getID()));
+  return vlist;
+}
 /*
 static PyObject *
 dlfl_boundary_walk(PyObject *self, PyObject *args) {
@@ -1054,13 +1145,13 @@ dlfl_extrude(PyObject *self, PyObject *args) {
 }
 
 static PyObject *
-dlfl_subdivide(PyObject *self, PyObject *args) {
+dlfl_subdivide(PyObject *self, PyObject *args, PyObject *kwds) {
   if( !currObj ) {
     Py_INCREF(Py_None);
     return Py_None;
   }
 
-  int choiceSize = 26;
+  int choiceSize = 25;
   const char* choices[] = { "loop",
 														"checker",
 														"simplest",
@@ -1086,18 +1177,68 @@ dlfl_subdivide(PyObject *self, PyObject *args) {
 														"linear-vertex",
 														"allfaces",
 														"root3"};
-
+  const DLFL::DLFLSubdivScheme schemes[] = { DLFL::STLoop,
+																						 DLFL::STCheckerBoard,
+																						 DLFL::STSimplest,
+																						 DLFL::STVertexCutting,
+																						 DLFL::STPentagonal,
+																						 DLFL::STPentagonal2,
+																						 DLFL::STHoneycomb,
+																						 DLFL::STDooSabin,
+																						 DLFL::STDooSabinBC,
+																						 DLFL::STDooSabinBCNew,
+																						 DLFL::STCornerCutting,
+																						 DLFL::STModifiedCornerCutting,
+																						 DLFL::STRoot4,
+																						 DLFL::STCatmullClark,
+																						 DLFL::STStar,
+																						 DLFL::STSqrt3,
+																						 DLFL::STFractal,
+																						 DLFL::STStellate,
+																						 DLFL::STTwoStellate,
+																						 DLFL::STDome,
+																						 DLFL::STDual1264,
+																						 DLFL::STLoopStyle,
+																						 DLFL::STAllFaces,
+																						 DLFL::STAllFaces,
+																						 DLFL::STRoot3 };
+  // Values of the options which are left out. Schemes whose functions have
+  // no defaults have always been given 0 from here.
+  const double defaults[][2] = { { 0, 0 },      // loop
+																 { 0.33, 0 },   // checker
+																 { 0, 0 },      // simplest
+																 { 0.25, 0 },   // vertex-cut
+																 { 0, 0 },      // pentagon
+																 { 0.75, 0 },   // pentagon-preserve
+																 { 0, 0 },      // honeycomb
+																 { 1, 0 },      // doo-sabin
+																 { 1, 0 },      // doo-sabin-bc
+																 { 0, 0 },      // doo-sabin-bc-new
+																 { 0, 0 },      // corner-cut
+																 { 0, 0 },      // modified-corner-cut
+																 { 0, 0 },      // root4
+																 { 0, 0 },      // catmull-clark
+																 { 0, 0 },      // star
+																 { 0, 0 },      // sqrt3
+																 { 1, 0 },      // fractal
+																 { 0, 0 },      // stellate
+																 { 0, 0 },      // double-stellate
+																 { 0, 0 },      // dome
+																 { 0, 0 },      // dual-12.6.4
+																 { 0, 0 },      // loop-style
+																 { 1, 0 },      // linear-vertex
+																 { 1, 0 },      // allfaces
+																 { 0, 0 } };    // root3
+
+  static char *kwlist[] = { "scheme", "attrb1", "attrb2", "levels", NULL };
   char* subdivType;
   int size;
-  double attrb1 = 0, attrb2 = 0; 
-  bool battrb1 = false, battrb2 = false; 
-  int argc = PyArg_ParseTuple(args, "s#|ddbb", &subdivType, &size, &attrb1, &attrb2 );
-  if( !argc )
+  // Whether the options were given, by position or keyword
+  const double unset = -DBL_MAX;
+  double attrb1 = unset, attrb2 = unset;
+  int levels = 1;
+  if( !PyArg_ParseTupleAndKeywords(args, kwds, "s#|ddi", kwlist, &subdivType, &size, &attrb1, &attrb2, &levels) )
     return NULL;
-  if( argc >= 3 )
-    battrb1 = true;
-  if( argc >= 4)
-    battrb2 = true;
 
   int choice = -1;
   for(int i = 0; i < choiceSize; i++ ) {
@@ -1107,94 +1248,12 @@ dlfl_subdivide(PyObject *self, PyObject *args) {
     }
   }
 
+  // All levels are done in one call, the normals etc. are only
+  // recomputed once after the script command
   if( choice != -1 ) {
-    switch( choice ) {
-    case 0 : // loop
-      DLFL::loopSubdivide( currObj );
-      break;
-    case 1 : // checker
-      if( battrb1 ) DLFL::checkerBoardRemeshing( currObj, attrb1 );
-      else DLFL::checkerBoardRemeshing( currObj );
-      break;
-    case 2 : // simplest
-      DLFL::simplestSubdivide( currObj );
-      break;
-    case 3 : // vertex-cut
-      if( battrb1 ) DLFL::vertexCuttingSubdivide( currObj, attrb1 );
-      else DLFL::vertexCuttingSubdivide( currObj );
-      break;
-    case 4 : // pentagon
-      DLFL::pentagonalSubdivide( currObj, attrb1 ); // since default is 0 don't need if...else
-      break;
-    case 5 : // dual-pentagon
-      if( battrb1 ) DLFL::pentagonalSubdivide2( currObj, attrb1 );
-      else DLFL::pentagonalSubdivide2( currObj );
-      break;
-    case 6 : // honeycomb
-      DLFL::honeycombSubdivide( currObj );
-      break;
-    case 7 : // doo-sabin
-      if( battrb1 ) DLFL::dooSabinSubdivide( currObj, (bool)attrb1 );
-      else DLFL::dooSabinSubdivide( currObj );
-      break;
-    case 8 : // doo-sabin-bc
-      if( battrb1 ) DLFL::dooSabinSubdivideBC( currObj, (bool)attrb1 );
-      else DLFL::dooSabinSubdivideBC( currObj );
-      break;
-    case 9 : // doo-sabin-bc-new
-      DLFL::dooSabinSubdivideBCNew( currObj, attrb1, attrb2 ); // no defaults
-      break;
-    case 10 : // corner-cut
-      DLFL::cornerCuttingSubdivide( currObj, attrb1 );
-      break;
-    case 11 : // modified-corner-cut
-      DLFL::modifiedCornerCuttingSubdivide( currObj, attrb1 );
-      break;
-    case 12 : // root4
-      if( battrb1 && battrb2 ) DLFL::root4Subdivide( currObj, attrb1, attrb2 );
-      else if( battrb1 ) DLFL::root4Subdivide( currObj, attrb1 );
-      else DLFL::root4Subdivide( currObj );
-      break;
-    case 13 : // catmull-clark
-      DLFL::catmullClarkSubdivide( currObj );
-      break;
-    case 14 : // star
-      if( battrb1 ) DLFL::starSubdivide( currObj, attrb1 );
-      else DLFL::starSubdivide( currObj );
-      break;
-    case 15 : // sqrt3
-      DLFL::sqrt3Subdivide( currObj );
-      break;
-    case 16 : // fractal
-      if( battrb1 ) DLFL::fractalSubdivide( currObj, attrb1 );
-      else DLFL::fractalSubdivide( currObj );
-      break;
-    case 17 : // stellate
-      DLFL::stellateSubdivide( currObj );
-      break;
-    case 18 : // double-stellate
-      DLFL::twostellateSubdivide( currObj, attrb1, attrb2 ); // no defaults
-      break;
-    case 19 : // dome
-      DLFL::domeSubdivide( currObj, attrb1, attrb2 ); // no defaults
-      break;
-    case 20 : // dual-12.6.4
-      DLFL::dual1264Subdivide( currObj, attrb1 ); // no defaults
-      break;
-		case 21 : // loop style
-			DLFL::loopStyleSubdivide( currObj, attrb1 );
-			break;
-		case 24 : // root3 - dave
-			DLFL::createDual(currObj, true); // Use accurate method
-			DLFL::honeycombSubdivide(currObj);
-			DLFL::createDual(currObj,true); // Use accurate method
-			break;
-		case 22 : // linear-vertex
-		case 23 : // allfaces
-    default : // allfaces
-      if( battrb1 ) DLFL::subdivideAllFaces( currObj, (bool)attrb1 );
-      else DLFL::subdivideAllFaces( currObj );
-    }
+    if( attrb1 == unset ) attrb1 = defaults[choice][0];
+    if( attrb2 == unset ) attrb2 = defaults[choice][1];
+    DLFL::subdivide( currObj, schemes[choice], levels, attrb1, attrb2 );
   }
   Py_INCREF(Py_None);
   return Py_None;
@@ -1263,6 +1322,25 @@ PyObject *dlfl_dual(PyObject *self, PyObject *args)
   return Py_None;
 }
 
+static 
+PyObject *dlfl_limit(PyObject *self, PyObject *args) 
+{
+  char* scheme;
+  int size;
+  if( !PyArg_ParseTuple(args, "s#", &scheme, &size) )
+    return NULL;
+
+  // False for an unknown scheme or an open mesh, which has no limit points
+  bool projected = false;
+  if( currObj ) {
+    if( strncmp(scheme,"catmull-clark",size) == 0 )
+      projected = DLFL::projectToCatmullClarkLimit( currObj );
+    else if( strncmp(scheme,"doo-sabin",size) == 0 )
+      projected = DLFL::projectToDooSabinLimit( currObj );
+  }
+  return Py_BuildValue("b", projected);
+}
+
 static PyObject *dlfl_connectEdges(PyObject *self, PyObject *args) { 
 	int edgeId1, edgeId2;
 	int faceId1, faceId2;
@@ -1516,6 +1594,7 @@ static PyObject *dlfl_move(PyObject *self, PyObject *args) {
 				(vparray[i])->coords = vec;
 			}
 		}
+		currObj->changed();
 	}
 	Py_INCREF(Py_None);
 	return Py_None;
@@ -29,9 +29,11 @@ QMAKE_LFLAGS_DEBUG += -pg
 # exclude python or spacenav drivers
 # or include them with CONFIG +=
 CONFIG -= WITH_PYTHON \
-    WITH_SPACENAV
+    WITH_SPACENAV \
+    WITH_OPENMP
 
 # CONFIG += WITH_PYTHON
+# CONFIG += WITH_OPENMP
 # to include the popup command line interface leave the following line uncommented
 DEFINES *= QCOMPLETER
 
@@ -70,6 +72,11 @@ CONFIG(WITH_PYTHON) {
     message("PYTHON support will be included")
     DEFINES *= WITH_PYTHON
 }
+CONFIG(WITH_OPENMP) { 
+    message("OpenMP support will be included")
+    QMAKE_CXXFLAGS += -fopenmp
+    QMAKE_LFLAGS += -fopenmp
+}
 
 
 # Operating System Specific Tasks - OS/X
@@ -183,6 +190,8 @@ HEADERS += \
     MainWindow.h \
     GeometryRenderer.h \
     DLFLLighting.h \
+    DLFLProgressDialog.h \
+    DLFLTimer.h \
     qcumber.h \
     qshortcutdialog.h \
     qshortcutmanager.h \
@@ -197,10 +206,10 @@ HEADERS += \
     HighgenusMode.h \
     TexturingMode.h \
     ExperimentalModes.h \
-    DLFLSelection.h \
     #Viewport.h \
     TMPatchFace.h \
     TMPatchObject.h \
+    TMPatchTessellation.h \
     TMPatch.h \
     DLFLRenderer.h \
     hermite_connect_faces.h \
@@ -256,13 +265,14 @@ SOURCES += tools/insert_edge_tool.cc \
     TexturingMode.cc \
     ExperimentalModes.cc \
     DLFLLighting.cc \
+    DLFLProgressDialog.cc \
     DLFLRenderer.cc \
     hermite_connect_faces.cc \
-    DLFLSelection.cc \
     DLFLUndo.cc \
     DLFLLocator.cc \
     TMPatchObject.cc \
     TMPatchFace.cc \
+    TMPatchTessellation.cc \
     stylesheeteditor.cc \
     CgData.cc \
     include/Camera3.cc \